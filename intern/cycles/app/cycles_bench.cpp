@@ -0,0 +1,318 @@
+/*
+ * Copyright 2011-2013 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License
+ */
+
+/* Benchmarks of Cycles internals that don't need a scene file.
+ *
+ * task: throughput of the TaskScheduler, with many small tasks pushed from
+ * the main thread, tasks pushing subtasks from the worker threads, and
+ * tasks of very different duration where idle threads have to steal.
+ *
+ * bvh: build time and surface area heuristic cost of binary and QBVH trees,
+ * with and without spatial splits, for a mesh of random clustered triangles.
+ * Compare runs with different --threads to see the parallel build speedup,
+ * the SAH cost must be the same for every thread count. */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bvh.h"
+#include "bvh_params.h"
+
+#include "mesh.h"
+#include "object.h"
+
+#include "util_algorithm.h"
+#include "util_args.h"
+#include "util_function.h"
+#include "util_progress.h"
+#include "util_string.h"
+#include "util_task.h"
+#include "util_time.h"
+#include "util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+struct Options {
+	string benchmark;
+	int threads;
+	int runs;
+	int tasks;
+	int work;
+	int triangles;
+} options;
+
+/* Task Benchmark */
+
+static void work_task(float *result, int amount)
+{
+	float x = 0.0f;
+
+	for(int i = 0; i < amount; i++)
+		x = x * 0.999f + 1.0f;
+
+	*result = x;
+}
+
+static void nested_task(TaskPool *pool, float *results, int num, int amount)
+{
+	/* pushed from a worker thread, so these go into its own queue */
+	for(int i = 0; i < num; i++)
+		pool->push(function_bind(&work_task, &results[i], amount));
+}
+
+static double task_bench_flat(vector<float>& results)
+{
+	TaskPool pool;
+	double start = time_dt();
+
+	for(int i = 0; i < options.tasks; i++)
+		pool.push(function_bind(&work_task, &results[i], options.work));
+
+	pool.wait_work();
+
+	return time_dt() - start;
+}
+
+static double task_bench_nested(vector<float>& results)
+{
+	const int num_children = 64;
+	TaskPool pool;
+	double start = time_dt();
+
+	for(int i = 0; i < options.tasks; i += num_children) {
+		int num = min(num_children, options.tasks - i);
+		pool.push(function_bind(&nested_task, &pool, &results[i], num, options.work));
+	}
+
+	pool.wait_work();
+
+	return time_dt() - start;
+}
+
+static double task_bench_unbalanced(vector<float>& results)
+{
+	TaskPool pool;
+	double start = time_dt();
+
+	/* one task in 16 is 32 times longer than the others */
+	for(int i = 0; i < options.tasks; i++) {
+		int amount = (i % 16 == 0)? options.work * 32: options.work;
+		pool.push(function_bind(&work_task, &results[i], amount));
+	}
+
+	pool.wait_work();
+
+	return time_dt() - start;
+}
+
+static void task_bench_run(const char *name, double (*bench)(vector<float>&))
+{
+	vector<float> results(options.tasks);
+	double best = 0.0, total = 0.0;
+
+	for(int run = 0; run < options.runs; run++) {
+		double t = bench(results);
+
+		best = (run == 0)? t: min(best, t);
+		total += t;
+	}
+
+	printf("%-12s %10d %12.4f %12.4f %14.0f\n", name, options.tasks,
+		best, total / options.runs, options.tasks / best);
+}
+
+static void task_bench()
+{
+	TaskScheduler::init(options.threads);
+
+	printf("Task scheduler, %d threads, %d work per task, best of %d runs\n\n",
+		TaskScheduler::num_threads(), options.work, options.runs);
+	printf("%-12s %10s %12s %12s %14s\n", "benchmark", "tasks", "best (s)", "average (s)", "tasks/s");
+
+	task_bench_run("flat", task_bench_flat);
+	task_bench_run("nested", task_bench_nested);
+	task_bench_run("unbalanced", task_bench_unbalanced);
+
+	TaskScheduler::exit();
+}
+
+/* BVH Benchmark */
+
+static float bvh_bench_random(uint *seed)
+{
+	*seed = *seed * 1103515245u + 12345u;
+	return (float)((*seed >> 8) & 0xFFFFFF) / (float)0x1000000;
+}
+
+/* small triangles in clusters of different size and density, like the
+ * objects of a scene, so the tree is not trivially balanced */
+static void bvh_bench_mesh(Mesh *mesh, int num_triangles)
+{
+	const int num_clusters = 64;
+	float3 centers[num_clusters];
+	float radius[num_clusters];
+	uint seed = 1;
+
+	for(int i = 0; i < num_clusters; i++) {
+		centers[i] = make_float3(bvh_bench_random(&seed), bvh_bench_random(&seed), bvh_bench_random(&seed));
+		radius[i] = 0.01f + 0.1f*bvh_bench_random(&seed);
+	}
+
+	mesh->verts.resize(num_triangles*3);
+
+	for(int i = 0; i < num_triangles; i++) {
+		int c = (int)(bvh_bench_random(&seed)*bvh_bench_random(&seed)*num_clusters);
+		float3 center = centers[c] + radius[c]*make_float3(
+			2.0f*bvh_bench_random(&seed) - 1.0f,
+			2.0f*bvh_bench_random(&seed) - 1.0f,
+			2.0f*bvh_bench_random(&seed) - 1.0f);
+
+		for(int j = 0; j < 3; j++) {
+			float3 offset = make_float3(
+				bvh_bench_random(&seed) - 0.5f,
+				bvh_bench_random(&seed) - 0.5f,
+				bvh_bench_random(&seed) - 0.5f);
+
+			mesh->verts[i*3 + j] = center + 0.01f*offset;
+		}
+
+		mesh->add_triangle(i*3, i*3 + 1, i*3 + 2, 0, false);
+	}
+
+	mesh->compute_bounds();
+}
+
+static void bvh_bench_run(const char *name, bool use_qbvh, bool use_spatial_split,
+	const vector<Object*>& objects)
+{
+	BVHParams params;
+	params.use_qbvh = use_qbvh;
+	params.use_spatial_split = use_spatial_split;
+
+	double best = 0.0, total = 0.0;
+	float SAH = 0.0f;
+	int num_nodes = 0;
+
+	for(int run = 0; run < options.runs; run++) {
+		Progress progress;
+		BVH *bvh = BVH::create(params, objects);
+
+		double start = time_dt();
+		bvh->build(progress);
+		double t = time_dt() - start;
+
+		best = (run == 0)? t: min(best, t);
+		total += t;
+
+		SAH = bvh->pack.SAH;
+		num_nodes = (int)bvh->pack.nodes.size() / (use_qbvh? BVH_QNODE_SIZE: BVH_NODE_SIZE);
+
+		delete bvh;
+	}
+
+	printf("%-14s %12.4f %12.4f %12d %12.2f\n", name,
+		best, total / options.runs, num_nodes, SAH);
+}
+
+static void bvh_bench()
+{
+	TaskScheduler::init(options.threads);
+
+	Mesh mesh;
+	bvh_bench_mesh(&mesh, options.triangles);
+
+	Object object;
+	object.mesh = &mesh;
+
+	vector<Object*> objects;
+	objects.push_back(&object);
+
+	printf("BVH build, %d triangles, %d threads, best of %d runs\n\n",
+		options.triangles, TaskScheduler::num_threads(), options.runs);
+	printf("%-14s %12s %12s %12s %12s\n", "benchmark", "best (s)", "average (s)", "nodes", "SAH");
+
+	bvh_bench_run("binary", false, false, objects);
+	bvh_bench_run("binary split", false, true, objects);
+	bvh_bench_run("qbvh", true, false, objects);
+	bvh_bench_run("qbvh split", true, true, objects);
+
+	TaskScheduler::exit();
+}
+
+/* Options */
+
+static int files_parse(int argc, const char *argv[])
+{
+	if(argc > 0)
+		options.benchmark = argv[0];
+
+	return 0;
+}
+
+static void options_parse(int argc, const char **argv)
+{
+	options.benchmark = "";
+	options.threads = 0;
+	options.runs = 5;
+	options.tasks = 100000;
+	options.work = 1000;
+	options.triangles = 250000;
+
+	/* parse options */
+	ArgParse ap;
+	bool help = false;
+
+	ap.options ("Usage: cycles_bench [options] task|bvh",
+		"%*", files_parse, "",
+		"--threads %d", &options.threads, "Number of threads, 0 for all processors",
+		"--runs %d", &options.runs, "Number of times to run each benchmark",
+		"--tasks %d", &options.tasks, "Number of tasks (task)",
+		"--work %d", &options.work, "Loop iterations per task (task)",
+		"--triangles %d", &options.triangles, "Number of triangles (bvh)",
+		"--help", &help, "Print help message",
+		NULL);
+
+	if(ap.parse(argc, argv) < 0) {
+		fprintf(stderr, "%s\n", ap.geterror().c_str());
+		ap.usage();
+		exit(EXIT_FAILURE);
+	}
+	else if(help || (options.benchmark != "task" && options.benchmark != "bvh")) {
+		ap.usage();
+		exit(EXIT_SUCCESS);
+	}
+
+	if(options.runs < 1 || options.tasks < 1 || options.triangles < 1 || options.work < 0) {
+		fprintf(stderr, "Runs, tasks and triangles must be at least 1, work can't be negative.\n");
+		exit(EXIT_FAILURE);
+	}
+}
+
+CCL_NAMESPACE_END
+
+using namespace ccl;
+
+int main(int argc, const char **argv)
+{
+	options_parse(argc, argv);
+
+	if(options.benchmark == "task")
+		task_bench();
+	else if(options.benchmark == "bvh")
+		bvh_bench();
+
+	return 0;
+}
@@ -124,9 +124,22 @@ static void scene_init(int width, int height)
 	}
 }
 
+static void session_print_stats()
+{
+	double mesh_time, displacement_time, mesh_bvh_time, scene_bvh_time;
+
+	options.session->progress.get_mesh_update_times(mesh_time, displacement_time, mesh_bvh_time, scene_bvh_time);
+
+	printf("\nMesh update: meshes %.3fs, displacement %.3fs, mesh BVH %.3fs, scene BVH %.3fs\n",
+		mesh_time, displacement_time, mesh_bvh_time, scene_bvh_time);
+}
+
 static void session_exit()
 {
 	if(options.session) {
+		if(options.session_params.background && !options.quiet)
+			session_print_stats();
+
 		delete options.session;
 		options.session = NULL;
 	}
@@ -164,6 +164,28 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
                 default=False,
                 )
 
+        cls.use_adaptive_sampling = BoolProperty(
+                name="Adaptive Sampling",
+                description="Stop rendering tiles early once their noise level drops below the threshold, "
+                            "and spend the skipped samples on tiles that are still noisy (Sobol pattern only), "
+                            "only used for final renders on the CPU without progressive refine",
+                default=False,
+                )
+        cls.adaptive_threshold = FloatProperty(
+                name="Noise Threshold",
+                description="Noise level below which a tile is considered converged, tested for every 8x8 block of "
+                            "pixels in the tile, lower values give less noise",
+                min=0.0001, max=1.0,
+                default=0.01,
+                precision=4,
+                )
+        cls.adaptive_min_samples = IntProperty(
+                name="Min Samples",
+                description="Minimum number of samples to render for each tile before testing it for convergence",
+                min=2, max=2147483647,
+                default=16,
+                )
+
         cls.aa_samples = IntProperty(
                 name="AA Samples",
                 description="Number of antialiasing samples to render for each pixel",
@@ -221,6 +243,13 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
                 default='SOBOL',
                 )
 
+        cls.use_light_tree = BoolProperty(
+                name="Light Tree",
+                description="Sample lights using a hierarchy that takes distance and orientation into account, "
+                            "reducing noise in scenes with many lights (path tracing integrator only)",
+                default=False,
+                )
+
         cls.use_layer_samples = EnumProperty(
                 name="Layer Samples",
                 description="How to use per render layer sample settings",
@@ -387,6 +416,30 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
                 description="Cache last built BVH to disk for faster re-render if no geometry changed",
                 default=False,
                 )
+        cls.cache_size = IntProperty(
+                name="Cache Size",
+                description="Maximum size of BVH cache files on disk in MB, least recently used files are removed first",
+                min=0, max=1048576,
+                default=1024,
+                )
+        cls.use_dynamic_bvh = BoolProperty(
+                name="Dynamic BVH",
+                description="Only refit deformed meshes and rebuild the object level BVH between frames "
+                            "with persistent data, at the cost of slower render time",
+                default=False,
+                )
+        cls.use_texture_cache = BoolProperty(
+                name="Texture Cache",
+                description="Load image textures on demand in tiles, keeping memory usage within "
+                            "the cache size (CPU and SVM only)",
+                default=False,
+                )
+        cls.texture_cache_size = IntProperty(
+                name="Cache Size",
+                description="Maximum memory used for image textures by the texture cache, in megabytes",
+                min=64, max=1048576,
+                default=4096,
+                )
         cls.tile_order = EnumProperty(
                 name="Tile Order",
                 description="Tile order for rendering",
@@ -143,6 +143,20 @@ class CyclesRender_PT_sampling(CyclesButtonsPanel, Panel):
         if cscene.feature_set == 'EXPERIMENTAL' and (device_type == 'NONE' or cscene.device == 'CPU'):
             layout.row().prop(cscene, "sampling_pattern", text="Pattern")
 
+        if cscene.progressive == 'PATH':
+            layout.row().prop(cscene, "use_light_tree")
+
+        if device_type == 'NONE' or cscene.device == 'CPU':
+            split = layout.split()
+
+            col = split.column()
+            col.prop(cscene, "use_adaptive_sampling")
+
+            col = split.column(align=True)
+            col.active = cscene.use_adaptive_sampling
+            col.prop(cscene, "adaptive_threshold", text="Threshold")
+            col.prop(cscene, "adaptive_min_samples")
+
         for rl in scene.render.layers:
             if rl.samples > 0:
                 layout.separator()
@@ -281,13 +295,26 @@ class CyclesRender_PT_performance(CyclesButtonsPanel, Panel):
 
         col.label(text="Final Render:")
         col.prop(cscene, "use_cache")
+        sub = col.column()
+        sub.active = cscene.use_cache
+        sub.prop(cscene, "cache_size")
         col.prop(rd, "use_persistent_data", text="Persistent Images")
+        sub = col.column()
+        sub.active = rd.use_persistent_data
+        sub.prop(cscene, "use_dynamic_bvh")
 
         col.separator()
 
         col.label(text="Acceleration structure:")
         col.prop(cscene, "debug_use_spatial_splits")
 
+        col.separator()
+
+        col.prop(cscene, "use_texture_cache")
+        sub = col.column()
+        sub.active = cscene.use_texture_cache
+        sub.prop(cscene, "texture_cache_size")
+
 
 class CyclesRender_PT_opengl(CyclesButtonsPanel, Panel):
     bl_label = "OpenGL Render"
@@ -379,6 +379,10 @@ void BlenderSession::render()
 			}
 		}
 
+		/* internal pass for the adaptive sampling noise estimate */
+		if(session_params.adaptive_threshold > 0.0f)
+			Pass::add(PASS_ADAPTIVE_AUX, passes);
+
 		buffer_params.passes = passes;
 		scene->film->tag_passes_update(scene, passes);
 		scene->film->tag_update(scene);
@@ -772,12 +776,16 @@ bool BlenderSession::builtin_image_pixels(const string &builtin_name, void *buil
 			}
 		}
 
-		/* premultiply, byte images are always straight for blender */
-		unsigned char *cp = pixels;
-		for(int i = 0; i < width * height; i++, cp += channels) {
-			cp[0] = (cp[0] * cp[3]) >> 8;
-			cp[1] = (cp[1] * cp[3]) >> 8;
-			cp[2] = (cp[2] * cp[3]) >> 8;
+		/* premultiply, byte images are always straight for blender. only RGBA
+		 * has alpha, single channel images are stored compact at one byte per
+		 * pixel. */
+		if(channels == 4) {
+			unsigned char *cp = pixels;
+			for(int i = 0; i < width * height; i++, cp += channels) {
+				cp[0] = (cp[0] * cp[3]) >> 8;
+				cp[1] = (cp[1] * cp[3]) >> 8;
+				cp[2] = (cp[2] * cp[3]) >> 8;
+			}
 		}
 
 		return true;
@@ -220,6 +220,8 @@ void BlenderSync::sync_integrator()
 	if(experimental)
 		integrator->sampling_pattern = (SamplingPattern)RNA_enum_get(&cscene, "sampling_pattern");
 
+	integrator->use_light_tree = get_boolean(cscene, "use_light_tree");
+
 	if(integrator->modified(previntegrator))
 		integrator->tag_update(scene);
 }
@@ -345,19 +347,27 @@ SceneParams BlenderSync::get_scene_params(BL::Scene b_scene, bool background)
 	else if(shadingsystem == 1)
 		params.shadingsystem = SceneParams::OSL;
 	
-	if(background)
-		params.bvh_type = SceneParams::BVH_STATIC;
-	else
-		params.bvh_type = (SceneParams::BVHType)RNA_enum_get(&cscene, "debug_bvh_type");
-
 	params.use_bvh_spatial_split = RNA_boolean_get(&cscene, "debug_use_spatial_splits");
 	params.use_bvh_cache = (background)? RNA_boolean_get(&cscene, "use_cache"): false;
+	params.bvh_cache_size = RNA_int_get(&cscene, "cache_size");
+
+	params.use_texture_cache = RNA_boolean_get(&cscene, "use_texture_cache");
+	params.texture_cache_size = RNA_int_get(&cscene, "texture_cache_size");
 
 	if(background && params.shadingsystem != SceneParams::OSL)
 		params.persistent_data = r.use_persistent_data();
 	else
 		params.persistent_data = false;
 
+	/* for animation renders with persistent data, a dynamic BVH avoids full
+	 * rebuilds when only some meshes deform */
+	if(!background)
+		params.bvh_type = (SceneParams::BVHType)RNA_enum_get(&cscene, "debug_bvh_type");
+	else if(params.persistent_data && RNA_boolean_get(&cscene, "use_dynamic_bvh"))
+		params.bvh_type = SceneParams::BVH_DYNAMIC;
+	else
+		params.bvh_type = SceneParams::BVH_STATIC;
+
 	return params;
 }
 
@@ -486,6 +496,14 @@ SessionParams BlenderSync::get_session_params(BL::RenderEngine b_engine, BL::Use
 	else
 		params.progressive = true;
 
+	/* adaptive sampling, only supported for tiled final renders on the CPU */
+	if(background && !params.progressive && params.device.type == DEVICE_CPU &&
+	   get_boolean(cscene, "use_adaptive_sampling"))
+	{
+		params.adaptive_threshold = get_float(cscene, "adaptive_threshold");
+		params.adaptive_min_samples = get_int(cscene, "adaptive_min_samples");
+	}
+
 	/* shading system - scene level needs full refresh */
 	int shadingsystem = RNA_boolean_get(&cscene, "shading_system");
 
@@ -25,12 +25,14 @@
 #include "bvh_node.h"
 #include "bvh_params.h"
 
+#include "util_algorithm.h"
 #include "util_cache.h"
 #include "util_debug.h"
 #include "util_foreach.h"
 #include "util_map.h"
 #include "util_progress.h"
 #include "util_system.h"
+#include "util_task.h"
 #include "util_types.h"
 #include "util_math.h"
 
@@ -59,6 +61,7 @@ struct BVHStackEntry
 BVH::BVH(const BVHParams& params_, const vector<Object*>& objects_)
 : params(params_), objects(objects_)
 {
+	instances_prim_offset = 0;
 }
 
 BVH *BVH::create(const BVHParams& params, const vector<Object*>& objects)
@@ -73,7 +76,12 @@ BVH *BVH::create(const BVHParams& params, const vector<Object*>& objects)
 
 bool BVH::cache_read(CacheData& key)
 {
-	key.add(system_cpu_bits());
+	/* key buffers are only hashed on lookup, so must not point to temporaries */
+	static const int version = BVH_CACHE_VERSION;
+	static const int cpu_bits = system_cpu_bits();
+
+	key.add(version);
+	key.add(cpu_bits);
 	key.add(&params, sizeof(params));
 
 	foreach(Object *ob, objects) {
@@ -86,7 +94,7 @@ bool BVH::cache_read(CacheData& key)
 		key.add(&ob->mesh->transform_applied, sizeof(bool));
 	}
 
-	CacheData value;
+	CacheData& value = cache_data;
 
 	if(Cache::global.lookup(key, value)) {
 		cache_filename = key.get_filename();
@@ -152,18 +160,20 @@ void BVH::clear_cache_except()
 
 void BVH::build(Progress& progress)
 {
-	progress.set_substatus("Building BVH");
-
 	/* cache read */
 	CacheData key("bvh");
 
 	if(params.use_cache) {
 		progress.set_substatus("Looking in BVH cache");
 
-		if(cache_read(key))
+		if(cache_read(key)) {
+			progress.set_substatus("Read BVH from cache");
 			return;
+		}
 	}
 
+	progress.set_substatus("Building BVH");
+
 	/* build nodes */
 	vector<int> prim_segment;
 	vector<int> prim_index;
@@ -202,8 +212,7 @@ void BVH::build(Progress& progress)
 
 	/* pack nodes */
 	progress.set_substatus("Packing BVH nodes");
-	array<int> tmp_prim_object = pack.prim_object;
-	pack_nodes(tmp_prim_object, root);
+	pack_nodes(root);
 	
 	/* free build nodes */
 	root->deleteSubtree();
@@ -234,6 +243,51 @@ void BVH::refit(Progress& progress)
 	refit_nodes();
 }
 
+/* Updating */
+
+bool BVH::update(Progress& progress, const set<Mesh*>& updated_meshes)
+{
+	/* for the top level BVH, rebuild the tree over objects while reusing the
+	 * merged instance data, of which only the data for refitted meshes is
+	 * copied again. returns false when a full build is needed instead */
+	if(!instances_valid())
+		return false;
+
+	progress.set_substatus("Building BVH");
+
+	vector<int> prim_segment;
+	vector<int> prim_index;
+	vector<int> prim_object;
+
+	BVHBuild bvh_build(objects, prim_segment, prim_index, prim_object, params, progress);
+	BVHNode *root = bvh_build.run();
+
+	if(progress.get_cancel()) {
+		if(root) root->deleteSubtree();
+		return true;
+	}
+
+	/* top level primitives are stored before the instances */
+	if(prim_index.size() != instances_prim_offset) {
+		root->deleteSubtree();
+		return false;
+	}
+
+	for(size_t i = 0; i < prim_index.size(); i++) {
+		pack.prim_segment[i] = prim_segment[i];
+		pack.prim_index[i] = prim_index[i];
+		pack.prim_object[i] = prim_object[i];
+	}
+
+	progress.set_substatus("Packing BVH nodes");
+	pack_primitives_range(0, prim_index.size());
+
+	bool packed = pack_nodes(root, &updated_meshes);
+	root->deleteSubtree();
+
+	return packed;
+}
+
 /* Triangles */
 
 void BVH::pack_triangle(int idx, float4 woop[3])
@@ -310,17 +364,11 @@ void BVH::pack_curve_segment(int idx, float4 woop[3])
 
 }
 
-void BVH::pack_primitives()
+void BVH::pack_primitives_range(size_t begin, size_t end)
 {
 	int nsize = TRI_NODE_SIZE;
-	size_t tidx_size = pack.prim_index.size();
-
-	pack.tri_woop.clear();
-	pack.tri_woop.resize(tidx_size * nsize);
-	pack.prim_visibility.clear();
-	pack.prim_visibility.resize(tidx_size);
 
-	for(unsigned int i = 0; i < tidx_size; i++) {
+	for(size_t i = begin; i < end; i++) {
 		if(pack.prim_index[i] != -1) {
 			float4 woop[3];
 
@@ -345,6 +393,26 @@ void BVH::pack_primitives()
 	}
 }
 
+void BVH::pack_primitives()
+{
+	int nsize = TRI_NODE_SIZE;
+	size_t tidx_size = pack.prim_index.size();
+
+	pack.tri_woop.clear();
+	pack.tri_woop.resize(tidx_size * nsize);
+	pack.prim_visibility.clear();
+	pack.prim_visibility.resize(tidx_size);
+
+	TaskPool pool;
+
+	for(size_t begin = 0; begin < tidx_size; begin += PACK_TASK_SIZE) {
+		size_t end = min(begin + PACK_TASK_SIZE, tidx_size);
+		pool.push(function_bind(&BVH::pack_primitives_range, this, begin, end));
+	}
+
+	pool.wait_work();
+}
+
 /* Pack Instances */
 
 void BVH::pack_instances(size_t nodes_size)
@@ -365,59 +433,25 @@ void BVH::pack_instances(size_t nodes_size)
 				pack.prim_index[i] += objects[pack.prim_object[i]]->mesh->tri_offset;
 		}
 
-	/* track offsets of instanced BVH data in global array */
-	size_t prim_offset = pack.prim_index.size();
-	size_t nodes_offset = nodes_size;
-
 	/* clear array that gives the node indexes for instanced objects */
 	pack.object_node.clear();
+	pack.object_node.resize(objects.size());
 
-	/* reserve */
+	/* compute offsets of instanced BVH data in global array */
 	size_t prim_index_size = pack.prim_index.size();
 	size_t tri_woop_size = pack.tri_woop.size();
-
-	size_t pack_prim_index_offset = prim_index_size;
-	size_t pack_tri_woop_offset = tri_woop_size;
-	size_t pack_nodes_offset = nodes_size;
 	size_t object_offset = 0;
 
 	map<Mesh*, int> mesh_map;
 
+	instances.clear();
+	instance_meshes.clear();
+
 	foreach(Object *ob, objects) {
 		Mesh *mesh = ob->mesh;
 		BVH *bvh = mesh->bvh;
 
-		if(!mesh->transform_applied) {
-			if(mesh_map.find(mesh) == mesh_map.end()) {
-				prim_index_size += bvh->pack.prim_index.size();
-				tri_woop_size += bvh->pack.tri_woop.size();
-				nodes_size += bvh->pack.nodes.size()*nsize;
-
-				mesh_map[mesh] = 1;
-			}
-		}
-	}
-
-	mesh_map.clear();
-
-	pack.prim_index.resize(prim_index_size);
-	pack.prim_segment.resize(prim_index_size);
-	pack.prim_object.resize(prim_index_size);
-	pack.prim_visibility.resize(prim_index_size);
-	pack.tri_woop.resize(tri_woop_size);
-	pack.nodes.resize(nodes_size);
-	pack.object_node.resize(objects.size());
-
-	int *pack_prim_index = (pack.prim_index.size())? &pack.prim_index[0]: NULL;
-	int *pack_prim_segment = (pack.prim_segment.size())? &pack.prim_segment[0]: NULL;
-	int *pack_prim_object = (pack.prim_object.size())? &pack.prim_object[0]: NULL;
-	uint *pack_prim_visibility = (pack.prim_visibility.size())? &pack.prim_visibility[0]: NULL;
-	float4 *pack_tri_woop = (pack.tri_woop.size())? &pack.tri_woop[0]: NULL;
-	int4 *pack_nodes = (pack.nodes.size())? &pack.nodes[0]: NULL;
-
-	/* merge */
-	foreach(Object *ob, objects) {
-		Mesh *mesh = ob->mesh;
+		instance_meshes.push_back(mesh);
 
 		/* if mesh transform is applied, that means it's already in the top
 		 * level BVH, and we don't need to merge it in */
@@ -430,92 +464,312 @@ void BVH::pack_instances(size_t nodes_size)
 		 * node offset for this object */
 		map<Mesh*, int>::iterator it = mesh_map.find(mesh);
 
-		if(mesh_map.find(mesh) != mesh_map.end()) {
-			int noffset = it->second;
-			pack.object_node[object_offset++] = noffset;
+		if(it != mesh_map.end()) {
+			pack.object_node[object_offset++] = it->second;
 			continue;
 		}
 
-		BVH *bvh = mesh->bvh;
+		BVHInstance instance;
 
-		int noffset = nodes_offset/nsize;
-		int mesh_tri_offset = mesh->tri_offset;
-		int mesh_curve_offset = mesh->curve_offset;
+		instance.mesh = mesh;
+		instance.tri_offset = mesh->tri_offset;
+		instance.curve_offset = mesh->curve_offset;
+		instance.prim_offset = prim_index_size;
+		instance.tri_woop_offset = tri_woop_size;
+		instance.nodes_offset = nodes_size;
+		instance.num_prims = bvh->pack.prim_index.size();
+		instance.num_tri_woop = bvh->pack.tri_woop.size();
+		instance.num_nodes = bvh->pack.nodes.size();
+
+		prim_index_size += instance.num_prims;
+		tri_woop_size += instance.num_tri_woop;
+		nodes_size += instance.num_nodes;
 
 		/* fill in node indexes for instances */
+		int noffset = instance.nodes_offset/nsize;
+
 		if((bvh->pack.is_leaf.size() != 0) && bvh->pack.is_leaf[0])
 			pack.object_node[object_offset++] = -noffset-1;
 		else
 			pack.object_node[object_offset++] = noffset;
 
 		mesh_map[mesh] = pack.object_node[object_offset-1];
+		instances.push_back(instance);
+	}
+
+	instances_prim_offset = pack.prim_index.size();
+
+	pack.prim_index.resize(prim_index_size);
+	pack.prim_segment.resize(prim_index_size);
+	pack.prim_object.resize(prim_index_size);
+	pack.prim_visibility.resize(prim_index_size);
+	pack.tri_woop.resize(tri_woop_size);
+	pack.nodes.resize(nodes_size);
+
+	/* merge */
+	TaskPool pool;
+
+	foreach(const BVHInstance& instance, instances)
+		pool.push(function_bind(&BVH::pack_instance, this, instance));
+
+	pool.wait_work();
+}
+
+void BVH::pack_instance(const BVHInstance& instance)
+{
+	bool use_qbvh = params.use_qbvh;
+	size_t nsize = (use_qbvh)? BVH_QNODE_SIZE: BVH_NODE_SIZE;
+
+	BVH *bvh = instance.mesh->bvh;
+	int noffset = instance.nodes_offset/nsize;
+	int prim_offset = instance.prim_offset;
+
+	/* merge primitive and object indexes */
+	if(instance.num_prims) {
+		int *pack_prim_index = &pack.prim_index[instance.prim_offset];
+		int *pack_prim_segment = &pack.prim_segment[instance.prim_offset];
+		int *pack_prim_object = &pack.prim_object[instance.prim_offset];
+		uint *pack_prim_visibility = &pack.prim_visibility[instance.prim_offset];
+
+		int *bvh_prim_index = &bvh->pack.prim_index[0];
+		int *bvh_prim_segment = &bvh->pack.prim_segment[0];
+		uint *bvh_prim_visibility = &bvh->pack.prim_visibility[0];
 
-		/* merge primitive and object indexes */
-		if(bvh->pack.prim_index.size()) {
-			size_t bvh_prim_index_size = bvh->pack.prim_index.size();
-			int *bvh_prim_index = &bvh->pack.prim_index[0];
-			int *bvh_prim_segment = &bvh->pack.prim_segment[0];
-			uint *bvh_prim_visibility = &bvh->pack.prim_visibility[0];
-
-			for(size_t i = 0; i < bvh_prim_index_size; i++) {
-				if(bvh->pack.prim_segment[i] != ~0)
-					pack_prim_index[pack_prim_index_offset] = bvh_prim_index[i] + mesh_curve_offset;
-				else
-					pack_prim_index[pack_prim_index_offset] = bvh_prim_index[i] + mesh_tri_offset;
-
-				pack_prim_segment[pack_prim_index_offset] = bvh_prim_segment[i];
-				pack_prim_visibility[pack_prim_index_offset] = bvh_prim_visibility[i];
-				pack_prim_object[pack_prim_index_offset] = 0;  // unused for instances
-				pack_prim_index_offset++;
+		for(size_t i = 0; i < instance.num_prims; i++) {
+			if(bvh_prim_segment[i] != ~0)
+				pack_prim_index[i] = bvh_prim_index[i] + instance.curve_offset;
+			else
+				pack_prim_index[i] = bvh_prim_index[i] + instance.tri_offset;
+
+			pack_prim_segment[i] = bvh_prim_segment[i];
+			pack_prim_visibility[i] = bvh_prim_visibility[i];
+			pack_prim_object[i] = 0;  // unused for instances
+		}
+	}
+
+	/* merge triangle intersection data */
+	if(instance.num_tri_woop) {
+		memcpy(&pack.tri_woop[instance.tri_woop_offset], &bvh->pack.tri_woop[0],
+			instance.num_tri_woop*sizeof(float4));
+	}
+
+	/* merge nodes */
+	if(instance.num_nodes) {
+		int4 *pack_nodes = &pack.nodes[instance.nodes_offset];
+		size_t nsize_bbox = (use_qbvh)? nsize-2: nsize-1;
+		int4 *bvh_nodes = &bvh->pack.nodes[0];
+		size_t bvh_nodes_size = instance.num_nodes;
+		int *bvh_is_leaf = (bvh->pack.is_leaf.size() != 0) ? &bvh->pack.is_leaf[0] : NULL;
+
+		for(size_t i = 0, j = 0; i < bvh_nodes_size; i+=nsize, j++) {
+			memcpy(pack_nodes + i, bvh_nodes + i, nsize_bbox*sizeof(int4));
+
+			/* modify offsets into arrays */
+			int4 data = bvh_nodes[i + nsize_bbox];
+
+			if(bvh_is_leaf && bvh_is_leaf[j]) {
+				data.x += prim_offset;
+				data.y += prim_offset;
 			}
+			else {
+				data.x += (data.x < 0)? -noffset: noffset;
+				data.y += (data.y < 0)? -noffset: noffset;
+
+				if(use_qbvh) {
+					data.z += (data.z < 0)? -noffset: noffset;
+					data.w += (data.w < 0)? -noffset: noffset;
+				}
+			}
+
+			pack_nodes[i + nsize_bbox] = data;
+
+			if(use_qbvh)
+				pack_nodes[i + nsize_bbox+1] = bvh_nodes[i + nsize_bbox+1];
 		}
+	}
+}
+
+bool BVH::instances_valid()
+{
+	/* test if merged instance data can be reused, which is the case when the
+	 * objects use the same meshes, and their BVH's were only refitted */
+	if(!params.top_level || instance_meshes.size() != objects.size())
+		return false;
 
-		/* merge triangle intersection data */
-		if(bvh->pack.tri_woop.size()) {
-			memcpy(pack_tri_woop + pack_tri_woop_offset, &bvh->pack.tri_woop[0],
-				bvh->pack.tri_woop.size()*sizeof(float4));
-			pack_tri_woop_offset += bvh->pack.tri_woop.size();
+	for(size_t i = 0; i < objects.size(); i++) {
+		Mesh *mesh = objects[i]->mesh;
+
+		if(mesh != instance_meshes[i] || mesh->transform_applied)
+			return false;
+	}
+
+	foreach(const BVHInstance& instance, instances) {
+		Mesh *mesh = instance.mesh;
+		BVH *bvh = mesh->bvh;
+
+		if(!bvh ||
+		   instance.tri_offset != mesh->tri_offset ||
+		   instance.curve_offset != mesh->curve_offset ||
+		   instance.num_prims != bvh->pack.prim_index.size() ||
+		   instance.num_tri_woop != bvh->pack.tri_woop.size() ||
+		   instance.num_nodes != bvh->pack.nodes.size())
+			return false;
+	}
+
+	return true;
+}
+
+/* Pack Nodes */
+
+void BVH::count_subtree(const BVHNode *node, int *num)
+{
+	/* count nodes as they will be packed, which for QBVH is not the same as
+	 * the number of nodes in the binary tree */
+	(*num)++;
+
+	if(!node->is_leaf()) {
+		const BVHNode *children[4];
+		int numchildren = pack_children(node, children);
+
+		for(int i = 0; i < numchildren; i++)
+			count_subtree(children[i], num);
+	}
+}
+
+void BVH::pack_subtree(const BVHStackEntry *root, int next_idx)
+{
+	vector<BVHStackEntry> stack;
+	stack.reserve(BVHParams::MAX_DEPTH*4);
+	stack.push_back(*root);
+
+	while(stack.size()) {
+		BVHStackEntry e = stack.back();
+		stack.pop_back();
+
+		pack.is_leaf[e.idx] = e.node->is_leaf();
+
+		if(e.node->is_leaf()) {
+			/* leaf node */
+			const LeafNode* leaf = reinterpret_cast<const LeafNode*>(e.node);
+			pack_leaf(e, leaf);
 		}
+		else {
+			/* inner node */
+			const BVHNode *children[4];
+			int numchildren = pack_children(e.node, children);
 
-		/* merge nodes */
-		if(bvh->pack.nodes.size()) {
-			size_t nsize_bbox = (use_qbvh)? nsize-2: nsize-1;
-			int4 *bvh_nodes = &bvh->pack.nodes[0];
-			size_t bvh_nodes_size = bvh->pack.nodes.size(); 
-			int *bvh_is_leaf = (bvh->pack.is_leaf.size() != 0) ? &bvh->pack.is_leaf[0] : NULL;
+			/* push entries on the stack */
+			for(int i = 0; i < numchildren; i++)
+				stack.push_back(BVHStackEntry(children[i], next_idx++));
 
-			for(size_t i = 0, j = 0; i < bvh_nodes_size; i+=nsize, j++) {
-				memcpy(pack_nodes + pack_nodes_offset, bvh_nodes + i, nsize_bbox*sizeof(int4));
+			/* set node */
+			pack_inner(e, &stack[stack.size()-numchildren], numchildren);
+		}
+	}
+}
 
-				/* modify offsets into arrays */
-				int4 data = bvh_nodes[i + nsize_bbox];
+bool BVH::pack_nodes(const BVHNode *root, const set<Mesh*> *updated_meshes)
+{
+	/* expand the top of the tree breadth first, until there are enough
+	 * subtrees to pack in parallel. top nodes get the index of their place
+	 * in this array, children of a node are consecutive */
+	size_t num_subtrees = max(TaskScheduler::num_threads(), 1)*8;
+	vector<BVHStackEntry> entries;
+	vector<int> first_child;
+	size_t num_top = 0, num_open = 1;
 
-				if(bvh_is_leaf && bvh_is_leaf[j]) {
-					data.x += prim_offset;
-					data.y += prim_offset;
-				}
-				else {
-					data.x += (data.x < 0)? -noffset: noffset;
-					data.y += (data.y < 0)? -noffset: noffset;
+	entries.push_back(BVHStackEntry(root, 0));
 
-					if(use_qbvh) {
-						data.z += (data.z < 0)? -noffset: noffset;
-						data.w += (data.w < 0)? -noffset: noffset;
-					}
-				}
+	while(num_top < entries.size() && num_open < num_subtrees) {
+		const BVHNode *node = entries[num_top].node;
+		first_child.push_back(entries.size());
 
-				pack_nodes[pack_nodes_offset + nsize_bbox] = data;
+		if(!node->is_leaf()) {
+			const BVHNode *children[4];
+			int numchildren = pack_children(node, children);
 
-				if(use_qbvh)
-					pack_nodes[pack_nodes_offset + nsize_bbox+1] = bvh_nodes[i + nsize_bbox+1];
+			for(int i = 0; i < numchildren; i++)
+				entries.push_back(BVHStackEntry(children[i], entries.size()));
 
-				pack_nodes_offset += nsize;
-			}
+			num_open += numchildren;
 		}
 
-		nodes_offset += bvh->pack.nodes.size();
-		prim_offset += bvh->pack.prim_index.size();
+		num_open--;
+
+		num_top++;
+	}
+
+	/* count nodes in subtrees */
+	vector<int> subtree_size(entries.size() - num_top, 0);
+	TaskPool pool;
+
+	for(size_t i = num_top; i < entries.size(); i++)
+		pool.push(function_bind(&BVH::count_subtree, this, entries[i].node, &subtree_size[i - num_top]));
+
+	pool.wait_work();
+
+	/* subtree nodes are stored after the top nodes */
+	vector<int> subtree_offset(subtree_size.size());
+	size_t node_size = entries.size();
+
+	for(size_t i = 0; i < subtree_size.size(); i++) {
+		subtree_offset[i] = node_size;
+		node_size += subtree_size[i] - 1;
+	}
+
+	if(updated_meshes) {
+		/* reuse merged instances, which are stored after the top level nodes
+		 * and so only stay valid if the number of nodes is the same */
+		if(node_size != pack.is_leaf.size())
+			return false;
+
+		foreach(const BVHInstance& instance, instances)
+			if(updated_meshes->find(instance.mesh) != updated_meshes->end())
+				pool.push(function_bind(&BVH::pack_instance, this, instance));
+
+		pool.wait_work();
+	}
+	else {
+		/* resize arrays */
+		size_t nsize = (params.use_qbvh)? BVH_QNODE_SIZE: BVH_NODE_SIZE;
+
+		pack.nodes.clear();
+		pack.is_leaf.clear();
+		pack.is_leaf.resize(node_size);
+
+		/* for top level BVH, first merge existing BVH's so we know the offsets */
+		if(params.top_level)
+			pack_instances(node_size*nsize);
+		else
+			pack.nodes.resize(node_size*nsize);
 	}
+
+	/* pack subtrees in parallel */
+	for(size_t i = num_top; i < entries.size(); i++)
+		pool.push(function_bind(&BVH::pack_subtree, this, &entries[i], subtree_offset[i - num_top]));
+
+	/* pack top nodes meanwhile */
+	for(size_t i = 0; i < num_top; i++) {
+		const BVHStackEntry& e = entries[i];
+
+		pack.is_leaf[e.idx] = e.node->is_leaf();
+
+		if(e.node->is_leaf()) {
+			const LeafNode* leaf = reinterpret_cast<const LeafNode*>(e.node);
+			pack_leaf(e, leaf);
+		}
+		else {
+			int last_child = (i + 1 < num_top)? first_child[i + 1]: entries.size();
+			pack_inner(e, &entries[first_child[i]], last_child - first_child[i]);
+		}
+	}
+
+	pool.wait_work();
+
+	/* root index to start traversal at, to handle case of single leaf node */
+	pack.root_index = (pack.is_leaf[0])? -1: 0;
+
+	return true;
 }
 
 /* Regular BVH */
@@ -535,8 +789,11 @@ void RegularBVH::pack_leaf(const BVHStackEntry& e, const LeafNode *leaf)
 		pack_node(e.idx, leaf->m_bounds, leaf->m_bounds, leaf->m_lo, leaf->m_hi, leaf->m_visibility, leaf->m_visibility);
 }
 
-void RegularBVH::pack_inner(const BVHStackEntry& e, const BVHStackEntry& e0, const BVHStackEntry& e1)
+void RegularBVH::pack_inner(const BVHStackEntry& e, const BVHStackEntry *en, int num)
 {
+	const BVHStackEntry& e0 = en[0];
+	const BVHStackEntry& e1 = en[1];
+
 	pack_node(e.idx, e0.node->m_bounds, e1.node->m_bounds, e0.encodeIdx(), e1.encodeIdx(), e0.node->m_visibility, e1.node->m_visibility);
 }
 
@@ -553,49 +810,12 @@ void RegularBVH::pack_node(int idx, const BoundBox& b0, const BoundBox& b1, int
 	memcpy(&pack.nodes[idx * BVH_NODE_SIZE], data, sizeof(int4)*BVH_NODE_SIZE);
 }
 
-void RegularBVH::pack_nodes(const array<int>& prims, const BVHNode *root)
+int RegularBVH::pack_children(const BVHNode *node, const BVHNode *children[4])
 {
-	size_t node_size = root->getSubtreeSize(BVH_STAT_NODE_COUNT);
-
-	/* resize arrays */
-	pack.nodes.clear();
-	pack.is_leaf.clear();
-	pack.is_leaf.resize(node_size);
-
-	/* for top level BVH, first merge existing BVH's so we know the offsets */
-	if(params.top_level)
-		pack_instances(node_size*BVH_NODE_SIZE);
-	else
-		pack.nodes.resize(node_size*BVH_NODE_SIZE);
+	children[0] = node->get_child(0);
+	children[1] = node->get_child(1);
 
-	int nextNodeIdx = 0;
-
-	vector<BVHStackEntry> stack;
-	stack.reserve(BVHParams::MAX_DEPTH*2);
-	stack.push_back(BVHStackEntry(root, nextNodeIdx++));
-
-	while(stack.size()) {
-		BVHStackEntry e = stack.back();
-		stack.pop_back();
-
-		pack.is_leaf[e.idx] = e.node->is_leaf();
-
-		if(e.node->is_leaf()) {
-			/* leaf node */
-			const LeafNode* leaf = reinterpret_cast<const LeafNode*>(e.node);
-			pack_leaf(e, leaf);
-		}
-		else {
-			/* innner node */
-			stack.push_back(BVHStackEntry(e.node->get_child(0), nextNodeIdx++));
-			stack.push_back(BVHStackEntry(e.node->get_child(1), nextNodeIdx++));
-
-			pack_inner(e, stack[stack.size()-2], stack[stack.size()-1]);
-		}
-	}
-
-	/* root index to start traversal at, to handle case of single leaf node */
-	pack.root_index = (pack.is_leaf[0])? -1: 0;
+	return 2;
 }
 
 void RegularBVH::refit_nodes()
@@ -751,75 +971,30 @@ void QBVH::pack_inner(const BVHStackEntry& e, const BVHStackEntry *en, int num)
 
 /* Quad SIMD Nodes */
 
-void QBVH::pack_nodes(const array<int>& prims, const BVHNode *root)
+int QBVH::pack_children(const BVHNode *node, const BVHNode *children[4])
 {
-	size_t node_size = root->getSubtreeSize(BVH_STAT_NODE_COUNT);
-
-	/* resize arrays */
-	pack.nodes.clear();
-	pack.is_leaf.clear();
-	pack.is_leaf.resize(node_size);
-
-	/* for top level BVH, first merge existing BVH's so we know the offsets */
-	if(params.top_level)
-		pack_instances(node_size*BVH_QNODE_SIZE);
-	else
-		pack.nodes.resize(node_size*BVH_QNODE_SIZE);
+	/* collect nodes, skipping a level of the binary tree */
+	const BVHNode *node0 = node->get_child(0);
+	const BVHNode *node1 = node->get_child(1);
+	int numnodes = 0;
 
-	int nextNodeIdx = 0;
-
-	vector<BVHStackEntry> stack;
-	stack.reserve(BVHParams::MAX_DEPTH*2);
-	stack.push_back(BVHStackEntry(root, nextNodeIdx++));
-
-	while(stack.size()) {
-		BVHStackEntry e = stack.back();
-		stack.pop_back();
-
-		pack.is_leaf[e.idx] = e.node->is_leaf();
-
-		if(e.node->is_leaf()) {
-			/* leaf node */
-			const LeafNode* leaf = reinterpret_cast<const LeafNode*>(e.node);
-			pack_leaf(e, leaf);
-		}
-		else {
-			/* inner node */
-			const BVHNode *node = e.node;
-			const BVHNode *node0 = node->get_child(0);
-			const BVHNode *node1 = node->get_child(1);
-
-			/* collect nodes */
-			const BVHNode *nodes[4];
-			int numnodes = 0;
-
-			if(node0->is_leaf()) {
-				nodes[numnodes++] = node0;
-			}
-			else {
-				nodes[numnodes++] = node0->get_child(0);
-				nodes[numnodes++] = node0->get_child(1);
-			}
-
-			if(node1->is_leaf()) {
-				nodes[numnodes++] = node1;
-			}
-			else {
-				nodes[numnodes++] = node1->get_child(0);
-				nodes[numnodes++] = node1->get_child(1);
-			}
-
-			/* push entries on the stack */
-			for(int i = 0; i < numnodes; i++)
-				stack.push_back(BVHStackEntry(nodes[i], nextNodeIdx++));
+	if(node0->is_leaf()) {
+		children[numnodes++] = node0;
+	}
+	else {
+		children[numnodes++] = node0->get_child(0);
+		children[numnodes++] = node0->get_child(1);
+	}
 
-			/* set node */
-			pack_inner(e, &stack[stack.size()-numnodes], numnodes);
-		}
+	if(node1->is_leaf()) {
+		children[numnodes++] = node1;
+	}
+	else {
+		children[numnodes++] = node1->get_child(0);
+		children[numnodes++] = node1->get_child(1);
 	}
 
-	/* root index to start traversal at, to handle case of single leaf node */
-	pack.root_index = (pack.is_leaf[0])? -1: 0;
+	return numnodes;
 }
 
 void QBVH::refit_nodes()
@@ -20,6 +20,8 @@
 
 #include "bvh_params.h"
 
+#include "util_cache.h"
+#include "util_set.h"
 #include "util_string.h"
 #include "util_types.h"
 #include "util_vector.h"
@@ -30,8 +32,8 @@ class BVHNode;
 struct BVHStackEntry;
 class BVHParams;
 class BoundBox;
-class CacheData;
 class LeafNode;
+class Mesh;
 class Object;
 class Progress;
 
@@ -40,6 +42,9 @@ class Progress;
 #define BVH_ALIGN		4096
 #define TRI_NODE_SIZE	3
 
+/* increase when changing the packed BVH layout, so cache files are rebuilt */
+#define BVH_CACHE_VERSION	2
+
 /* Packed BVH
  *
  * BVH stored as it will be used for traversal on the rendering device. */
@@ -78,6 +83,24 @@ struct PackedBVH {
 	}
 };
 
+/* Merged Instance
+ *
+ * Location of the data of an instanced mesh BVH in the top level BVH arrays. */
+
+struct BVHInstance {
+	Mesh *mesh;
+	int tri_offset;
+	int curve_offset;
+
+	size_t prim_offset;
+	size_t tri_woop_offset;
+	size_t nodes_offset;
+
+	size_t num_prims;
+	size_t num_tri_woop;
+	size_t num_nodes;
+};
+
 /* BVH */
 
 class BVH
@@ -93,13 +116,16 @@ public:
 
 	void build(Progress& progress);
 	void refit(Progress& progress);
+	bool update(Progress& progress, const set<Mesh*>& updated_meshes);
 
 	void clear_cache_except();
 
 protected:
 	BVH(const BVHParams& params, const vector<Object*>& objects);
 
-	/* cache */
+	/* cache, packed arrays read from the cache may reference its data */
+	CacheData cache_data;
+
 	bool cache_read(CacheData& key);
 	void cache_write(CacheData& key);
 
@@ -108,11 +134,29 @@ protected:
 	void pack_triangle(int idx, float4 woop[3]);
 	void pack_curve_segment(int idx, float4 woop[3]);
 
+	/* triangles and strands are packed in parallel, in chunks of this size */
+	enum { PACK_TASK_SIZE = 65536 };
+	void pack_primitives_range(size_t begin, size_t end);
+
 	/* merge instance BVH's */
+	vector<BVHInstance> instances;
+	vector<Mesh*> instance_meshes;
+	size_t instances_prim_offset;
+
 	void pack_instances(size_t nodes_size);
+	void pack_instance(const BVHInstance& instance);
+	bool instances_valid();
+
+	/* pack nodes, subtrees below the top of the tree are counted and packed
+	 * in parallel */
+	bool pack_nodes(const BVHNode *root, const set<Mesh*> *updated_meshes = NULL);
+	void pack_subtree(const BVHStackEntry *root, int next_idx);
+	void count_subtree(const BVHNode *node, int *num);
 
 	/* for subclasses to implement */
-	virtual void pack_nodes(const array<int>& prims, const BVHNode *root) = 0;
+	virtual int pack_children(const BVHNode *node, const BVHNode *children[4]) = 0;
+	virtual void pack_leaf(const BVHStackEntry& e, const LeafNode *leaf) = 0;
+	virtual void pack_inner(const BVHStackEntry& e, const BVHStackEntry *en, int num) = 0;
 	virtual void refit_nodes() = 0;
 };
 
@@ -127,9 +171,9 @@ protected:
 	RegularBVH(const BVHParams& params, const vector<Object*>& objects);
 
 	/* pack */
-	void pack_nodes(const array<int>& prims, const BVHNode *root);
+	int pack_children(const BVHNode *node, const BVHNode *children[4]);
 	void pack_leaf(const BVHStackEntry& e, const LeafNode *leaf);
-	void pack_inner(const BVHStackEntry& e, const BVHStackEntry& e0, const BVHStackEntry& e1);
+	void pack_inner(const BVHStackEntry& e, const BVHStackEntry *en, int num);
 	void pack_node(int idx, const BoundBox& b0, const BoundBox& b1, int c0, int c1, uint visibility0, uint visibility1);
 
 	/* refit */
@@ -148,7 +192,7 @@ protected:
 	QBVH(const BVHParams& params, const vector<Object*>& objects);
 
 	/* pack */
-	void pack_nodes(const array<int>& prims, const BVHNode *root);
+	int pack_children(const BVHNode *node, const BVHNode *children[4]);
 	void pack_leaf(const BVHStackEntry& e, const LeafNode *leaf);
 	void pack_inner(const BVHStackEntry& e, const BVHStackEntry *en, int num);
 
@@ -24,12 +24,15 @@
 
 CCL_NAMESPACE_BEGIN
 
-/* Single threaded object binner. Finds the split with the best SAH heuristic
- * by testing for each dimension multiple partitionings for regular spaced
- * partition locations. A partitioning for a partition location is computed,
- * by putting primitives whose centroid is on the left and right of the split
- * location to different sets. The SAH is evaluated by computing the number of
- * blocks occupied by the primitives in the partitions. */
+/* Object binner. Finds the split with the best SAH heuristic by testing for
+ * each dimension multiple partitionings for regular spaced partition
+ * locations. A partitioning for a partition location is computed, by putting
+ * primitives whose centroid is on the left and right of the split location to
+ * different sets. The SAH is evaluated by computing the number of blocks
+ * occupied by the primitives in the partitions.
+ *
+ * Large ranges are binned in parallel, with each task filling its own bins
+ * for a chunk of primitives, which are merged afterwards. */
 
 class BVHObjectBinning : public BVHRange
 {
@@ -51,6 +54,17 @@ protected:
 	enum { MAX_BINS = 32 };
 	enum { LOG_BLOCK_SIZE = 2 };
 
+	/* ranges from this size are binned in parallel, in chunks of this size */
+	enum { PARALLEL_BINNING_SIZE = 131072 };
+	enum { PARALLEL_BINNING_CHUNK = 32768 };
+
+	struct Bins {
+		BoundBox bounds[MAX_BINS][4];	/* bounds for every bin in every dimension */
+		int4 count[MAX_BINS];			/* number of primitives mapped to bin */
+	};
+
+	void bin_primitives(const BVHReference *prims, size_t begin, size_t end, Bins *bins) const;
+
 	/* computes the bin numbers for each dimension for a box. */
 	__forceinline int4 get_bin(const BoundBox& box) const
 	{
@@ -26,6 +26,7 @@
 #include "scene.h"
 #include "curves.h"
 
+#include "util_algorithm.h"
 #include "util_debug.h"
 #include "util_foreach.h"
 #include "util_progress.h"
@@ -66,11 +67,19 @@ BVHBuild::~BVHBuild()
 {
 }
 
-/* Adding References */
+/* Adding References
+ *
+ * References are generated in parallel for ranges of triangles and curves.
+ * Each range gets the slots for all its primitives reserved up front, and
+ * after all tasks are done, slots of primitives that were skipped because of
+ * invalid bounds are compacted away, so that the order is deterministic. */
 
-void BVHBuild::add_reference_mesh(BoundBox& root, BoundBox& center, Mesh *mesh, int i)
+void BVHBuild::add_reference_triangles(BVHReferenceRange *range)
 {
-	for(uint j = 0; j < mesh->triangles.size(); j++) {
+	Mesh *mesh = range->ob->mesh;
+	BVHReference *ref = &references[range->offset];
+
+	for(size_t j = range->begin; j < range->end; j++) {
 		Mesh::Triangle t = mesh->triangles[j];
 		BoundBox bounds = BoundBox::empty;
 
@@ -80,13 +89,19 @@ void BVHBuild::add_reference_mesh(BoundBox& root, BoundBox& center, Mesh *mesh,
 		}
 
 		if(bounds.valid()) {
-			references.push_back(BVHReference(bounds, j, i, ~0));
-			root.grow(bounds);
-			center.grow(bounds.center2());
+			ref[range->num++] = BVHReference(bounds, j, range->object, ~0);
+			range->bounds.grow(bounds);
+			range->center.grow(bounds.center2());
 		}
 	}
+}
 
-	for(uint j = 0; j < mesh->curves.size(); j++) {
+void BVHBuild::add_reference_curves(BVHReferenceRange *range)
+{
+	Mesh *mesh = range->ob->mesh;
+	BVHReference *ref = &references[range->offset];
+
+	for(size_t j = range->begin; j < range->end; j++) {
 		Mesh::Curve curve = mesh->curves[j];
 
 		for(int k = 0; k < curve.num_keys - 1; k++) {
@@ -108,72 +123,113 @@ void BVHBuild::add_reference_mesh(BoundBox& root, BoundBox& center, Mesh *mesh,
 			bounds.grow(upper, mr);
 
 			if(bounds.valid()) {
-				references.push_back(BVHReference(bounds, j, i, k));
-				root.grow(bounds);
-				center.grow(bounds.center2());
+				ref[range->num++] = BVHReference(bounds, j, range->object, k);
+				range->bounds.grow(bounds);
+				range->center.grow(bounds.center2());
 			}
 		}
 	}
 }
 
-void BVHBuild::add_reference_object(BoundBox& root, BoundBox& center, Object *ob, int i)
+void BVHBuild::add_reference_object(BVHReferenceRange *range)
 {
-	references.push_back(BVHReference(ob->bounds, -1, i, false));
-	root.grow(ob->bounds);
-	center.grow(ob->bounds.center2());
+	Object *ob = range->ob;
+
+	references[range->offset] = BVHReference(ob->bounds, -1, range->object, false);
+	range->num = 1;
+	range->bounds.grow(ob->bounds);
+	range->center.grow(ob->bounds.center2());
 }
 
-static size_t count_curve_segments(Mesh *mesh)
+static size_t count_curve_segments(Mesh *mesh, size_t begin, size_t end)
 {
-	size_t num = 0, num_curves = mesh->curves.size();
+	size_t num = 0;
 
-	for(size_t i = 0; i < num_curves; i++)
+	for(size_t i = begin; i < end; i++)
 		num += mesh->curves[i].num_keys - 1;
 	
 	return num;
 }
 
+void BVHBuild::add_reference_ranges(vector<BVHReferenceRange>& ranges, BVHReferenceRange::Type type,
+	Object *ob, int object, size_t num_prims, size_t& num_alloc_references)
+{
+	/* split primitives of a mesh into ranges for tasks */
+	for(size_t begin = 0; begin < num_prims; begin += REFERENCE_TASK_SIZE) {
+		BVHReferenceRange range;
+
+		range.type = type;
+		range.ob = ob;
+		range.object = object;
+		range.begin = begin;
+		range.end = min(begin + REFERENCE_TASK_SIZE, num_prims);
+		range.offset = num_alloc_references;
+		range.num = 0;
+		range.bounds = BoundBox::empty;
+		range.center = BoundBox::empty;
+
+		if(type == BVHReferenceRange::CURVES)
+			num_alloc_references += count_curve_segments(ob->mesh, range.begin, range.end);
+		else
+			num_alloc_references += range.end - range.begin;
+
+		ranges.push_back(range);
+	}
+}
+
 void BVHBuild::add_references(BVHRange& root)
 {
-	/* reserve space for references */
+	/* split into ranges and reserve space for references */
+	vector<BVHReferenceRange> ranges;
 	size_t num_alloc_references = 0;
+	int i = 0;
 
 	foreach(Object *ob, objects) {
-		if(params.top_level) {
-			if(ob->mesh->transform_applied) {
-				num_alloc_references += ob->mesh->triangles.size();
-				num_alloc_references += count_curve_segments(ob->mesh);
-			}
-			else
-				num_alloc_references++;
+		if(params.top_level && !ob->mesh->transform_applied) {
+			add_reference_ranges(ranges, BVHReferenceRange::OBJECT, ob, i, 1, num_alloc_references);
 		}
 		else {
-			num_alloc_references += ob->mesh->triangles.size();
-			num_alloc_references += count_curve_segments(ob->mesh);
+			add_reference_ranges(ranges, BVHReferenceRange::TRIANGLES, ob, i, ob->mesh->triangles.size(), num_alloc_references);
+			add_reference_ranges(ranges, BVHReferenceRange::CURVES, ob, i, ob->mesh->curves.size(), num_alloc_references);
 		}
+
+		i++;
 	}
 
-	references.reserve(num_alloc_references);
+	references.resize(num_alloc_references);
 
 	/* add references from objects */
-	BoundBox bounds = BoundBox::empty, center = BoundBox::empty;
-	int i = 0;
+	TaskPool pool;
 
-	foreach(Object *ob, objects) {
-		if(params.top_level) {
-			if(ob->mesh->transform_applied)
-				add_reference_mesh(bounds, center, ob->mesh, i);
-			else
-				add_reference_object(bounds, center, ob, i);
-		}
+	foreach(BVHReferenceRange& range, ranges) {
+		if(range.type == BVHReferenceRange::TRIANGLES)
+			pool.push(function_bind(&BVHBuild::add_reference_triangles, this, &range));
+		else if(range.type == BVHReferenceRange::CURVES)
+			pool.push(function_bind(&BVHBuild::add_reference_curves, this, &range));
 		else
-			add_reference_mesh(bounds, center, ob->mesh, i);
+			add_reference_object(&range);
+	}
 
-		i++;
+	pool.wait_work();
+
+	if(progress.get_cancel()) return;
+
+	/* compact references and merge bounds */
+	BoundBox bounds = BoundBox::empty, center = BoundBox::empty;
+	size_t num_references = 0;
+
+	foreach(BVHReferenceRange& range, ranges) {
+		if(range.offset != num_references)
+			for(size_t j = 0; j < range.num; j++)
+				references[num_references + j] = references[range.offset + j];
 
-		if(progress.get_cancel()) return;
+		num_references += range.num;
+		bounds.grow(range.bounds);
+		center.grow(range.center);
 	}
 
+	references.resize(num_references);
+
 	/* happens mostly on empty meshes */
 	if(!bounds.valid())
 		bounds.grow(make_float3(0.0f, 0.0f, 0.0f));
@@ -36,6 +36,27 @@ class Mesh;
 class Object;
 class Progress;
 
+/* Range of primitives to add references for */
+
+struct BVHReferenceRange {
+	enum Type { TRIANGLES, CURVES, OBJECT };
+
+	Type type;
+	Object *ob;
+	int object;
+
+	/* triangles or curves to add */
+	size_t begin;
+	size_t end;
+
+	/* first reserved reference slot and number of references added */
+	size_t offset;
+	size_t num;
+
+	BoundBox bounds;
+	BoundBox center;
+};
+
 /* BVH Builder */
 
 class BVHBuild
@@ -60,8 +81,12 @@ protected:
 	friend class BVHBuildTask;
 
 	/* adding references */
-	void add_reference_mesh(BoundBox& root, BoundBox& center, Mesh *mesh, int i);
-	void add_reference_object(BoundBox& root, BoundBox& center, Object *ob, int i);
+	enum { REFERENCE_TASK_SIZE = 65536 };
+	void add_reference_triangles(BVHReferenceRange *range);
+	void add_reference_curves(BVHReferenceRange *range);
+	void add_reference_object(BVHReferenceRange *range);
+	void add_reference_ranges(vector<BVHReferenceRange>& ranges, BVHReferenceRange::Type type,
+		Object *ob, int object, size_t num_prims, size_t& num_alloc_references);
 	void add_references(BVHRange& root);
 
 	/* building */
@@ -40,6 +40,11 @@
 
 CCL_NAMESPACE_BEGIN
 
+/* number of samples between adaptive sampling convergence tests, must be even */
+#define ADAPTIVE_SAMPLE_STEP 8
+/* size of the pixel blocks whose noise estimates are tested for convergence */
+#define ADAPTIVE_BLOCK_SIZE 8
+
 class CPUDevice : public Device
 {
 public:
@@ -51,6 +56,9 @@ public:
 	
 	CPUDevice(Stats &stats) : Device(stats)
 	{
+		kernel_globals.texture_cache.lookup = NULL;
+		kernel_globals.texture_cache.cache = NULL;
+
 #ifdef WITH_OSL
 		kernel_globals.osl = &osl_globals;
 #endif
@@ -58,6 +66,7 @@ public:
 		/* do now to avoid thread issues */
 		system_cpu_support_sse2();
 		system_cpu_support_sse3();
+		system_cpu_support_avx();
 	}
 
 	~CPUDevice()
@@ -123,6 +132,11 @@ public:
 #endif
 	}
 
+	void *texture_cache_memory()
+	{
+		return &kernel_globals.texture_cache;
+	}
+
 	void thread_run(DeviceTask *task)
 	{
 		if(task->type == DeviceTask::PATH_TRACE)
@@ -142,6 +156,52 @@ public:
 		}
 	};
 
+	float thread_block_error(KernelGlobals *kg, RenderTile& tile, int x0, int y0, int x1, int y1)
+	{
+		/* the auxiliary pass holds the odd samples only, so with an even sample
+		 * count the difference between the two halves of the samples gives a
+		 * per pixel error estimate, weighted relative to pixel brightness */
+		KernelFilm *kfilm = &kg->__data.film;
+		float *buffer = (float*)tile.buffer;
+		float inv_sample = 1.0f/(float)tile.sample;
+		float error = 0.0f;
+
+		for(int y = y0; y < y1; y++) {
+			for(int x = x0; x < x1; x++) {
+				float *pixel = buffer + (tile.offset + x + y*tile.stride)*kfilm->pass_stride;
+				float *combined = pixel + kfilm->pass_combined;
+				float *odd = pixel + kfilm->pass_adaptive_aux;
+
+				float diff = fabsf(combined[0] - 2.0f*odd[0]) +
+				             fabsf(combined[1] - 2.0f*odd[1]) +
+				             fabsf(combined[2] - 2.0f*odd[2]);
+				float sum = combined[0] + combined[1] + combined[2];
+
+				error += diff*inv_sample/sqrtf(max(sum*inv_sample, 1e-4f));
+			}
+		}
+
+		return error/(float)((x1 - x0)*(y1 - y0));
+	}
+
+	bool thread_tile_converged(KernelGlobals *kg, RenderTile& tile, float threshold)
+	{
+		/* a tile is converged when all its blocks are, so a small noisy region
+		 * like a caustic can't be hidden by a clean background. single pixel
+		 * estimates are too noisy themselves to test individually. */
+		for(int y = tile.y; y < tile.y + tile.h; y += ADAPTIVE_BLOCK_SIZE) {
+			for(int x = tile.x; x < tile.x + tile.w; x += ADAPTIVE_BLOCK_SIZE) {
+				int x1 = min(x + ADAPTIVE_BLOCK_SIZE, tile.x + tile.w);
+				int y1 = min(y + ADAPTIVE_BLOCK_SIZE, tile.y + tile.h);
+
+				if(thread_block_error(kg, tile, x, y, x1, y1) >= threshold)
+					return false;
+			}
+		}
+
+		return true;
+	}
+
 	void thread_path_trace(DeviceTask& task)
 	{
 		if(task_pool.canceled()) {
@@ -155,7 +215,21 @@ public:
 		OSLShader::thread_init(&kg, &kernel_globals, &osl_globals);
 #endif
 
+		void(*path_trace_tile)(KernelGlobals*, float*, unsigned int*, int, int, int, int, int, int, int);
+
+#ifdef WITH_OPTIMIZED_KERNEL
+		if(system_cpu_support_avx())
+			path_trace_tile = kernel_cpu_avx_path_trace_tile;
+		else if(system_cpu_support_sse3())
+			path_trace_tile = kernel_cpu_sse3_path_trace_tile;
+		else if(system_cpu_support_sse2())
+			path_trace_tile = kernel_cpu_sse2_path_trace_tile;
+		else
+#endif
+			path_trace_tile = kernel_cpu_path_trace_tile;
+
 		RenderTile tile;
+		bool adaptive = (task.adaptive_threshold > 0.0f) && (kg.__data.film.pass_flag & PASS_ADAPTIVE_AUX);
 		
 		while(task.acquire_tile(this, tile)) {
 			float *render_buffer = (float*)tile.buffer;
@@ -163,64 +237,30 @@ public:
 			int start_sample = tile.start_sample;
 			int end_sample = tile.start_sample + tile.num_samples;
 
-#ifdef WITH_OPTIMIZED_KERNEL
-			if(system_cpu_support_sse3()) {
-				for(int sample = start_sample; sample < end_sample; sample++) {
-					if (task.get_cancel() || task_pool.canceled()) {
-						if(task.need_finish_queue == false)
-							break;
-					}
-
-					for(int y = tile.y; y < tile.y + tile.h; y++) {
-						for(int x = tile.x; x < tile.x + tile.w; x++) {
-							kernel_cpu_sse3_path_trace(&kg, render_buffer, rng_state,
-								sample, x, y, tile.offset, tile.stride);
-						}
-					}
-
-					tile.sample = sample + 1;
-
-					task.update_progress(tile);
+			for(int sample = start_sample; sample < end_sample; sample++) {
+				if (task.get_cancel() || task_pool.canceled()) {
+					if(task.need_finish_queue == false)
+						break;
 				}
-			}
-			else if(system_cpu_support_sse2()) {
-				for(int sample = start_sample; sample < end_sample; sample++) {
-					if (task.get_cancel() || task_pool.canceled()) {
-						if(task.need_finish_queue == false)
-							break;
-					}
-
-					for(int y = tile.y; y < tile.y + tile.h; y++) {
-						for(int x = tile.x; x < tile.x + tile.w; x++) {
-							kernel_cpu_sse2_path_trace(&kg, render_buffer, rng_state,
-								sample, x, y, tile.offset, tile.stride);
-						}
-					}
-
-					tile.sample = sample + 1;
-
-					task.update_progress(tile);
-				}
-			}
-			else
-#endif
-			{
-				for(int sample = start_sample; sample < end_sample; sample++) {
-					if (task.get_cancel() || task_pool.canceled()) {
-						if(task.need_finish_queue == false)
-							break;
-					}
-
-					for(int y = tile.y; y < tile.y + tile.h; y++) {
-						for(int x = tile.x; x < tile.x + tile.w; x++) {
-							kernel_cpu_path_trace(&kg, render_buffer, rng_state,
-								sample, x, y, tile.offset, tile.stride);
-						}
-					}
-
-					tile.sample = sample + 1;
-
-					task.update_progress(tile);
+
+				path_trace_tile(&kg, render_buffer, rng_state, sample,
+					tile.x, tile.y, tile.w, tile.h, tile.offset, tile.stride);
+
+				tile.sample = sample + 1;
+
+				task.update_progress(tile);
+
+				/* adaptive sampling, test the tile for convergence every few samples */
+				if(adaptive && tile.sample >= task.adaptive_min_samples &&
+				   ((tile.sample % ADAPTIVE_SAMPLE_STEP) == 0 || tile.sample == end_sample))
+				{
+					if(thread_tile_converged(&kg, tile, task.adaptive_threshold))
+						break;
+
+					/* still noisy at the last sample, continue up to the next test
+					 * with samples skipped by tiles that converged */
+					if(tile.sample == end_sample && task.acquire_adaptive_samples)
+						end_sample += task.acquire_adaptive_samples(tile, ADAPTIVE_SAMPLE_STEP - tile.sample % ADAPTIVE_SAMPLE_STEP);
 				}
 			}
 
@@ -243,7 +283,13 @@ public:
 
 		if(task.rgba_half) {
 #ifdef WITH_OPTIMIZED_KERNEL
-			if(system_cpu_support_sse3()) {
+			if(system_cpu_support_avx()) {
+				for(int y = task.y; y < task.y + task.h; y++)
+					for(int x = task.x; x < task.x + task.w; x++)
+						kernel_cpu_avx_convert_to_half_float(&kernel_globals, (uchar4*)task.rgba_half, (float*)task.buffer,
+							sample_scale, x, y, task.offset, task.stride);
+			}
+			else if(system_cpu_support_sse3()) {
 				for(int y = task.y; y < task.y + task.h; y++)
 					for(int x = task.x; x < task.x + task.w; x++)
 						kernel_cpu_sse3_convert_to_half_float(&kernel_globals, (uchar4*)task.rgba_half, (float*)task.buffer,
@@ -266,7 +312,13 @@ public:
 		}
 		else {
 #ifdef WITH_OPTIMIZED_KERNEL
-			if(system_cpu_support_sse3()) {
+			if(system_cpu_support_avx()) {
+				for(int y = task.y; y < task.y + task.h; y++)
+					for(int x = task.x; x < task.x + task.w; x++)
+						kernel_cpu_avx_convert_to_byte(&kernel_globals, (uchar4*)task.rgba_byte, (float*)task.buffer,
+							sample_scale, x, y, task.offset, task.stride);
+			}
+			else if(system_cpu_support_sse3()) {
 				for(int y = task.y; y < task.y + task.h; y++)
 					for(int x = task.x; x < task.x + task.w; x++)
 						kernel_cpu_sse3_convert_to_byte(&kernel_globals, (uchar4*)task.rgba_byte, (float*)task.buffer,
@@ -298,7 +350,15 @@ public:
 #endif
 
 #ifdef WITH_OPTIMIZED_KERNEL
-		if(system_cpu_support_sse3()) {
+		if(system_cpu_support_avx()) {
+			for(int x = task.shader_x; x < task.shader_x + task.shader_w; x++) {
+				kernel_cpu_avx_shader(&kg, (uint4*)task.shader_input, (float4*)task.shader_output, task.shader_eval_type, x);
+
+				if(task_pool.canceled())
+					break;
+			}
+		}
+		else if(system_cpu_support_sse3()) {
 			for(int x = task.shader_x; x < task.shader_x + task.shader_w; x++) {
 				kernel_cpu_sse3_shader(&kg, (uint4*)task.shader_input, (float4*)task.shader_output, task.shader_eval_type, x);
 
@@ -19,6 +19,8 @@
 
 #include "device_task.h"
 
+#include "buffers.h"
+
 #include "util_algorithm.h"
 #include "util_time.h"
 
@@ -29,6 +31,7 @@ CCL_NAMESPACE_BEGIN
 DeviceTask::DeviceTask(Type type_)
 : type(type_), x(0), y(0), w(0), h(0), rgba_byte(0), rgba_half(0), buffer(0),
   sample(0), num_samples(1),
+  adaptive_threshold(0.0f), adaptive_min_samples(0),
   shader_input(0), shader_output(0),
   shader_eval_type(0), shader_x(0), shader_w(0)
 {
@@ -93,7 +96,8 @@ void DeviceTask::update_progress(RenderTile &rtile)
 	if (type != PATH_TRACE)
 		return;
 
-	if(update_progress_sample)
+	/* samples beyond the samples of the tile were counted when other tiles skipped them */
+	if(update_progress_sample && rtile.sample <= rtile.start_sample + rtile.num_samples)
 		update_progress_sample();
 
 	if(update_tile_sample) {
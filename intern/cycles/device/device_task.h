@@ -45,6 +45,11 @@ public:
 	int num_samples;
 	int offset, stride;
 
+	/* adaptive sampling, tiles stop early once their noise estimate
+	 * drops below the threshold, disabled when zero */
+	float adaptive_threshold;
+	int adaptive_min_samples;
+
 	device_ptr shader_input;
 	device_ptr shader_output;
 	int shader_eval_type;
@@ -61,6 +66,7 @@ public:
 	boost::function<void(void)> update_progress_sample;
 	boost::function<void(RenderTile&)> update_tile_sample;
 	boost::function<void(RenderTile&)> release_tile;
+	boost::function<int(RenderTile&, int)> acquire_adaptive_samples;
 	boost::function<bool(void)> get_cancel;
 
 	bool need_finish_queue;
@@ -50,6 +50,51 @@ void kernel_tex_copy(KernelGlobals *kg, const char *name, device_ptr mem, size_t
 #define KERNEL_IMAGE_TEX(type, ttype, tname)
 #include "kernel_textures.h"
 
+	else if(strstr(name, "__tex_image_half4")) {
+		texture_image_half4 *tex = NULL;
+		int id = atoi(name + strlen("__tex_image_half4_"));
+		int array_index = id;
+
+		if (array_index >= 0 && array_index < MAX_FLOAT_IMAGES) {
+			tex = &kg->texture_half4_images[array_index];
+		}
+
+		if(tex) {
+			tex->data = (half4*)mem;
+			tex->width = width;
+			tex->height = height;
+		}
+	}
+	else if(strstr(name, "__tex_image_float1")) {
+		texture_image_float *tex = NULL;
+		int id = atoi(name + strlen("__tex_image_float1_"));
+		int array_index = id;
+
+		if (array_index >= 0 && array_index < MAX_FLOAT_IMAGES) {
+			tex = &kg->texture_float1_images[array_index];
+		}
+
+		if(tex) {
+			tex->data = (float*)mem;
+			tex->width = width;
+			tex->height = height;
+		}
+	}
+	else if(strstr(name, "__tex_image_byte1")) {
+		texture_image_uchar *tex = NULL;
+		int id = atoi(name + strlen("__tex_image_byte1_"));
+		int array_index = id - MAX_FLOAT_IMAGES;
+
+		if (array_index >= 0 && array_index < MAX_BYTE_IMAGES) {
+			tex = &kg->texture_byte1_images[array_index];
+		}
+
+		if(tex) {
+			tex->data = (uchar*)mem;
+			tex->width = width;
+			tex->height = height;
+		}
+	}
 	else if(strstr(name, "__tex_image_float")) {
 		texture_image_float4 *tex = NULL;
 		int id = atoi(name + strlen("__tex_image_float_"));
@@ -96,6 +141,11 @@ void kernel_cpu_path_trace(KernelGlobals *kg, float *buffer, unsigned int *rng_s
 		kernel_path_trace(kg, buffer, rng_state, sample, x, y, offset, stride);
 }
 
+void kernel_cpu_path_trace_tile(KernelGlobals *kg, float *buffer, unsigned int *rng_state, int sample, int x, int y, int w, int h, int offset, int stride)
+{
+	kernel_path_trace_tile(kg, buffer, rng_state, sample, x, y, w, h, offset, stride);
+}
+
 /* Film */
 
 void kernel_cpu_convert_to_byte(KernelGlobals *kg, uchar4 *rgba, float *buffer, float sample_scale, int x, int y, int offset, int stride)
@@ -172,7 +172,15 @@ ccl_device_noinline float3 indirect_primitive_emission(KernelGlobals *kg, Shader
 #endif
 		/* multiple importance sampling, get triangle light pdf,
 		 * and compute weight with respect to BSDF pdf */
-		float pdf = triangle_light_pdf(kg, sd->Ng, sd->I, t);
+		float pdf;
+
+#ifdef __LIGHT_TREE__
+		if(kernel_data.integrator.use_light_tree)
+			pdf = light_tree_emission_pdf(kg, sd, t);
+		else
+#endif
+			pdf = triangle_light_pdf(kg, sd->Ng, sd->I, t);
+
 		float mis_weight = power_heuristic(bsdf_pdf, pdf);
 
 		return L*mis_weight;
@@ -38,6 +38,14 @@ typedef struct KernelGlobals {
 	texture_image_uchar4 texture_byte_images[MAX_BYTE_IMAGES];
 	texture_image_float4 texture_float_images[MAX_FLOAT_IMAGES];
 
+	/* compact storage for the same slots, only one of the images for a slot
+	 * has data: single channel byte and float, and half float RGBA images */
+	texture_image_uchar texture_byte1_images[MAX_BYTE_IMAGES];
+	texture_image_float texture_float1_images[MAX_FLOAT_IMAGES];
+	texture_image_half4 texture_half4_images[MAX_FLOAT_IMAGES];
+
+	texture_image_cache texture_cache;
+
 #define KERNEL_TEX(type, ttype, name) ttype name;
 #define KERNEL_IMAGE_TEX(type, ttype, name)
 #include "kernel_textures.h"
@@ -54,6 +62,33 @@ typedef struct KernelGlobals {
 
 } KernelGlobals;
 
+ccl_device_inline float4 kernel_tex_image_interp_cpu(KernelGlobals *kg, int tex, float x, float y)
+{
+	if(kg->texture_cache.lookup) {
+		float4 r;
+
+		if(kg->texture_cache.lookup(kg->texture_cache.cache, tex, x, y, &r))
+			return r;
+	}
+
+	if(tex < MAX_FLOAT_IMAGES) {
+		if(kg->texture_half4_images[tex].data)
+			return kg->texture_half4_images[tex].interp(x, y);
+		else if(kg->texture_float1_images[tex].data)
+			return kg->texture_float1_images[tex].interp(x, y);
+
+		return kg->texture_float_images[tex].interp(x, y);
+	}
+	else {
+		tex -= MAX_FLOAT_IMAGES;
+
+		if(kg->texture_byte1_images[tex].data)
+			return kg->texture_byte1_images[tex].interp(x, y);
+
+		return kg->texture_byte_images[tex].interp(x, y);
+	}
+}
+
 #endif
 
 /* For CUDA, constant memory textures must be globals, so we can't put them
@@ -36,6 +36,20 @@ typedef struct LightSample {
 
 #ifdef __BACKGROUND_MIS__
 
+ccl_device float background_light_select_pdf(KernelGlobals *kg)
+{
+#ifdef __LIGHT_TREE__
+	/* with the light tree, infinite lights are picked uniformly with a fixed
+	 * probability, outside of the tree */
+	if(kernel_data.integrator.use_light_tree) {
+		int num_infinite = kernel_data.integrator.num_distribution - kernel_data.integrator.num_light_tree_emitters;
+		return kernel_data.integrator.light_tree_prob_infinite/(float)num_infinite;
+	}
+#endif
+
+	return kernel_data.integrator.pdf_lights;
+}
+
 ccl_device float3 background_light_sample(KernelGlobals *kg, float randu, float randv, float *pdf)
 {
 	/* for the following, the CDF values are actually a pair of floats, with the
@@ -106,7 +120,7 @@ ccl_device float3 background_light_sample(KernelGlobals *kg, float randu, float
 	else
 		*pdf = (cdf_u.x * cdf_v.x)/(M_2PI_F * M_PI_F * sin_theta * denom);
 
-	*pdf *= kernel_data.integrator.pdf_lights;
+	*pdf *= background_light_select_pdf(kg);
 
 	/* compute direction */
 	return -equirectangular_to_direction(u, v);
@@ -140,7 +154,7 @@ ccl_device float background_light_pdf(KernelGlobals *kg, float3 direction)
 
 	float pdf = (cdf_u.x * cdf_v.x)/(M_2PI_F * M_PI_F * sin_theta * denom);
 
-	return pdf * kernel_data.integrator.pdf_lights;
+	return pdf * background_light_select_pdf(kg);
 }
 #endif
 
@@ -542,12 +556,231 @@ ccl_device int light_distribution_sample(KernelGlobals *kg, float randt)
 	return clamp(first-1, 0, kernel_data.integrator.num_distribution-1);
 }
 
+/* Light Tree
+ *
+ * Bounding volume hierarchy over all emitters with a position, picking
+ * lights proportional to an importance estimate of each node for the
+ * shading point. Leaves index contiguous ranges of the light distribution,
+ * which is sorted in tree order, distant and background lights come last. */
+
+#ifdef __LIGHT_TREE__
+
+ccl_device float light_tree_node_importance(KernelGlobals *kg, int node, float3 P)
+{
+	float4 data0 = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 0);
+	float4 data1 = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 1);
+	float4 data2 = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 2);
+
+	float3 bmin = make_float3(data0.x, data0.y, data0.z);
+	float3 bmax = make_float3(data1.x, data1.y, data1.z);
+	float3 axis = make_float3(data2.x, data2.y, data2.z);
+	float energy = data0.w;
+	float theta_o = data1.w;
+
+	float3 V = P - 0.5f*(bmin + bmax);
+	float dist2 = len_squared(V);
+	float radius2 = 0.25f*len_squared(bmax - bmin);
+
+	/* inside the bounds, distance and orientation can't be bounded */
+	if(dist2 <= radius2)
+		return energy/max(radius2, 1e-8f);
+
+	/* emitters are two sided, so only the angle to the closest of both cone
+	 * directions matters, reduced by the cone spread and the bounds extent */
+	float dist = sqrtf(dist2);
+	float theta = safe_acosf(fabsf(dot(axis, V))/dist);
+	float theta_u = safe_asinf(sqrtf(radius2/dist2));
+	float theta_i = max(theta - theta_o - theta_u, 0.0f);
+
+	if(theta_i >= M_PI_2_F)
+		return 0.0f;
+
+	return energy*cosf(theta_i)/dist2;
+}
+
+ccl_device float light_tree_child_probability(KernelGlobals *kg, int child0, int child1, float3 P)
+{
+	float importance0 = light_tree_node_importance(kg, child0, P);
+	float importance1 = light_tree_node_importance(kg, child1, P);
+	float total = importance0 + importance1;
+
+	return (total > 0.0f)? importance0/total: 0.5f;
+}
+
+ccl_device float light_tree_leaf_probability(KernelGlobals *kg, int first, int num, int index)
+{
+	/* within a leaf, emitters are picked proportional to their distribution weight */
+	float cdf_begin = kernel_tex_fetch(__light_distribution, first).x;
+	float cdf_end = kernel_tex_fetch(__light_distribution, first + num).x;
+
+	if(cdf_end <= cdf_begin)
+		return 0.0f;
+
+	float cdf = kernel_tex_fetch(__light_distribution, index).x;
+	float cdf_next = kernel_tex_fetch(__light_distribution, index + 1).x;
+
+	return (cdf_next - cdf)/(cdf_end - cdf_begin);
+}
+
+ccl_device int light_tree_sample(KernelGlobals *kg, float randt, float3 P, float *pdf)
+{
+	int num_emitters = kernel_data.integrator.num_light_tree_emitters;
+	int num_infinite = kernel_data.integrator.num_distribution - num_emitters;
+	float prob_infinite = kernel_data.integrator.light_tree_prob_infinite;
+
+	/* distant and background lights */
+	if(randt < prob_infinite) {
+		int index = min(float_to_int(randt/prob_infinite*num_infinite), num_infinite - 1);
+		*pdf = prob_infinite/(float)num_infinite;
+		return num_emitters + index;
+	}
+
+	/* traverse the tree, reusing the random number at each level */
+	randt = (randt - prob_infinite)/(1.0f - prob_infinite);
+	*pdf = 1.0f - prob_infinite;
+
+	int node = 0;
+
+	while(true) {
+		float4 data3 = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 3);
+		int num = __float_as_int(data3.z);
+
+		if(num > 0) {
+			int first = __float_as_int(data3.x);
+			float cdf_begin = kernel_tex_fetch(__light_distribution, first).x;
+			float cdf_end = kernel_tex_fetch(__light_distribution, first + num).x;
+			float cdf_t = cdf_begin + randt*(cdf_end - cdf_begin);
+			int index = first;
+
+			while(index < first + num - 1 && kernel_tex_fetch(__light_distribution, index + 1).x <= cdf_t)
+				index++;
+
+			*pdf *= light_tree_leaf_probability(kg, first, num, index);
+			return index;
+		}
+
+		int child0 = __float_as_int(data3.x);
+		int child1 = __float_as_int(data3.y);
+		float prob0 = light_tree_child_probability(kg, child0, child1, P);
+
+		if(randt < prob0) {
+			randt = randt/prob0;
+			*pdf *= prob0;
+			node = child0;
+		}
+		else {
+			randt = (randt - prob0)/(1.0f - prob0);
+			*pdf *= 1.0f - prob0;
+			node = child1;
+		}
+	}
+}
+
+ccl_device float light_tree_pdf(KernelGlobals *kg, float3 P, int index)
+{
+	int num_emitters = kernel_data.integrator.num_light_tree_emitters;
+	float prob_infinite = kernel_data.integrator.light_tree_prob_infinite;
+
+	if(index >= num_emitters)
+		return prob_infinite/(float)(kernel_data.integrator.num_distribution - num_emitters);
+
+	/* follow the same path as sampling, leaves are sorted so the split index
+	 * tells which child contains the emitter */
+	float pdf = 1.0f - prob_infinite;
+	int node = 0;
+
+	while(true) {
+		float4 data3 = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 3);
+		int num = __float_as_int(data3.z);
+
+		if(num > 0)
+			return pdf*light_tree_leaf_probability(kg, __float_as_int(data3.x), num, index);
+
+		int child0 = __float_as_int(data3.x);
+		int child1 = __float_as_int(data3.y);
+		int split = __float_as_int(data3.w);
+		float prob0 = light_tree_child_probability(kg, child0, child1, P);
+
+		if(index < split) {
+			pdf *= prob0;
+			node = child0;
+		}
+		else {
+			pdf *= 1.0f - prob0;
+			node = child1;
+		}
+	}
+}
+
+ccl_device float light_tree_triangle_area(KernelGlobals *kg, int prim, int object)
+{
+	float3 V[3];
+	triangle_vertices(kg, prim, V);
+
+#ifdef __INSTANCING__
+	if(object >= 0) {
+		Transform tfm = object_fetch_transform(kg, object, OBJECT_TRANSFORM);
+
+		V[0] = transform_point(&tfm, V[0]);
+		V[1] = transform_point(&tfm, V[1]);
+		V[2] = transform_point(&tfm, V[2]);
+	}
+#endif
+
+	return triangle_area(V[0], V[1], V[2]);
+}
+
+ccl_device float light_tree_triangle_pdf(KernelGlobals *kg, float pdf_select, int prim, int object,
+	const float3 Ng, const float3 I, float t)
+{
+	float area = light_tree_triangle_area(kg, prim, object);
+	float cos_pi = fabsf(dot(Ng, I));
+
+	if(cos_pi == 0.0f || area == 0.0f)
+		return 0.0f;
+
+	return t*t*pdf_select/(cos_pi*area);
+}
+
+ccl_device float light_tree_emission_pdf(KernelGlobals *kg, ShaderData *sd, float t)
+{
+	/* find the distribution index of the triangle that was hit */
+	int object_offset = sd->object*2;
+	uint map_offset = kernel_tex_fetch(__light_tree_emitter_map, object_offset);
+
+	if(map_offset == LIGHT_TREE_NONE)
+		return 0.0f;
+
+	uint tri_offset = kernel_tex_fetch(__light_tree_emitter_map, object_offset + 1);
+	uint index = kernel_tex_fetch(__light_tree_emitter_map, map_offset + sd->prim - tri_offset);
+
+	if(index == LIGHT_TREE_NONE)
+		return 0.0f;
+
+	/* importance was evaluated at the point the ray came from */
+	float3 P = sd->P + sd->I*t;
+	float pdf_select = light_tree_pdf(kg, P, index);
+	int object = __float_as_int(kernel_tex_fetch(__light_distribution, index).w);
+
+	return light_tree_triangle_pdf(kg, pdf_select, sd->prim, object, sd->Ng, sd->I, t);
+}
+
+#endif
+
 /* Generic Light */
 
 ccl_device void light_sample(KernelGlobals *kg, float randt, float randu, float randv, float time, float3 P, LightSample *ls)
 {
 	/* sample index */
-	int index = light_distribution_sample(kg, randt);
+	int index;
+	float pdf_select = 1.0f;
+
+#ifdef __LIGHT_TREE__
+	if(kernel_data.integrator.use_light_tree)
+		index = light_tree_sample(kg, randt, P, &pdf_select);
+	else
+#endif
+		index = light_distribution_sample(kg, randt);
 
 	/* fetch light data */
 	float4 l = kernel_tex_fetch(__light_distribution, index);
@@ -568,12 +801,28 @@ ccl_device void light_sample(KernelGlobals *kg, float randt, float randu, float
 
 		/* compute incoming direction, distance and pdf */
 		ls->D = normalize_len(ls->P - P, &ls->t);
-		ls->pdf = triangle_light_pdf(kg, ls->Ng, -ls->D, ls->t);
+#ifdef __LIGHT_TREE__
+		if(kernel_data.integrator.use_light_tree)
+			ls->pdf = light_tree_triangle_pdf(kg, pdf_select, prim, object, ls->Ng, -ls->D, ls->t);
+		else
+#endif
+			ls->pdf = triangle_light_pdf(kg, ls->Ng, -ls->D, ls->t);
 		ls->shader |= __float_as_int(l.z) & (~SHADER_MASK);
 	}
 	else {
 		int lamp = -prim-1;
 		lamp_light_sample(kg, lamp, randu, randv, P, ls);
+
+#ifdef __LIGHT_TREE__
+		/* replace the uniform lamp selection probability, background
+		 * lights already account for it in their pdf */
+		if(kernel_data.integrator.use_light_tree && ls->type != LIGHT_BACKGROUND) {
+			if(pdf_select == 0.0f)
+				ls->pdf = 0.0f;
+			else
+				ls->eval_fac *= kernel_data.integrator.pdf_lights/pdf_select;
+		}
+#endif
 	}
 }
 
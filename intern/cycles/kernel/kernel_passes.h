@@ -34,6 +34,16 @@ ccl_device_inline void kernel_write_pass_float4(ccl_global float *buffer, int sa
 	*buf = (sample == 0)? value: *buf + value;
 }
 
+ccl_device_inline void kernel_write_adaptive_pass(KernelGlobals *kg, ccl_global float *buffer, int sample, float4 L)
+{
+#ifdef __PASSES__
+	/* accumulate odd samples only, comparing against the combined pass then
+	 * gives a cheap estimate of the remaining noise for adaptive sampling */
+	if((kernel_data.film.pass_flag & PASS_ADAPTIVE_AUX) && (sample & 1))
+		kernel_write_pass_float4(buffer + kernel_data.film.pass_adaptive_aux, sample >> 1, L);
+#endif
+}
+
 ccl_device_inline void kernel_write_data_passes(KernelGlobals *kg, ccl_global float *buffer, PathRadiance *L,
 	ShaderData *sd, int sample, int path_flag, float3 throughput)
 {
@@ -1222,6 +1222,7 @@ ccl_device void kernel_path_trace(KernelGlobals *kg,
 
 	/* accumulate result in output buffer */
 	kernel_write_pass_float4(buffer, sample, L);
+	kernel_write_adaptive_pass(kg, buffer, sample, L);
 
 	path_rng_end(kg, rng_state, rng);
 }
@@ -1254,10 +1255,35 @@ ccl_device void kernel_branched_path_trace(KernelGlobals *kg,
 
 	/* accumulate result in output buffer */
 	kernel_write_pass_float4(buffer, sample, L);
+	kernel_write_adaptive_pass(kg, buffer, sample, L);
 
 	path_rng_end(kg, rng_state, rng);
 }
 #endif
 
+#ifdef __KERNEL_CPU__
+/* Path trace all pixels of a tile, shared by the CPU kernel entry points.
+ * Looping inside the kernel file lets the per pixel kernel get inlined and
+ * the integrator branch is only evaluated once per tile. */
+ccl_device_inline void kernel_path_trace_tile(KernelGlobals *kg,
+	ccl_global float *buffer, ccl_global uint *rng_state,
+	int sample, int x, int y, int w, int h, int offset, int stride)
+{
+#ifdef __BRANCHED_PATH__
+	if(kernel_data.integrator.branched) {
+		for(int py = y; py < y + h; py++)
+			for(int px = x; px < x + w; px++)
+				kernel_branched_path_trace(kg, buffer, rng_state, sample, px, py, offset, stride);
+	}
+	else
+#endif
+	{
+		for(int py = y; py < y + h; py++)
+			for(int px = x; px < x + w; px++)
+				kernel_path_trace(kg, buffer, rng_state, sample, px, py, offset, stride);
+	}
+}
+#endif
+
 CCL_NAMESPACE_END
 
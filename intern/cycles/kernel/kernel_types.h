@@ -30,6 +30,8 @@ CCL_NAMESPACE_BEGIN
 #define OBJECT_SIZE 		11
 #define OBJECT_VECTOR_SIZE	6
 #define LIGHT_SIZE			4
+#define LIGHT_TREE_NODE_SIZE	4
+#define LIGHT_TREE_NONE		(~0u)
 #define FILTER_TABLE_SIZE	256
 #define RAMP_TABLE_SIZE		256
 #define PARTICLE_SIZE 		5
@@ -136,6 +138,7 @@ CCL_NAMESPACE_BEGIN
 #define __PASSES__
 #define __BACKGROUND_MIS__
 #define __LAMP_MIS__
+#define __LIGHT_TREE__
 #define __AO__
 #define __ANISOTROPIC__
 #define __CAMERA_MOTION__
@@ -268,7 +271,8 @@ typedef enum PassType {
 	PASS_MIST = 2097152,
 	PASS_SUBSURFACE_DIRECT = 4194304,
 	PASS_SUBSURFACE_INDIRECT = 8388608,
-	PASS_SUBSURFACE_COLOR = 16777216
+	PASS_SUBSURFACE_COLOR = 16777216,
+	PASS_ADAPTIVE_AUX = 33554432
 } PassType;
 
 #define PASS_ALL (~0)
@@ -693,7 +697,7 @@ typedef struct KernelFilm {
 	int pass_emission;
 	int pass_background;
 	int pass_ao;
-	int pass_pad1;
+	int pass_adaptive_aux;
 
 	int pass_shadow;
 	float pass_shadow_scale;
@@ -769,8 +773,13 @@ typedef struct KernelIntegrator {
 	/* sampler */
 	int sampling_pattern;
 
+	/* light tree */
+	int use_light_tree;
+	int num_light_tree_emitters;
+	float light_tree_prob_infinite;
+
 	/* padding */
-	int pad;
+	int pad1, pad2;
 } KernelIntegrator;
 
 typedef struct KernelBVH {
@@ -826,6 +835,21 @@ typedef struct KernelData {
 	KernelBlackbody blackbody;
 } KernelData;
 
+#ifdef __KERNEL_CPU__
+
+/* Image lookups through an on-demand texture cache instead of fully loaded
+ * images, filled in by the ImageManager. The lookup returns false for slots
+ * that are not in the cache, those use the regular image textures. */
+
+typedef bool (*texture_cache_lookup_func)(void *cache, int slot, float x, float y, float4 *result);
+
+typedef struct texture_image_cache {
+	texture_cache_lookup_func lookup;
+	void *cache;
+} texture_image_cache;
+
+#endif
+
 CCL_NAMESPACE_END
 
 #endif /*  __KERNEL_TYPES_H__ */
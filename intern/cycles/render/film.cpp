@@ -155,6 +155,9 @@ void Pass::add(PassType type, vector<Pass>& passes)
 			pass.components = 4;
 			pass.exposure = false;
 			break;
+		case PASS_ADAPTIVE_AUX:
+			pass.components = 4;
+			break;
 	}
 
 	passes.push_back(pass);
@@ -391,6 +394,9 @@ void Film::device_update(Device *device, DeviceScene *dscene, Scene *scene)
 				kfilm->pass_shadow = kfilm->pass_stride;
 				kfilm->use_light_pass = 1;
 				break;
+			case PASS_ADAPTIVE_AUX:
+				kfilm->pass_adaptive_aux = kfilm->pass_stride;
+				break;
 			case PASS_NONE:
 				break;
 		}
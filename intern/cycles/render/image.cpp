@@ -23,6 +23,8 @@
 #include "util_path.h"
 #include "util_progress.h"
 
+#include <OpenImageIO/texture.h>
+
 #ifdef WITH_OSL
 #include <OSL/oslexec.h>
 #endif
@@ -36,6 +38,12 @@ ImageManager::ImageManager()
 	osl_texture_system = NULL;
 	animation_frame = 0;
 
+	compact_images = false;
+
+	use_texture_cache = false;
+	texture_cache_size = 0;
+	texture_cache = NULL;
+
 	tex_num_images = TEX_NUM_IMAGES;
 	tex_num_float_images = TEX_NUM_FLOAT_IMAGES;
 	tex_image_byte_start = TEX_IMAGE_BYTE_START;
@@ -47,6 +55,8 @@ ImageManager::~ImageManager()
 		assert(!images[slot]);
 	for(size_t slot = 0; slot < float_images.size(); slot++)
 		assert(!float_images[slot]);
+
+	texture_cache_free();
 }
 
 void ImageManager::set_pack_images(bool pack_images_)
@@ -59,6 +69,147 @@ void ImageManager::set_osl_texture_system(void *texture_system)
 	osl_texture_system = texture_system;
 }
 
+void ImageManager::set_texture_cache(Device *device, bool use_texture_cache_, int texture_cache_size_)
+{
+	/* the kernel can only call back into the texture cache on the CPU, and
+	 * OSL already does its own on-demand texture loading */
+	texture_image_cache *kernel_cache = (texture_image_cache*)device->texture_cache_memory();
+
+	if(!kernel_cache || osl_texture_system)
+		use_texture_cache_ = false;
+
+	if(use_texture_cache_ == use_texture_cache && texture_cache_size_ == texture_cache_size)
+		return;
+
+	use_texture_cache = use_texture_cache_;
+	texture_cache_size = texture_cache_size_;
+
+	if(use_texture_cache) {
+		if(!texture_cache) {
+			TextureSystem *ts = TextureSystem::create(false);
+
+			ts->attribute("automip", 1);
+			ts->attribute("autotile", 64);
+			ts->attribute("gray_to_rgb", 1);
+
+			texture_cache = ts;
+		}
+
+		((TextureSystem*)texture_cache)->attribute("max_memory_MB", (float)texture_cache_size);
+
+		texture_cache_handles.clear();
+		texture_cache_handles.resize(tex_image_byte_start + tex_num_images, NULL);
+
+		kernel_cache->cache = this;
+		kernel_cache->lookup = texture_cache_lookup;
+	}
+	else if(kernel_cache) {
+		kernel_cache->lookup = NULL;
+		kernel_cache->cache = NULL;
+	}
+
+	/* reload all images in the new mode */
+	for(size_t slot = 0; slot < images.size(); slot++)
+		if(images[slot])
+			images[slot]->need_load = true;
+
+	for(size_t slot = 0; slot < float_images.size(); slot++)
+		if(float_images[slot])
+			float_images[slot]->need_load = true;
+
+	need_update = true;
+}
+
+void ImageManager::texture_cache_free()
+{
+	if(texture_cache) {
+		TextureSystem::destroy((TextureSystem*)texture_cache);
+		texture_cache = NULL;
+	}
+
+	texture_cache_handles.clear();
+	use_texture_cache = false;
+}
+
+bool ImageManager::texture_cache_lookup(void *cache, int slot, float x, float y, float4 *result)
+{
+	ImageManager *manager = (ImageManager*)cache;
+	TextureSystem::TextureHandle *handle = (TextureSystem::TextureHandle*)manager->texture_cache_handles[slot];
+
+	if(!handle)
+		return false;
+
+	TextureSystem *ts = (TextureSystem*)manager->texture_cache;
+	TextureOpt options;
+	float r[4];
+
+	options.nchannels = 4;
+	options.fill = 1.0f;
+	options.swrap = TextureOpt::WrapPeriodic;
+	options.twrap = TextureOpt::WrapPeriodic;
+	options.interpmode = TextureOpt::InterpBilinear;
+
+	/* no derivatives are available for SVM texture coordinates, so lookups
+	 * use the highest resolution level, fetching only the tiles needed.
+	 * images are stored bottom to top, so flip t. */
+	if(!ts->texture(handle, NULL, options, x, 1.0f - y, 0.0f, 0.0f, 0.0f, 0.0f, r)) {
+		r[0] = TEX_IMAGE_MISSING_R;
+		r[1] = TEX_IMAGE_MISSING_G;
+		r[2] = TEX_IMAGE_MISSING_B;
+		r[3] = TEX_IMAGE_MISSING_A;
+	}
+
+	*result = make_float4(r[0], r[1], r[2], r[3]);
+
+	return true;
+}
+
+bool ImageManager::texture_cache_load_image(Image *img, int slot)
+{
+	/* builtin images have no file the cache could read tiles from */
+	if(img->builtin_data || img->filename == "")
+		return false;
+
+	TextureSystem *ts = (TextureSystem*)texture_cache;
+	ustring filename(img->filename);
+	int resolution[2];
+
+	/* test if the file can be read, otherwise fall back to regular loading
+	 * which will show the missing texture color */
+	if(!ts->get_texture_info(filename, 0, ustring("resolution"), TypeDesc(TypeDesc::INT, 2), resolution))
+		return false;
+
+	texture_cache_handles[slot] = ts->get_texture_handle(filename);
+
+	return texture_cache_handles[slot] != NULL;
+}
+
+void ImageManager::texture_cache_stats(Progress& progress)
+{
+	if(!use_texture_cache) {
+		progress.set_texture_cache_stats(0, 0, 0);
+		return;
+	}
+
+	TextureSystem *ts = (TextureSystem*)texture_cache;
+	long long lookups = 0, misses = 0, memory = 0;
+
+	ts->getattribute("stat:find_tile_calls", TypeDesc::INT64, &lookups);
+	ts->getattribute("stat:find_tile_cache_misses", TypeDesc::INT64, &misses);
+	ts->getattribute("stat:cache_memory_used", TypeDesc::INT64, &memory);
+
+	/* OIIO counts every tile lookup and the lookups that missed the cache,
+	 * all other lookups were served from the cache or microcache */
+	long long hits = (lookups > misses)? lookups - misses: 0;
+
+	progress.set_texture_cache_stats(hits, misses, memory);
+}
+
+void ImageManager::set_compact_images(bool compact_images_)
+{
+	compact_images = compact_images_;
+}
+
 void ImageManager::set_extended_image_limits(void)
 {
 	tex_num_images = TEX_EXTENDED_NUM_IMAGES;
@@ -83,21 +234,24 @@ bool ImageManager::set_animation_frame_update(int frame)
 	return false;
 }
 
-bool ImageManager::is_float_image(const string& filename, void *builtin_data, bool& is_linear)
+ImageManager::ImageDataType ImageManager::get_image_metadata(const string& filename, void *builtin_data, bool& is_linear)
 {
-	bool is_float = false;
+	bool is_float = false, is_half = false;
+	int channels = 4;
 	is_linear = false;
 
 	if(builtin_data) {
 		if(builtin_image_info_cb) {
-			int width, height, channels;
+			int width, height;
 			builtin_image_info_cb(filename, builtin_data, is_float, width, height, channels);
 		}
 
-		if(is_float)
+		if(is_float) {
 			is_linear = true;
+			return (channels == 1)? IMAGE_DATA_TYPE_FLOAT: IMAGE_DATA_TYPE_FLOAT4;
+		}
 
-		return is_float;
+		return (channels == 1)? IMAGE_DATA_TYPE_BYTE: IMAGE_DATA_TYPE_BYTE4;
 	}
 
 	ImageInput *in = ImageInput::create(filename);
@@ -120,6 +274,17 @@ bool ImageManager::is_float_image(const string& filename, void *builtin_data, bo
 				}
 			}
 
+			/* half float images can be stored as is, if all channels are half */
+			if(spec.format == TypeDesc::HALF) {
+				is_half = true;
+
+				for(size_t channel = 0; channel < spec.channelformats.size(); channel++)
+					if(spec.channelformats[channel] != TypeDesc::HALF)
+						is_half = false;
+			}
+
+			channels = spec.nchannels;
+
 			/* basic color space detection, not great but better than nothing
 			 * before we do OpenColorIO integration */
 			if(is_float) {
@@ -142,7 +307,23 @@ bool ImageManager::is_float_image(const string& filename, void *builtin_data, bo
 		delete in;
 	}
 
-	return is_float;
+	if(is_float) {
+		if(channels == 1)
+			return IMAGE_DATA_TYPE_FLOAT;
+		else if(is_half && (channels == 3 || channels == 4))
+			return IMAGE_DATA_TYPE_HALF4;
+
+		return IMAGE_DATA_TYPE_FLOAT4;
+	}
+
+	return (channels == 1)? IMAGE_DATA_TYPE_BYTE: IMAGE_DATA_TYPE_BYTE4;
+}
+
+bool ImageManager::is_float_image(const string& filename, void *builtin_data, bool& is_linear)
+{
+	ImageDataType type = get_image_metadata(filename, builtin_data, is_linear);
+
+	return type != IMAGE_DATA_TYPE_BYTE4 && type != IMAGE_DATA_TYPE_BYTE;
 }
 
 int ImageManager::add_image(const string& filename, void *builtin_data, bool animated, bool& is_float, bool& is_linear)
@@ -151,7 +332,16 @@ int ImageManager::add_image(const string& filename, void *builtin_data, bool ani
 	size_t slot;
 
 	/* load image info and find out if we need a float texture */
-	is_float = (pack_images)? false: is_float_image(filename, builtin_data, is_linear);
+	ImageDataType type = IMAGE_DATA_TYPE_BYTE4;
+
+	if(!pack_images)
+		type = get_image_metadata(filename, builtin_data, is_linear);
+
+	is_float = (type != IMAGE_DATA_TYPE_BYTE4 && type != IMAGE_DATA_TYPE_BYTE);
+
+	/* devices other than the CPU only support RGBA storage */
+	if(!compact_images)
+		type = (is_float)? IMAGE_DATA_TYPE_FLOAT4: IMAGE_DATA_TYPE_BYTE4;
 
 	if(is_float) {
 		/* find existing image */
@@ -186,6 +376,7 @@ int ImageManager::add_image(const string& filename, void *builtin_data, bool ani
 		img->need_load = true;
 		img->animated = animated;
 		img->users = 1;
+		img->type = type;
 
 		float_images[slot] = img;
 	}
@@ -221,6 +412,7 @@ int ImageManager::add_image(const string& filename, void *builtin_data, bool ani
 		img->need_load = true;
 		img->animated = animated;
 		img->users = 1;
+		img->type = type;
 
 		images[slot] = img;
 
@@ -452,6 +644,146 @@ bool ImageManager::file_load_float_image(Image *img, device_vector<float4>& tex_
 	return true;
 }
 
+template<typename T>
+bool ImageManager::file_load_compact_image(Image *img, ImageDataType type, device_vector<T>& tex_img)
+{
+	if(img->filename == "")
+		return false;
+
+	TypeDesc format;
+	int channels;
+
+	if(type == IMAGE_DATA_TYPE_BYTE) {
+		format = TypeDesc::UINT8;
+		channels = 1;
+	}
+	else if(type == IMAGE_DATA_TYPE_FLOAT) {
+		format = TypeDesc::FLOAT;
+		channels = 1;
+	}
+	else if(type == IMAGE_DATA_TYPE_HALF4) {
+		format = TypeDesc::HALF;
+		channels = 4;
+	}
+	else
+		return false;
+
+	ImageInput *in = NULL;
+	int width, height, components;
+
+	if(!img->builtin_data) {
+		/* load image from file through OIIO */
+		in = ImageInput::create(img->filename);
+
+		if(!in)
+			return false;
+
+		ImageSpec spec;
+
+		if(!in->open(img->filename, spec)) {
+			delete in;
+			return false;
+		}
+
+		width = spec.width;
+		height = spec.height;
+		components = spec.nchannels;
+	}
+	else {
+		/* load image using builtin images callbacks, no half float support */
+		if(type == IMAGE_DATA_TYPE_HALF4 || !builtin_image_info_cb)
+			return false;
+		if(type == IMAGE_DATA_TYPE_BYTE && !builtin_image_pixels_cb)
+			return false;
+		if(type == IMAGE_DATA_TYPE_FLOAT && !builtin_image_float_pixels_cb)
+			return false;
+
+		bool is_float;
+		builtin_image_info_cb(img->filename, img->builtin_data, is_float, width, height, components);
+	}
+
+	/* file might have changed since we got the metadata, only RGB images can
+	 * be expanded to RGBA here */
+	if(!(components == channels || (channels == 4 && components == 3))) {
+		if(in) {
+			in->close();
+			delete in;
+		}
+
+		return false;
+	}
+
+	T *pixels = tex_img.resize(width, height);
+	int scanlinesize = width*components*format.size();
+
+	if(in) {
+		in->read_image(format,
+			(uchar*)pixels + (height-1)*scanlinesize,
+			AutoStride,
+			-scanlinesize,
+			AutoStride);
+
+		in->close();
+		delete in;
+	}
+	else if(type == IMAGE_DATA_TYPE_BYTE) {
+		builtin_image_pixels_cb(img->filename, img->builtin_data, (uchar*)pixels);
+	}
+	else {
+		builtin_image_float_pixels_cb(img->filename, img->builtin_data, (float*)pixels);
+	}
+
+	if(channels == 4 && components == 3) {
+		half *hpixels = (half*)pixels;
+		const half one = 0x3C00;
+
+		for(int i = width*height-1; i >= 0; i--) {
+			hpixels[i*4+3] = one;
+			hpixels[i*4+2] = hpixels[i*3+2];
+			hpixels[i*4+1] = hpixels[i*3+1];
+			hpixels[i*4+0] = hpixels[i*3+0];
+		}
+	}
+
+	return true;
+}
+
+template<typename T>
+void ImageManager::device_tex_free(Device *device, device_vector<T>& tex_img)
+{
+	if(tex_img.device_pointer) {
+		thread_scoped_lock device_lock(device_mutex);
+		device->tex_free(tex_img);
+	}
+
+	tex_img.clear();
+}
+
+template<typename T>
+void ImageManager::device_tex_alloc(Device *device, const char *prefix, int slot, device_vector<T>& tex_img)
+{
+	if(pack_images)
+		return;
+
+	string name = string_printf("%s_%03d", prefix, slot);
+
+	thread_scoped_lock device_lock(device_mutex);
+	device->tex_alloc(name.c_str(), tex_img, true, true);
+}
+
+template<typename T>
+void ImageManager::device_compact_tex_free(Device *device, const char *prefix, int slot, device_vector<T>& tex_img)
+{
+	bool bound = (tex_img.device_pointer != 0);
+
+	device_tex_free(device, tex_img);
+
+	/* the kernel picks the storage of a slot by which texture has data, so
+	 * bind the now empty texture to clear its pointer to the freed pixels */
+	if(bound)
+		device_tex_alloc(device, prefix, slot, tex_img);
+}
+
 void ImageManager::device_load_image(Device *device, DeviceScene *dscene, int slot, Progress *progress)
 {
 	if(progress->get_cancel())
@@ -471,18 +803,28 @@ void ImageManager::device_load_image(Device *device, DeviceScene *dscene, int sl
 		is_float = true;
 	}
 
-	if(is_float) {
-		string filename = path_filename(float_images[slot]->filename);
-		progress->set_status("Updating Images", "Loading " + filename);
+	string filename = path_filename(img->filename);
+	progress->set_status("Updating Images", "Loading " + filename);
 
+	if(is_float) {
 		device_vector<float4>& tex_img = dscene->tex_float_image[slot];
+		device_vector<float>& tex_float1_img = dscene->tex_float1_image[slot];
+		device_vector<half4>& tex_half4_img = dscene->tex_half4_image[slot];
 
-		if(tex_img.device_pointer) {
-			thread_scoped_lock device_lock(device_mutex);
-			device->tex_free(tex_img);
-		}
+		device_tex_free(device, tex_img);
+		device_compact_tex_free(device, "__tex_image_float1", slot, tex_float1_img);
+		device_compact_tex_free(device, "__tex_image_half4", slot, tex_half4_img);
 
-		if(!file_load_float_image(img, tex_img)) {
+		if(use_texture_cache && texture_cache_load_image(img, slot)) {
+			/* pixels are read on demand by the texture cache */
+		}
+		else if(img->type == IMAGE_DATA_TYPE_FLOAT && file_load_compact_image(img, img->type, tex_float1_img)) {
+			/* single channel float */
+		}
+		else if(img->type == IMAGE_DATA_TYPE_HALF4 && file_load_compact_image(img, img->type, tex_half4_img)) {
+			/* half float RGBA */
+		}
+		else if(!file_load_float_image(img, tex_img)) {
 			/* on failure to load, we set a 1x1 pixels pink image */
 			float *pixels = (float*)tex_img.resize(1, 1);
 
@@ -492,28 +834,27 @@ void ImageManager::device_load_image(Device *device, DeviceScene *dscene, int sl
 			pixels[3] = TEX_IMAGE_MISSING_A;
 		}
 
-		string name;
+		device_tex_alloc(device, "__tex_image_float", slot, tex_img);
 
-		if(slot >= 10) name = string_printf("__tex_image_float_0%d", slot);
-		else name = string_printf("__tex_image_float_00%d", slot);
-
-		if(!pack_images) {
-			thread_scoped_lock device_lock(device_mutex);
-			device->tex_alloc(name.c_str(), tex_img, true, true);
-		}
+		if(tex_float1_img.size())
+			device_tex_alloc(device, "__tex_image_float1", slot, tex_float1_img);
+		if(tex_half4_img.size())
+			device_tex_alloc(device, "__tex_image_half4", slot, tex_half4_img);
 	}
 	else {
-		string filename = path_filename(images[slot - tex_image_byte_start]->filename);
-		progress->set_status("Updating Images", "Loading " + filename);
-
 		device_vector<uchar4>& tex_img = dscene->tex_image[slot - tex_image_byte_start];
+		device_vector<uchar>& tex_byte1_img = dscene->tex_byte1_image[slot - tex_image_byte_start];
 
-		if(tex_img.device_pointer) {
-			thread_scoped_lock device_lock(device_mutex);
-			device->tex_free(tex_img);
-		}
+		device_tex_free(device, tex_img);
+		device_compact_tex_free(device, "__tex_image_byte1", slot, tex_byte1_img);
 
-		if(!file_load_image(img, tex_img)) {
+		if(use_texture_cache && texture_cache_load_image(img, slot)) {
+			/* pixels are read on demand by the texture cache */
+		}
+		else if(img->type == IMAGE_DATA_TYPE_BYTE && file_load_compact_image(img, img->type, tex_byte1_img)) {
+			/* single channel byte */
+		}
+		else if(!file_load_image(img, tex_img)) {
 			/* on failure to load, we set a 1x1 pixels pink image */
 			uchar *pixels = (uchar*)tex_img.resize(1, 1);
 
@@ -523,15 +864,10 @@ void ImageManager::device_load_image(Device *device, DeviceScene *dscene, int sl
 			pixels[3] = (TEX_IMAGE_MISSING_A * 255);
 		}
 
-		string name;
+		device_tex_alloc(device, "__tex_image", slot, tex_img);
 
-		if(slot >= 10) name = string_printf("__tex_image_0%d", slot);
-		else name = string_printf("__tex_image_00%d", slot);
-
-		if(!pack_images) {
-			thread_scoped_lock device_lock(device_mutex);
-			device->tex_alloc(name.c_str(), tex_img, true, true);
-		}
+		if(tex_byte1_img.size())
+			device_tex_alloc(device, "__tex_image_byte1", slot, tex_byte1_img);
 	}
 
 	img->need_load = false;
@@ -552,6 +888,11 @@ void ImageManager::device_free_image(Device *device, DeviceScene *dscene, int sl
 	}
 
 	if(img) {
+		if(texture_cache && texture_cache_handles[slot]) {
+			((TextureSystem*)texture_cache)->invalidate(ustring(img->filename));
+			texture_cache_handles[slot] = NULL;
+		}
+
 		if(osl_texture_system) {
 #ifdef WITH_OSL
 			ustring filename(images[slot]->filename);
@@ -559,27 +900,16 @@ void ImageManager::device_free_image(Device *device, DeviceScene *dscene, int sl
 #endif
 		}
 		else if(is_float) {
-			device_vector<float4>& tex_img = dscene->tex_float_image[slot];
-
-			if(tex_img.device_pointer) {
-				thread_scoped_lock device_lock(device_mutex);
-				device->tex_free(tex_img);
-			}
-
-			tex_img.clear();
+			device_tex_free(device, dscene->tex_float_image[slot]);
+			device_compact_tex_free(device, "__tex_image_float1", slot, dscene->tex_float1_image[slot]);
+			device_compact_tex_free(device, "__tex_image_half4", slot, dscene->tex_half4_image[slot]);
 
 			delete float_images[slot];
 			float_images[slot] = NULL;
 		}
 		else {
-			device_vector<uchar4>& tex_img = dscene->tex_image[slot - tex_image_byte_start];
-
-			if(tex_img.device_pointer) {
-				thread_scoped_lock device_lock(device_mutex);
-				device->tex_free(tex_img);
-			}
-
-			tex_img.clear();
+			device_tex_free(device, dscene->tex_image[slot - tex_image_byte_start]);
+			device_compact_tex_free(device, "__tex_image_byte1", slot, dscene->tex_byte1_image[slot - tex_image_byte_start]);
 
 			delete images[slot - tex_image_byte_start];
 			images[slot - tex_image_byte_start] = NULL;
@@ -680,6 +1010,17 @@ void ImageManager::device_free(Device *device, DeviceScene *dscene)
 
 	images.clear();
 	float_images.clear();
+
+	if(texture_cache) {
+		texture_image_cache *kernel_cache = (texture_image_cache*)device->texture_cache_memory();
+
+		if(kernel_cache) {
+			kernel_cache->lookup = NULL;
+			kernel_cache->cache = NULL;
+		}
+
+		texture_cache_free();
+	}
 }
 
 CCL_NAMESPACE_END
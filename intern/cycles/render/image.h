@@ -57,16 +57,30 @@ public:
 	void device_free(Device *device, DeviceScene *dscene);
 
 	void set_osl_texture_system(void *texture_system);
+	void set_texture_cache(Device *device, bool use_texture_cache_, int texture_cache_size_);
 	void set_pack_images(bool pack_images_);
+	void set_compact_images(bool compact_images_);
 	void set_extended_image_limits(void);
 	bool set_animation_frame_update(int frame);
 
+	void texture_cache_stats(Progress& progress);
+
 	bool need_update;
 
 	boost::function<void(const string &filename, void *data, bool &is_float, int &width, int &height, int &channels)> builtin_image_info_cb;
 	boost::function<bool(const string &filename, void *data, unsigned char *pixels)> builtin_image_pixels_cb;
 	boost::function<bool(const string &filename, void *data, float *pixels)> builtin_image_float_pixels_cb;
 private:
+	/* storage of image pixels, besides RGBA byte and float images the CPU
+	 * supports compact storage for single channel and half float images */
+	enum ImageDataType {
+		IMAGE_DATA_TYPE_FLOAT4,
+		IMAGE_DATA_TYPE_BYTE4,
+		IMAGE_DATA_TYPE_HALF4,
+		IMAGE_DATA_TYPE_FLOAT,
+		IMAGE_DATA_TYPE_BYTE
+	};
+
 	int tex_num_images;
 	int tex_num_float_images;
 	int tex_image_byte_start;
@@ -80,15 +94,36 @@ private:
 		bool need_load;
 		bool animated;
 		int users;
+		ImageDataType type;
 	};
 
 	vector<Image*> images;
 	vector<Image*> float_images;
 	void *osl_texture_system;
 	bool pack_images;
+	bool compact_images;
+
+	/* on-demand tiled and mipmapped loading of image files, the images are
+	 * not loaded into device memory but looked up from the kernel through
+	 * the texture cache, which keeps memory usage within the given size */
+	bool use_texture_cache;
+	int texture_cache_size;
+	void *texture_cache;
+	vector<void*> texture_cache_handles;
+
+	static bool texture_cache_lookup(void *cache, int slot, float x, float y, float4 *result);
+	bool texture_cache_load_image(Image *img, int slot);
+	void texture_cache_free();
+
+	ImageDataType get_image_metadata(const string& filename, void *builtin_data, bool& is_linear);
 
 	bool file_load_image(Image *img, device_vector<uchar4>& tex_img);
 	bool file_load_float_image(Image *img, device_vector<float4>& tex_img);
+	template<typename T> bool file_load_compact_image(Image *img, ImageDataType type, device_vector<T>& tex_img);
+
+	template<typename T> void device_tex_free(Device *device, device_vector<T>& tex_img);
+	template<typename T> void device_tex_alloc(Device *device, const char *prefix, int slot, device_vector<T>& tex_img);
+	template<typename T> void device_compact_tex_free(Device *device, const char *prefix, int slot, device_vector<T>& tex_img);
 
 	void device_load_image(Device *device, DeviceScene *dscene, int slot, Progress *progess);
 	void device_free_image(Device *device, DeviceScene *dscene, int slot);
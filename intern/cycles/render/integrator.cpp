@@ -57,6 +57,7 @@ Integrator::Integrator()
 	method = PATH;
 
 	sampling_pattern = SAMPLING_PATTERN_SOBOL;
+	use_light_tree = false;
 
 	need_update = true;
 }
@@ -172,11 +173,16 @@ bool Integrator::modified(const Integrator& integrator)
 		mesh_light_samples == integrator.mesh_light_samples &&
 		subsurface_samples == integrator.subsurface_samples &&
 		motion_blur == integrator.motion_blur &&
-		sampling_pattern == integrator.sampling_pattern);
+		sampling_pattern == integrator.sampling_pattern &&
+		use_light_tree == integrator.use_light_tree);
 }
 
 void Integrator::tag_update(Scene *scene)
 {
+	/* light tree is built along with the light distribution */
+	if(scene->light_manager->use_light_tree != (use_light_tree && method == PATH))
+		scene->light_manager->tag_update(scene);
+
 	need_update = true;
 }
 
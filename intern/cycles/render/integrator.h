@@ -65,6 +65,7 @@ public:
 	Method method;
 
 	SamplingPattern sampling_pattern;
+	bool use_light_tree;
 
 	bool need_update;
 
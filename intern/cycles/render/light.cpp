@@ -19,6 +19,7 @@
 #include "integrator.h"
 #include "film.h"
 #include "light.h"
+#include "light_tree.h"
 #include "mesh.h"
 #include "object.h"
 #include "scene.h"
@@ -135,6 +136,7 @@ LightManager::LightManager()
 {
 	need_update = true;
 	use_light_visibility = false;
+	use_light_tree = false;
 }
 
 LightManager::~LightManager()
@@ -196,6 +198,13 @@ void LightManager::device_update_distribution(Device *device, DeviceScene *dscen
 	float4 *distribution = dscene->light_distribution.resize(num_distribution + 1);
 	float totarea = 0.0f;
 
+	/* light tree, only supported by the path integrator */
+	Integrator *integrator = scene->integrator;
+	use_light_tree = integrator->use_light_tree && integrator->method == Integrator::PATH;
+
+	bool build_light_tree = use_light_tree && device->info.advanced_shading;
+	vector<LightTreeEmitter> tree_emitters;
+
 	/* triangles */
 	size_t offset = 0;
 	int j = 0;
@@ -264,7 +273,23 @@ void LightManager::device_update_distribution(Device *device, DeviceScene *dscen
 						p3 = transform_point(&tfm, p3);
 					}
 
-					totarea += triangle_area(p1, p2, p3);
+					float area = triangle_area(p1, p2, p3);
+					totarea += area;
+
+					if(build_light_tree) {
+						LightTreeEmitter emitter;
+						float3 N = cross(p2 - p1, p3 - p1);
+
+						emitter.bounds = BoundBox(p1);
+						emitter.bounds.grow(p2);
+						emitter.bounds.grow(p3);
+						emitter.axis = (len(N) > 0.0f)? normalize(N): make_float3(0.0f, 0.0f, 1.0f);
+						emitter.theta_o = 0.0f;
+						emitter.energy = area;
+						emitter.index = offset - 1;
+
+						tree_emitters.push_back(emitter);
+					}
 				}
 			}
 
@@ -327,6 +352,38 @@ void LightManager::device_update_distribution(Device *device, DeviceScene *dscen
 			use_lamp_mis = true;
 		if(light->type == LIGHT_BACKGROUND)
 			num_background_lights++;
+
+		/* distant and background lights have no position, and are sampled
+		 * separately from the tree */
+		if(build_light_tree && light->type != LIGHT_DISTANT && light->type != LIGHT_BACKGROUND) {
+			LightTreeEmitter emitter;
+			float3 dir = (len(light->dir) > 0.0f)? normalize(light->dir): make_float3(0.0f, 0.0f, 1.0f);
+
+			emitter.bounds = BoundBox(light->co);
+			emitter.axis = dir;
+			emitter.theta_o = M_PI_F;
+			emitter.energy = lightarea;
+			emitter.index = offset;
+
+			if(light->type == LIGHT_AREA) {
+				float3 axisu = light->axisu*(light->sizeu*light->size*0.5f);
+				float3 axisv = light->axisv*(light->sizev*light->size*0.5f);
+
+				emitter.bounds.grow(light->co - axisu - axisv);
+				emitter.bounds.grow(light->co + axisu - axisv);
+				emitter.bounds.grow(light->co - axisu + axisv);
+				emitter.bounds.grow(light->co + axisu + axisv);
+				emitter.theta_o = 0.0f;
+			}
+			else {
+				emitter.bounds.grow(light->co, light->size);
+
+				if(light->type == LIGHT_SPOT)
+					emitter.theta_o = min(light->spot_angle*0.5f, M_PI_F);
+			}
+
+			tree_emitters.push_back(emitter);
+		}
 	}
 
 	/* normalize cumulative distribution functions */
@@ -335,6 +392,17 @@ void LightManager::device_update_distribution(Device *device, DeviceScene *dscen
 	distribution[num_distribution].z = 0.0f;
 	distribution[num_distribution].w = 0.0f;
 
+	if(build_light_tree && tree_emitters.size()) {
+		device_update_tree(device, dscene, scene, distribution, num_distribution, tree_emitters);
+	}
+	else {
+		KernelIntegrator *kintegrator = &dscene->data.integrator;
+
+		kintegrator->use_light_tree = false;
+		kintegrator->num_light_tree_emitters = 0;
+		kintegrator->light_tree_prob_infinite = 0.0f;
+	}
+
 	if(totarea > 0.0f) {
 		for(size_t i = 0; i < num_distribution; i++)
 			distribution[i].x /= totarea;
@@ -402,6 +470,89 @@ void LightManager::device_update_distribution(Device *device, DeviceScene *dscen
 	}
 }
 
+void LightManager::device_update_tree(Device *device, DeviceScene *dscene, Scene *scene,
+	float4 *distribution, size_t num_distribution, vector<LightTreeEmitter>& emitters)
+{
+	/* build tree, this reorders the emitters */
+	LightTree tree;
+	tree.build(emitters);
+
+	/* new order of the distribution, tree emitters in tree order followed by
+	 * distant and background lights */
+	vector<int> order;
+	vector<bool> in_tree(num_distribution, false);
+
+	order.reserve(num_distribution);
+
+	foreach(LightTreeEmitter& emitter, emitters) {
+		order.push_back(emitter.index);
+		in_tree[emitter.index] = true;
+	}
+
+	float totarea = distribution[num_distribution].x;
+	float infinite_area = 0.0f;
+
+	for(size_t i = 0; i < num_distribution; i++) {
+		if(!in_tree[i]) {
+			order.push_back(i);
+			infinite_area += distribution[i + 1].x - distribution[i].x;
+		}
+	}
+
+	/* reorder distribution, recomputing the cumulative area */
+	vector<float4> old_distribution(distribution, distribution + num_distribution + 1);
+	float area = 0.0f;
+
+	for(size_t i = 0; i < num_distribution; i++) {
+		const float4& l = old_distribution[order[i]];
+
+		distribution[i] = l;
+		distribution[i].x = area;
+
+		area += old_distribution[order[i] + 1].x - l.x;
+	}
+
+	/* map object and triangle index to distribution index, to find the pdf
+	 * of triangles hit by indirect rays. per object there is an offset into
+	 * the map followed by the mesh triangle offset */
+	vector<uint> emitter_map(scene->objects.size()*2, LIGHT_TREE_NONE);
+
+	for(size_t i = 0; i < emitters.size(); i++) {
+		int prim = __float_as_int(distribution[i].y);
+
+		if(prim < 0)
+			continue;
+
+		int object_id = __float_as_int(distribution[i].w);
+		int object = (object_id < 0)? ~object_id: object_id;
+		Mesh *mesh = scene->objects[object]->mesh;
+
+		if(emitter_map[object*2] == LIGHT_TREE_NONE) {
+			emitter_map[object*2] = emitter_map.size();
+			emitter_map[object*2 + 1] = mesh->tri_offset;
+			emitter_map.resize(emitter_map.size() + mesh->triangles.size(), LIGHT_TREE_NONE);
+		}
+
+		emitter_map[emitter_map[object*2] + prim - mesh->tri_offset] = i;
+	}
+
+	/* update device */
+	KernelIntegrator *kintegrator = &dscene->data.integrator;
+
+	kintegrator->use_light_tree = true;
+	kintegrator->num_light_tree_emitters = emitters.size();
+	kintegrator->light_tree_prob_infinite = (totarea > 0.0f)? infinite_area/totarea: 0.0f;
+
+	float4 *nodes = dscene->light_tree_nodes.resize(tree.nodes.size());
+	memcpy(nodes, &tree.nodes[0], tree.nodes.size()*sizeof(float4));
+
+	uint *map = dscene->light_tree_emitter_map.resize(emitter_map.size());
+	memcpy(map, &emitter_map[0], emitter_map.size()*sizeof(uint));
+
+	device->tex_alloc("__light_tree_nodes", dscene->light_tree_nodes);
+	device->tex_alloc("__light_tree_emitter_map", dscene->light_tree_emitter_map);
+}
+
 void LightManager::device_update_background(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress)
 {
 	KernelIntegrator *kintegrator = &dscene->data.integrator;
@@ -666,11 +817,15 @@ void LightManager::device_free(Device *device, DeviceScene *dscene)
 {
 	device->tex_free(dscene->light_distribution);
 	device->tex_free(dscene->light_data);
+	device->tex_free(dscene->light_tree_nodes);
+	device->tex_free(dscene->light_tree_emitter_map);
 	device->tex_free(dscene->light_background_marginal_cdf);
 	device->tex_free(dscene->light_background_conditional_cdf);
 
 	dscene->light_distribution.clear();
 	dscene->light_data.clear();
+	dscene->light_tree_nodes.clear();
+	dscene->light_tree_emitter_map.clear();
 	dscene->light_background_marginal_cdf.clear();
 	dscene->light_background_conditional_cdf.clear();
 }
@@ -26,6 +26,7 @@ CCL_NAMESPACE_BEGIN
 
 class Device;
 class DeviceScene;
+class LightTreeEmitter;
 class Progress;
 class Scene;
 
@@ -64,6 +65,7 @@ public:
 class LightManager {
 public:
 	bool use_light_visibility;
+	bool use_light_tree;
 	bool need_update;
 
 	LightManager();
@@ -77,6 +79,8 @@ public:
 protected:
 	void device_update_points(Device *device, DeviceScene *dscene, Scene *scene);
 	void device_update_distribution(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress);
+	void device_update_tree(Device *device, DeviceScene *dscene, Scene *scene,
+		float4 *distribution, size_t num_distribution, vector<LightTreeEmitter>& emitters);
 	void device_update_background(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress);
 };
 
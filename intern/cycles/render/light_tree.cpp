@@ -0,0 +1,291 @@
+/*
+ * Copyright 2011-2013 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License
+ */
+
+#include "kernel_types.h"
+
+#include "light_tree.h"
+
+#include "util_algorithm.h"
+#include "util_math.h"
+
+CCL_NAMESPACE_BEGIN
+
+#define LIGHT_TREE_NUM_BINS 12
+#define LIGHT_TREE_MAX_LEAF_SIZE 4
+
+/* Cone Merging
+ *
+ * Smallest cone containing both cones, from "Importance Sampling of Many
+ * Lights with Adaptive Tree Splitting". Emitters are two sided, so cones are
+ * flipped into the same hemisphere first. A negative spread marks an empty
+ * cone. */
+
+static void merge_cone(float3& axis, float& theta_o, float3 axis_b, float theta_b)
+{
+	if(theta_b < 0.0f)
+		return;
+
+	if(theta_o < 0.0f) {
+		axis = axis_b;
+		theta_o = theta_b;
+		return;
+	}
+
+	float3 axis_a = axis;
+	float theta_a = theta_o;
+
+	if(dot(axis_a, axis_b) < 0.0f)
+		axis_b = -axis_b;
+
+	if(theta_b > theta_a) {
+		swap(axis_a, axis_b);
+		swap(theta_a, theta_b);
+	}
+
+	float cos_d = dot(axis_a, axis_b);
+	float theta_d = safe_acosf(cos_d);
+
+	if(min(theta_d + theta_b, M_PI_F) <= theta_a) {
+		axis = axis_a;
+		theta_o = theta_a;
+		return;
+	}
+
+	float theta_n = 0.5f*(theta_a + theta_d + theta_b);
+
+	if(theta_n >= M_PI_F) {
+		axis = axis_a;
+		theta_o = M_PI_F;
+		return;
+	}
+
+	/* rotate axis a towards b */
+	float theta_r = theta_n - theta_a;
+	float3 ortho = axis_b - axis_a*cos_d;
+	float ortho_len = len(ortho);
+
+	if(ortho_len > 1e-6f)
+		axis = normalize(axis_a*cosf(theta_r) + ortho*(sinf(theta_r)/ortho_len));
+	else
+		axis = axis_a;
+
+	theta_o = theta_n;
+}
+
+/* Emitter Partitioning */
+
+class LightTreeSplitPredicate {
+public:
+	LightTreeSplitPredicate(int dim_, float bin_min_, float bin_scale_, int split_bin_)
+	: dim(dim_), bin_min(bin_min_), bin_scale(bin_scale_), split_bin(split_bin_) {}
+
+	bool operator()(const LightTreeEmitter& emitter) const
+	{
+		return light_tree_bin(emitter, dim, bin_min, bin_scale) < split_bin;
+	}
+
+	static int light_tree_bin(const LightTreeEmitter& emitter, int dim, float bin_min, float bin_scale)
+	{
+		float3 centroid = emitter.centroid();
+		int bin = (int)((centroid[dim] - bin_min)*bin_scale);
+
+		return clamp(bin, 0, LIGHT_TREE_NUM_BINS - 1);
+	}
+
+protected:
+	int dim;
+	float bin_min;
+	float bin_scale;
+	int split_bin;
+};
+
+/* Light Tree */
+
+LightTree::LightTree()
+{
+}
+
+void LightTree::build(vector<LightTreeEmitter>& emitters)
+{
+	nodes.clear();
+
+	if(emitters.size() == 0)
+		return;
+
+	/* node count is at most twice the number of leaves */
+	nodes.reserve(2*(emitters.size()/LIGHT_TREE_MAX_LEAF_SIZE + 1)*LIGHT_TREE_NODE_SIZE);
+
+	build_node(emitters, 0, emitters.size());
+}
+
+LightTree::NodeInfo LightTree::node_info(const vector<LightTreeEmitter>& emitters, int begin, int end)
+{
+	NodeInfo info;
+
+	info.bounds = BoundBox::empty;
+	info.axis = make_float3(0.0f, 0.0f, 1.0f);
+	info.theta_o = -1.0f;
+	info.energy = 0.0f;
+
+	for(int i = begin; i < end; i++) {
+		const LightTreeEmitter& emitter = emitters[i];
+
+		info.bounds.grow(emitter.bounds);
+		info.energy += emitter.energy;
+		merge_cone(info.axis, info.theta_o, emitter.axis, emitter.theta_o);
+	}
+
+	return info;
+}
+
+float LightTree::node_cost(const NodeInfo& info)
+{
+	/* orientation measure of the cone, assuming emission over the full
+	 * hemisphere around each emitter normal */
+	float theta_o = max(info.theta_o, 0.0f);
+	float theta_w = min(theta_o + M_PI_2_F, M_PI_F);
+	float sin_o = sinf(theta_o);
+	float cos_o = cosf(theta_o);
+
+	float measure = M_2PI_F*(1.0f - cos_o) +
+		M_PI_2_F*(2.0f*theta_w*sin_o - cosf(theta_o - 2.0f*theta_w) - 2.0f*theta_o*sin_o + cos_o);
+
+	return info.energy*measure*info.bounds.half_area();
+}
+
+void LightTree::pack_node(int node, const NodeInfo& info, int x, int y, int z, int w)
+{
+	float4 *data = &nodes[node*LIGHT_TREE_NODE_SIZE];
+
+	data[0] = make_float4(info.bounds.min.x, info.bounds.min.y, info.bounds.min.z, info.energy);
+	data[1] = make_float4(info.bounds.max.x, info.bounds.max.y, info.bounds.max.z, max(info.theta_o, 0.0f));
+	data[2] = make_float4(info.axis.x, info.axis.y, info.axis.z, 0.0f);
+	data[3] = make_float4(__int_as_float(x), __int_as_float(y), __int_as_float(z), __int_as_float(w));
+}
+
+int LightTree::build_node(vector<LightTreeEmitter>& emitters, int begin, int end)
+{
+	int node = nodes.size()/LIGHT_TREE_NODE_SIZE;
+	int num = end - begin;
+
+	nodes.resize(nodes.size() + LIGHT_TREE_NODE_SIZE);
+
+	NodeInfo info = node_info(emitters, begin, end);
+
+	if(num <= LIGHT_TREE_MAX_LEAF_SIZE) {
+		pack_node(node, info, begin, 0, num, 0);
+		return node;
+	}
+
+	/* centroid bounds */
+	BoundBox centroid_bounds = BoundBox::empty;
+
+	for(int i = begin; i < end; i++)
+		centroid_bounds.grow(emitters[i].centroid());
+
+	float3 extent = centroid_bounds.size();
+
+	/* find best split over all dimensions */
+	int best_dim = -1;
+	int best_bin = 0;
+	float best_cost = FLT_MAX;
+
+	for(int dim = 0; dim < 3; dim++) {
+		if(extent[dim] <= 0.0f)
+			continue;
+
+		float bin_min = centroid_bounds.min[dim];
+		float bin_scale = LIGHT_TREE_NUM_BINS/extent[dim];
+
+		NodeInfo bins[LIGHT_TREE_NUM_BINS];
+		int counts[LIGHT_TREE_NUM_BINS];
+
+		for(int b = 0; b < LIGHT_TREE_NUM_BINS; b++) {
+			bins[b].bounds = BoundBox::empty;
+			bins[b].axis = make_float3(0.0f, 0.0f, 1.0f);
+			bins[b].theta_o = -1.0f;
+			bins[b].energy = 0.0f;
+			counts[b] = 0;
+		}
+
+		for(int i = begin; i < end; i++) {
+			const LightTreeEmitter& emitter = emitters[i];
+			int b = LightTreeSplitPredicate::light_tree_bin(emitter, dim, bin_min, bin_scale);
+
+			bins[b].bounds.grow(emitter.bounds);
+			bins[b].energy += emitter.energy;
+			merge_cone(bins[b].axis, bins[b].theta_o, emitter.axis, emitter.theta_o);
+			counts[b]++;
+		}
+
+		/* sweep from the right, then evaluate splits from the left */
+		float right_cost[LIGHT_TREE_NUM_BINS];
+		NodeInfo right = bins[LIGHT_TREE_NUM_BINS - 1];
+
+		right_cost[LIGHT_TREE_NUM_BINS - 1] = node_cost(right);
+
+		for(int b = LIGHT_TREE_NUM_BINS - 2; b > 0; b--) {
+			right.bounds.grow(bins[b].bounds);
+			right.energy += bins[b].energy;
+			merge_cone(right.axis, right.theta_o, bins[b].axis, bins[b].theta_o);
+			right_cost[b] = node_cost(right);
+		}
+
+		NodeInfo left = bins[0];
+		int left_count = counts[0];
+
+		for(int b = 1; b < LIGHT_TREE_NUM_BINS; b++) {
+			if(left_count > 0 && left_count < num) {
+				float cost = node_cost(left) + right_cost[b];
+
+				if(cost < best_cost) {
+					best_cost = cost;
+					best_dim = dim;
+					best_bin = b;
+				}
+			}
+
+			left.bounds.grow(bins[b].bounds);
+			left.energy += bins[b].energy;
+			merge_cone(left.axis, left.theta_o, bins[b].axis, bins[b].theta_o);
+			left_count += counts[b];
+		}
+	}
+
+	/* partition, falling back to splitting in the middle when all centroids
+	 * coincide or every split leaves one side empty */
+	int middle;
+
+	if(best_dim != -1) {
+		float bin_min = centroid_bounds.min[best_dim];
+		float bin_scale = LIGHT_TREE_NUM_BINS/extent[best_dim];
+		LightTreeSplitPredicate predicate(best_dim, bin_min, bin_scale, best_bin);
+
+		middle = std::partition(emitters.begin() + begin, emitters.begin() + end, predicate) - emitters.begin();
+	}
+	else
+		middle = begin + num/2;
+
+	int child0 = build_node(emitters, begin, middle);
+	int child1 = build_node(emitters, middle, end);
+
+	pack_node(node, info, child0, child1, 0, middle);
+
+	return node;
+}
+
+CCL_NAMESPACE_END
+
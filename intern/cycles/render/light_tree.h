@@ -0,0 +1,81 @@
+/*
+ * Copyright 2011-2013 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License
+ */
+
+#ifndef __LIGHT_TREE_H__
+#define __LIGHT_TREE_H__
+
+#include "util_boundbox.h"
+#include "util_types.h"
+#include "util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Light Tree Emitter
+ *
+ * Emitting triangle or lamp with bounds, a cone bounding the directions it
+ * emits light in, and its weight in the light distribution as energy. */
+
+class LightTreeEmitter {
+public:
+	BoundBox bounds;
+	float3 axis;
+	float theta_o;
+	float energy;
+	int index;
+
+	float3 centroid() const { return bounds.center(); }
+};
+
+/* Light Tree
+ *
+ * Bounding volume hierarchy over emitters, built with a binned surface area
+ * orientation heuristic. Building reorders the emitters so that each node
+ * covers a contiguous range, nodes are packed for the kernel as
+ * LIGHT_TREE_NODE_SIZE float4's:
+ *
+ * 0: bounds min, energy
+ * 1: bounds max, cone spread angle
+ * 2: cone axis
+ * 3: inner node: child0, child1, 0, first emitter of child1
+ *    leaf node: first emitter, 0, number of emitters */
+
+class LightTree {
+public:
+	LightTree();
+
+	void build(vector<LightTreeEmitter>& emitters);
+
+	vector<float4> nodes;
+
+protected:
+	struct NodeInfo {
+		BoundBox bounds;
+		float3 axis;
+		float theta_o;
+		float energy;
+	};
+
+	int build_node(vector<LightTreeEmitter>& emitters, int begin, int end);
+
+	NodeInfo node_info(const vector<LightTreeEmitter>& emitters, int begin, int end);
+	float node_cost(const NodeInfo& info);
+	void pack_node(int node, const NodeInfo& info, int x, int y, int z, int w);
+};
+
+CCL_NAMESPACE_END
+
+#endif /* __LIGHT_TREE_H__ */
+
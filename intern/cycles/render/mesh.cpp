@@ -31,6 +31,7 @@
 #include "util_foreach.h"
 #include "util_progress.h"
 #include "util_set.h"
+#include "util_time.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -815,7 +816,7 @@ void MeshManager::device_update_mesh(Device *device, DeviceScene *dscene, Scene
 	}
 }
 
-void MeshManager::device_update_bvh(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress)
+void MeshManager::device_update_bvh(Device *device, DeviceScene *dscene, Scene *scene, const set<Mesh*>& updated_meshes, Progress& progress)
 {
 	/* bvh build */
 	progress.set_status("Updating Scene BVH", "Building");
@@ -826,9 +827,20 @@ void MeshManager::device_update_bvh(Device *device, DeviceScene *dscene, Scene *
 	bparams.use_spatial_split = scene->params.use_bvh_spatial_split;
 	bparams.use_cache = scene->params.use_bvh_cache;
 
-	delete bvh;
-	bvh = BVH::create(bparams, scene->objects);
-	bvh->build(progress);
+	/* with a dynamic BVH only the object level tree needs to be rebuilt, data
+	 * of meshes that did not change is kept from the previous update */
+	bool updated = false;
+
+	if(bvh && scene->params.bvh_type == SceneParams::BVH_DYNAMIC) {
+		bvh->objects = scene->objects;
+		updated = bvh->update(progress, updated_meshes);
+	}
+
+	if(!updated) {
+		delete bvh;
+		bvh = BVH::create(bparams, scene->objects);
+		bvh->build(progress);
+	}
 
 	if(progress.get_cancel()) return;
 
@@ -888,7 +900,10 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 		}
 	}
 
-	/* device update */
+	/* device update, timing each stage for the statistics */
+	double time_stage = time_dt();
+	double mesh_time, displacement_time, mesh_bvh_time;
+
 	device_free(device, dscene);
 
 	device_update_mesh(device, dscene, scene, progress);
@@ -897,6 +912,9 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 	device_update_attributes(device, dscene, scene, progress);
 	if(progress.get_cancel()) return;
 
+	mesh_time = time_dt() - time_stage;
+	time_stage = time_dt();
+
 	/* update displacement */
 	bool displacement_done = false;
 
@@ -918,12 +936,26 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 		if(progress.get_cancel()) return;
 	}
 
-	/* update bvh */
+	displacement_time = time_dt() - time_stage;
+	time_stage = time_dt();
+
+	/* update bvh, meshes that did not change keep their BVH */
+	if(scene->params.use_bvh_cache) {
+		Cache::global.set_max_size((size_t)scene->params.bvh_cache_size*1024*1024);
+		Cache::global.reset_stats();
+	}
+
 	size_t i = 0, num_bvh = 0;
+	set<Mesh*> updated_meshes;
 
-	foreach(Mesh *mesh, scene->meshes)
-		if(mesh->need_update && !mesh->transform_applied)
-			num_bvh++;
+	foreach(Mesh *mesh, scene->meshes) {
+		if(mesh->need_update) {
+			updated_meshes.insert(mesh);
+
+			if(!mesh->transform_applied)
+				num_bvh++;
+		}
+	}
 
 	TaskPool pool;
 
@@ -935,6 +967,9 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 	}
 
 	pool.wait_work();
+
+	mesh_bvh_time = time_dt() - time_stage;
+	time_stage = time_dt();
 	
 	foreach(Shader *shader, scene->shaders)
 		shader->need_update_attributes = false;
@@ -952,7 +987,18 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 
 	if(progress.get_cancel()) return;
 
-	device_update_bvh(device, dscene, scene, progress);
+	device_update_bvh(device, dscene, scene, updated_meshes, progress);
+
+	/* all lookups of this update are done now, mesh BVH's and the scene BVH */
+	if(scene->params.use_bvh_cache) {
+		int hits, misses;
+		Cache::global.get_stats(hits, misses);
+		progress.set_bvh_cache_stats(hits, misses);
+	}
+	else
+		progress.set_bvh_cache_stats(0, 0);
+
+	progress.set_mesh_update_times(mesh_time, displacement_time, mesh_bvh_time, time_dt() - time_stage);
 
 	need_update = false;
 }
@@ -24,6 +24,7 @@
 #include "util_list.h"
 #include "util_map.h"
 #include "util_param.h"
+#include "util_set.h"
 #include "util_transform.h"
 #include "util_types.h"
 #include "util_vector.h"
@@ -149,7 +150,7 @@ public:
 	void device_update_object(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress);
 	void device_update_mesh(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress);
 	void device_update_attributes(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress);
-	void device_update_bvh(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress);
+	void device_update_bvh(Device *device, DeviceScene *dscene, Scene *scene, const set<Mesh*>& updated_meshes, Progress& progress);
 	void device_free(Device *device, DeviceScene *dscene);
 
 	void tag_update(Scene *scene);
@@ -61,8 +61,11 @@ Scene::Scene(const SceneParams& params_, const DeviceInfo& device_info_)
 	else
 		shader_manager = ShaderManager::create(this, SceneParams::SVM);
 
-	if (device_info_.type == DEVICE_CPU)
+	/* single channel and half float images are only supported on the CPU */
+	if (device_info_.type == DEVICE_CPU) {
 		image_manager->set_extended_image_limits();
+		image_manager->set_compact_images(true);
+	}
 }
 
 Scene::~Scene()
@@ -141,6 +144,7 @@ void Scene::device_update(Device *device_, Progress& progress)
 	 */
 	
 	image_manager->set_pack_images(device->info.pack_images);
+	image_manager->set_texture_cache(device, params.use_texture_cache, params.texture_cache_size);
 
 	progress.set_status("Updating Background");
 	background->device_update(device, &dscene, this);
@@ -86,6 +86,8 @@ public:
 	/* lights */
 	device_vector<float4> light_distribution;
 	device_vector<float4> light_data;
+	device_vector<float4> light_tree_nodes;
+	device_vector<uint> light_tree_emitter_map;
 	device_vector<float2> light_background_marginal_cdf;
 	device_vector<float2> light_background_conditional_cdf;
 
@@ -107,6 +109,11 @@ public:
 	device_vector<uchar4> tex_image[TEX_EXTENDED_NUM_IMAGES];
 	device_vector<float4> tex_float_image[TEX_EXTENDED_NUM_FLOAT_IMAGES];
 
+	/* compact images, CPU only */
+	device_vector<uchar> tex_byte1_image[TEX_EXTENDED_NUM_IMAGES];
+	device_vector<float> tex_float1_image[TEX_EXTENDED_NUM_FLOAT_IMAGES];
+	device_vector<half4> tex_half4_image[TEX_EXTENDED_NUM_FLOAT_IMAGES];
+
 	/* opencl images */
 	device_vector<uchar4> tex_image_packed;
 	device_vector<uint4> tex_image_packed_info;
@@ -121,15 +128,19 @@ public:
 	enum { OSL, SVM } shadingsystem;
 	enum BVHType { BVH_DYNAMIC, BVH_STATIC } bvh_type;
 	bool use_bvh_cache;
+	int bvh_cache_size;  /* in MB */
 	bool use_bvh_spatial_split;
 	bool use_qbvh;
 	bool persistent_data;
+	bool use_texture_cache;
+	int texture_cache_size;  /* in MB */
 
 	SceneParams()
 	{
 		shadingsystem = SVM;
 		bvh_type = BVH_DYNAMIC;
 		use_bvh_cache = false;
+		bvh_cache_size = 1024;
 		use_bvh_spatial_split = false;
 #ifdef __QBVH__
 		use_qbvh = true;
@@ -137,15 +148,20 @@ public:
 		use_qbvh = false;
 #endif
 		persistent_data = false;
+		use_texture_cache = false;
+		texture_cache_size = 4096;
 	}
 
 	bool modified(const SceneParams& params)
 	{ return !(shadingsystem == params.shadingsystem
 		&& bvh_type == params.bvh_type
 		&& use_bvh_cache == params.use_bvh_cache
+		&& bvh_cache_size == params.bvh_cache_size
 		&& use_bvh_spatial_split == params.use_bvh_spatial_split
 		&& use_qbvh == params.use_qbvh
-		&& persistent_data == params.persistent_data); }
+		&& persistent_data == params.persistent_data
+		&& use_texture_cache == params.use_texture_cache
+		&& texture_cache_size == params.texture_cache_size); }
 };
 
 /* Scene */
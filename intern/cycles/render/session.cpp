@@ -20,6 +20,7 @@
 #include "buffers.h"
 #include "camera.h"
 #include "device.h"
+#include "image.h"
 #include "integrator.h"
 #include "scene.h"
 #include "session.h"
@@ -33,6 +34,10 @@
 
 CCL_NAMESPACE_BEGIN
 
+/* with adaptive sampling, samples skipped by converged tiles are spent on tiles that
+ * are still noisy at their last sample, up to this multiple of the number of samples */
+#define ADAPTIVE_MAX_SAMPLES_FACTOR 4
+
 /* Note about  preserve_tile_device option for tile manager:
  * progressive refine and viewport rendering does requires tiles to
  * always be allocated for the same device
@@ -67,6 +72,7 @@ Session::Session(const SessionParams& params_)
 	preview_time = 0.0;
 	paused_time = 0.0;
 	last_update_time = 0.0;
+	adaptive_sample_pool = 0;
 
 	delayed_reset.do_reset = false;
 	delayed_reset.samples = 0;
@@ -445,6 +451,16 @@ void Session::release_tile(RenderTile& rtile)
 {
 	thread_scoped_lock tile_lock(tile_mutex);
 
+	/* count samples skipped by adaptive sampling as done, so progress and
+	 * the per tile sample counter stay correct, and give them to the tiles
+	 * that are still noisy */
+	int skipped_samples = rtile.start_sample + rtile.num_samples - rtile.sample;
+
+	if(skipped_samples > 0 && !progress.get_cancel()) {
+		progress.add_samples(skipped_samples);
+		adaptive_sample_pool += (int64_t)skipped_samples*rtile.w*rtile.h;
+	}
+
 	if(write_render_tile_cb) {
 		if(params.progressive_refine == false) {
 			/* todo: optimize this by making it thread safe and removing lock */
@@ -457,6 +473,27 @@ void Session::release_tile(RenderTile& rtile)
 	update_status_time();
 }
 
+int Session::acquire_adaptive_samples(RenderTile& rtile, int num_samples)
+{
+	thread_scoped_lock tile_lock(tile_mutex);
+
+	int max_sample = rtile.start_sample + rtile.num_samples*ADAPTIVE_MAX_SAMPLES_FACTOR;
+
+	num_samples = min(num_samples, max_sample - rtile.sample);
+
+	if(num_samples <= 0 || progress.get_cancel())
+		return 0;
+
+	int64_t pixel_samples = (int64_t)num_samples*rtile.w*rtile.h;
+
+	if(adaptive_sample_pool < pixel_samples)
+		return 0;
+
+	adaptive_sample_pool -= pixel_samples;
+
+	return num_samples;
+}
+
 void Session::run_cpu()
 {
 	bool tiles_written = false;
@@ -647,6 +684,7 @@ void Session::reset_(BufferParams& buffer_params, int samples)
 	start_time = time_dt();
 	preview_time = 0.0;
 	paused_time = 0.0;
+	adaptive_sample_pool = 0;
 
 	if(!params.background)
 		progress.set_start_time(start_time + paused_time);
@@ -787,6 +825,25 @@ void Session::update_status_time(bool show_pause, bool show_done)
 		substatus = string_printf("Path Tracing Sample %d", sample+1);
 	else
 		substatus = string_printf("Path Tracing Sample %d/%d", sample+1, tile_manager.num_samples);
+
+	/* texture cache statistics */
+	uint64_t cache_hits, cache_misses, cache_memory;
+
+	scene->image_manager->texture_cache_stats(progress);
+	progress.get_texture_cache_stats(cache_hits, cache_misses, cache_memory);
+
+	if(cache_hits + cache_misses > 0) {
+		substatus += string_printf(", Texture Cache %.2fM, %.1f%% Hits",
+			(double)cache_memory/(1024.0*1024.0),
+			100.0*(double)cache_hits/(double)(cache_hits + cache_misses));
+	}
+
+	int bvh_cache_hits, bvh_cache_misses;
+
+	progress.get_bvh_cache_stats(bvh_cache_hits, bvh_cache_misses);
+
+	if(bvh_cache_hits + bvh_cache_misses > 0)
+		substatus += string_printf(", BVH Cache %d Hits, %d Misses", bvh_cache_hits, bvh_cache_misses);
 	
 	if(show_pause) {
 		status = "Paused";
@@ -831,6 +888,17 @@ void Session::path_trace()
 	task.need_finish_queue = params.progressive_refine;
 	task.integrator_branched = scene->integrator->method == Integrator::BRANCHED_PATH;
 
+	/* adaptive sampling only works when each tile is rendered to completion at once */
+	if(!params.progressive) {
+		task.adaptive_threshold = params.adaptive_threshold;
+		task.adaptive_min_samples = params.adaptive_min_samples;
+
+		/* correlated multi-jitter patterns are made for the number of samples,
+		 * sobol sequences can be continued beyond it */
+		if(scene->integrator->sampling_pattern == SAMPLING_PATTERN_SOBOL)
+			task.acquire_adaptive_samples = function_bind(&Session::acquire_adaptive_samples, this, _1, _2);
+	}
+
 	device->task_add(task);
 }
 
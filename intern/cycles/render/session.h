@@ -53,6 +53,9 @@ public:
 	int start_resolution;
 	int threads;
 
+	float adaptive_threshold;
+	int adaptive_min_samples;
+
 	bool display_buffer_linear;
 
 	double cancel_timeout;
@@ -74,6 +77,9 @@ public:
 		start_resolution = INT_MAX;
 		threads = 0;
 
+		adaptive_threshold = 0.0f;
+		adaptive_min_samples = 16;
+
 		display_buffer_linear = false;
 
 		cancel_timeout = 0.1;
@@ -96,6 +102,8 @@ public:
 		&& tile_size == params.tile_size
 		&& start_resolution == params.start_resolution
 		&& threads == params.threads
+		&& adaptive_threshold == params.adaptive_threshold
+		&& adaptive_min_samples == params.adaptive_min_samples
 		&& display_buffer_linear == params.display_buffer_linear
 		&& cancel_timeout == params.cancel_timeout
 		&& reset_timeout == params.reset_timeout
@@ -165,6 +173,7 @@ protected:
 	bool acquire_tile(Device *tile_device, RenderTile& tile);
 	void update_tile_sample(RenderTile& tile);
 	void release_tile(RenderTile& tile);
+	int acquire_adaptive_samples(RenderTile& tile, int num_samples);
 
 	void update_progress_sample();
 
@@ -192,6 +201,9 @@ protected:
 	double preview_time;
 	double paused_time;
 
+	/* pixel samples skipped by tiles that converged, protected by tile_mutex */
+	int64_t adaptive_sample_pool;
+
 	/* progressive refine */
 	double last_update_time;
 	bool update_progressive_refine(bool cancel);
@@ -15,7 +15,16 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <ctime>
 
+#ifdef _WIN32
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#include "util_algorithm.h"
 #include "util_cache.h"
 #include "util_debug.h"
 #include "util_foreach.h"
@@ -35,19 +44,67 @@
 
 CCL_NAMESPACE_BEGIN
 
+/* File Format */
+
+#define CACHE_ALIGN 16
+
+static const char cache_magic[8] = {'C', 'Y', 'C', 'A', 'C', 'H', 'E', '\0'};
+
+struct CacheHeader {
+	char magic[8];
+	int version;
+	int pad;
+};
+
+static size_t cache_align_up(size_t size)
+{
+	return (size + CACHE_ALIGN - 1) & ~(size_t)(CACHE_ALIGN - 1);
+}
+
+/* arrays reference the loaded data directly, so it must be aligned like a
+ * mapped file would be */
+static void *cache_aligned_malloc(size_t size)
+{
+#ifdef _WIN32
+	return _aligned_malloc(size, CACHE_ALIGN);
+#else
+	void *mem;
+	return (posix_memalign(&mem, CACHE_ALIGN, size) == 0)? mem: NULL;
+#endif
+}
+
+static void cache_aligned_free(void *mem)
+{
+#ifdef _WIN32
+	_aligned_free(mem);
+#else
+	free(mem);
+#endif
+}
+
 /* CacheData */
 
 CacheData::CacheData(const string& name_)
 {
 	name = name_;
-	f = NULL;
 	have_filename = false;
+	map_data = NULL;
+	map_size = 0;
+	map_offset = 0;
+	map_is_mmap = false;
 }
 
 CacheData::~CacheData()
 {
-	if(f)
-		fclose(f);
+	if(!map_data)
+		return;
+
+#ifndef _WIN32
+	if(map_is_mmap)
+		munmap(map_data, map_size);
+	else
+#endif
+		cache_aligned_free(map_data);
 }
 
 const string& CacheData::get_filename()
@@ -66,10 +123,54 @@ const string& CacheData::get_filename()
 	return filename;
 }
 
+bool CacheData::read_begin(size_t& size, void *&mapped)
+{
+	/* every buffer starts with its size, padded for alignment */
+	mapped = NULL;
+
+	if(!map_data || map_offset + CACHE_ALIGN > map_size)
+		return false;
+
+	memcpy(&size, (char*)map_data + map_offset, sizeof(size));
+	map_offset += CACHE_ALIGN;
+
+	if(map_offset + size > map_size)
+		return false;
+
+	mapped = (char*)map_data + map_offset;
+	return true;
+}
+
+void CacheData::read_end(size_t size)
+{
+	map_offset += cache_align_up(size);
+}
+
+bool CacheData::read_value(void *data, size_t size)
+{
+	size_t read_size;
+	void *mapped;
+
+	if(!read_begin(read_size, mapped) || read_size != size)
+		return false;
+
+	memcpy(data, mapped, size);
+
+	read_end(size);
+	return true;
+}
+
 /* Cache */
 
 Cache Cache::global;
 
+Cache::Cache()
+{
+	max_size = 0;
+	hits = 0;
+	misses = 0;
+}
+
 string Cache::data_filename(CacheData& key)
 {
 	return path_user_get(path_join("cache", key.get_filename()));
@@ -77,24 +178,60 @@ string Cache::data_filename(CacheData& key)
 
 void Cache::insert(CacheData& key, CacheData& value)
 {
+	/* write to temporary file first, so that other processes sharing the
+	 * cache never see a partially written file */
 	string filename = data_filename(key);
+	string tmp_filename = filename + ".tmp";
 	path_create_directories(filename);
-	FILE *f = fopen(filename.c_str(), "wb");
+	FILE *f = fopen(tmp_filename.c_str(), "wb");
 
 	if(!f) {
-		fprintf(stderr, "Failed to open file %s for writing.\n", filename.c_str());
+		fprintf(stderr, "Failed to open file %s for writing.\n", tmp_filename.c_str());
 		return;
 	}
 
+	CacheHeader header;
+	memcpy(header.magic, cache_magic, sizeof(header.magic));
+	header.version = FILE_VERSION;
+	header.pad = 0;
+
+	bool ok = (fwrite(&header, sizeof(header), 1, f) == 1);
+	char zero[CACHE_ALIGN] = {0};
+
 	foreach(CacheBuffer& buffer, value.buffers) {
-		if(!fwrite(&buffer.size, sizeof(buffer.size), 1, f))
-			fprintf(stderr, "Failed to write to file %s.\n", filename.c_str());
-		if(buffer.size)
+		char block[CACHE_ALIGN] = {0};
+		memcpy(block, &buffer.size, sizeof(buffer.size));
+
+		if(!fwrite(block, sizeof(block), 1, f))
+			ok = false;
+
+		if(buffer.size) {
+			size_t pad = cache_align_up(buffer.size) - buffer.size;
+
 			if(!fwrite(buffer.data, buffer.size, 1, f))
-				fprintf(stderr, "Failed to write to file %s.\n", filename.c_str());
+				ok = false;
+			if(pad && !fwrite(zero, pad, 1, f))
+				ok = false;
+		}
 	}
 	
 	fclose(f);
+
+	if(!ok) {
+		fprintf(stderr, "Failed to write to file %s.\n", tmp_filename.c_str());
+		::remove(tmp_filename.c_str());
+		return;
+	}
+
+	if(::rename(tmp_filename.c_str(), filename.c_str()) != 0) {
+		/* rename does not replace existing files on all platforms */
+		::remove(filename.c_str());
+
+		if(::rename(tmp_filename.c_str(), filename.c_str()) != 0) {
+			fprintf(stderr, "Failed to write to file %s.\n", filename.c_str());
+			::remove(tmp_filename.c_str());
+		}
+	}
 }
 
 bool Cache::lookup(CacheData& key, CacheData& value)
@@ -102,11 +239,79 @@ bool Cache::lookup(CacheData& key, CacheData& value)
 	string filename = data_filename(key);
 	FILE *f = fopen(filename.c_str(), "rb");
 
-	if(!f)
+	if(!f) {
+		thread_scoped_lock lock(stats_mutex);
+		misses++;
 		return false;
+	}
+
+	/* files written by other versions are removed */
+	CacheHeader header;
+
+	if(!fread(&header, sizeof(header), 1, f) ||
+	   memcmp(header.magic, cache_magic, sizeof(cache_magic)) != 0 ||
+	   header.version != FILE_VERSION)
+	{
+		fclose(f);
+		::remove(filename.c_str());
+
+		thread_scoped_lock lock(stats_mutex);
+		misses++;
+		return false;
+	}
 	
 	value.name = key.name;
-	value.f = f;
+
+	fseek(f, 0, SEEK_END);
+	size_t size = ftell(f);
+	void *data = NULL;
+
+#ifndef _WIN32
+	/* map the file privately, so that data can still be modified in memory */
+	data = mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_PRIVATE, fileno(f), 0);
+
+	if(data != MAP_FAILED)
+		value.map_is_mmap = true;
+	else
+		data = NULL;
+#endif
+
+	/* otherwise read the whole file, rather than keeping it open for as long
+	 * as the data is used */
+	if(!data) {
+		data = cache_aligned_malloc(size);
+
+		if(data) {
+			fseek(f, 0, SEEK_SET);
+
+			if(!fread(data, size, 1, f)) {
+				cache_aligned_free(data);
+				data = NULL;
+			}
+		}
+	}
+
+	fclose(f);
+
+	if(!data) {
+		fprintf(stderr, "Failed to read file %s.\n", filename.c_str());
+
+		thread_scoped_lock lock(stats_mutex);
+		misses++;
+		return false;
+	}
+
+	value.map_data = data;
+	value.map_size = size;
+	value.map_offset = sizeof(CacheHeader);
+
+	/* update modification time, eviction removes least recently used first.
+	 * failure is harmless, the cache may be shared and read-only. */
+	boost::system::error_code ec;
+	boost::filesystem::last_write_time(filename, std::time(NULL), ec);
+
+	thread_scoped_lock lock(stats_mutex);
+	hits++;
 
 	return true;
 }
@@ -115,22 +320,80 @@ void Cache::clear_except(const string& name, const set<string>& except)
 {
 	string dir = path_user_get("cache");
 
-	if(boost::filesystem::exists(dir)) {
-		boost::filesystem::directory_iterator it(dir), it_end;
+	/* other processes may share the cache and remove files while we iterate,
+	 * so filesystem errors skip the file instead of throwing */
+	boost::system::error_code ec;
+
+	if(!boost::filesystem::exists(dir, ec))
+		return;
+
+	/* collect files that are not in use, and total size of all files */
+	typedef std::pair<std::time_t, std::pair<boost::filesystem::path, size_t> > CacheFile;
+	vector<CacheFile> files;
+	size_t total_size = 0;
+
+	boost::filesystem::directory_iterator it(dir, ec), it_end;
 
-		for(; it != it_end; it++) {
+	for(; !ec && it != it_end; it.increment(ec)) {
 #if (BOOST_FILESYSTEM_VERSION == 2)
-			string filename = it->path().filename();
+		string filename = it->path().filename();
 #else
-			string filename = it->path().filename().string();
+		string filename = it->path().filename().string();
 #endif
 
-			if(boost::starts_with(filename, name))
-				if(except.find(filename) == except.end())
-					boost::filesystem::remove(it->path());
-		}
+		if(!boost::starts_with(filename, name) || boost::ends_with(filename, ".tmp"))
+			continue;
+
+		boost::system::error_code file_ec;
+		size_t size = boost::filesystem::file_size(it->path(), file_ec);
+		if(file_ec)
+			continue;
+
+		std::time_t time = boost::filesystem::last_write_time(it->path(), file_ec);
+		if(file_ec)
+			continue;
+
+		total_size += size;
+
+		if(except.find(filename) == except.end())
+			files.push_back(CacheFile(time, std::make_pair(it->path(), size)));
+	}
+
+	/* remove least recently used files first */
+	sort(files.begin(), files.end());
+
+	foreach(CacheFile& file, files) {
+		if(total_size <= max_size)
+			break;
+
+		/* a file already removed by another process is not an error */
+		boost::filesystem::remove(file.second.first, ec);
+
+		if(!ec)
+			total_size -= file.second.second;
 	}
 }
 
+void Cache::set_max_size(size_t max_size_)
+{
+	max_size = max_size_;
+}
+
+void Cache::get_stats(int& hits_, int& misses_)
+{
+	thread_scoped_lock lock(stats_mutex);
+
+	hits_ = hits;
+	misses_ = misses;
+}
+
+void Cache::reset_stats()
+{
+	thread_scoped_lock lock(stats_mutex);
+
+	hits = 0;
+	misses = 0;
+}
+
 CCL_NAMESPACE_END
 
@@ -28,10 +28,16 @@
  * invalidate cache entries, at the cost of exta computation. If everything
  * is stored in a global cache, computations can perhaps even be shared between
  * different scenes where it may be hard to detect duplicate work.
+ *
+ * Cache files start with a header containing the file format version, and
+ * buffers are stored 16 byte aligned, so that where supported the file can be
+ * memory mapped and arrays can reference the data without copying it. Where
+ * it is not, the file is read into memory, so no file stays open.
  */
 
 #include "util_set.h"
 #include "util_string.h"
+#include "util_thread.h"
 #include "util_vector.h"
 
 CCL_NAMESPACE_BEGIN
@@ -51,7 +57,13 @@ public:
 	string name;
 	string filename;
 	bool have_filename;
-	FILE *f;
+
+	/* memory mapped or loaded file, arrays read from it reference this
+	 * memory and are only valid as long as this data exists */
+	void *map_data;
+	size_t map_size;
+	size_t map_offset;
+	bool map_is_mmap;
 
 	CacheData(const string& name = "");
 	~CacheData();
@@ -99,8 +111,9 @@ public:
 	template<typename T> void read(array<T>& data)
 	{
 		size_t size;
+		void *mapped;
 
-		if(!fread(&size, sizeof(size), 1, f)) {
+		if(!read_begin(size, mapped)) {
 			fprintf(stderr, "Failed to read vector size from cache.\n");
 			return;
 		}
@@ -108,56 +121,64 @@ public:
 		if(!size)
 			return;
 
-		data.resize(size/sizeof(T));
+		data.reference((T*)mapped, size/sizeof(T));
 
-		if(!fread(&data[0], size, 1, f)) {
-			fprintf(stderr, "Failed to read vector data from cache (%lu).\n", (unsigned long)size);
-			return;
-		}
+		read_end(size);
 	}
 
 	void read(int& data)
 	{
-		size_t size;
-
-		if(!fread(&size, sizeof(size), 1, f))
-			fprintf(stderr, "Failed to read int size from cache.\n");
-		if(!fread(&data, sizeof(data), 1, f))
+		if(!read_value(&data, sizeof(data)))
 			fprintf(stderr, "Failed to read int from cache.\n");
 	}
 
 	void read(float& data)
 	{
-		size_t size;
-
-		if(!fread(&size, sizeof(size), 1, f))
-			fprintf(stderr, "Failed to read float size from cache.\n");
-		if(!fread(&data, sizeof(data), 1, f))
+		if(!read_value(&data, sizeof(data)))
 			fprintf(stderr, "Failed to read float from cache.\n");
 	}
 
 	void read(size_t& data)
 	{
-		size_t size;
-
-		if(!fread(&size, sizeof(size), 1, f))
-			fprintf(stderr, "Failed to read size_t size from cache.\n");
-		if(!fread(&data, sizeof(data), 1, f))
+		if(!read_value(&data, sizeof(data)))
 			fprintf(stderr, "Failed to read size_t from cache.\n");
 	}
+
+protected:
+	bool read_begin(size_t& size, void *&mapped);
+	void read_end(size_t size);
+	bool read_value(void *data, size_t size);
 };
 
 class Cache {
 public:
 	static Cache global;
 
+	Cache();
+
 	void insert(CacheData& key, CacheData& value);
 	bool lookup(CacheData& key, CacheData& value);
 
+	/* remove files with the given name prefix, except the ones in use, until
+	 * the total size of the files is below the maximum cache size */
 	void clear_except(const string& name, const set<string>& except);
 
+	void set_max_size(size_t max_size);
+
+	/* lookup statistics */
+	void get_stats(int& hits, int& misses);
+	void reset_stats();
+
+	/* file format version, increase when changing the layout */
+	enum { FILE_VERSION = 2 };
+
 protected:
 	string data_filename(CacheData& key);
+
+	thread_mutex stats_mutex;
+	size_t max_size;
+	int hits;
+	int misses;
 };
 
 CCL_NAMESPACE_END
@@ -122,7 +122,9 @@ string path_files_md5_hash(const string& dir)
 
 void path_create_directories(const string& path)
 {
-	boost::filesystem::create_directories(path_dirname(path));
+	/* on failure, opening the file afterwards fails and is handled there */
+	boost::system::error_code ec;
+	boost::filesystem::create_directories(path_dirname(path), ec);
 }
 
 bool path_write_binary(const string& path, const vector<uint8_t>& binary)
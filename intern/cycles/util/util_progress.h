@@ -27,6 +27,7 @@
 #include "util_string.h"
 #include "util_time.h"
 #include "util_thread.h"
+#include "util_types.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -47,6 +48,15 @@ public:
 		cancel = false;
 		cancel_message = "";
 		cancel_cb = NULL;
+		texture_cache_hits = 0;
+		texture_cache_misses = 0;
+		texture_cache_memory = 0;
+		bvh_cache_hits = 0;
+		bvh_cache_misses = 0;
+		mesh_update_time = 0.0;
+		displacement_time = 0.0;
+		mesh_bvh_time = 0.0;
+		scene_bvh_time = 0.0;
 	}
 
 	Progress(Progress& progress)
@@ -79,6 +89,15 @@ public:
 		sync_substatus = "";
 		cancel = false;
 		cancel_message = "";
+		texture_cache_hits = 0;
+		texture_cache_misses = 0;
+		texture_cache_memory = 0;
+		bvh_cache_hits = 0;
+		bvh_cache_misses = 0;
+		mesh_update_time = 0.0;
+		displacement_time = 0.0;
+		mesh_bvh_time = 0.0;
+		scene_bvh_time = 0.0;
 	}
 
 	/* cancel */
@@ -149,6 +168,13 @@ public:
 		sample++;
 	}
 
+	void add_samples(int num_samples)
+	{
+		thread_scoped_lock lock(progress_mutex);
+
+		sample += num_samples;
+	}
+
 	int get_sample()
 	{
 		return sample;
@@ -217,6 +243,66 @@ public:
 		}
 	}
 
+	/* texture cache statistics */
+
+	void set_texture_cache_stats(uint64_t hits, uint64_t misses, uint64_t memory)
+	{
+		thread_scoped_lock lock(progress_mutex);
+
+		texture_cache_hits = hits;
+		texture_cache_misses = misses;
+		texture_cache_memory = memory;
+	}
+
+	void get_texture_cache_stats(uint64_t& hits, uint64_t& misses, uint64_t& memory)
+	{
+		thread_scoped_lock lock(progress_mutex);
+
+		hits = texture_cache_hits;
+		misses = texture_cache_misses;
+		memory = texture_cache_memory;
+	}
+
+	/* BVH cache statistics */
+
+	void set_bvh_cache_stats(int hits, int misses)
+	{
+		thread_scoped_lock lock(progress_mutex);
+
+		bvh_cache_hits = hits;
+		bvh_cache_misses = misses;
+	}
+
+	void get_bvh_cache_stats(int& hits, int& misses)
+	{
+		thread_scoped_lock lock(progress_mutex);
+
+		hits = bvh_cache_hits;
+		misses = bvh_cache_misses;
+	}
+
+	/* mesh update timing, in seconds */
+
+	void set_mesh_update_times(double mesh_, double displacement_, double mesh_bvh_, double scene_bvh_)
+	{
+		thread_scoped_lock lock(progress_mutex);
+
+		mesh_update_time = mesh_;
+		displacement_time = displacement_;
+		mesh_bvh_time = mesh_bvh_;
+		scene_bvh_time = scene_bvh_;
+	}
+
+	void get_mesh_update_times(double& mesh_, double& displacement_, double& mesh_bvh_, double& scene_bvh_)
+	{
+		thread_scoped_lock lock(progress_mutex);
+
+		mesh_ = mesh_update_time;
+		displacement_ = displacement_time;
+		mesh_bvh_ = mesh_bvh_time;
+		scene_bvh_ = scene_bvh_time;
+	}
+
 	/* callback */
 
 	void set_update()
@@ -253,6 +339,18 @@ protected:
 
 	volatile bool cancel;
 	string cancel_message;
+
+	uint64_t texture_cache_hits;
+	uint64_t texture_cache_misses;
+	uint64_t texture_cache_memory;  /* resident bytes */
+
+	int bvh_cache_hits;
+	int bvh_cache_misses;
+
+	double mesh_update_time;    /* meshes and attributes */
+	double displacement_time;
+	double mesh_bvh_time;
+	double scene_bvh_time;
 };
 
 CCL_NAMESPACE_END
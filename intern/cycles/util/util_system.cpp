@@ -118,6 +118,20 @@ int system_cpu_bits()
 
 #if defined(__x86_64__) || defined(_M_X64) || defined(i386) || defined(_M_IX86)
 
+static uint64_t system_cpu_xgetbv(int index)
+{
+#if defined(_MSC_VER) && (_MSC_FULL_VER >= 160040219)
+	return _xgetbv(index);
+#elif defined(__GNUC__)
+	uint32_t eax, edx;
+	/* xgetbv opcode, for assemblers that don't know the instruction */
+	asm(".byte 0x0f, 0x01, 0xd0" : "=a" (eax), "=d" (edx) : "c" (index));
+	return ((uint64_t)edx << 32) | eax;
+#else
+	return 0;
+#endif
+}
+
 struct CPUCapabilities {
 	bool x64;
 	bool mmx;
@@ -132,6 +146,7 @@ struct CPUCapabilities {
 	bool xop;
 	bool fma3;
 	bool fma4;
+	bool osxsave;
 };
 
 static CPUCapabilities& system_cpu_capabilities()
@@ -165,6 +180,15 @@ static CPUCapabilities& system_cpu_capabilities()
 
 			caps.avx = (result[2] & ((int)1 << 28)) != 0;
 			caps.fma3 = (result[2] & ((int)1 << 12)) != 0;
+			caps.osxsave = (result[2] & ((int)1 << 27)) != 0;
+
+			/* AVX registers are only usable if the OS saves them on context switch */
+			if(caps.avx && caps.osxsave) {
+				uint64_t xcr0 = system_cpu_xgetbv(0);
+				caps.avx = (xcr0 & 0x6) == 0x6;
+			}
+			else
+				caps.avx = false;
 		}
 
 #if 0
@@ -195,6 +219,12 @@ bool system_cpu_support_sse3()
 	return caps.sse && caps.sse2 && caps.sse3 && caps.ssse3;
 }
 
+bool system_cpu_support_avx()
+{
+	CPUCapabilities& caps = system_cpu_capabilities();
+	return caps.sse && caps.sse2 && caps.sse3 && caps.ssse3 && caps.sse41 && caps.avx;
+}
+
 #else
 
 bool system_cpu_support_sse2()
@@ -207,6 +237,11 @@ bool system_cpu_support_sse3()
 	return false;
 }
 
+bool system_cpu_support_avx()
+{
+	return false;
+}
+
 #endif
 
 CCL_NAMESPACE_END
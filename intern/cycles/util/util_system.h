@@ -26,6 +26,7 @@ string system_cpu_brand_string();
 int system_cpu_bits();
 bool system_cpu_support_sse2();
 bool system_cpu_support_sse3();
+bool system_cpu_support_avx();
 
 CCL_NAMESPACE_END
 
@@ -60,31 +60,18 @@ void TaskPool::push(const TaskRunFunction& run, bool front)
 
 void TaskPool::wait_work()
 {
+	/* when called from a worker thread, tasks from its own queue are tried
+	 * first, they are most likely still in cache */
+	int thread_id = TaskScheduler::thread_id_get();
 	thread_scoped_lock num_lock(num_mutex);
 
 	while(num != 0) {
 		num_lock.unlock();
 
-		thread_scoped_lock queue_lock(TaskScheduler::queue_mutex);
-
 		/* find task from this pool. if we get a task from another pool,
 		 * we can get into deadlock */
 		TaskScheduler::Entry work_entry;
-		bool found_entry = false;
-		list<TaskScheduler::Entry>::iterator it;
-
-		for(it = TaskScheduler::queue.begin(); it != TaskScheduler::queue.end(); it++) {
-			TaskScheduler::Entry& entry = *it;
-
-			if(entry.pool == this) {
-				work_entry = entry;
-				found_entry = true;
-				TaskScheduler::queue.erase(it);
-				break;
-			}
-		}
-
-		queue_lock.unlock();
+		bool found_entry = TaskScheduler::pop(thread_id, this, work_entry);
 
 		/* if found task, do it, otherwise wait until other tasks are done */
 		if(found_entry) {
@@ -155,12 +142,14 @@ void TaskPool::num_decrease(int done)
 	num_mutex.unlock();
 }
 
-void TaskPool::num_increase()
+int TaskPool::num_increase()
 {
 	thread_scoped_lock num_lock(num_mutex);
 	num++;
 	THREADING_DEBUG("num==%d, notifying all in TaskPool::num_increase\n", num);
 	num_cond.notify_all();
+
+	return num;
 }
 
 /* Task Scheduler */
@@ -170,14 +159,28 @@ int TaskScheduler::users = 0;
 vector<thread*> TaskScheduler::threads;
 bool TaskScheduler::do_exit = false;
 
-list<TaskScheduler::Entry> TaskScheduler::queue;
-thread_mutex TaskScheduler::queue_mutex;
-thread_condition_variable TaskScheduler::queue_cond;
+vector<TaskScheduler::ThreadQueue*> TaskScheduler::queues;
+
+thread_mutex TaskScheduler::sleep_mutex;
+thread_condition_variable TaskScheduler::sleep_cond;
+int TaskScheduler::num_sleeping = 0;
+
+/* index of the worker thread running, stored as id + 1 so that NULL means
+ * the thread is not one of the scheduler threads */
+static pthread_key_t task_thread_key;
+static pthread_once_t task_thread_key_once = PTHREAD_ONCE_INIT;
+
+static void task_thread_key_create()
+{
+	pthread_key_create(&task_thread_key, NULL);
+}
 
 void TaskScheduler::init(int num_threads)
 {
 	thread_scoped_lock lock(mutex);
 
+	pthread_once(&task_thread_key_once, task_thread_key_create);
+
 	/* multiple cycles instances can use this task scheduler, sharing the same
 	 * threads, so we keep track of the number of users. */
 	if(users == 0) {
@@ -188,6 +191,12 @@ void TaskScheduler::init(int num_threads)
 			num_threads = system_cpu_thread_count();
 		}
 
+		/* queues must exist before any thread starts stealing */
+		queues.resize(num_threads);
+
+		for(size_t i = 0; i < queues.size(); i++)
+			queues[i] = new ThreadQueue();
+
 		/* launch threads that will be waiting for work */
 		threads.resize(num_threads);
 
@@ -206,8 +215,10 @@ void TaskScheduler::exit()
 
 	if(users == 0) {
 		/* stop all waiting threads */
+		sleep_mutex.lock();
 		do_exit = true;
-		TaskScheduler::queue_cond.notify_all();
+		sleep_cond.notify_all();
+		sleep_mutex.unlock();
 
 		/* delete threads */
 		foreach(thread *t, threads) {
@@ -216,35 +227,112 @@ void TaskScheduler::exit()
 		}
 
 		threads.clear();
+
+		foreach(ThreadQueue *queue, queues)
+			delete queue;
+
+		queues.clear();
 	}
 }
 
-bool TaskScheduler::thread_wait_pop(Entry& entry)
+int TaskScheduler::thread_id_get()
 {
-	thread_scoped_lock queue_lock(queue_mutex);
+	if(queues.empty())
+		return -1;
 
-	while(queue.empty() && !do_exit)
-		queue_cond.wait(queue_lock);
+	return (int)(size_t)pthread_getspecific(task_thread_key) - 1;
+}
 
-	if(queue.empty()) {
-		assert(do_exit);
+bool TaskScheduler::queue_pop(ThreadQueue *queue, TaskPool *pool, bool steal, Entry& entry)
+{
+	thread_scoped_lock queue_lock(queue->mutex);
+
+	if(queue->entries.empty())
 		return false;
+
+	if(pool == NULL) {
+		/* the owner takes from the front, thieves from the back to stay away
+		 * from the tasks the owner is about to run */
+		if(steal) {
+			entry = queue->entries.back();
+			queue->entries.pop_back();
+		}
+		else {
+			entry = queue->entries.front();
+			queue->entries.pop_front();
+		}
+
+		return true;
 	}
-	
-	entry = queue.front();
-	queue.pop_front();
 
-	return true;
+	/* only accept tasks from the given pool */
+	list<Entry>::iterator it;
+
+	for(it = queue->entries.begin(); it != queue->entries.end(); it++) {
+		if(it->pool == pool) {
+			entry = *it;
+			queue->entries.erase(it);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool TaskScheduler::pop(int thread_id, TaskPool *pool, Entry& entry)
+{
+	int num_queues = queues.size();
+
+	/* own queue first */
+	if(thread_id >= 0 && queue_pop(queues[thread_id], pool, false, entry))
+		return true;
+
+	/* then steal from others, starting at the neighbour so that threads
+	 * don't all go for the same victim */
+	int start = (thread_id >= 0)? thread_id + 1: 0;
+
+	for(int i = 0; i < num_queues; i++) {
+		int victim = (start + i) % num_queues;
+
+		if(victim != thread_id && queue_pop(queues[victim], pool, true, entry))
+			return true;
+	}
+
+	return false;
+}
+
+bool TaskScheduler::thread_wait_pop(int thread_id, Entry& entry)
+{
+	while(true) {
+		if(pop(thread_id, NULL, entry))
+			return true;
+
+		/* nothing found, check again while holding the sleep lock so that
+		 * a push in between can't be missed, and sleep if still empty */
+		thread_scoped_lock sleep_lock(sleep_mutex);
+
+		if(do_exit)
+			return false;
+
+		if(pop(thread_id, NULL, entry))
+			return true;
+
+		num_sleeping++;
+		sleep_cond.wait(sleep_lock);
+		num_sleeping--;
+	}
 }
 
 void TaskScheduler::thread_run(int thread_id)
 {
 	Entry entry;
 
+	pthread_setspecific(task_thread_key, (void*)(size_t)(thread_id + 1));
+
 	/* todo: test affinity/denormal mask */
 
 	/* keep popping off tasks */
-	while(thread_wait_pop(entry)) {
+	while(thread_wait_pop(thread_id, entry)) {
 		/* run task */
 		entry.task->run();
 
@@ -258,42 +346,57 @@ void TaskScheduler::thread_run(int thread_id)
 
 void TaskScheduler::push(Entry& entry, bool front)
 {
-	entry.pool->num_increase();
+	int num = entry.pool->num_increase();
+	int thread_id = thread_id_get();
+
+	/* workers push into their own queue, other threads spread tasks over
+	 * all queues so that work is available to steal right away */
+	ThreadQueue *queue;
+
+	if(thread_id >= 0)
+		queue = queues[thread_id];
+	else
+		queue = queues[num % queues.size()];
 
 	/* add entry to queue */
-	TaskScheduler::queue_mutex.lock();
+	queue->mutex.lock();
 	if(front)
-		TaskScheduler::queue.push_front(entry);
+		queue->entries.push_front(entry);
 	else
-		TaskScheduler::queue.push_back(entry);
-
-	TaskScheduler::queue_cond.notify_one();
-	TaskScheduler::queue_mutex.unlock();
+		queue->entries.push_back(entry);
+	queue->mutex.unlock();
+
+	/* wake up a thread if any is sleeping */
+	sleep_mutex.lock();
+	if(num_sleeping)
+		sleep_cond.notify_one();
+	sleep_mutex.unlock();
 }
 
 void TaskScheduler::clear(TaskPool *pool)
 {
-	thread_scoped_lock queue_lock(TaskScheduler::queue_mutex);
-
-	/* erase all tasks from this pool from the queue */
-	list<Entry>::iterator it = queue.begin();
 	int done = 0;
 
-	while(it != queue.end()) {
-		Entry& entry = *it;
+	/* erase all tasks from this pool from the queues */
+	foreach(ThreadQueue *queue, queues) {
+		thread_scoped_lock queue_lock(queue->mutex);
+
+		list<Entry>::iterator it = queue->entries.begin();
 
-		if(entry.pool == pool) {
-			done++;
-			delete entry.task;
+		while(it != queue->entries.end()) {
+			Entry& entry = *it;
 
-			it = queue.erase(it);
+			if(entry.pool == pool) {
+				done++;
+				delete entry.task;
+
+				it = queue->entries.erase(it);
+			}
+			else
+				it++;
 		}
-		else
-			it++;
 	}
 
-	queue_lock.unlock();
-
 	/* notify done */
 	pool->num_decrease(done);
 }
@@ -72,7 +72,7 @@ protected:
 	friend class TaskScheduler;
 
 	void num_decrease(int done);
-	void num_increase();
+	int num_increase();
 
 	thread_mutex num_mutex;
 	thread_condition_variable num_cond;
@@ -83,8 +83,11 @@ protected:
 
 /* Task Scheduler
  * 
- * Central scheduler that holds running threads ready to execute tasks. A singe
- * queue holds the task from all pools. */
+ * Central scheduler that holds running threads ready to execute tasks. Each
+ * worker thread has its own queue; tasks pushed from a worker go into its own
+ * queue, tasks pushed from other threads are distributed over the queues.
+ * Threads that run out of work steal from the back of the other queues, so
+ * there is no single lock that all threads contend on. */
 
 class TaskScheduler
 {
@@ -106,17 +109,29 @@ protected:
 		TaskPool *pool;
 	};
 
+	struct ThreadQueue {
+		list<Entry> entries;
+		thread_mutex mutex;
+	};
+
 	static thread_mutex mutex;
 	static int users;
 	static vector<thread*> threads;
 	static bool do_exit;
 
-	static list<Entry> queue;
-	static thread_mutex queue_mutex;
-	static thread_condition_variable queue_cond;
+	static vector<ThreadQueue*> queues;
+
+	/* sleeping threads wait for pushes on this */
+	static thread_mutex sleep_mutex;
+	static thread_condition_variable sleep_cond;
+	static int num_sleeping;
 
 	static void thread_run(int thread_id);
-	static bool thread_wait_pop(Entry& entry);
+	static bool thread_wait_pop(int thread_id, Entry& entry);
+
+	static int thread_id_get();
+	static bool queue_pop(ThreadQueue *queue, TaskPool *pool, bool steal, Entry& entry);
+	static bool pop(int thread_id, TaskPool *pool, Entry& entry);
 
 	static void push(Entry& entry, bool front);
 	static void clear(TaskPool *pool);
@@ -95,6 +95,14 @@
 #include <tmmintrin.h> /* SSSE 3 */
 #endif
 
+#ifdef __KERNEL_SSE41__
+#include <smmintrin.h> /* SSE 4.1 */
+#endif
+
+#ifdef __KERNEL_AVX__
+#include <immintrin.h> /* AVX */
+#endif
+
 #else
 
 /* MinGW64 has conflicting declarations for these SSE headers in <windows.h>.
@@ -596,6 +604,39 @@ ccl_device_inline void float4_store_half(half *h, const float4 *f, float scale)
 #endif
 }
 
+ccl_device_inline float half_to_float(half h)
+{
+	/* full conversion including denormals, infinity and nan, used for
+	 * reading half float image textures */
+	union { uint i; float f; } out;
+	uint sign = (uint)(h & 0x8000) << 16;
+	uint exponent = (h >> 10) & 0x1F;
+	uint mantissa = h & 0x3FF;
+
+	if(exponent == 0) {
+		if(mantissa == 0) {
+			out.i = sign;
+		}
+		else {
+			/* denormal, renormalize */
+			exponent = 113;
+			while(!(mantissa & 0x400)) {
+				mantissa <<= 1;
+				exponent--;
+			}
+			out.i = sign | (exponent << 23) | ((mantissa & 0x3FF) << 13);
+		}
+	}
+	else if(exponent == 31) {
+		out.i = sign | 0x7F800000 | (mantissa << 13);
+	}
+	else {
+		out.i = sign | ((exponent + 112) << 23) | (mantissa << 13);
+	}
+
+	return out.f;
+}
+
 #endif
 
 #endif
@@ -65,6 +65,7 @@ public:
 	{
 		data = NULL;
 		datasize = 0;
+		referenced = false;
 	}
 
 	array(size_t newsize)
@@ -77,6 +78,8 @@ public:
 			data = (T*)malloc_aligned(sizeof(T)*newsize, alignment);
 			datasize = newsize;
 		}
+
+		referenced = false;
 	}
 
 	array(const array& from)
@@ -86,6 +89,8 @@ public:
 
 	array& operator=(const array& from)
 	{
+		referenced = false;
+
 		if(from.datasize == 0) {
 			data = NULL;
 			datasize = 0;
@@ -103,6 +108,7 @@ public:
 	{
 		datasize = from.size();
 		data = NULL;
+		referenced = false;
 
 		if(datasize > 0) {
 			data = (T*)malloc_aligned(sizeof(T)*datasize, alignment);
@@ -117,7 +123,8 @@ public:
 
 	~array()
 	{
-		free_aligned(data);
+		if(!referenced)
+			free_aligned(data);
 	}
 
 	void resize(size_t newsize)
@@ -128,18 +135,32 @@ public:
 		else if(newsize != datasize) {
 			T *newdata = (T*)malloc_aligned(sizeof(T)*newsize, alignment);
 			memcpy(newdata, data, ((datasize < newsize)? datasize: newsize)*sizeof(T));
-			free_aligned(data);
+			if(!referenced)
+				free_aligned(data);
 
 			data = newdata;
 			datasize = newsize;
+			referenced = false;
 		}
 	}
 
 	void clear()
 	{
-		free_aligned(data);
+		if(!referenced)
+			free_aligned(data);
 		data = NULL;
 		datasize = 0;
+		referenced = false;
+	}
+
+	/* use memory owned by someone else, for example a memory mapped file. it
+	 * must stay valid while in use, and is copied on resize */
+	void reference(T *ptr, size_t newsize)
+	{
+		clear();
+		data = ptr;
+		datasize = newsize;
+		referenced = true;
 	}
 
 	size_t size() const
@@ -155,6 +176,7 @@ public:
 protected:
 	T *data;
 	size_t datasize;
+	bool referenced;
 };
 
 CCL_NAMESPACE_END
@@ -181,9 +181,56 @@ extern "C" {
 extern const char *(*MEM_name_ptr)(void *vmemh);
 #endif
 
+/**
+ * Memory accounting per category.
+ *
+ * Allocations are accounted to the tag on top of the tag stack of the
+ * allocating thread, MEM_TAG_NONE when the stack is empty. Frees are accounted
+ * to the tag of the block, whatever thread frees it. Tags are not inherited by
+ * threads started while a tag is pushed, these have to push their own.
+ *
+ * Only 64 bit builds with compiler supported thread local storage store tags,
+ * elsewhere all memory is accounted to MEM_TAG_NONE. */
+enum {
+	MEM_TAG_NONE = 0,
+	MEM_TAG_MESH,
+	MEM_TAG_IMAGE,
+	MEM_TAG_RENDER,
+	MEM_TAG_UNDO,
+	MEM_TAG_CACHE,
+	MEM_TAG_TOT
+};
+
+typedef struct MEM_TagStats {
+	size_t mem_in_use;    /* bytes in use */
+	size_t peak_mem;      /* highest bytes in use, since the last reset */
+	size_t totalloc;      /* number of allocations so far, use differences for rates */
+	size_t totalloc_len;  /* bytes allocated so far */
+} MEM_TagStats;
+
+/** Account allocations of this thread to tag, until the matching MEM_tag_pop. */
+void MEM_tag_push(int tag);
+void MEM_tag_pop(void);
+
+/** Name of the tag, as used for printing and in python. */
+const char *MEM_tag_name(int tag);
+
+/** Get the counters of a tag, zeroed when the tag is out of range. */
+void MEM_tag_stats(int tag, MEM_TagStats *r_stats);
+
+/** Reset the peak memory of all tags to their memory in use. */
+void MEM_tag_reset_peak_memory(void);
+
+/** Print the counters of all tags. */
+void MEM_tag_print_stats(void);
+
 /* Switch allocator to slower but fully guarded mode. */
 void MEM_use_guarded_allocator(void);
 
+/* Switch allocator to per thread caches of small blocks, for faster
+ * allocation from many threads. Cached memory isn't given back to the system. */
+void MEM_use_threadcache_allocator(void);
+
 #ifdef __cplusplus
 /* alloc funcs for C++ only */
 #define MEM_CXX_CLASS_ALLOC_FUNCS(_id)                                        \
@@ -215,6 +262,13 @@ public:                                                                       \
 			((type*)(what))->~type(); \
 			MEM_freeN(what); \
 	} } (void)0
+
+/* accounts allocations to a tag until the end of the scope */
+class MEM_TagScope {
+public:
+	MEM_TagScope(int tag) { MEM_tag_push(tag); }
+	~MEM_TagScope() { MEM_tag_pop(); }
+};
 #endif  /* __cplusplus */
 
 #ifdef __cplusplus
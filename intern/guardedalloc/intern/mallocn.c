@@ -30,13 +30,19 @@
  *  \ingroup MEM
  *
  * Guarded memory allocation, and boundary-write detection.
+ *
+ * The allocator functions point to one of the implementations, the tag
+ * accounting is shared by all of them.
  */
 
+#include <string.h>
+
 #include "MEM_guardedalloc.h"
 
 /* to ensure strict conversions */
 #include "../../source/blender/blenlib/BLI_strict_flags.h"
 
+#include "atomic_ops.h"
 #include "mallocn_intern.h"
 
 size_t (*MEM_allocN_len)(const void *vmemh) = MEM_lockfree_allocN_len;
@@ -93,3 +99,192 @@ void MEM_use_guarded_allocator(void)
 	MEM_name_ptr = MEM_guarded_name_ptr;
 #endif
 }
+
+/* ******** tags ******** */
+
+#define MEM_TAG_STACK_SIZE 16
+
+typedef struct MemTagCounters {
+	size_t mem_in_use, peak_mem, totalloc, totalloc_len;
+	/* counters of different tags on different cache lines */
+	char pad[64 - 4 * sizeof(size_t)];
+} MemTagCounters;
+
+static MemTagCounters tag_counters[MEM_TAG_TOT];
+
+static const char *tag_names[MEM_TAG_TOT] = {
+	"none",
+	"mesh",
+	"image",
+	"render",
+	"undo",
+	"cache",
+};
+
+/* counters not added to tag_counters yet, set by allocators that delay it */
+void (*mem_tag_pending)(unsigned int tag, intptr_t *r_mem_in_use, size_t *r_totalloc, size_t *r_totalloc_len) = NULL;
+
+#ifdef MEM_TAG_THREAD_LOCAL
+/* nested pushes of the tag on top of the stack only count, so recursion doesn't grow the stack */
+static MEM_TAG_THREAD_LOCAL unsigned char tag_stack[MEM_TAG_STACK_SIZE];
+static MEM_TAG_THREAD_LOCAL unsigned int tag_repeat[MEM_TAG_STACK_SIZE];
+static MEM_TAG_THREAD_LOCAL int tag_depth = 0;
+static int tag_overflow_reported = 0;
+#endif
+
+unsigned int mem_tag_current(void)
+{
+#ifdef MEM_TAG_THREAD_LOCAL
+	if (tag_depth > 0)
+		return tag_stack[tag_depth - 1];
+#endif
+	return MEM_TAG_NONE;
+}
+
+void mem_tag_count_alloc(unsigned int tag, size_t len)
+{
+	MemTagCounters *counters = &tag_counters[tag];
+	size_t mem_in_use = atomic_add_z(&counters->mem_in_use, len);
+
+	atomic_add_z(&counters->totalloc, 1);
+	atomic_add_z(&counters->totalloc_len, len);
+
+	/* Not strictly speaking thread-safe, like the peak of the allocators. */
+	if (mem_in_use > counters->peak_mem)
+		counters->peak_mem = mem_in_use;
+}
+
+void mem_tag_count_free(unsigned int tag, size_t len)
+{
+	atomic_sub_z(&tag_counters[tag].mem_in_use, len);
+}
+
+void mem_tag_flush(unsigned int tag, intptr_t mem_in_use, size_t totalloc, size_t totalloc_len)
+{
+	MemTagCounters *counters = &tag_counters[tag];
+	size_t new_mem_in_use;
+
+	if (mem_in_use >= 0)
+		new_mem_in_use = atomic_add_z(&counters->mem_in_use, (size_t)mem_in_use);
+	else
+		new_mem_in_use = atomic_sub_z(&counters->mem_in_use, (size_t)-mem_in_use);
+
+	atomic_add_z(&counters->totalloc, totalloc);
+	atomic_add_z(&counters->totalloc_len, totalloc_len);
+
+	/* a free of another thread may have been flushed before the allocation,
+	 * so the counter can temporarily wrap around */
+	if ((intptr_t)new_mem_in_use > 0 && new_mem_in_use > counters->peak_mem)
+		counters->peak_mem = new_mem_in_use;
+}
+
+void MEM_tag_push(int tag)
+{
+#ifdef MEM_TAG_THREAD_LOCAL
+	/* the tag indexes the counters when blocks are allocated and freed */
+	if (tag < 0 || tag >= MEM_TAG_TOT)
+		tag = MEM_TAG_NONE;
+
+	if (tag_depth > 0 && tag_stack[tag_depth - 1] == (unsigned char)tag) {
+		tag_repeat[tag_depth - 1]++;
+	}
+	else if (tag_depth < MEM_TAG_STACK_SIZE) {
+		tag_stack[tag_depth] = (unsigned char)tag;
+		tag_repeat[tag_depth] = 0;
+		tag_depth++;
+	}
+	else {
+		/* count the push on the top of the stack to keep pops balanced, allocations
+		 * are accounted to the tag on top of the stack until the matching pop */
+		tag_repeat[tag_depth - 1]++;
+
+		if (!tag_overflow_reported) {
+			tag_overflow_reported = 1;
+			fprintf(stderr, "MEM_tag_push: more than %d nested different tags, '%s' accounted as '%s'\n",
+			        MEM_TAG_STACK_SIZE, tag_names[tag], tag_names[tag_stack[tag_depth - 1]]);
+		}
+	}
+#else
+	(void)tag;
+#endif
+}
+
+void MEM_tag_pop(void)
+{
+#ifdef MEM_TAG_THREAD_LOCAL
+	if (tag_depth > 0) {
+		if (tag_repeat[tag_depth - 1] > 0)
+			tag_repeat[tag_depth - 1]--;
+		else
+			tag_depth--;
+	}
+#endif
+}
+
+const char *MEM_tag_name(int tag)
+{
+	return (tag >= 0 && tag < MEM_TAG_TOT) ? tag_names[tag] : "unknown";
+}
+
+void MEM_tag_stats(int tag, MEM_TagStats *r_stats)
+{
+	MemTagCounters *counters;
+	intptr_t mem_in_use;
+
+	if (tag < 0 || tag >= MEM_TAG_TOT) {
+		memset(r_stats, 0, sizeof(*r_stats));
+		return;
+	}
+
+	counters = &tag_counters[tag];
+	mem_in_use = (intptr_t)counters->mem_in_use;
+
+	r_stats->totalloc = counters->totalloc;
+	r_stats->totalloc_len = counters->totalloc_len;
+
+	if (mem_tag_pending) {
+		intptr_t pending_mem_in_use;
+		size_t pending_totalloc, pending_totalloc_len;
+
+		mem_tag_pending((unsigned int)tag, &pending_mem_in_use, &pending_totalloc, &pending_totalloc_len);
+
+		mem_in_use += pending_mem_in_use;
+		r_stats->totalloc += pending_totalloc;
+		r_stats->totalloc_len += pending_totalloc_len;
+	}
+
+	r_stats->mem_in_use = (mem_in_use > 0) ? (size_t)mem_in_use : 0;
+	r_stats->peak_mem = (r_stats->mem_in_use > counters->peak_mem) ? r_stats->mem_in_use : counters->peak_mem;
+}
+
+void MEM_tag_reset_peak_memory(void)
+{
+	int tag;
+
+	for (tag = 0; tag < MEM_TAG_TOT; tag++) {
+		MEM_TagStats stats;
+
+		tag_counters[tag].peak_mem = 0;
+		MEM_tag_stats(tag, &stats);
+		tag_counters[tag].peak_mem = stats.mem_in_use;
+	}
+}
+
+void MEM_tag_print_stats(void)
+{
+	int tag;
+
+	printf("\n%-8s %12s %12s %12s %12s\n", "tag", "in use (MB)", "peak (MB)", "allocs", "alloc (MB)");
+
+	for (tag = 0; tag < MEM_TAG_TOT; tag++) {
+		MEM_TagStats stats;
+
+		MEM_tag_stats(tag, &stats);
+
+		printf("%-8s %12.3f %12.3f %12lu %12.3f\n", tag_names[tag],
+		       (double)stats.mem_in_use / (double)(1024 * 1024),
+		       (double)stats.peak_mem / (double)(1024 * 1024),
+		       (unsigned long)stats.totalloc,
+		       (double)stats.totalloc_len / (double)(1024 * 1024));
+	}
+}
@@ -113,7 +113,8 @@ typedef struct MemHead {
 	const char *name;
 	const char *nextname;
 	int tag2;
-	int mmap;  /* if true, memory was mmapped */
+	short mmap;  /* if true, memory was mmapped */
+	short mem_tag;  /* MEM_TAG_ the block is accounted to */
 #ifdef DEBUG_MEMCOUNTER
 	int _count;
 #endif
@@ -464,6 +465,7 @@ static void make_memhead_header(MemHead *memh, size_t len, const char *str)
 	memh->nextname = NULL;
 	memh->len = len;
 	memh->mmap = 0;
+	memh->mem_tag = (short)mem_tag_current();
 	memh->tag2 = MEMTAG2;
 
 #ifdef DEBUG_MEMDUPLINAME
@@ -479,6 +481,7 @@ static void make_memhead_header(MemHead *memh, size_t len, const char *str)
 
 	atomic_add_u(&totblock, 1);
 	atomic_add_z(&mem_in_use, len);
+	mem_tag_count_alloc((unsigned int)memh->mem_tag, len);
 
 	mem_lock_thread();
 	addtail(membase, &memh->next);
@@ -674,6 +677,8 @@ void MEM_guarded_printmemlist_stats(void)
 	
 	mem_unlock_thread();
 
+	MEM_tag_print_stats();
+
 #ifdef HAVE_MALLOC_STATS
 	printf("System Statistics:\n");
 	malloc_stats();
@@ -926,6 +931,7 @@ static void rem_memblock(MemHead *memh)
 
 	atomic_sub_u(&totblock, 1);
 	atomic_sub_z(&mem_in_use, memh->len);
+	mem_tag_count_free((unsigned int)memh->mem_tag, memh->len);
 
 #ifdef DEBUG_MEMDUPLINAME
 	if (memh->need_free_name)
@@ -77,6 +77,34 @@
 
 #define SIZET_ALIGN_4(len) ((len + 3) & ~(size_t)3)
 
+/* The tag of a block is stored in the top bits of its length, this needs 64 bit
+ * size_t, and the tag stack needs compiler supported thread local storage. */
+#if defined(__LP64__) || defined(_WIN64)
+#  if defined(_MSC_VER)
+#    define MEM_TAG_THREAD_LOCAL __declspec(thread)
+#  elif defined(__GNUC__) && !defined(__APPLE__)
+#    define MEM_TAG_THREAD_LOCAL __thread
+#  endif
+#endif
+
+#ifdef MEM_TAG_THREAD_LOCAL
+#  define MEM_TAG_SHIFT 56
+#  define MEM_TAG_LEN_BITS(tag) ((size_t)(tag) << MEM_TAG_SHIFT)
+#  define MEM_TAG_FROM_LEN(len) ((unsigned int)((len) >> MEM_TAG_SHIFT))
+#  define MEM_TAG_LEN_MASK ((((size_t) 1) << MEM_TAG_SHIFT) - 1)
+#else
+#  define MEM_TAG_LEN_BITS(tag) ((size_t) 0)
+#  define MEM_TAG_FROM_LEN(len) 0u
+#  define MEM_TAG_LEN_MASK (~((size_t) 0))
+#endif
+
+/* Tag accounting shared by the allocators */
+unsigned int mem_tag_current(void);
+void mem_tag_count_alloc(unsigned int tag, size_t len);
+void mem_tag_count_free(unsigned int tag, size_t len);
+void mem_tag_flush(unsigned int tag, intptr_t mem_in_use, size_t totalloc, size_t totalloc_len);
+extern void (*mem_tag_pending)(unsigned int tag, intptr_t *r_mem_in_use, size_t *r_totalloc, size_t *r_totalloc_len);
+
 /* Prototypes for counted allocator functions */
 size_t MEM_lockfree_allocN_len(const void *vmemh) ATTR_WARN_UNUSED_RESULT;
 void MEM_lockfree_freeN(void *vmemh);
@@ -129,4 +157,30 @@ uintptr_t MEM_guarded_get_peak_memory(void) ATTR_WARN_UNUSED_RESULT;
 const char *MEM_guarded_name_ptr(void *vmemh);
 #endif
 
+/* Prototypes for thread cache allocator functions */
+size_t MEM_threadcache_allocN_len(const void *vmemh) ATTR_WARN_UNUSED_RESULT;
+void MEM_threadcache_freeN(void *vmemh);
+void *MEM_threadcache_dupallocN(const void *vmemh) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT;
+void *MEM_threadcache_reallocN_id(void *vmemh, size_t len, const char *UNUSED(str)) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT ATTR_ALLOC_SIZE(2);
+void *MEM_threadcache_recallocN_id(void *vmemh, size_t len, const char *UNUSED(str)) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT ATTR_ALLOC_SIZE(2);
+void *MEM_threadcache_callocN(size_t len, const char *UNUSED(str)) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT ATTR_ALLOC_SIZE(1) ATTR_NONNULL(2);
+void *MEM_threadcache_mallocN(size_t len, const char *UNUSED(str)) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT ATTR_ALLOC_SIZE(1) ATTR_NONNULL(2);
+void *MEM_threadcache_mapallocN(size_t len, const char *UNUSED(str)) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT ATTR_ALLOC_SIZE(1) ATTR_NONNULL(2);
+void MEM_threadcache_printmemlist_pydict(void);
+void MEM_threadcache_printmemlist(void);
+void MEM_threadcache_callbackmemlist(void (*func)(void *));
+void MEM_threadcache_printmemlist_stats(void);
+void MEM_threadcache_set_error_callback(void (*func)(const char *));
+bool MEM_threadcache_check_memory_integrity(void);
+void MEM_threadcache_set_lock_callback(void (*lock)(void), void (*unlock)(void));
+void MEM_threadcache_set_memory_debug(void);
+uintptr_t MEM_threadcache_get_memory_in_use(void);
+uintptr_t MEM_threadcache_get_mapped_memory_in_use(void);
+unsigned int MEM_threadcache_get_memory_blocks_in_use(void);
+void MEM_threadcache_reset_peak_memory(void);
+uintptr_t MEM_threadcache_get_peak_memory(void) ATTR_WARN_UNUSED_RESULT;
+#ifndef NDEBUG
+const char *MEM_threadcache_name_ptr(void *vmemh);
+#endif
+
 #endif  /* __MALLOCN_INTERN_H__ */
@@ -47,7 +47,8 @@
 #include "mallocn_intern.h"
 
 typedef struct MemHead {
-	/* Length of allocated memory block. */
+	/* Length of allocated memory block, the lowest bit is the mmap flag and
+	 * the top bits the tag (see MEM_TAG_SHIFT). */
 	size_t len;
 } MemHead;
 
@@ -62,6 +63,7 @@ static void (*thread_unlock_callback)(void) = NULL;
 #define MEMHEAD_FROM_PTR(ptr) (((MemHead*) vmemh) - 1)
 #define PTR_FROM_MEMHEAD(memhead) (memhead + 1)
 #define MEMHEAD_IS_MMAP(memhead) ((memhead)->len & (size_t) 1)
+#define MEMHEAD_TAG(memhead) MEM_TAG_FROM_LEN((memhead)->len)
 
 #ifdef __GNUC__
 __attribute__ ((format(printf, 1, 2)))
@@ -98,7 +100,7 @@ static void mem_unlock_thread(void)
 size_t MEM_lockfree_allocN_len(const void *vmemh)
 {
 	if (vmemh) {
-		return MEMHEAD_FROM_PTR(vmemh)->len & ~((size_t) 1);
+		return MEMHEAD_FROM_PTR(vmemh)->len & MEM_TAG_LEN_MASK & ~((size_t) 1);
 	}
 	else {
 		return 0;
@@ -112,6 +114,7 @@ void MEM_lockfree_freeN(void *vmemh)
 
 	atomic_sub_u(&totblock, 1);
 	atomic_sub_z(&mem_in_use, len);
+	mem_tag_count_free(MEMHEAD_TAG(memh), len);
 
 	if (MEMHEAD_IS_MMAP(memh)) {
 		atomic_sub_z(&mmap_in_use, len);
@@ -220,9 +223,12 @@ void *MEM_lockfree_callocN(size_t len, const char *str)
 	memh = (MemHead *)calloc(1, len + sizeof(MemHead));
 
 	if (memh) {
-		memh->len = len;
+		unsigned int tag = mem_tag_current();
+
+		memh->len = len | MEM_TAG_LEN_BITS(tag);
 		atomic_add_u(&totblock, 1);
 		atomic_add_z(&mem_in_use, len);
+		mem_tag_count_alloc(tag, len);
 
 		/* TODO(sergey): Not strictly speaking thread-safe. */
 		peak_mem = mem_in_use > peak_mem ? mem_in_use : peak_mem;
@@ -243,13 +249,16 @@ void *MEM_lockfree_mallocN(size_t len, const char *str)
 	memh = (MemHead *)malloc(len + sizeof(MemHead));
 
 	if (memh) {
+		unsigned int tag = mem_tag_current();
+
 		if (malloc_debug_memset && len) {
 			memset(memh + 1, 255, len);
 		}
 
-		memh->len = len;
+		memh->len = len | MEM_TAG_LEN_BITS(tag);
 		atomic_add_u(&totblock, 1);
 		atomic_add_z(&mem_in_use, len);
+		mem_tag_count_alloc(tag, len);
 
 		/* TODO(sergey): Not strictly speaking thread-safe. */
 		peak_mem = mem_in_use > peak_mem ? mem_in_use : peak_mem;
@@ -278,10 +287,13 @@ void *MEM_lockfree_mapallocN(size_t len, const char *str)
 #endif
 
 	if (memh != (MemHead *)-1) {
-		memh->len = len | (size_t) 1;
+		unsigned int tag = mem_tag_current();
+
+		memh->len = len | (size_t) 1 | MEM_TAG_LEN_BITS(tag);
 		atomic_add_u(&totblock, 1);
 		atomic_add_z(&mem_in_use, len);
 		atomic_add_z(&mmap_in_use, len);
+		mem_tag_count_alloc(tag, len);
 
 		/* TODO(sergey): Not strictly speaking thread-safe. */
 		peak_mem = mem_in_use > peak_mem ? mem_in_use : peak_mem;
@@ -315,6 +327,7 @@ void MEM_lockfree_printmemlist_stats(void)
 	       (double)mem_in_use / (double)(1024 * 1024));
 	printf("peak memory len: %.3f MB\n",
 	       (double)peak_mem / (double)(1024 * 1024));
+	MEM_tag_print_stats();
 	printf("\nFor more detailed per-block statistics run Blender with memory debugging command line argument.\n");
 
 #ifdef HAVE_MALLOC_STATS
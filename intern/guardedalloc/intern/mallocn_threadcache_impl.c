@@ -0,0 +1,815 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2014 by Blender Foundation.
+ * All rights reserved.
+ *
+ * The Original Code is: all of this file.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file guardedalloc/intern/mallocn_threadcache_impl.c
+ *  \ingroup MEM
+ *
+ * Memory allocation with a cache of small blocks per thread.
+ *
+ * Blocks up to MEM_SMALL_MAX bytes are rounded up to a size class and taken
+ * from a free list of the calling thread, which is filled from chunks allocated
+ * from the system. Freed blocks go to the free list of the freeing thread, when
+ * a list gets too long half of it is moved to a global list, from which other
+ * threads refill their lists. Chunks are never given back to the system.
+ *
+ * Memory counters, including those of the tags, are kept per thread as well
+ * and only added to the global counters once they changed by MEM_FLUSH_SIZE,
+ * or when they are queried.
+ */
+
+#include <stdlib.h>
+#include <string.h> /* memcpy */
+#include <stdarg.h>
+#include <sys/types.h>
+#include <pthread.h>
+
+#include "MEM_guardedalloc.h"
+
+/* to ensure strict conversions */
+#include "../../source/blender/blenlib/BLI_strict_flags.h"
+
+#include "atomic_ops.h"
+#include "mallocn_intern.h"
+
+typedef struct MemHead {
+	/* Length of allocated memory block, the lowest two bits are flags and
+	 * the top bits the tag (see MEM_TAG_SHIFT). */
+	size_t len;
+} MemHead;
+
+/* free blocks are linked through their first bytes */
+typedef struct MemFreeBlock {
+	struct MemFreeBlock *next;
+} MemFreeBlock;
+
+typedef struct MemFreeList {
+	MemFreeBlock *first;
+	unsigned int count;
+} MemFreeList;
+
+/* size classes are multiples of MEM_SMALL_STEP, including the MemHead */
+#define MEM_SMALL_STEP 16
+#define MEM_SMALL_MAX 512
+#define MEM_NUM_CLASSES (MEM_SMALL_MAX / MEM_SMALL_STEP)
+#define MEM_CHUNK_SIZE (64 * 1024)
+
+/* change of memory in use after which a thread adds its counters to the global ones */
+#define MEM_FLUSH_SIZE (256 * 1024)
+
+typedef struct MemThreadCache {
+	struct MemThreadCache *next, *prev;
+	MemFreeList free[MEM_NUM_CLASSES];
+
+	/* changes since the last flush, negative when freeing blocks of other threads */
+	intptr_t totblock, mem_in_use;
+	intptr_t tag_mem_in_use[MEM_TAG_TOT];
+	size_t tag_totalloc[MEM_TAG_TOT], tag_totalloc_len[MEM_TAG_TOT];
+} MemThreadCache;
+
+/* global lists, counters and the list of thread caches are protected by the mutex */
+static pthread_mutex_t cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t cache_key;
+static MemThreadCache *caches = NULL;
+static MemFreeList free_lists[MEM_NUM_CLASSES];
+
+static intptr_t totblock = 0, mem_in_use = 0;
+static size_t mmap_in_use = 0, chunk_mem = 0, peak_mem = 0;
+static bool malloc_debug_memset = false;
+
+static void (*error_callback)(const char *) = NULL;
+static void (*thread_lock_callback)(void) = NULL;
+static void (*thread_unlock_callback)(void) = NULL;
+
+#define MEMHEAD_FROM_PTR(ptr) (((MemHead*) vmemh) - 1)
+#define PTR_FROM_MEMHEAD(memhead) (memhead + 1)
+#define MEMHEAD_IS_MMAP(memhead) ((memhead)->len & (size_t) 1)
+#define MEMHEAD_IS_SMALL(memhead) ((memhead)->len & (size_t) 2)
+#define MEMHEAD_TAG(memhead) MEM_TAG_FROM_LEN((memhead)->len)
+#define MEMHEAD_LEN(memhead) ((memhead)->len & MEM_TAG_LEN_MASK & ~((size_t) 3))
+
+#define SIZE_CLASS(len) ((unsigned int)(((len) + sizeof(MemHead) - 1) / MEM_SMALL_STEP))
+#define SIZE_CLASS_BLOCK_SIZE(index) ((size_t)((index) + 1) * MEM_SMALL_STEP)
+#define IS_SMALL(len) ((len) + sizeof(MemHead) <= MEM_SMALL_MAX)
+
+#ifdef __GNUC__
+__attribute__ ((format(printf, 1, 2)))
+#endif
+static void print_error(const char *str, ...)
+{
+	char buf[512];
+	va_list ap;
+
+	va_start(ap, str);
+	vsnprintf(buf, sizeof(buf), str, ap);
+	va_end(ap);
+	buf[sizeof(buf) - 1] = '\0';
+
+	if (error_callback) {
+		error_callback(buf);
+	}
+}
+
+#if defined(WIN32)
+static void mem_lock_thread(void)
+{
+	if (thread_lock_callback)
+		thread_lock_callback();
+}
+
+static void mem_unlock_thread(void)
+{
+	if (thread_unlock_callback)
+		thread_unlock_callback();
+}
+#endif
+
+/* ******** counters ******** */
+
+static void update_peak_locked(void)
+{
+	intptr_t total = mem_in_use;
+	MemThreadCache *cache;
+
+	for (cache = caches; cache; cache = cache->next)
+		total += cache->mem_in_use;
+
+	if (total > 0 && (size_t)total > peak_mem)
+		peak_mem = (size_t)total;
+}
+
+static void flush_counters_locked(MemThreadCache *cache)
+{
+	unsigned int tag;
+
+	totblock += cache->totblock;
+	mem_in_use += cache->mem_in_use;
+	cache->totblock = 0;
+	cache->mem_in_use = 0;
+
+	for (tag = 0; tag < MEM_TAG_TOT; tag++) {
+		mem_tag_flush(tag, cache->tag_mem_in_use[tag], cache->tag_totalloc[tag], cache->tag_totalloc_len[tag]);
+		cache->tag_mem_in_use[tag] = 0;
+		cache->tag_totalloc[tag] = 0;
+		cache->tag_totalloc_len[tag] = 0;
+	}
+}
+
+static void count_alloc(MemThreadCache *cache, unsigned int tag, size_t len)
+{
+	cache->totblock++;
+	cache->mem_in_use += (intptr_t)len;
+	cache->tag_mem_in_use[tag] += (intptr_t)len;
+	cache->tag_totalloc[tag]++;
+	cache->tag_totalloc_len[tag] += len;
+
+	if (cache->mem_in_use >= MEM_FLUSH_SIZE) {
+		pthread_mutex_lock(&cache_mutex);
+		flush_counters_locked(cache);
+		update_peak_locked();
+		pthread_mutex_unlock(&cache_mutex);
+	}
+}
+
+static void count_free(MemThreadCache *cache, unsigned int tag, size_t len)
+{
+	cache->totblock--;
+	cache->mem_in_use -= (intptr_t)len;
+	cache->tag_mem_in_use[tag] -= (intptr_t)len;
+
+	if (cache->mem_in_use <= -MEM_FLUSH_SIZE) {
+		pthread_mutex_lock(&cache_mutex);
+		flush_counters_locked(cache);
+		pthread_mutex_unlock(&cache_mutex);
+	}
+}
+
+/* counters of the tag not flushed by the threads yet */
+static void tag_pending(unsigned int tag, intptr_t *r_mem_in_use, size_t *r_totalloc, size_t *r_totalloc_len)
+{
+	MemThreadCache *cache;
+
+	*r_mem_in_use = 0;
+	*r_totalloc = 0;
+	*r_totalloc_len = 0;
+
+	pthread_mutex_lock(&cache_mutex);
+	for (cache = caches; cache; cache = cache->next) {
+		*r_mem_in_use += cache->tag_mem_in_use[tag];
+		*r_totalloc += cache->tag_totalloc[tag];
+		*r_totalloc_len += cache->tag_totalloc_len[tag];
+	}
+	pthread_mutex_unlock(&cache_mutex);
+}
+
+/* ******** free lists ******** */
+
+/* move the first count blocks of list to the front of dst */
+static void free_list_move(MemFreeList *dst, MemFreeList *list, unsigned int count)
+{
+	MemFreeBlock *first = list->first, *last = first;
+	unsigned int i;
+
+	for (i = 1; i < count; i++)
+		last = last->next;
+
+	list->first = last->next;
+	list->count -= count;
+
+	last->next = dst->first;
+	dst->first = first;
+	dst->count += count;
+}
+
+static unsigned int free_list_batch(unsigned int index)
+{
+	return (unsigned int)(MEM_CHUNK_SIZE / SIZE_CLASS_BLOCK_SIZE(index));
+}
+
+static void thread_cache_free(void *data)
+{
+	MemThreadCache *cache = data;
+	unsigned int i;
+
+	pthread_mutex_lock(&cache_mutex);
+
+	for (i = 0; i < MEM_NUM_CLASSES; i++) {
+		if (cache->free[i].count)
+			free_list_move(&free_lists[i], &cache->free[i], cache->free[i].count);
+	}
+
+	flush_counters_locked(cache);
+
+	if (cache->prev) cache->prev->next = cache->next;
+	else caches = cache->next;
+	if (cache->next) cache->next->prev = cache->prev;
+
+	pthread_mutex_unlock(&cache_mutex);
+
+	free(cache);
+}
+
+static MemThreadCache *thread_cache(void)
+{
+	MemThreadCache *cache = pthread_getspecific(cache_key);
+
+	if (cache == NULL) {
+		cache = calloc(1, sizeof(MemThreadCache));
+
+		if (cache) {
+			pthread_setspecific(cache_key, cache);
+
+			pthread_mutex_lock(&cache_mutex);
+			cache->next = caches;
+			if (caches) caches->prev = cache;
+			caches = cache;
+			pthread_mutex_unlock(&cache_mutex);
+		}
+	}
+
+	return cache;
+}
+
+static bool thread_cache_refill(MemThreadCache *cache, unsigned int index)
+{
+	MemFreeList *list = &cache->free[index];
+	unsigned int batch = free_list_batch(index);
+
+	pthread_mutex_lock(&cache_mutex);
+	if (free_lists[index].count)
+		free_list_move(list, &free_lists[index], batch < free_lists[index].count ? batch : free_lists[index].count);
+	pthread_mutex_unlock(&cache_mutex);
+
+	if (list->count == 0) {
+		size_t block_size = SIZE_CLASS_BLOCK_SIZE(index);
+		char *chunk = malloc(MEM_CHUNK_SIZE);
+		unsigned int i;
+
+		if (chunk == NULL)
+			return false;
+
+		atomic_add_z(&chunk_mem, MEM_CHUNK_SIZE);
+
+		for (i = batch; i > 0; i--) {
+			MemFreeBlock *block = (MemFreeBlock *)(chunk + (i - 1) * block_size);
+			block->next = list->first;
+			list->first = block;
+		}
+		list->count = batch;
+	}
+
+	return true;
+}
+
+static MemHead *small_alloc(MemThreadCache *cache, size_t len)
+{
+	unsigned int index = SIZE_CLASS(len);
+	MemFreeList *list = &cache->free[index];
+	MemFreeBlock *block;
+
+	if (list->first == NULL && !thread_cache_refill(cache, index))
+		return NULL;
+
+	block = list->first;
+	list->first = block->next;
+	list->count--;
+
+	return (MemHead *)block;
+}
+
+static void small_free(MemThreadCache *cache, MemHead *memh)
+{
+	unsigned int index = SIZE_CLASS(MEMHEAD_LEN(memh));
+	MemFreeBlock *block = (MemFreeBlock *)memh;
+
+	if (cache) {
+		MemFreeList *list = &cache->free[index];
+		unsigned int batch = free_list_batch(index);
+
+		block->next = list->first;
+		list->first = block;
+		list->count++;
+
+		if (list->count > 2 * batch) {
+			pthread_mutex_lock(&cache_mutex);
+			free_list_move(&free_lists[index], list, batch);
+			pthread_mutex_unlock(&cache_mutex);
+		}
+	}
+	else {
+		pthread_mutex_lock(&cache_mutex);
+		block->next = free_lists[index].first;
+		free_lists[index].first = block;
+		free_lists[index].count++;
+		pthread_mutex_unlock(&cache_mutex);
+	}
+}
+
+/* allocate len bytes, from the thread cache when small enough */
+static MemHead *memh_alloc(MemThreadCache *cache, size_t len, unsigned int tag, bool clear)
+{
+	MemHead *memh;
+
+	if (cache && IS_SMALL(len)) {
+		memh = small_alloc(cache, len);
+
+		if (memh) {
+			if (clear)
+				memset(memh + 1, 0, len);
+			memh->len = len | (size_t) 2 | MEM_TAG_LEN_BITS(tag);
+		}
+	}
+	else {
+		if (clear)
+			memh = (MemHead *)calloc(1, len + sizeof(MemHead));
+		else
+			memh = (MemHead *)malloc(len + sizeof(MemHead));
+
+		if (memh)
+			memh->len = len | MEM_TAG_LEN_BITS(tag);
+	}
+
+	return memh;
+}
+
+/* ******** allocator functions ******** */
+
+size_t MEM_threadcache_allocN_len(const void *vmemh)
+{
+	if (vmemh) {
+		return MEMHEAD_LEN(MEMHEAD_FROM_PTR(vmemh));
+	}
+	else {
+		return 0;
+	}
+}
+
+void MEM_threadcache_freeN(void *vmemh)
+{
+	MemHead *memh = MEMHEAD_FROM_PTR(vmemh);
+	MemThreadCache *cache = thread_cache();
+	size_t len = MEMHEAD_LEN(memh);
+	unsigned int tag = MEMHEAD_TAG(memh);
+
+	if (cache) {
+		count_free(cache, tag, len);
+	}
+	else {
+		pthread_mutex_lock(&cache_mutex);
+		totblock--;
+		mem_in_use -= (intptr_t)len;
+		pthread_mutex_unlock(&cache_mutex);
+		mem_tag_count_free(tag, len);
+	}
+
+	if (MEMHEAD_IS_MMAP(memh)) {
+		atomic_sub_z(&mmap_in_use, len);
+#if defined(WIN32)
+		/* our windows mmap implementation is not thread safe */
+		mem_lock_thread();
+#endif
+		if (munmap(memh, len + sizeof(MemHead)))
+			printf("Couldn't unmap memory\n");
+#if defined(WIN32)
+		mem_unlock_thread();
+#endif
+	}
+	else {
+		if (malloc_debug_memset && len) {
+			memset(memh + 1, 255, len);
+		}
+
+		if (MEMHEAD_IS_SMALL(memh))
+			small_free(cache, memh);
+		else
+			free(memh);
+	}
+}
+
+void *MEM_threadcache_dupallocN(const void *vmemh)
+{
+	void *newp = NULL;
+	if (vmemh) {
+		MemHead *memh = MEMHEAD_FROM_PTR(vmemh);
+		const size_t prev_size = MEM_allocN_len(vmemh);
+		if (MEMHEAD_IS_MMAP(memh)) {
+			newp = MEM_threadcache_mapallocN(prev_size, "dupli_mapalloc");
+		}
+		else {
+			newp = MEM_threadcache_mallocN(prev_size, "dupli_malloc");
+		}
+		memcpy(newp, vmemh, prev_size);
+	}
+	return newp;
+}
+
+/* small blocks that keep their size class are resized in place */
+static bool realloc_in_place(void *vmemh, size_t len)
+{
+	MemHead *memh = MEMHEAD_FROM_PTR(vmemh);
+	size_t old_len = MEM_allocN_len(vmemh);
+	MemThreadCache *cache;
+
+	len = SIZET_ALIGN_4(len);
+
+	if (!MEMHEAD_IS_SMALL(memh) || !IS_SMALL(len) || SIZE_CLASS(len) != SIZE_CLASS(old_len))
+		return false;
+
+	cache = thread_cache();
+	if (cache == NULL)
+		return false;
+
+	count_free(cache, MEMHEAD_TAG(memh), old_len);
+	count_alloc(cache, MEMHEAD_TAG(memh), len);
+
+	memh->len = len | (size_t) 2 | MEM_TAG_LEN_BITS(MEMHEAD_TAG(memh));
+
+	return true;
+}
+
+void *MEM_threadcache_reallocN_id(void *vmemh, size_t len, const char *str)
+{
+	void *newp = NULL;
+
+	if (vmemh) {
+		size_t old_len = MEM_allocN_len(vmemh);
+
+		if (realloc_in_place(vmemh, len))
+			return vmemh;
+
+		newp = MEM_threadcache_mallocN(len, "realloc");
+		if (newp) {
+			if (len < old_len) {
+				/* shrink */
+				memcpy(newp, vmemh, len);
+			}
+			else {
+				/* grow (or remain same size) */
+				memcpy(newp, vmemh, old_len);
+			}
+		}
+
+		MEM_threadcache_freeN(vmemh);
+	}
+	else {
+		newp = MEM_threadcache_mallocN(len, str);
+	}
+
+	return newp;
+}
+
+void *MEM_threadcache_recallocN_id(void *vmemh, size_t len, const char *str)
+{
+	void *newp = NULL;
+
+	if (vmemh) {
+		size_t old_len = MEM_allocN_len(vmemh);
+
+		if (realloc_in_place(vmemh, len)) {
+			if (len > old_len) {
+				/* grow, zero new bytes */
+				memset(((char *)vmemh) + old_len, 0, len - old_len);
+			}
+			return vmemh;
+		}
+
+		newp = MEM_threadcache_mallocN(len, "recalloc");
+		if (newp) {
+			if (len < old_len) {
+				/* shrink */
+				memcpy(newp, vmemh, len);
+			}
+			else {
+				memcpy(newp, vmemh, old_len);
+
+				if (len > old_len) {
+					/* grow */
+					/* zero new bytes */
+					memset(((char *)newp) + old_len, 0, len - old_len);
+				}
+			}
+		}
+
+		MEM_threadcache_freeN(vmemh);
+	}
+	else {
+		newp = MEM_threadcache_callocN(len, str);
+	}
+
+	return newp;
+}
+
+void *MEM_threadcache_callocN(size_t len, const char *str)
+{
+	MemThreadCache *cache = thread_cache();
+	unsigned int tag = mem_tag_current();
+	MemHead *memh;
+
+	len = SIZET_ALIGN_4(len);
+
+	memh = memh_alloc(cache, len, tag, true);
+
+	if (memh) {
+		if (cache) {
+			count_alloc(cache, tag, len);
+		}
+		else {
+			pthread_mutex_lock(&cache_mutex);
+			totblock++;
+			mem_in_use += (intptr_t)len;
+			update_peak_locked();
+			pthread_mutex_unlock(&cache_mutex);
+			mem_tag_count_alloc(tag, len);
+		}
+
+		return PTR_FROM_MEMHEAD(memh);
+	}
+	print_error("Calloc returns null: len=" SIZET_FORMAT " in %s, total %u\n",
+	            SIZET_ARG(len), str, (unsigned int) MEM_threadcache_get_memory_in_use());
+	return NULL;
+}
+
+void *MEM_threadcache_mallocN(size_t len, const char *str)
+{
+	MemThreadCache *cache = thread_cache();
+	unsigned int tag = mem_tag_current();
+	MemHead *memh;
+
+	len = SIZET_ALIGN_4(len);
+
+	memh = memh_alloc(cache, len, tag, false);
+
+	if (memh) {
+		if (malloc_debug_memset && len) {
+			memset(memh + 1, 255, len);
+		}
+
+		if (cache) {
+			count_alloc(cache, tag, len);
+		}
+		else {
+			pthread_mutex_lock(&cache_mutex);
+			totblock++;
+			mem_in_use += (intptr_t)len;
+			update_peak_locked();
+			pthread_mutex_unlock(&cache_mutex);
+			mem_tag_count_alloc(tag, len);
+		}
+
+		return PTR_FROM_MEMHEAD(memh);
+	}
+	print_error("Malloc returns null: len=" SIZET_FORMAT " in %s, total %u\n",
+	            SIZET_ARG(len), str, (unsigned int) MEM_threadcache_get_memory_in_use());
+	return NULL;
+}
+
+void *MEM_threadcache_mapallocN(size_t len, const char *str)
+{
+	unsigned int tag = mem_tag_current();
+	MemHead *memh;
+
+	len = SIZET_ALIGN_4(len);
+
+#if defined(WIN32)
+	/* our windows mmap implementation is not thread safe */
+	mem_lock_thread();
+#endif
+	memh = mmap(NULL, len + sizeof(MemHead),
+	            PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANON, -1, 0);
+#if defined(WIN32)
+	mem_unlock_thread();
+#endif
+
+	if (memh != (MemHead *)-1) {
+		memh->len = len | (size_t) 1 | MEM_TAG_LEN_BITS(tag);
+		atomic_add_z(&mmap_in_use, len);
+
+		/* mapped blocks are big, no need to delay updating the counters */
+		pthread_mutex_lock(&cache_mutex);
+		totblock++;
+		mem_in_use += (intptr_t)len;
+		update_peak_locked();
+		pthread_mutex_unlock(&cache_mutex);
+		mem_tag_count_alloc(tag, len);
+
+		return PTR_FROM_MEMHEAD(memh);
+	}
+	print_error("Mapalloc returns null, fallback to regular malloc: "
+	            "len=" SIZET_FORMAT " in %s, total %u\n",
+	            SIZET_ARG(len), str, (unsigned int) mmap_in_use);
+	return MEM_threadcache_callocN(len, str);
+}
+
+void MEM_threadcache_printmemlist_pydict(void)
+{
+}
+
+void MEM_threadcache_printmemlist(void)
+{
+}
+
+/* unused */
+void MEM_threadcache_callbackmemlist(void (*func)(void *))
+{
+	(void) func;  /* Ignored. */
+}
+
+void MEM_threadcache_printmemlist_stats(void)
+{
+	printf("\ntotal memory len: %.3f MB\n",
+	       (double)MEM_threadcache_get_memory_in_use() / (double)(1024 * 1024));
+	printf("peak memory len: %.3f MB\n",
+	       (double)MEM_threadcache_get_peak_memory() / (double)(1024 * 1024));
+	printf("small block chunks: %.3f MB\n",
+	       (double)chunk_mem / (double)(1024 * 1024));
+	MEM_tag_print_stats();
+	printf("\nFor more detailed per-block statistics run Blender with memory debugging command line argument.\n");
+
+#ifdef HAVE_MALLOC_STATS
+	printf("System Statistics:\n");
+	malloc_stats();
+#endif
+}
+
+void MEM_threadcache_set_error_callback(void (*func)(const char *))
+{
+	error_callback = func;
+}
+
+bool MEM_threadcache_check_memory_integrity(void)
+{
+	return true;
+}
+
+void MEM_threadcache_set_lock_callback(void (*lock)(void), void (*unlock)(void))
+{
+	thread_lock_callback = lock;
+	thread_unlock_callback = unlock;
+}
+
+void MEM_threadcache_set_memory_debug(void)
+{
+	malloc_debug_memset = true;
+}
+
+uintptr_t MEM_threadcache_get_memory_in_use(void)
+{
+	MemThreadCache *cache;
+	intptr_t total;
+
+	pthread_mutex_lock(&cache_mutex);
+	total = mem_in_use;
+	for (cache = caches; cache; cache = cache->next)
+		total += cache->mem_in_use;
+	pthread_mutex_unlock(&cache_mutex);
+
+	return (total > 0) ? (uintptr_t)total : 0;
+}
+
+uintptr_t MEM_threadcache_get_mapped_memory_in_use(void)
+{
+	return mmap_in_use;
+}
+
+unsigned int MEM_threadcache_get_memory_blocks_in_use(void)
+{
+	MemThreadCache *cache;
+	intptr_t total;
+
+	pthread_mutex_lock(&cache_mutex);
+	total = totblock;
+	for (cache = caches; cache; cache = cache->next)
+		total += cache->totblock;
+	pthread_mutex_unlock(&cache_mutex);
+
+	return (total > 0) ? (unsigned int)total : 0;
+}
+
+void MEM_threadcache_reset_peak_memory(void)
+{
+	pthread_mutex_lock(&cache_mutex);
+	peak_mem = 0;
+	pthread_mutex_unlock(&cache_mutex);
+}
+
+uintptr_t MEM_threadcache_get_peak_memory(void)
+{
+	uintptr_t peak;
+
+	pthread_mutex_lock(&cache_mutex);
+	update_peak_locked();
+	peak = peak_mem;
+	pthread_mutex_unlock(&cache_mutex);
+
+	return peak;
+}
+
+#ifndef NDEBUG
+const char *MEM_threadcache_name_ptr(void *vmemh)
+{
+	if (vmemh) {
+		return "unknown block name ptr";
+	}
+	else {
+		return "MEM_threadcache_name_ptr(NULL)";
+	}
+}
+#endif  /* NDEBUG */
+
+/* Defined here rather than in mallocn.c, so the tools that compile the other
+ * allocators into their executables don't depend on pthreads. */
+void MEM_use_threadcache_allocator(void)
+{
+	/* caches of exiting threads are moved to the global free lists */
+	pthread_key_create(&cache_key, thread_cache_free);
+	mem_tag_pending = tag_pending;
+
+	MEM_allocN_len = MEM_threadcache_allocN_len;
+	MEM_freeN = MEM_threadcache_freeN;
+	MEM_dupallocN = MEM_threadcache_dupallocN;
+	MEM_reallocN_id = MEM_threadcache_reallocN_id;
+	MEM_recallocN_id = MEM_threadcache_recallocN_id;
+	MEM_callocN = MEM_threadcache_callocN;
+	MEM_mallocN = MEM_threadcache_mallocN;
+	MEM_mapallocN = MEM_threadcache_mapallocN;
+	MEM_printmemlist_pydict = MEM_threadcache_printmemlist_pydict;
+	MEM_printmemlist = MEM_threadcache_printmemlist;
+	MEM_callbackmemlist = MEM_threadcache_callbackmemlist;
+	MEM_printmemlist_stats = MEM_threadcache_printmemlist_stats;
+	MEM_set_error_callback = MEM_threadcache_set_error_callback;
+	MEM_check_memory_integrity = MEM_threadcache_check_memory_integrity;
+	MEM_set_lock_callback = MEM_threadcache_set_lock_callback;
+	MEM_set_memory_debug = MEM_threadcache_set_memory_debug;
+	MEM_get_memory_in_use = MEM_threadcache_get_memory_in_use;
+	MEM_get_mapped_memory_in_use = MEM_threadcache_get_mapped_memory_in_use;
+	MEM_get_memory_blocks_in_use = MEM_threadcache_get_memory_blocks_in_use;
+	MEM_reset_peak_memory = MEM_threadcache_reset_peak_memory;
+	MEM_get_peak_memory = MEM_threadcache_get_peak_memory;
+
+#ifndef NDEBUG
+	MEM_name_ptr = MEM_threadcache_name_ptr;
+#endif
+}
@@ -0,0 +1,239 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2014 by Blender Foundation.
+ * All rights reserved.
+ *
+ * The Original Code is: all of this file.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/**
+ * Allocation benchmark, allocating and freeing blocks from many threads.
+ *
+ * Usage: threadtest [lockfree|guarded|threadcache] [threads] [iterations]
+ *
+ * Every thread keeps a window of live blocks of mostly small random sizes,
+ * replacing one block per iteration. Every fourth block is freed by the
+ * next thread, to include frees of blocks allocated by other threads.
+ * Threads account their blocks to different tags, which must all be back
+ * to zero memory in use at the end.
+ */
+
+/* To compile run:
+ * gcc -O2 -I../../ -I../../../atomic/ threadtest.c ../../intern/mallocn.c ../../intern/mallocn_guarded_impl.c \
+ *     ../../intern/mallocn_lockfree_impl.c ../../intern/mallocn_threadcache_impl.c -lpthread -o threadtest
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sys/time.h>
+
+#include "MEM_guardedalloc.h"
+
+#define MAX_THREADS 64
+#define WINDOW_SIZE 1024
+
+typedef struct ThreadData {
+	pthread_t thread;
+	int index;
+	int iterations;
+	unsigned int seed;
+
+	/* blocks handed to this thread to be freed */
+	pthread_mutex_t mutex;
+	void **handoff;
+	int handoff_len, handoff_size;
+} ThreadData;
+
+static ThreadData threads[MAX_THREADS];
+static int num_threads = 4;
+static pthread_mutex_t guarded_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void mem_error_cb(const char *errorStr)
+{
+	fprintf(stderr, "%s", errorStr);
+	fflush(stderr);
+}
+
+/* the guarded allocator needs a lock for use from multiple threads */
+static void guarded_lock(void)
+{
+	pthread_mutex_lock(&guarded_mutex);
+}
+
+static void guarded_unlock(void)
+{
+	pthread_mutex_unlock(&guarded_mutex);
+}
+
+static double time_seconds(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return (double)tv.tv_sec + (double)tv.tv_usec * 1e-6;
+}
+
+static size_t random_size(unsigned int *seed)
+{
+	unsigned int r = (unsigned int)rand_r(seed);
+
+	/* mostly small blocks, as allocated for BMesh elements and list items */
+	if (r % 64 == 0)
+		return 512 + r % 16384;
+	return 8 + r % 248;
+}
+
+static void handoff_push(ThreadData *data, void *block)
+{
+	pthread_mutex_lock(&data->mutex);
+	if (data->handoff_len == data->handoff_size) {
+		data->handoff_size = data->handoff_size ? data->handoff_size * 2 : 256;
+		data->handoff = realloc(data->handoff, sizeof(void *) * (size_t)data->handoff_size);
+	}
+	data->handoff[data->handoff_len++] = block;
+	pthread_mutex_unlock(&data->mutex);
+}
+
+static void handoff_free(ThreadData *data)
+{
+	int i;
+
+	pthread_mutex_lock(&data->mutex);
+	for (i = 0; i < data->handoff_len; i++)
+		MEM_freeN(data->handoff[i]);
+	data->handoff_len = 0;
+	pthread_mutex_unlock(&data->mutex);
+}
+
+static void *thread_run(void *arg)
+{
+	ThreadData *data = arg;
+	ThreadData *next = &threads[(data->index + 1) % num_threads];
+	void *window[WINDOW_SIZE] = {NULL};
+	int i;
+
+	MEM_tag_push(1 + data->index % (MEM_TAG_TOT - 1));
+
+	for (i = 0; i < data->iterations; i++) {
+		int slot = i % WINDOW_SIZE;
+		size_t size = random_size(&data->seed);
+
+		if (window[slot]) {
+			if (i % 4 == 0)
+				handoff_push(next, window[slot]);
+			else
+				MEM_freeN(window[slot]);
+		}
+
+		window[slot] = (i % 8 == 0) ? MEM_callocN(size, "threadtest calloc") : MEM_mallocN(size, "threadtest");
+		memset(window[slot], i & 255, size);
+
+		if (i % WINDOW_SIZE == 0)
+			handoff_free(data);
+	}
+
+	for (i = 0; i < WINDOW_SIZE; i++) {
+		if (window[i])
+			MEM_freeN(window[i]);
+	}
+
+	MEM_tag_pop();
+
+	return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+	const char *allocator = "lockfree";
+	int iterations = 1000000;
+	double start, end;
+	int i, tag, error = 0;
+
+	if (argc > 1) allocator = argv[1];
+	if (argc > 2) num_threads = atoi(argv[2]);
+	if (argc > 3) iterations = atoi(argv[3]);
+
+	if (num_threads < 1) num_threads = 1;
+	if (num_threads > MAX_THREADS) num_threads = MAX_THREADS;
+
+	if (strcmp(allocator, "guarded") == 0) {
+		MEM_use_guarded_allocator();
+		MEM_set_lock_callback(guarded_lock, guarded_unlock);
+	}
+	else if (strcmp(allocator, "threadcache") == 0) {
+		MEM_use_threadcache_allocator();
+	}
+	else if (strcmp(allocator, "lockfree") != 0) {
+		fprintf(stderr, "Unknown allocator %s\n", allocator);
+		return 1;
+	}
+
+	MEM_set_error_callback(mem_error_cb);
+
+	for (i = 0; i < num_threads; i++) {
+		threads[i].index = i;
+		threads[i].iterations = iterations;
+		threads[i].seed = (unsigned int)i + 1;
+		pthread_mutex_init(&threads[i].mutex, NULL);
+	}
+
+	start = time_seconds();
+
+	for (i = 0; i < num_threads; i++)
+		pthread_create(&threads[i].thread, NULL, thread_run, &threads[i]);
+	for (i = 0; i < num_threads; i++)
+		pthread_join(threads[i].thread, NULL);
+
+	/* blocks handed off after the last pass of the receiving thread */
+	for (i = 0; i < num_threads; i++)
+		handoff_free(&threads[i]);
+
+	end = time_seconds();
+
+	printf("%s: %d threads, %d iterations, %.3f s, %.1f M allocations/s\n",
+	       allocator, num_threads, iterations, end - start,
+	       (double)num_threads * iterations / (end - start) * 1e-6);
+	printf("blocks in use: %u, memory in use: %lu, peak memory: %lu\n",
+	       MEM_get_memory_blocks_in_use(), (unsigned long)MEM_get_memory_in_use(),
+	       (unsigned long)MEM_get_peak_memory());
+
+	MEM_tag_print_stats();
+
+	for (i = 0; i < num_threads; i++) {
+		pthread_mutex_destroy(&threads[i].mutex);
+		free(threads[i].handoff);
+	}
+
+	for (tag = 0; tag < MEM_TAG_TOT; tag++) {
+		MEM_TagStats stats;
+
+		MEM_tag_stats(tag, &stats);
+		if (stats.mem_in_use != 0)
+			error = 1;
+	}
+
+	if (MEM_get_memory_blocks_in_use() != 0)
+		error = 1;
+
+	return error;
+}
@@ -201,6 +201,8 @@ class RENDERLAYER_PT_views(RenderLayerButtonsPanel, Panel):
         row = layout.row()
         row.prop(rd, "views_setup", expand=True)
 
+        layout.prop(rd, "use_views_share_data")
+
         if basic_stereo:
             row = layout.row()
             row.template_list("RENDERLAYER_UL_renderviews", "", rd, "stereo_views", rd.views, "active_index", rows=2)
@@ -2237,9 +2237,11 @@ static void mesh_build_data(Scene *scene, Object *ob, CustomDataMask dataMask,
 	BKE_object_free_derived_caches(ob);
 	BKE_object_sculpt_modifiers_changed(ob);
 
+	MEM_tag_push(MEM_TAG_MESH);
 	mesh_calc_modifiers(scene, ob, NULL, &ob->derivedDeform,
 	                    &ob->derivedFinal, 0, 1,
 	                    needMapping, dataMask, -1, 1, build_shapekey_layers);
+	MEM_tag_pop();
 
 	DM_set_object_boundbox(ob, ob->derivedFinal);
 
@@ -2274,7 +2276,10 @@ static void editbmesh_build_data(Scene *scene, Object *obedit, BMEditMesh *em, C
 		em->derivedCage = NULL;
 	}
 
+	MEM_tag_push(MEM_TAG_MESH);
 	editbmesh_calc_modifiers(scene, obedit, em, &em->derivedCage, &em->derivedFinal, dataMask);
+	MEM_tag_pop();
+
 	DM_set_object_boundbox(obedit, em->derivedFinal);
 
 	em->lastDataMask = dataMask;
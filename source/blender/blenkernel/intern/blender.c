@@ -674,7 +674,9 @@ void BKE_write_undo(bContext *C, const char *name)
 		if (curundo->prev) prevfile = &(curundo->prev->memfile);
 		
 		memused = MEM_get_memory_in_use();
+		MEM_tag_push(MEM_TAG_UNDO);
 		/* success = */ /* UNUSED */ BLO_write_file_mem(CTX_data_main(C), prevfile, &curundo->memfile, G.fileflags);
+		MEM_tag_pop();
 		curundo->undosize = MEM_get_memory_in_use() - memused;
 	}
 
@@ -2505,6 +2505,8 @@ int BKE_ptcache_write(PTCacheID *pid, unsigned int cfra)
 	if (ptcache_write_needed(pid, cfra, &overwrite)==0)
 		return 0;
 
+	MEM_tag_push(MEM_TAG_CACHE);
+
 	if (pid->write_stream) {
 		ptcache_write_stream(pid, cfra, totpoint);
 	}
@@ -2512,6 +2514,8 @@ int BKE_ptcache_write(PTCacheID *pid, unsigned int cfra)
 		error += ptcache_write(pid, cfra, overwrite);
 	}
 
+	MEM_tag_pop();
+
 	/* Mark frames skipped if more than 1 frame forwards since last non-skipped frame. */
 	if (cfra - cache->last_exact == 1 || cfra == cache->startframe) {
 		cache->last_exact = cfra;
@@ -107,6 +107,18 @@ typedef enum OrderOfChunks {
 
 #define COM_NUMBER_OF_CHANNELS 4
 
+/**
+ * @brief maximum number of inputs of an operation that can be fused as a rect kernel
+ * @see NodeOperation.isRectKernel
+ */
+#define COM_RECT_KERNEL_MAX_INPUTS 4
+
+/**
+ * @brief memory limit of the buffers cached between executions when editing, in megabytes
+ * @see BufferCache
+ */
+#define COM_BUFFER_CACHE_LIMIT 1024
+
 #define COM_BLUR_BOKEH_PIXELS 512
 
 #endif  /* __COM_DEFINES_H__ */
@@ -0,0 +1,472 @@
+/*
+ * Copyright 2013, Blender Foundation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <map>
+#include <typeinfo>
+
+#include "COM_BufferCache.h"
+#include "COM_BufferCacheKey.h"
+#include "COM_ReadBufferOperation.h"
+#include "COM_SocketConnection.h"
+#include "COM_defines.h"
+
+extern "C" {
+#include "BLI_sys_types.h"
+#include "BLI_utildefines.h"
+#include "DNA_color_types.h"
+#include "DNA_node_types.h"
+#include "DNA_scene_types.h"
+#include "BKE_node.h"
+}
+
+#include "MEM_guardedalloc.h"
+
+using std::map;
+
+typedef struct BufferCacheEntry {
+	MemoryBuffer *buffer;
+	/* executed chunks of the buffer, NULL when none are known */
+	ChunkExecutionState *chunkStates;
+	unsigned int numberOfChunks;
+	/* operation using the buffer during the current execution */
+	WriteBufferOperation *owner;
+	unsigned int lastUsed;
+} BufferCacheEntry;
+
+typedef map<uint64_t, BufferCacheEntry *> BufferCacheMap;
+typedef map<NodeOperation *, uint64_t> OperationKeyMap;
+
+typedef struct BufferCacheKeyState {
+	uint64_t contextHash;
+	int viewId;
+	bool rendering;
+	OperationKeyMap keys;
+} BufferCacheKeyState;
+
+static BufferCacheMap s_entries;
+static unsigned int s_executionCounter = 0;
+
+/* ******** Keys ******** */
+
+static uint64_t hash_data(uint64_t hash, const void *data, size_t size)
+{
+	return BufferCacheKey::hashData(hash, data, size);
+}
+
+static uint64_t hash_string(uint64_t hash, const char *str)
+{
+	return BufferCacheKey::hashString(hash, str);
+}
+
+static uint64_t hash_context(CompositorContext &context)
+{
+	const RenderData *rd = context.getRenderData();
+	const bNodeTree *ntree = context.getbNodeTree();
+	const ColorManagedViewSettings *viewSettings = context.getViewSettings();
+	const ColorManagedDisplaySettings *displaySettings = context.getDisplaySettings();
+	uint64_t hash = BUFFER_CACHE_HASH_INIT;
+	int values[7];
+
+	/* the view is only part of the keys of view dependent operations */
+	values[0] = context.isFastCalculation();
+	values[1] = context.getQuality();
+	values[2] = context.getChunksize();
+	values[3] = rd->cfra;
+	values[4] = rd->size;
+	values[5] = rd->xsch;
+	values[6] = rd->ysch;
+	hash = hash_data(hash, values, sizeof(values));
+	hash = hash_data(hash, &rd->subframe, sizeof(rd->subframe));
+	hash = hash_data(hash, &rd->mode, sizeof(rd->mode));
+	hash = hash_data(hash, &rd->scemode, sizeof(rd->scemode));
+	hash = hash_data(hash, &rd->alphamode, sizeof(rd->alphamode));
+
+	/* the viewer border changes the chunks of all ExecutionGroup's */
+	if (ntree->flag & NTREE_VIEWER_BORDER) {
+		hash = hash_data(hash, &ntree->viewer_border, sizeof(ntree->viewer_border));
+	}
+
+	if (viewSettings) {
+		hash = hash_string(hash, viewSettings->look);
+		hash = hash_string(hash, viewSettings->view_transform);
+		hash = hash_data(hash, &viewSettings->exposure, sizeof(viewSettings->exposure));
+		hash = hash_data(hash, &viewSettings->gamma, sizeof(viewSettings->gamma));
+	}
+	if (displaySettings) {
+		hash = hash_string(hash, displaySettings->display_device);
+	}
+
+	return hash;
+}
+
+static int count_render_views(const RenderData *rd)
+{
+	SceneRenderView *srv;
+	int numberOfViews = 0;
+
+	if ((rd->scemode & R_MULTIVIEW) == 0) {
+		return 1;
+	}
+
+	for (srv = (SceneRenderView *)rd->views.first; srv; srv = srv->next) {
+		if ((srv->viewflag & SCE_VIEW_DISABLE) == 0) {
+			numberOfViews++;
+		}
+	}
+	return numberOfViews;
+}
+
+static uint64_t hash_curve_mapping(uint64_t hash, CurveMapping *cumap)
+{
+	int index;
+
+	hash = hash_data(hash, &cumap->flag, sizeof(cumap->flag));
+	hash = hash_data(hash, &cumap->clipr, sizeof(cumap->clipr));
+	hash = hash_data(hash, cumap->black, sizeof(cumap->black));
+	hash = hash_data(hash, cumap->white, sizeof(cumap->white));
+	for (index = 0; index < CM_TOT; index++) {
+		CurveMap *cuma = &cumap->cm[index];
+		hash = hash_data(hash, &cuma->totpoint, sizeof(cuma->totpoint));
+		if (cuma->curve) {
+			hash = hash_data(hash, cuma->curve, sizeof(CurveMapPoint) * cuma->totpoint);
+		}
+	}
+	return hash;
+}
+
+static uint64_t hash_node(uint64_t hash, bNode *node)
+{
+	bNodeSocket *sock;
+
+	hash = hash_data(hash, &node, sizeof(node));
+	hash = hash_data(hash, &node->type, sizeof(node->type));
+	hash = hash_data(hash, &node->custom1, sizeof(node->custom1));
+	hash = hash_data(hash, &node->custom2, sizeof(node->custom2));
+	hash = hash_data(hash, &node->custom3, sizeof(node->custom3));
+	hash = hash_data(hash, &node->custom4, sizeof(node->custom4));
+	hash = BufferCacheKey::hashNodeID(hash, node);
+
+	if (node->storage) {
+		switch (node->type) {
+			case CMP_NODE_TIME:
+			case CMP_NODE_CURVE_VEC:
+			case CMP_NODE_CURVE_RGB:
+			case CMP_NODE_HUECORRECT:
+				hash = hash_curve_mapping(hash, (CurveMapping *)node->storage);
+				break;
+			default:
+				hash = hash_data(hash, node->storage, MEM_allocN_len(node->storage));
+				break;
+		}
+	}
+
+	for (sock = (bNodeSocket *)node->inputs.first; sock; sock = sock->next) {
+		if (sock->default_value) {
+			hash = hash_data(hash, sock->default_value, MEM_allocN_len(sock->default_value));
+		}
+	}
+
+	return hash;
+}
+
+/**
+ * @brief key of the output of an operation, 0 when the output can't be cached
+ */
+static uint64_t hash_operation(NodeOperation *operation, BufferCacheKeyState &state)
+{
+	OperationKeyMap::iterator found = state.keys.find(operation);
+	uint64_t hash = 0;
+	unsigned int index;
+
+	if (found != state.keys.end()) {
+		return found->second;
+	}
+
+	if (operation->isReadBufferOperation()) {
+		ReadBufferOperation *readOperation = (ReadBufferOperation *)operation;
+		hash = hash_operation(readOperation->getMemoryProxy()->getWriteBufferOperation(), state);
+	}
+	else if (state.rendering && operation->isViewDependent()) {
+		/* only the buffers shared by all views are kept during rendering */
+	}
+	else if (state.rendering || operation->getbNode() == NULL || BufferCacheKey::isCacheable(operation->getbNode())) {
+		const char *type = typeid(*operation).name();
+		unsigned int resolution[2];
+
+		resolution[0] = operation->getWidth();
+		resolution[1] = operation->getHeight();
+
+		hash = hash_string(state.contextHash, type);
+		hash = hash_data(hash, resolution, sizeof(resolution));
+
+		if (operation->isViewDependent()) {
+			hash = hash_data(hash, &state.viewId, sizeof(state.viewId));
+		}
+
+		if (operation->getbNode()) {
+			hash = hash_node(hash, operation->getbNode());
+		}
+
+		/* constants created for unconnected sockets and resolution conversion */
+		if (operation->isSetOperation()) {
+			float value[4];
+			operation->readSampled(value, 0.0f, 0.0f, COM_PS_NEAREST);
+			hash = hash_data(hash, value, sizeof(value));
+		}
+
+		for (index = 0; index < operation->getNumberOfInputSockets(); index++) {
+			InputSocket *socket = operation->getInputSocket(index);
+			uint64_t inputHash = 0;
+
+			if (socket->isConnected()) {
+				NodeOperation *inputOperation = (NodeOperation *)socket->getConnection()->getFromNode();
+				inputHash = hash_operation(inputOperation, state);
+				if (inputHash == 0) {
+					hash = 0;
+					break;
+				}
+			}
+			hash = hash_data(hash, &inputHash, sizeof(inputHash));
+		}
+
+		if (hash == 0 && index == operation->getNumberOfInputSockets()) {
+			hash = 1;
+		}
+	}
+
+	state.keys[operation] = hash;
+	return hash;
+}
+
+void BufferCache::determineKeys(ExecutionSystem *system)
+{
+	vector<NodeOperation *> &operations = system->getOperations();
+	CompositorContext &context = system->getContext();
+	BufferCacheKeyState state;
+	unsigned int index;
+
+	s_executionCounter++;
+
+	if (context.isRendering()) {
+		/* renders only share buffers between the views of a multiview render */
+		if (count_render_views(context.getRenderData()) < 2) {
+			return;
+		}
+		/* the first view starts a new render result */
+		if (context.getViewId() == 0) {
+			clear();
+		}
+	}
+
+	state.contextHash = hash_context(context);
+	state.viewId = context.getViewId();
+	state.rendering = context.isRendering();
+
+	for (index = 0; index < operations.size(); index++) {
+		NodeOperation *operation = operations[index];
+		if (operation->isWriteBufferOperation()) {
+			WriteBufferOperation *writeOperation = (WriteBufferOperation *)operation;
+			writeOperation->setCacheKey(hash_operation(writeOperation, state));
+		}
+	}
+}
+
+/* ******** Buffers ******** */
+
+static BufferCacheEntry *find_entry(WriteBufferOperation *operation)
+{
+	BufferCacheMap::iterator found;
+
+	if (operation->getCacheKey() == 0) {
+		return NULL;
+	}
+
+	found = s_entries.find(operation->getCacheKey());
+	if (found == s_entries.end()) {
+		return NULL;
+	}
+	return found->second;
+}
+
+static void free_entry(BufferCacheEntry *entry)
+{
+	delete entry->buffer;
+	if (entry->chunkStates) {
+		MEM_freeN(entry->chunkStates);
+	}
+	MEM_freeN(entry);
+}
+
+static size_t entry_size(BufferCacheEntry *entry)
+{
+	return sizeof(float) * entry->buffer->getNumberOfChannels() * entry->buffer->getWidth() * entry->buffer->getHeight();
+}
+
+MemoryBuffer *BufferCache::acquire(WriteBufferOperation *operation)
+{
+	BufferCacheEntry *entry = find_entry(operation);
+
+	if (entry == NULL || entry->owner != NULL) {
+		return NULL;
+	}
+	if (entry->buffer->getWidth() != (int)operation->getWidth() ||
+	    entry->buffer->getHeight() != (int)operation->getHeight() ||
+	    entry->buffer->getNumberOfChannels() != MemoryBuffer::determineNumberOfChannels(operation->getMemoryProxy()->getDataType()))
+	{
+		return NULL;
+	}
+
+	entry->owner = operation;
+	entry->lastUsed = s_executionCounter;
+	return entry->buffer;
+}
+
+void BufferCache::release(WriteBufferOperation *operation, MemoryBuffer *buffer)
+{
+	BufferCacheEntry *entry = find_entry(operation);
+
+	if (entry && entry->owner == operation) {
+		/* the cached buffer has been used */
+		return;
+	}
+	if (entry && entry->owner != NULL) {
+		/* an other operation with the same key already stored its buffer */
+		delete buffer;
+		return;
+	}
+
+	if (entry == NULL) {
+		entry = (BufferCacheEntry *)MEM_callocN(sizeof(BufferCacheEntry), "BufferCacheEntry");
+		s_entries[operation->getCacheKey()] = entry;
+	}
+	else {
+		delete entry->buffer;
+		if (entry->chunkStates) {
+			MEM_freeN(entry->chunkStates);
+			entry->chunkStates = NULL;
+		}
+	}
+
+	entry->buffer = buffer;
+	entry->owner = operation;
+	entry->lastUsed = s_executionCounter;
+}
+
+void BufferCache::restoreChunkStates(WriteBufferOperation *operation, ChunkExecutionState *states, unsigned int numberOfChunks)
+{
+	BufferCacheEntry *entry = find_entry(operation);
+	unsigned int index;
+
+	if (entry == NULL || entry->owner != operation || entry->chunkStates == NULL ||
+	    entry->numberOfChunks != numberOfChunks)
+	{
+		return;
+	}
+
+	for (index = 0; index < numberOfChunks; index++) {
+		if (entry->chunkStates[index] == COM_ES_EXECUTED) {
+			states[index] = COM_ES_EXECUTED;
+		}
+	}
+}
+
+void BufferCache::storeChunkStates(WriteBufferOperation *operation, const ChunkExecutionState *states, unsigned int numberOfChunks)
+{
+	BufferCacheEntry *entry = find_entry(operation);
+	unsigned int index;
+
+	if (entry == NULL || entry->owner != operation) {
+		return;
+	}
+
+	if (entry->chunkStates == NULL || entry->numberOfChunks != numberOfChunks) {
+		if (entry->chunkStates) {
+			MEM_freeN(entry->chunkStates);
+		}
+		entry->chunkStates = (ChunkExecutionState *)MEM_mallocN(sizeof(ChunkExecutionState) * numberOfChunks, __func__);
+		entry->numberOfChunks = numberOfChunks;
+	}
+
+	/* scheduled chunks have not been finished */
+	for (index = 0; index < numberOfChunks; index++) {
+		entry->chunkStates[index] = (states[index] == COM_ES_EXECUTED) ? COM_ES_EXECUTED : COM_ES_NOT_SCHEDULED;
+	}
+}
+
+void BufferCache::freeUnused(ExecutionSystem *system)
+{
+	CompositorContext &context = system->getContext();
+	BufferCacheMap::iterator iter;
+	size_t totalSize = 0;
+	const size_t limit = (size_t)COM_BUFFER_CACHE_LIMIT * 1024 * 1024;
+
+	/* all views of the render result have been composited */
+	if (context.isRendering() && context.getViewId() + 1 >= count_render_views(context.getRenderData())) {
+		clear();
+		return;
+	}
+
+	/* buffers without executed chunks, the operations using the buffers are done */
+	for (iter = s_entries.begin(); iter != s_entries.end(); ) {
+		BufferCacheEntry *entry = iter->second;
+		bool executed = false;
+		unsigned int index;
+
+		entry->owner = NULL;
+
+		if (entry->chunkStates) {
+			for (index = 0; index < entry->numberOfChunks && !executed; index++) {
+				executed = (entry->chunkStates[index] == COM_ES_EXECUTED);
+			}
+		}
+
+		if (!executed) {
+			free_entry(entry);
+			s_entries.erase(iter++);
+		}
+		else {
+			totalSize += entry_size(entry);
+			++iter;
+		}
+	}
+
+	/* least recently used buffers */
+	while (totalSize > limit) {
+		BufferCacheMap::iterator oldest = s_entries.end();
+
+		for (iter = s_entries.begin(); iter != s_entries.end(); ++iter) {
+			if (oldest == s_entries.end() || iter->second->lastUsed < oldest->second->lastUsed) {
+				oldest = iter;
+			}
+		}
+
+		totalSize -= entry_size(oldest->second);
+		free_entry(oldest->second);
+		s_entries.erase(oldest);
+	}
+}
+
+void BufferCache::clear()
+{
+	BufferCacheMap::iterator iter;
+
+	for (iter = s_entries.begin(); iter != s_entries.end(); ++iter) {
+		free_entry(iter->second);
+	}
+	s_entries.clear();
+}
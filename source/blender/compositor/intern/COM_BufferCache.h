@@ -0,0 +1,93 @@
+/*
+ * Copyright 2013, Blender Foundation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _COM_BufferCache_h_
+#define _COM_BufferCache_h_
+
+#include "COM_ExecutionGroup.h"
+#include "COM_ExecutionSystem.h"
+#include "COM_MemoryBuffer.h"
+#include "COM_WriteBufferOperation.h"
+
+/**
+ * @brief cache of the MemoryBuffer's written by WriteBufferOperation's, kept between executions
+ *
+ * Every WriteBufferOperation gets a key that is a hash of the operations it depends on: their type,
+ * resolution and the settings of the bNode they were created for, and the keys of the buffers they read.
+ * When the key of a buffer didn't change since the last execution, its MemoryBuffer and the chunks that
+ * were already calculated are reused. Changing a node therefore only recalculates the buffers downstream
+ * of that node.
+ *
+ * Buffers depending on external data that can change without the node changing (images, movie clips,
+ * masks, textures) are not cached when editing. Render layers are cached, the cache is cleared when a
+ * new render result is available. For nodes using a scene the scene camera is part of the key.
+ *
+ * When rendering multiple views, COM_execute is called for every view. The buffers that don't depend
+ * on a view dependent operation (render layers, images) are calculated for the first view and reused
+ * for the other views, the cache is cleared after the last view.
+ *
+ * The cache is limited to COM_BUFFER_CACHE_LIMIT megabytes.
+ * @ingroup Memory
+ */
+class BufferCache {
+public:
+	/**
+	 * @brief determine the cache keys of all WriteBufferOperation's of an ExecutionSystem
+	 * @note resolutions must have been determined
+	 */
+	static void determineKeys(ExecutionSystem *system);
+
+	/**
+	 * @brief get the cached buffer of a WriteBufferOperation
+	 * @return the cached MemoryBuffer, or NULL when there is none
+	 */
+	static MemoryBuffer *acquire(WriteBufferOperation *operation);
+
+	/**
+	 * @brief give the buffer of a WriteBufferOperation to the cache after execution
+	 * @note the buffer is owned by the cache afterwards
+	 */
+	static void release(WriteBufferOperation *operation, MemoryBuffer *buffer);
+
+	/**
+	 * @brief mark the chunks that are available in the cached buffer as executed
+	 */
+	static void restoreChunkStates(WriteBufferOperation *operation, ChunkExecutionState *states, unsigned int numberOfChunks);
+
+	/**
+	 * @brief remember which chunks of the buffer of a WriteBufferOperation have been executed
+	 */
+	static void storeChunkStates(WriteBufferOperation *operation, const ChunkExecutionState *states, unsigned int numberOfChunks);
+
+	/**
+	 * @brief free buffers without executed chunks, and the least recently used buffers when over the memory limit
+	 * @note after the last view of a render all buffers are freed
+	 */
+	static void freeUnused(ExecutionSystem *system);
+
+	/**
+	 * @brief free all cached buffers
+	 */
+	static void clear();
+
+#ifdef WITH_CXX_GUARDEDALLOC
+	MEM_CXX_CLASS_ALLOC_FUNCS("COM:BufferCache")
+#endif
+};
+
+#endif
@@ -0,0 +1,104 @@
+/*
+ * Copyright 2013, Blender Foundation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <string.h>
+
+#include "COM_BufferCacheKey.h"
+
+extern "C" {
+#include "BLI_utildefines.h"
+#include "DNA_camera_types.h"
+#include "DNA_ID.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+}
+
+uint64_t BufferCacheKey::hashData(uint64_t hash, const void *data, size_t size)
+{
+	const unsigned char *bytes = (const unsigned char *)data;
+	size_t index;
+
+	for (index = 0; index < size; index++) {
+		hash ^= bytes[index];
+		hash *= BUFFER_CACHE_HASH_PRIME;
+	}
+	return hash;
+}
+
+uint64_t BufferCacheKey::hashString(uint64_t hash, const char *str)
+{
+	return hashData(hash, str, strlen(str) + 1);
+}
+
+/**
+ * scenes (render layers) are cleared by COM_clearCaches and their camera is part of the key,
+ * node groups are converted to their own nodes.
+ */
+bool BufferCacheKey::isCacheable(bNode *node)
+{
+	if (node->id == NULL) {
+		return true;
+	}
+	return ELEM(GS(node->id->name), ID_SCE, ID_NT);
+}
+
+static uint64_t hash_camera(uint64_t hash, Object *camob)
+{
+	Camera *camera;
+
+	hash = BufferCacheKey::hashData(hash, &camob, sizeof(camob));
+	if (camob == NULL) {
+		return hash;
+	}
+
+	/* the depth of field distance is measured from the camera */
+	hash = BufferCacheKey::hashData(hash, camob->obmat, sizeof(camob->obmat));
+	if (camob->type != OB_CAMERA) {
+		return hash;
+	}
+
+	camera = (Camera *)camob->data;
+	hash = BufferCacheKey::hashData(hash, &camera->type, sizeof(camera->type));
+	hash = BufferCacheKey::hashData(hash, &camera->clipsta, sizeof(camera->clipsta));
+	hash = BufferCacheKey::hashData(hash, &camera->clipend, sizeof(camera->clipend));
+	hash = BufferCacheKey::hashData(hash, &camera->lens, sizeof(camera->lens));
+	hash = BufferCacheKey::hashData(hash, &camera->ortho_scale, sizeof(camera->ortho_scale));
+	hash = BufferCacheKey::hashData(hash, &camera->sensor_x, sizeof(camera->sensor_x));
+	hash = BufferCacheKey::hashData(hash, &camera->sensor_y, sizeof(camera->sensor_y));
+	hash = BufferCacheKey::hashData(hash, &camera->sensor_fit, sizeof(camera->sensor_fit));
+	hash = BufferCacheKey::hashData(hash, &camera->YF_dofdist, sizeof(camera->YF_dofdist));
+	hash = BufferCacheKey::hashData(hash, &camera->dof_ob, sizeof(camera->dof_ob));
+	if (camera->dof_ob) {
+		hash = BufferCacheKey::hashData(hash, camera->dof_ob->obmat, sizeof(camera->dof_ob->obmat));
+	}
+
+	return hash;
+}
+
+uint64_t BufferCacheKey::hashNodeID(uint64_t hash, bNode *node)
+{
+	hash = hashData(hash, &node->id, sizeof(node->id));
+
+	if (node->id && GS(node->id->name) == ID_SCE) {
+		/* defocus reads the lens and depth of field of the scene camera */
+		Scene *scene = (Scene *)node->id;
+		hash = hash_camera(hash, scene->camera);
+	}
+
+	return hash;
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright 2013, Blender Foundation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _COM_BufferCacheKey_h_
+#define _COM_BufferCacheKey_h_
+
+#include <stddef.h>
+
+extern "C" {
+#include "BLI_sys_types.h"
+#include "DNA_node_types.h"
+}
+
+/* FNV-1a */
+#define BUFFER_CACHE_HASH_INIT  14695981039346656037ULL
+#define BUFFER_CACHE_HASH_PRIME 1099511628211ULL
+
+/**
+ * @brief hashing of the data the keys of the BufferCache are made of
+ *
+ * Only depends on DNA, so the keys of nodes can be tested without an ExecutionSystem.
+ * @see BufferCache
+ * @ingroup Memory
+ */
+class BufferCacheKey {
+public:
+	/**
+	 * @brief add a block of memory to a hash
+	 */
+	static uint64_t hashData(uint64_t hash, const void *data, size_t size);
+
+	/**
+	 * @brief add a string, including its terminator, to a hash
+	 */
+	static uint64_t hashString(uint64_t hash, const char *str);
+
+	/**
+	 * @brief check if the result of a node only depends on data that is part of its key
+	 * @note nodes using images, movie clips, masks or textures can change without the node changing
+	 */
+	static bool isCacheable(bNode *node);
+
+	/**
+	 * @brief add the data a node reads through its ID block to a hash
+	 * @note for scenes this is the active camera, its transform and its lens and depth of field settings
+	 */
+	static uint64_t hashNodeID(uint64_t hash, bNode *node);
+};
+
+#endif
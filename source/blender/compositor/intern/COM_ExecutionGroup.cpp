@@ -26,6 +26,7 @@
 #include <stdlib.h>
 
 #include "COM_ExecutionGroup.h"
+#include "COM_BufferCache.h"
 #include "COM_InputSocket.h"
 #include "COM_SocketConnection.h"
 #include "COM_defines.h"
@@ -47,11 +48,19 @@
 #include "WM_api.h"
 #include "WM_types.h"
 
+/**
+ * @brief lock for the chunk states and dependencies of all ExecutionGroup's
+ * @note chunks are added to the WorkScheduler after releasing the lock, as the work can be executed directly
+ */
+static ThreadMutex g_scheduleMutex = PTHREAD_MUTEX_INITIALIZER;
+
 ExecutionGroup::ExecutionGroup()
 {
 	this->m_isOutput = false;
 	this->m_complex = false;
 	this->m_chunkExecutionStates = NULL;
+	this->m_chunkDependencies = NULL;
+	this->m_chunkDependents = NULL;
 	this->m_bTree = NULL;
 	this->m_height = 0;
 	this->m_width = 0;
@@ -65,6 +74,7 @@ ExecutionGroup::ExecutionGroup()
 	this->m_chunksFinished = 0;
 	BLI_rcti_init(&this->m_viewerBorder, 0, 0, 0, 0);
 	this->m_executionStartTime = 0;
+	this->m_executionTime = 0;
 }
 
 CompositorPriority ExecutionGroup::getRenderPriotrity()
@@ -160,11 +170,20 @@ void ExecutionGroup::initExecution()
 	determineNumberOfChunks();
 
 	this->m_chunkExecutionStates = NULL;
+	this->m_executionTime = 0;
 	if (this->m_numberOfChunks != 0) {
 		this->m_chunkExecutionStates = (ChunkExecutionState *)MEM_mallocN(sizeof(ChunkExecutionState) * this->m_numberOfChunks, __func__);
+		this->m_chunkDependencies = (unsigned int *)MEM_callocN(sizeof(unsigned int) * this->m_numberOfChunks, __func__);
+		this->m_chunkDependents = new vector<ChunkReference>[this->m_numberOfChunks];
 		for (index = 0; index < this->m_numberOfChunks; index++) {
 			this->m_chunkExecutionStates[index] = COM_ES_NOT_SCHEDULED;
 		}
+
+		/* chunks available in a cached buffer don't need to be calculated again */
+		NodeOperation *output = this->getOutputNodeOperation();
+		if (output->isWriteBufferOperation() && ((WriteBufferOperation *)output)->getCacheKey()) {
+			BufferCache::restoreChunkStates((WriteBufferOperation *)output, this->m_chunkExecutionStates, this->m_numberOfChunks);
+		}
 	}
 
 
@@ -181,20 +200,124 @@ void ExecutionGroup::initExecution()
 	maxNumber++;
 	this->m_cachedMaxReadBufferOffset = maxNumber;
 
+	determineRectKernels();
 }
 
 void ExecutionGroup::deinitExecution()
 {
 	if (this->m_chunkExecutionStates != NULL) {
+		/* chunks of a cancelled execution can be incomplete */
+		NodeOperation *output = this->getOutputNodeOperation();
+		if (output->isWriteBufferOperation() && ((WriteBufferOperation *)output)->getCacheKey() && !output->isBreaked()) {
+			BufferCache::storeChunkStates((WriteBufferOperation *)output, this->m_chunkExecutionStates, this->m_numberOfChunks);
+		}
 		MEM_freeN(this->m_chunkExecutionStates);
+		MEM_freeN(this->m_chunkDependencies);
+		delete[] this->m_chunkDependents;
 		this->m_chunkExecutionStates = NULL;
+		this->m_chunkDependencies = NULL;
+		this->m_chunkDependents = NULL;
 	}
 	this->m_numberOfChunks = 0;
 	this->m_numberOfXChunks = 0;
 	this->m_numberOfYChunks = 0;
 	this->m_cachedReadOperations.clear();
+	this->m_rectKernels.clear();
 	this->m_bTree = NULL;
 }
+
+void ExecutionGroup::determineRectKernels()
+{
+	NodeOperation *operation = this->getOutputNodeOperation();
+
+	this->m_rectKernels.clear();
+
+	/* only chunks that are written to a MemoryBuffer are calculated per row,
+	 * output operations (viewer, composite etc) read their input per pixel */
+	if (this->m_complex || !operation->isWriteBufferOperation()) {
+		return;
+	}
+
+	WriteBufferOperation *writeOperation = (WriteBufferOperation *)operation;
+	if (addRectKernel(writeOperation->getInput()) == -1) {
+		this->m_rectKernels.clear();
+	}
+}
+
+int ExecutionGroup::addRectKernel(NodeOperation *operation)
+{
+	unsigned int index;
+
+	/* operations read by multiple inputs are only calculated once */
+	for (index = 0; index < this->m_rectKernels.size(); index++) {
+		if (this->m_rectKernels[index].operation == operation) {
+			return index;
+		}
+	}
+
+	RectKernel kernel;
+	kernel.operation = operation;
+	kernel.numberOfInputs = 0;
+
+	if (!operation->isReadBufferOperation()) {
+		if (!operation->isRectKernel() || operation->getNumberOfInputSockets() > COM_RECT_KERNEL_MAX_INPUTS) {
+			return -1;
+		}
+
+		for (index = 0; index < operation->getNumberOfInputSockets(); index++) {
+			InputSocket *inputSocket = operation->getInputSocket(index);
+			if (!inputSocket->isConnected()) {
+				return -1;
+			}
+
+			NodeOperation *inputOperation = (NodeOperation *)inputSocket->getConnection()->getFromNode();
+			int inputKernel = addRectKernel(inputOperation);
+			if (inputKernel == -1) {
+				return -1;
+			}
+			kernel.inputs[index] = inputKernel;
+		}
+		kernel.numberOfInputs = operation->getNumberOfInputSockets();
+	}
+
+	this->m_rectKernels.push_back(kernel);
+	return this->m_rectKernels.size() - 1;
+}
+
+float *ExecutionGroup::allocateRectKernelRows(int width)
+{
+	/* the last kernel writes directly to the output */
+	int numberOfRows = this->m_rectKernels.size() - 1;
+	if (numberOfRows < 1) {
+		numberOfRows = 1;
+	}
+	return (float *)MEM_mallocN(sizeof(float) * COM_NUMBER_OF_CHANNELS * width * numberOfRows, __func__);
+}
+
+void ExecutionGroup::executeRectKernels(float *output, float *rows, int x, int y, int width)
+{
+	const int rowSize = width * COM_NUMBER_OF_CHANNELS;
+	const int lastKernel = this->m_rectKernels.size() - 1;
+	float *inputs[COM_RECT_KERNEL_MAX_INPUTS];
+	int index;
+
+	for (index = 0; index <= lastKernel; index++) {
+		const RectKernel &kernel = this->m_rectKernels[index];
+		float *row = (index == lastKernel) ? output : &rows[index * rowSize];
+
+		if (kernel.operation->isReadBufferOperation()) {
+			ReadBufferOperation *readOperation = (ReadBufferOperation *)kernel.operation;
+			readOperation->readRow(row, x, y, width);
+		}
+		else {
+			int input;
+			for (input = 0; input < kernel.numberOfInputs; input++) {
+				inputs[input] = &rows[kernel.inputs[input] * rowSize];
+			}
+			kernel.operation->executeRect(row, inputs, width);
+		}
+	}
+}
 void ExecutionGroup::determineResolution(unsigned int resolution[2])
 {
 	NodeOperation *operation = this->getOutputNodeOperation();
@@ -347,46 +470,23 @@ void ExecutionGroup::execute(ExecutionSystem *graph)
 	DebugInfo::execution_group_started(this);
 	DebugInfo::graphviz(graph);
 
-	bool breaked = false;
-	bool finished = false;
-	unsigned int startIndex = 0;
-	const int maxNumberEvaluated = BLI_system_thread_count() * 2;
-
-	while (!finished && !breaked) {
-		bool startEvaluated = false;
-		finished = true;
-		int numberEvaluated = 0;
-
-		for (index = startIndex; index < this->m_numberOfChunks && numberEvaluated < maxNumberEvaluated; index++) {
-			chunkNumber = chunkOrder[index];
-			int yChunk = chunkNumber / this->m_numberOfXChunks;
-			int xChunk = chunkNumber - (yChunk * this->m_numberOfXChunks);
-			const ChunkExecutionState state = this->m_chunkExecutionStates[chunkNumber];
-			if (state == COM_ES_NOT_SCHEDULED) {
-				scheduleChunkWhenPossible(graph, xChunk, yChunk);
-				finished = false;
-				startEvaluated = true;
-				numberEvaluated++;
-
-				if (bTree->update_draw)
-					bTree->update_draw(bTree->udh);
-			}
-			else if (state == COM_ES_SCHEDULED) {
-				finished = false;
-				startEvaluated = true;
-				numberEvaluated++;
-			}
-			else if (state == COM_ES_EXECUTED && !startEvaluated) {
-				startIndex = index + 1;
-			}
-		}
-
-		WorkScheduler::finish();
+	/* schedule all chunks, chunks are added to the WorkScheduler when their input chunks are executed */
+	vector<ChunkReference> ready;
 
-		if (bTree->test_break && bTree->test_break(bTree->tbh)) {
-			breaked = true;
-		}
+	BLI_mutex_lock(&g_scheduleMutex);
+	for (index = 0; index < this->m_numberOfChunks; index++) {
+		chunkNumber = chunkOrder[index];
+		int yChunk = chunkNumber / this->m_numberOfXChunks;
+		int xChunk = chunkNumber - (yChunk * this->m_numberOfXChunks);
+		scheduleChunkWhenPossible(graph, xChunk, yChunk, &ready);
 	}
+	BLI_mutex_unlock(&g_scheduleMutex);
+
+	scheduleReadyChunks(ready);
+
+	/* when breaked the remaining chunks are cancelled by the WorkScheduler */
+	WorkScheduler::finish();
+
 	DebugInfo::execution_group_finished(this);
 	DebugInfo::graphviz(graph);
 
@@ -446,16 +546,27 @@ void ExecutionGroup::printBackgroundStats(void)
 	printf("| Tree %s, Tile %d-%d ", this->m_bTree->id.name + 2,
 	       this->m_chunksFinished, this->m_numberOfChunks);
 
+	BLI_timestr(this->m_executionTime, timestr, sizeof(timestr));
+	printf("| Group Time %s ", timestr);
+
 	fputc('\n', stdout);
 	fflush(stdout);
 }
 
 void ExecutionGroup::finalizeChunkExecution(int chunkNumber, MemoryBuffer **memoryBuffers)
 {
+	vector<ChunkReference> ready;
+
+	BLI_mutex_lock(&g_scheduleMutex);
 	if (this->m_chunkExecutionStates[chunkNumber] == COM_ES_SCHEDULED)
 		this->m_chunkExecutionStates[chunkNumber] = COM_ES_EXECUTED;
 	
 	this->m_chunksFinished++;
+	releaseChunkDependents(chunkNumber, &ready);
+	BLI_mutex_unlock(&g_scheduleMutex);
+
+	scheduleReadyChunks(ready);
+
 	if (memoryBuffers) {
 		for (unsigned int index = 0; index < this->m_cachedMaxReadBufferOffset; index++) {
 			MemoryBuffer *buffer = memoryBuffers[index];
@@ -479,6 +590,32 @@ void ExecutionGroup::finalizeChunkExecution(int chunkNumber, MemoryBuffer **memo
 	}
 }
 
+void ExecutionGroup::cancelChunkExecution(int chunkNumber)
+{
+	vector<ChunkReference> ready;
+
+	BLI_mutex_lock(&g_scheduleMutex);
+	if (this->m_chunkExecutionStates[chunkNumber] == COM_ES_SCHEDULED)
+		this->m_chunkExecutionStates[chunkNumber] = COM_ES_NOT_SCHEDULED;
+
+	releaseChunkDependents(chunkNumber, &ready);
+	BLI_mutex_unlock(&g_scheduleMutex);
+
+	scheduleReadyChunks(ready);
+}
+
+void ExecutionGroup::addExecutionTime(double time)
+{
+	BLI_mutex_lock(&g_scheduleMutex);
+	this->m_executionTime += time;
+	BLI_mutex_unlock(&g_scheduleMutex);
+}
+
+bool ExecutionGroup::isBreaked()
+{
+	return this->getOutputNodeOperation()->isBreaked();
+}
+
 inline void ExecutionGroup::determineChunkRect(rcti *rect, const unsigned int xChunk, const unsigned int yChunk) const
 {
 	const int border_width = BLI_rcti_size_x(&this->m_viewerBorder);
@@ -508,59 +645,55 @@ MemoryBuffer *ExecutionGroup::allocateOutputBuffer(int chunkNumber, rcti *rect)
 	// we asume that this method is only called from complex execution groups.
 	NodeOperation *operation = this->getOutputNodeOperation();
 	if (operation->isWriteBufferOperation()) {
-		WriteBufferOperation *writeOperation = (WriteBufferOperation *)operation;
-		MemoryBuffer *buffer = new MemoryBuffer(writeOperation->getMemoryProxy(), rect);
+		/* OpenCL devices always write 4 channels, copied to the typed buffer of the proxy afterwards */
+		MemoryBuffer *buffer = new MemoryBuffer(COM_DT_COLOR, rect);
 		return buffer;
 	}
 	return NULL;
 }
 
 
-bool ExecutionGroup::scheduleAreaWhenPossible(ExecutionSystem *graph, rcti *area)
+void ExecutionGroup::scheduleAreaWhenPossible(ExecutionSystem *graph, rcti *area, const ChunkReference &dependent, vector<ChunkReference> *ready)
 {
-	if (this->m_singleThreaded) {
-		return scheduleChunkWhenPossible(graph, 0, 0);
-	}
 	// find all chunks inside the rect
 	// determine minxchunk, minychunk, maxxchunk, maxychunk where x and y are chunknumbers
 
 	int indexx, indexy;
-	int minx = max_ii(area->xmin - m_viewerBorder.xmin, 0);
-	int maxx = min_ii(area->xmax - m_viewerBorder.xmin, m_viewerBorder.xmax - m_viewerBorder.xmin);
-	int miny = max_ii(area->ymin - m_viewerBorder.ymin, 0);
-	int maxy = min_ii(area->ymax - m_viewerBorder.ymin, m_viewerBorder.ymax - m_viewerBorder.ymin);
-	int minxchunk = minx / (int)m_chunkSize;
-	int maxxchunk = (maxx + (int)m_chunkSize - 1) / (int)m_chunkSize;
-	int minychunk = miny / (int)m_chunkSize;
-	int maxychunk = (maxy + (int)m_chunkSize - 1) / (int)m_chunkSize;
-	minxchunk = max_ii(minxchunk, 0);
-	minychunk = max_ii(minychunk, 0);
-	maxxchunk = min_ii(maxxchunk, (int)m_numberOfXChunks);
-	maxychunk = min_ii(maxychunk, (int)m_numberOfYChunks);
-
-	bool result = true;
+	int minxchunk, minychunk, maxxchunk, maxychunk;
+	if (this->m_singleThreaded) {
+		minxchunk = 0;
+		minychunk = 0;
+		maxxchunk = 1;
+		maxychunk = 1;
+	}
+	else {
+		int minx = max_ii(area->xmin - m_viewerBorder.xmin, 0);
+		int maxx = min_ii(area->xmax - m_viewerBorder.xmin, m_viewerBorder.xmax - m_viewerBorder.xmin);
+		int miny = max_ii(area->ymin - m_viewerBorder.ymin, 0);
+		int maxy = min_ii(area->ymax - m_viewerBorder.ymin, m_viewerBorder.ymax - m_viewerBorder.ymin);
+		minxchunk = minx / (int)m_chunkSize;
+		maxxchunk = (maxx + (int)m_chunkSize - 1) / (int)m_chunkSize;
+		minychunk = miny / (int)m_chunkSize;
+		maxychunk = (maxy + (int)m_chunkSize - 1) / (int)m_chunkSize;
+		minxchunk = max_ii(minxchunk, 0);
+		minychunk = max_ii(minychunk, 0);
+		maxxchunk = min_ii(maxxchunk, (int)m_numberOfXChunks);
+		maxychunk = min_ii(maxychunk, (int)m_numberOfYChunks);
+	}
+
 	for (indexx = minxchunk; indexx < maxxchunk; indexx++) {
 		for (indexy = minychunk; indexy < maxychunk; indexy++) {
-			if (!scheduleChunkWhenPossible(graph, indexx, indexy)) {
-				result = false;
+			if (!scheduleChunkWhenPossible(graph, indexx, indexy, ready)) {
+				/* the dependent chunk waits until this chunk is executed */
+				const unsigned int chunkNumber = indexy * this->m_numberOfXChunks + indexx;
+				this->m_chunkDependents[chunkNumber].push_back(dependent);
+				dependent.group->m_chunkDependencies[dependent.chunkNumber]++;
 			}
 		}
 	}
-
-	return result;
 }
 
-bool ExecutionGroup::scheduleChunk(unsigned int chunkNumber)
-{
-	if (this->m_chunkExecutionStates[chunkNumber] == COM_ES_NOT_SCHEDULED) {
-		this->m_chunkExecutionStates[chunkNumber] = COM_ES_SCHEDULED;
-		WorkScheduler::schedule(this, chunkNumber);
-		return true;
-	}
-	return false;
-}
-
-bool ExecutionGroup::scheduleChunkWhenPossible(ExecutionSystem *graph, int xChunk, int yChunk)
+bool ExecutionGroup::scheduleChunkWhenPossible(ExecutionSystem *graph, int xChunk, int yChunk, vector<ChunkReference> *ready)
 {
 	if (xChunk < 0 || xChunk >= (int)this->m_numberOfXChunks) {
 		return true;
@@ -580,14 +713,19 @@ bool ExecutionGroup::scheduleChunkWhenPossible(ExecutionSystem *graph, int xChun
 	}
 
 	// chunk is nor executed nor scheduled.
+	this->m_chunkExecutionStates[chunkNumber] = COM_ES_SCHEDULED;
+	this->m_chunkDependencies[chunkNumber] = 0;
+
 	vector<MemoryProxy *> memoryProxies;
 	this->determineDependingMemoryProxies(&memoryProxies);
 
 	rcti rect;
 	determineChunkRect(&rect, xChunk, yChunk);
 	unsigned int index;
-	bool canBeExecuted = true;
 	rcti area;
+	ChunkReference reference;
+	reference.group = this;
+	reference.chunkNumber = chunkNumber;
 
 	for (index = 0; index < this->m_cachedReadOperations.size(); index++) {
 		ReadBufferOperation *readOperation = (ReadBufferOperation *)this->m_cachedReadOperations[index];
@@ -597,22 +735,48 @@ bool ExecutionGroup::scheduleChunkWhenPossible(ExecutionSystem *graph, int xChun
 		ExecutionGroup *group = memoryProxy->getExecutor();
 
 		if (group != NULL) {
-			if (!group->scheduleAreaWhenPossible(graph, &area)) {
-				canBeExecuted = false;
-			}
+			group->scheduleAreaWhenPossible(graph, &area, reference, ready);
 		}
 		else {
 			throw "ERROR";
 		}
 	}
 
-	if (canBeExecuted) {
-		scheduleChunk(chunkNumber);
+	if (this->m_chunkDependencies[chunkNumber] == 0) {
+		ready->push_back(reference);
 	}
 
 	return false;
 }
 
+void ExecutionGroup::releaseChunkDependents(unsigned int chunkNumber, vector<ChunkReference> *ready)
+{
+	vector<ChunkReference> &dependents = this->m_chunkDependents[chunkNumber];
+	unsigned int index;
+
+	for (index = 0; index < dependents.size(); index++) {
+		const ChunkReference &dependent = dependents[index];
+		if (--dependent.group->m_chunkDependencies[dependent.chunkNumber] == 0) {
+			ready->push_back(dependent);
+		}
+	}
+	dependents.clear();
+}
+
+void ExecutionGroup::scheduleReadyChunks(const vector<ChunkReference> &ready)
+{
+	unsigned int index;
+	for (index = 0; index < ready.size(); index++) {
+		ExecutionGroup *group = ready[index].group;
+		const bNodeTree *bTree = group->m_bTree;
+
+		WorkScheduler::schedule(group, ready[index].chunkNumber);
+
+		if (bTree && bTree->update_draw)
+			bTree->update_draw(bTree->udh);
+	}
+}
+
 void ExecutionGroup::determineDependingAreaOfInterest(rcti *input, ReadBufferOperation *readOperation, rcti *output)
 {
 	this->getOutputNodeOperation()->determineDependingAreaOfInterest(input, readOperation, output);
@@ -51,6 +51,41 @@ typedef enum ChunkExecutionState {
 	COM_ES_EXECUTED = 2
 } ChunkExecutionState;
 
+/**
+ * @brief a fused rect kernel of an ExecutionGroup
+ * @see ExecutionGroup.executeRectKernels
+ * @ingroup Execution
+ */
+typedef struct RectKernel {
+	/**
+	 * @brief operation calculating the row of this rect kernel
+	 * @note ReadBufferOperation's copy their row directly from the MemoryBuffer
+	 */
+	NodeOperation *operation;
+
+	/**
+	 * @brief number of input sockets of the operation
+	 */
+	int numberOfInputs;
+
+	/**
+	 * @brief index of the rect kernel calculating the row of each input socket
+	 */
+	int inputs[COM_RECT_KERNEL_MAX_INPUTS];
+} RectKernel;
+
+class ExecutionGroup;
+
+/**
+ * @brief reference to a chunk of an ExecutionGroup
+ * @see ExecutionGroup.scheduleChunkWhenPossible
+ * @ingroup Execution
+ */
+typedef struct ChunkReference {
+	ExecutionGroup *group;
+	unsigned int chunkNumber;
+} ChunkReference;
+
 class MemoryProxy;
 class ReadBufferOperation;
 class Device;
@@ -132,6 +167,15 @@ private:
 	 */
 	vector<NodeOperation *> m_cachedReadOperations;
 	
+	/**
+	 * @brief fused rect kernels calculating the output of this ExecutionGroup
+	 * Kernels are sorted so that the inputs of a kernel are calculated before the kernel itself,
+	 * the last kernel is the input of the output operation.
+	 * @note empty when not all operations of this group implement a rect kernel
+	 * @see NodeOperation.isRectKernel
+	 */
+	vector<RectKernel> m_rectKernels;
+
 	/**
 	 * @brief reference to the original bNodeTree, this field is only set for the 'top' execution group.
 	 * @note can only be used to call the callbacks for progress, status and break
@@ -150,6 +194,17 @@ private:
 	 *   - COM_ES_EXECUTED: executed
 	 */
 	ChunkExecutionState *m_chunkExecutionStates;
+
+	/**
+	 * @brief per scheduled chunk the number of input chunks that still need to be executed
+	 * @note the chunk is added to the WorkScheduler when this number reaches zero
+	 */
+	unsigned int *m_chunkDependencies;
+
+	/**
+	 * @brief per chunk the scheduled chunks of other ExecutionGroup's waiting for it
+	 */
+	vector<ChunkReference> *m_chunkDependents;
 	
 	/**
 	 * @brief indicator when this ExecutionGroup has valid NodeOperations in its vector for Execution
@@ -173,6 +228,12 @@ private:
 	 */
 	double m_executionStartTime;
 
+	/**
+	 * @brief total time spent calculating the chunks of this ExecutionGroup during the current execution
+	 * @note summed over all devices, so it can exceed the elapsed time
+	 */
+	double m_executionTime;
+
 	// methods
 	/**
 	 * @brief check whether parameter operation can be added to the execution group
@@ -204,33 +265,44 @@ private:
 	
 	/**
 	 * @brief try to schedule a specific chunk.
-	 * @note scheduling succeeds when all input requirements are met and the chunks hasn't been scheduled yet.
+	 * @note the chunk and the input chunks it depends on are scheduled when they haven't been scheduled yet.
+	 * @note the chunk is added to the ready list when all its input chunks are executed, otherwise it
+	 * @note is added by finalizeChunkExecution of the last input chunk.
+	 * @note must be called with the scheduling lock held
 	 * @param graph
 	 * @param xChunk
 	 * @param yChunk
+	 * @param ready chunks that can be added to the WorkScheduler
 	 * @return [true:false]
-	 * true: package(s) are scheduled
-	 * false: scheduling is deferred (depending workpackages are scheduled)
+	 * true: the chunk is executed
+	 * false: the chunk is scheduled, but not executed yet
 	 */
-	bool scheduleChunkWhenPossible(ExecutionSystem *graph, int xChunk, int yChunk);
+	bool scheduleChunkWhenPossible(ExecutionSystem *graph, int xChunk, int yChunk, vector<ChunkReference> *ready);
 
 	/**
 	 * @brief try to schedule a specific area.
-	 * @note Check if a certain area is available, when not available this are will be checked.
+	 * @note Schedules the chunks of the area that aren't executed, and makes the dependent chunk wait for them.
 	 * @note This method is called from other ExecutionGroup's.
 	 * @param graph
 	 * @param rect
-	 * @return [true:false]
-	 * true: package(s) are scheduled
-	 * false: scheduling is deferred (depending workpackages are scheduled)
+	 * @param dependent the chunk of the calling ExecutionGroup that needs the area
+	 * @param ready chunks that can be added to the WorkScheduler
 	 */
-	bool scheduleAreaWhenPossible(ExecutionSystem *graph, rcti *rect);
+	void scheduleAreaWhenPossible(ExecutionSystem *graph, rcti *rect, const ChunkReference &dependent, vector<ChunkReference> *ready);
 
 	/**
-	 * @brief add a chunk to the WorkScheduler.
-	 * @param chunknumber
+	 * @brief release the chunks waiting for a chunk that is done
+	 * @note must be called with the scheduling lock held
+	 * @param chunkNumber
+	 * @param ready chunks that can be added to the WorkScheduler
+	 */
+	void releaseChunkDependents(unsigned int chunkNumber, vector<ChunkReference> *ready);
+
+	/**
+	 * @brief add chunks to the WorkScheduler.
+	 * @param ready
 	 */
-	bool scheduleChunk(unsigned int chunkNumber);
+	static void scheduleReadyChunks(const vector<ChunkReference> &ready);
 	
 	/**
 	 * @brief determine the area of interest of a certain input area
@@ -241,6 +313,19 @@ private:
 	 */
 	void determineDependingAreaOfInterest(rcti *input, ReadBufferOperation *readOperation, rcti *output);
 
+	/**
+	 * @brief fuse the operations of this group into rect kernels when possible
+	 * @note result is stored in the m_rectKernels field
+	 */
+	void determineRectKernels();
+
+	/**
+	 * @brief add the rect kernel of an operation and its inputs
+	 * @param operation the operation to add
+	 * @return index of the rect kernel, -1 when the operation can not be fused
+	 */
+	int addRectKernel(NodeOperation *operation);
+
 
 public:
 	// constructors
@@ -323,6 +408,28 @@ public:
 	 */
 	void initExecution();
 	
+	/**
+	 * @brief can the output of this ExecutionGroup be calculated by executeRectKernels
+	 */
+	bool hasRectKernels() const { return !this->m_rectKernels.empty(); }
+
+	/**
+	 * @brief allocate the intermediate rows needed by executeRectKernels
+	 * @param width number of pixels in a row
+	 * @note must be freed with MEM_freeN by the caller
+	 */
+	float *allocateRectKernelRows(int width);
+
+	/**
+	 * @brief calculate a row of the output of this ExecutionGroup with the fused rect kernels
+	 * @param output the row to write to
+	 * @param rows intermediate rows, allocated with allocateRectKernelRows
+	 * @param x the first pixel of the row
+	 * @param y the row
+	 * @param width number of pixels in the row
+	 */
+	void executeRectKernels(float *output, float *rows, int x, int y, int width);
+
 	/**
 	 * @brief get all inputbuffers needed to calculate an chunk
 	 * @note all inputbuffers must be executed
@@ -354,10 +461,29 @@ public:
 	
 	/**
 	 * @brief after a chunk is executed the needed resources can be freed or unlocked.
+	 * @note chunks waiting for this chunk are added to the WorkScheduler
 	 * @param chunknumber
 	 * @param memorybuffers
 	 */
 	void finalizeChunkExecution(int chunkNumber, MemoryBuffer **memoryBuffers);
+
+	/**
+	 * @brief a scheduled chunk is not executed because the execution has breaked (by user)
+	 * @note chunks waiting for this chunk are added to the WorkScheduler, so they are cancelled as well
+	 * @param chunknumber
+	 */
+	void cancelChunkExecution(int chunkNumber);
+
+	/**
+	 * @brief add the time a device spent calculating a chunk of this ExecutionGroup
+	 * @see printBackgroundStats
+	 */
+	void addExecutionTime(double time);
+
+	/**
+	 * @brief has the execution been breaked (by user)
+	 */
+	bool isBreaked();
 	
 	/**
 	 * @brief deinitExecution is called just after execution the whole graph.
@@ -375,7 +501,9 @@ public:
 	 *   - CenterX
 	 *   - CenterY
 	 *
-	 * After determining the order of the chunks the chunks will be scheduled
+	 * After determining the order of the chunks the chunks will be scheduled. A chunk is added to the
+	 * WorkScheduler as soon as the chunks of other ExecutionGroup's it depends on are executed, so chunks
+	 * of different ExecutionGroup's are calculated at the same time.
 	 *
 	 * @see ViewerOperation
 	 * @param system
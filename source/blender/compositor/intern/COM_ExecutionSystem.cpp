@@ -39,6 +39,7 @@ extern "C" {
 #include "COM_ReadBufferOperation.h"
 #include "COM_ExecutionSystemHelper.h"
 #include "COM_Debug.h"
+#include "COM_BufferCache.h"
 
 #include "BKE_global.h"
 
@@ -146,6 +147,8 @@ void ExecutionSystem::execute()
 	}
 	unsigned int index;
 
+	BufferCache::determineKeys(this);
+
 	for (index = 0; index < this->m_operations.size(); index++) {
 		NodeOperation *operation = this->m_operations[index];
 		operation->setbNodeTree(this->m_context.getbNodeTree());
@@ -183,6 +186,8 @@ void ExecutionSystem::execute()
 		ExecutionGroup *executionGroup = this->m_groups[index];
 		executionGroup->deinitExecution();
 	}
+
+	BufferCache::freeUnused(this);
 }
 
 void ExecutionSystem::executeGroups(CompositorPriority priority)
@@ -224,6 +229,7 @@ void ExecutionSystem::addReadWriteBufferOperations(NodeOperation *operation)
 					writeoperation->setbNodeTree(this->getContext().getbNodeTree());
 					this->addOperation(writeoperation);
 					ExecutionSystemHelper::addLink(this->getConnections(), fromsocket, writeoperation->getInputSocket(0));
+					writeoperation->getMemoryProxy()->setDataType(fromsocket->getDataType());
 					writeoperation->readResolutionFromInputSocket();
 				}
 				ReadBufferOperation *readoperation = new ReadBufferOperation();
@@ -247,6 +253,7 @@ void ExecutionSystem::addReadWriteBufferOperations(NodeOperation *operation)
 		writeOperation->setbNodeTree(this->getContext().getbNodeTree());
 		this->addOperation(writeOperation);
 		ExecutionSystemHelper::addLink(this->getConnections(), outputsocket, writeOperation->getInputSocket(0));
+		writeOperation->getMemoryProxy()->setDataType(outputsocket->getDataType());
 		writeOperation->readResolutionFromInputSocket();
 		for (index = 0; index < outputsocket->getNumberOfConnections() - 1; index++) {
 			SocketConnection *connection = outputsocket->getConnection(index);
@@ -289,9 +296,19 @@ void ExecutionSystem::convertToOperations()
 
 	for (index = 0; index < this->m_nodes.size(); index++) {
 		Node *node = (Node *)this->m_nodes[index];
+		unsigned int firstOperation = this->m_operations.size();
+		unsigned int operationIndex;
 		DebugInfo::node_to_operations(node);
 		node->convertToOperations(this, &this->m_context);
 
+		/* remember the bNode settings the operations are created from, used for the BufferCache keys */
+		for (operationIndex = firstOperation; operationIndex < this->m_operations.size(); operationIndex++) {
+			NodeOperation *operation = this->m_operations[operationIndex];
+			if (operation->getbNode() == NULL) {
+				operation->setbNode(node->getbNode());
+			}
+		}
+
 		debug_check_node_connections(node);
 	}
 
@@ -43,9 +43,10 @@ MemoryBuffer::MemoryBuffer(MemoryProxy *memoryProxy, unsigned int chunkNumber, r
 	BLI_rcti_init(&this->m_rect, rect->xmin, rect->xmax, rect->ymin, rect->ymax);
 	this->m_memoryProxy = memoryProxy;
 	this->m_chunkNumber = chunkNumber;
-	this->m_buffer = (float *)MEM_mallocN(sizeof(float) * determineBufferSize() * COM_NUMBER_OF_CHANNELS, "COM_MemoryBuffer");
+	this->m_datatype = memoryProxy ? memoryProxy->getDataType() : COM_DT_COLOR;
+	this->m_num_channels = determineNumberOfChannels(this->m_datatype);
+	this->m_buffer = (float *)MEM_mallocN(sizeof(float) * determineBufferSize() * this->m_num_channels, "COM_MemoryBuffer");
 	this->m_state = COM_MB_ALLOCATED;
-	this->m_datatype = COM_DT_COLOR;
 	this->m_chunkWidth = this->m_rect.xmax - this->m_rect.xmin;
 }
 
@@ -54,20 +55,35 @@ MemoryBuffer::MemoryBuffer(MemoryProxy *memoryProxy, rcti *rect)
 	BLI_rcti_init(&this->m_rect, rect->xmin, rect->xmax, rect->ymin, rect->ymax);
 	this->m_memoryProxy = memoryProxy;
 	this->m_chunkNumber = -1;
-	this->m_buffer = (float *)MEM_mallocN(sizeof(float) * determineBufferSize() * COM_NUMBER_OF_CHANNELS, "COM_MemoryBuffer");
+	this->m_datatype = memoryProxy ? memoryProxy->getDataType() : COM_DT_COLOR;
+	this->m_num_channels = determineNumberOfChannels(this->m_datatype);
+	this->m_buffer = (float *)MEM_mallocN(sizeof(float) * determineBufferSize() * this->m_num_channels, "COM_MemoryBuffer");
 	this->m_state = COM_MB_TEMPORARILY;
-	this->m_datatype = COM_DT_COLOR;
 	this->m_chunkWidth = this->m_rect.xmax - this->m_rect.xmin;
 }
+
+MemoryBuffer::MemoryBuffer(DataType datatype, rcti *rect)
+{
+	BLI_rcti_init(&this->m_rect, rect->xmin, rect->xmax, rect->ymin, rect->ymax);
+	this->m_memoryProxy = NULL;
+	this->m_chunkNumber = -1;
+	this->m_datatype = datatype;
+	this->m_num_channels = determineNumberOfChannels(this->m_datatype);
+	this->m_buffer = (float *)MEM_mallocN(sizeof(float) * determineBufferSize() * this->m_num_channels, "COM_MemoryBuffer");
+	this->m_state = COM_MB_TEMPORARILY;
+	this->m_chunkWidth = this->m_rect.xmax - this->m_rect.xmin;
+}
+
 MemoryBuffer *MemoryBuffer::duplicate()
 {
-	MemoryBuffer *result = new MemoryBuffer(this->m_memoryProxy, &this->m_rect);
-	memcpy(result->m_buffer, this->m_buffer, this->determineBufferSize() * COM_NUMBER_OF_CHANNELS * sizeof(float));
+	MemoryBuffer *result = new MemoryBuffer(this->m_datatype, &this->m_rect);
+	result->m_memoryProxy = this->m_memoryProxy;
+	memcpy(result->m_buffer, this->m_buffer, this->determineBufferSize() * this->m_num_channels * sizeof(float));
 	return result;
 }
 void MemoryBuffer::clear()
 {
-	memset(this->m_buffer, 0, this->determineBufferSize() * COM_NUMBER_OF_CHANNELS * sizeof(float));
+	memset(this->m_buffer, 0, this->determineBufferSize() * this->m_num_channels * sizeof(float));
 }
 
 float *MemoryBuffer::convertToValueBuffer()
@@ -80,7 +96,7 @@ float *MemoryBuffer::convertToValueBuffer()
 	const float *fp_src = this->m_buffer;
 	float       *fp_dst = result;
 
-	for (i = 0; i < size; i++, fp_dst++, fp_src += COM_NUMBER_OF_CHANNELS) {
+	for (i = 0; i < size; i++, fp_dst++, fp_src += this->m_num_channels) {
 		*fp_dst = *fp_src;
 	}
 
@@ -95,7 +111,7 @@ float MemoryBuffer::getMaximumValue()
 
 	const float *fp_src = this->m_buffer;
 
-	for (i = 0; i < size; i++, fp_src += COM_NUMBER_OF_CHANNELS) {
+	for (i = 0; i < size; i++, fp_src += this->m_num_channels) {
 		float value = *fp_src;
 		if (value > result) {
 			result = value;
@@ -113,7 +129,7 @@ float MemoryBuffer::getMaximumValue(rcti *rect)
 	BLI_rcti_isect(rect, &this->m_rect, &rect_clamp);
 
 	if (!BLI_rcti_is_empty(&rect_clamp)) {
-		MemoryBuffer *temp = new MemoryBuffer(NULL, &rect_clamp);
+		MemoryBuffer *temp = new MemoryBuffer(this->m_datatype, &rect_clamp);
 		temp->copyContentFrom(this);
 		float result = temp->getMaximumValue();
 		delete temp;
@@ -144,14 +160,29 @@ void MemoryBuffer::copyContentFrom(MemoryBuffer *otherBuffer)
 	unsigned int maxX = min(this->m_rect.xmax, otherBuffer->m_rect.xmax);
 	unsigned int minY = max(this->m_rect.ymin, otherBuffer->m_rect.ymin);
 	unsigned int maxY = min(this->m_rect.ymax, otherBuffer->m_rect.ymax);
+	const unsigned int numChannels = this->m_num_channels;
+	const unsigned int otherNumChannels = otherBuffer->m_num_channels;
 	int offset;
 	int otherOffset;
 
 
 	for (otherY = minY; otherY < maxY; otherY++) {
-		otherOffset = ((otherY - otherBuffer->m_rect.ymin) * otherBuffer->m_chunkWidth + minX - otherBuffer->m_rect.xmin) * COM_NUMBER_OF_CHANNELS;
-		offset = ((otherY - this->m_rect.ymin) * this->m_chunkWidth + minX - this->m_rect.xmin) * COM_NUMBER_OF_CHANNELS;
-		memcpy(&this->m_buffer[offset], &otherBuffer->m_buffer[otherOffset], (maxX - minX) * COM_NUMBER_OF_CHANNELS * sizeof(float));
+		otherOffset = ((otherY - otherBuffer->m_rect.ymin) * otherBuffer->m_chunkWidth + minX - otherBuffer->m_rect.xmin) * otherNumChannels;
+		offset = ((otherY - this->m_rect.ymin) * this->m_chunkWidth + minX - this->m_rect.xmin) * numChannels;
+		if (numChannels == otherNumChannels) {
+			memcpy(&this->m_buffer[offset], &otherBuffer->m_buffer[otherOffset], (maxX - minX) * numChannels * sizeof(float));
+		}
+		else {
+			/* buffers of different datatypes, copy the channels they have in common */
+			unsigned int x;
+			float color[4];
+			for (x = minX; x < maxX; x++) {
+				otherBuffer->readPixel(color, &otherBuffer->m_buffer[otherOffset]);
+				memcpy(&this->m_buffer[offset], color, numChannels * sizeof(float));
+				offset += numChannels;
+				otherOffset += otherNumChannels;
+			}
+		}
 	}
 }
 
@@ -160,8 +191,8 @@ void MemoryBuffer::writePixel(int x, int y, const float color[4])
 	if (x >= this->m_rect.xmin && x < this->m_rect.xmax &&
 	    y >= this->m_rect.ymin && y < this->m_rect.ymax)
 	{
-		const int offset = (this->m_chunkWidth * (y - this->m_rect.ymin) + x - this->m_rect.xmin) * COM_NUMBER_OF_CHANNELS;
-		copy_v4_v4(&this->m_buffer[offset], color);
+		const int offset = (this->m_chunkWidth * (y - this->m_rect.ymin) + x - this->m_rect.xmin) * this->m_num_channels;
+		memcpy(&this->m_buffer[offset], color, sizeof(float) * this->m_num_channels);
 	}
 }
 
@@ -170,8 +201,11 @@ void MemoryBuffer::addPixel(int x, int y, const float color[4])
 	if (x >= this->m_rect.xmin && x < this->m_rect.xmax &&
 	    y >= this->m_rect.ymin && y < this->m_rect.ymax)
 	{
-		const int offset = (this->m_chunkWidth * (y - this->m_rect.ymin) + x - this->m_rect.xmin) * COM_NUMBER_OF_CHANNELS;
-		add_v4_v4(&this->m_buffer[offset], color);
+		const int offset = (this->m_chunkWidth * (y - this->m_rect.ymin) + x - this->m_rect.xmin) * this->m_num_channels;
+		unsigned int channel;
+		for (channel = 0; channel < this->m_num_channels; channel++) {
+			this->m_buffer[offset + channel] += color[channel];
+		}
 	}
 }
 
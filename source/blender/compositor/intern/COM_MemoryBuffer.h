@@ -68,6 +68,11 @@ private:
 	 * @brief the type of buffer COM_DT_VALUE, COM_DT_VECTOR, COM_DT_COLOR
 	 */
 	DataType m_datatype;
+
+	/**
+	 * @brief number of floats per pixel, determined by the datatype
+	 */
+	unsigned int m_num_channels;
 	
 	
 	/**
@@ -106,6 +111,11 @@ public:
 	 * @brief construct new temporarily MemoryBuffer for an area
 	 */
 	MemoryBuffer(MemoryProxy *memoryProxy, rcti *rect);
+
+	/**
+	 * @brief construct new temporarily MemoryBuffer of a datatype for an area
+	 */
+	MemoryBuffer(DataType datatype, rcti *rect);
 	
 	/**
 	 * @brief destructor
@@ -122,6 +132,47 @@ public:
 	 * @note buffer should already be available in memory
 	 */
 	float *getBuffer() { return this->m_buffer; }
+
+	/**
+	 * @brief number of floats per pixel: 1 for values, 3 for vectors, 4 for colors
+	 * @note operations accessing the buffer directly use this as the stride between pixels
+	 */
+	unsigned int getNumberOfChannels() const { return this->m_num_channels; }
+
+	/**
+	 * @brief number of floats per pixel for a datatype
+	 */
+	static unsigned int determineNumberOfChannels(DataType datatype)
+	{
+		switch (datatype) {
+			case COM_DT_VALUE:
+				return 1;
+			case COM_DT_VECTOR:
+				return 3;
+			default:
+				return COM_NUMBER_OF_CHANNELS;
+		}
+	}
+
+	/**
+	 * @brief expand a pixel of this buffer to 4 channels, unused channels are zero
+	 */
+	inline void readPixel(float result[4], const float *pixel) const
+	{
+		switch (this->m_num_channels) {
+			case 1:
+				result[0] = pixel[0];
+				result[1] = result[2] = result[3] = 0.0f;
+				break;
+			case 3:
+				copy_v3_v3(result, pixel);
+				result[3] = 0.0f;
+				break;
+			default:
+				copy_v4_v4(result, pixel);
+				break;
+		}
+	}
 	
 	/**
 	 * @brief after execution the state will be set to available by calling this method
@@ -175,8 +226,8 @@ public:
 		}
 		else {
 			wrap_pixel(x, y, extend_x, extend_y);
-			const int offset = (this->m_chunkWidth * y + x) * COM_NUMBER_OF_CHANNELS;
-			copy_v4_v4(result, &this->m_buffer[offset]);
+			const int offset = (this->m_chunkWidth * y + x) * this->m_num_channels;
+			readPixel(result, &this->m_buffer[offset]);
 		}
 	}
 
@@ -185,22 +236,60 @@ public:
 	                        MemoryBufferExtend extend_y = COM_MB_CLIP)
 	{
 		wrap_pixel(x, y, extend_x, extend_y);
-		const int offset = (this->m_chunkWidth * y + x) * COM_NUMBER_OF_CHANNELS;
+		const int offset = (this->m_chunkWidth * y + x) * this->m_num_channels;
 
 		BLI_assert(offset >= 0);
-		BLI_assert(offset < this->determineBufferSize() * COM_NUMBER_OF_CHANNELS);
+		BLI_assert(offset < this->determineBufferSize() * this->m_num_channels);
 		BLI_assert(!(extend_x == COM_MB_CLIP && (x < m_rect.xmin || x >= m_rect.xmax)) &&
 		           !(extend_y == COM_MB_CLIP && (y < m_rect.ymin || y >= m_rect.ymax)));
 
 #if 0
 		/* always true */
 		BLI_assert((int)(MEM_allocN_len(this->m_buffer) / sizeof(*this->m_buffer)) ==
-		           (int)(this->determineBufferSize() * COM_NUMBER_OF_CHANNELS));
+		           (int)(this->determineBufferSize() * this->m_num_channels));
 #endif
 
-		copy_v4_v4(result, &this->m_buffer[offset]);
+		readPixel(result, &this->m_buffer[offset]);
 	}
-	
+
+	/**
+	 * @brief read a row of pixels, pixels outside the rect are zero like in read
+	 * @param result row of width pixels
+	 */
+	inline void readRow(float *result, int x, int y, int width)
+	{
+		if (y < m_rect.ymin || y >= m_rect.ymax) {
+			memset(result, 0, sizeof(float) * COM_NUMBER_OF_CHANNELS * width);
+			return;
+		}
+
+		int xmin = max_ii(x, m_rect.xmin);
+		int xmax = min_ii(x + width, m_rect.xmax);
+
+		if (xmin >= xmax) {
+			memset(result, 0, sizeof(float) * COM_NUMBER_OF_CHANNELS * width);
+			return;
+		}
+		if (xmin > x) {
+			memset(result, 0, sizeof(float) * COM_NUMBER_OF_CHANNELS * (xmin - x));
+		}
+
+		const int offset = (this->m_chunkWidth * (y - this->m_rect.ymin) + (xmin - this->m_rect.xmin)) * this->m_num_channels;
+		if (this->m_num_channels == COM_NUMBER_OF_CHANNELS) {
+			memcpy(&result[(xmin - x) * COM_NUMBER_OF_CHANNELS], &this->m_buffer[offset],
+			       sizeof(float) * COM_NUMBER_OF_CHANNELS * (xmax - xmin));
+		}
+		else {
+			for (int i = 0; i < xmax - xmin; i++) {
+				readPixel(&result[(xmin - x + i) * COM_NUMBER_OF_CHANNELS], &this->m_buffer[offset + i * this->m_num_channels]);
+			}
+		}
+
+		if (xmax < x + width) {
+			memset(&result[(xmax - x) * COM_NUMBER_OF_CHANNELS], 0, sizeof(float) * COM_NUMBER_OF_CHANNELS * (x + width - xmax));
+		}
+	}
+
 	void writePixel(int x, int y, const float color[4]);
 	void addPixel(int x, int y, const float color[4]);
 	inline void readBilinear(float result[4], float x, float y,
@@ -27,6 +27,8 @@ MemoryProxy::MemoryProxy()
 {
 	this->m_writeBufferOperation = NULL;
 	this->m_executor = NULL;
+	this->m_buffer = NULL;
+	this->m_datatype = COM_DT_COLOR;
 }
 
 void MemoryProxy::allocate(unsigned int width, unsigned int height)
@@ -48,9 +48,9 @@ private:
 	ExecutionGroup *m_executor;
 	
 	/**
-	 * @brief datatype of this MemoryProxy
+	 * @brief datatype of this MemoryProxy, determines the number of channels of the buffers
 	 */
-	/* DataType m_datatype; */ /* UNUSED */
+	DataType m_datatype;
 	
 	/**
 	 * @brief channel information of this buffer
@@ -88,6 +88,17 @@ public:
 	 */
 	WriteBufferOperation *getWriteBufferOperation() { return this->m_writeBufferOperation; }
 
+	/**
+	 * @brief set the datatype of the buffers of this MemoryProxy
+	 * @note should be the datatype of the output socket that is written to the buffer
+	 */
+	void setDataType(DataType datatype) { this->m_datatype = datatype; }
+
+	/**
+	 * @brief get the datatype of the buffers of this MemoryProxy
+	 */
+	DataType getDataType() const { return this->m_datatype; }
+
 	/**
 	 * @brief allocate memory of size width x height
 	 */
@@ -103,6 +114,13 @@ public:
 	 */
 	inline MemoryBuffer *getBuffer() { return this->m_buffer; }
 
+	/**
+	 * @brief use an already allocated buffer
+	 * @note the buffer is not freed by the MemoryProxy
+	 * @see BufferCache
+	 */
+	void setBuffer(MemoryBuffer *buffer) { this->m_buffer = buffer; }
+
 #ifdef WITH_CXX_GUARDEDALLOC
 	MEM_CXX_CLASS_ALLOC_FUNCS("COM:MemoryProxy")
 #endif
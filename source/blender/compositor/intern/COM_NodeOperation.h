@@ -140,6 +140,26 @@ public:
 	 */
 	virtual void executeRegion(rcti *rect, unsigned int chunkNumber) {}
 
+	/**
+	 * @brief does this operation implement executeRect
+	 *
+	 * A rect kernel only reads its inputs at the pixel it calculates. When all operations between the
+	 * ReadBufferOperation's and the WriteBufferOperation of an ExecutionGroup are rect kernels, the
+	 * ExecutionGroup fuses them and calculates the chunk row by row, without calling executePixelSampled.
+	 * @see ExecutionGroup.determineRectKernels
+	 */
+	virtual bool isRectKernel() const { return false; }
+
+	/**
+	 * @brief calculate a row of pixels
+	 * @ingroup execution
+	 * @note all rows store COM_NUMBER_OF_CHANNELS floats per pixel, value sockets only use the first channel
+	 * @param output the row to write to
+	 * @param inputs a row for every input socket
+	 * @param numberOfPixels number of pixels in the rows
+	 */
+	virtual void executeRect(float *output, float **inputs, int numberOfPixels) {}
+
 	/**
 	 * @brief when a chunk is executed by an OpenCLDevice, this method is called
 	 * @ingroup execution
@@ -202,6 +222,15 @@ public:
 
 	virtual bool isSetOperation() const { return false; }
 
+	/**
+	 * @brief does the output of this operation depend on the view being composited
+	 *
+	 * Operations that don't depend on a view dependent operation are calculated once for all views of a
+	 * multiview render.
+	 * @see BufferCache
+	 */
+	virtual bool isViewDependent() const { return false; }
+
 	/**
 	 * @brief is this operation of type ReadBufferOperation
 	 * @return [true:false]
@@ -79,14 +79,39 @@ cl_mem OpenCLDevice::COM_clAttachMemoryBufferToKernelParameter(cl_kernel kernel,
 	cl_int error;
 	
 	MemoryBuffer *result = reader->getInputMemoryBuffer(inputMemoryBuffers);
+	cl_mem clBuffer;
 
-	const cl_image_format imageFormat = {
-		CL_RGBA,
-		CL_FLOAT
-	};
+	if (result->getNumberOfChannels() == 1) {
+		const cl_image_format imageFormat = {
+			CL_R,
+			CL_FLOAT
+		};
 
-	cl_mem clBuffer = clCreateImage2D(this->m_context, CL_MEM_READ_ONLY | CL_MEM_USE_HOST_PTR, &imageFormat, result->getWidth(),
-	                                  result->getHeight(), 0, result->getBuffer(), &error);
+		clBuffer = clCreateImage2D(this->m_context, CL_MEM_READ_ONLY | CL_MEM_USE_HOST_PTR, &imageFormat, result->getWidth(),
+		                           result->getHeight(), 0, result->getBuffer(), &error);
+	}
+	else if (result->getNumberOfChannels() == 3) {
+		/* there are no 3 channel float images, upload a 4 channel copy */
+		const cl_image_format imageFormat = {
+			CL_RGBA,
+			CL_FLOAT
+		};
+		MemoryBuffer *expanded = new MemoryBuffer(COM_DT_COLOR, result->getRect());
+		expanded->copyContentFrom(result);
+
+		clBuffer = clCreateImage2D(this->m_context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, &imageFormat, result->getWidth(),
+		                           result->getHeight(), 0, expanded->getBuffer(), &error);
+		delete expanded;
+	}
+	else {
+		const cl_image_format imageFormat = {
+			CL_RGBA,
+			CL_FLOAT
+		};
+
+		clBuffer = clCreateImage2D(this->m_context, CL_MEM_READ_ONLY | CL_MEM_USE_HOST_PTR, &imageFormat, result->getWidth(),
+		                           result->getHeight(), 0, result->getBuffer(), &error);
+	}
 
 	if (error != CL_SUCCESS) { printf("CLERROR[%d]: %s\n", error, clewErrorString(error));  }
 	if (error == CL_SUCCESS) cleanup->push_back(clBuffer);
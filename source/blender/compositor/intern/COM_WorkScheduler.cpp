@@ -21,6 +21,7 @@
  */
 
 #include <list>
+#include <deque>
 #include <stdio.h>
 
 #include "COM_compositor.h"
@@ -35,6 +36,7 @@
 
 #include "PIL_time.h"
 #include "BLI_threads.h"
+#include "BLI_task.h"
 
 #include "BKE_global.h"
 
@@ -53,11 +55,40 @@
 static vector<CPUDevice *> g_cpudevices;
 
 #if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+/**
+ * @brief work of a single CPU thread
+ *
+ * The thread takes work from the front of its own queue. Chunks that become ready when the thread
+ * finishes a chunk are added to the front, so they are calculated next while their input is still
+ * in the cache. When its queue is empty the thread steals work from the back of the queue of another thread.
+ */
+typedef struct CPUWorkQueue {
+	Device *device;
+	/* thread and threadStarted are protected by g_workMutex */
+	pthread_t thread;
+	bool threadStarted;
+	deque<WorkPackage *> packages;
+	SpinLock lock;
+} CPUWorkQueue;
+
 /// @brief list of all thread for every CPUDevice in cpudevices a thread exists
 static ListBase g_cputhreads;
 static bool g_cpuInitialized = false;
-/// @brief all scheduled work for the cpu
-static ThreadQueue *g_cpuqueue;
+/// @brief all scheduled work for the cpu, a queue for every CPUDevice
+static vector<CPUWorkQueue *> g_cpuqueues;
+/// @brief queue the next package from outside the cpu threads is added to
+static unsigned int g_cpuqueueNext;
+/// @brief lock for the counters below, and the conditions
+static ThreadMutex g_workMutex;
+/// @brief notified when work is added to the cpu queues or the threads are stopped
+static ThreadCondition g_workCondition;
+/// @brief notified when all scheduled work is done
+static ThreadCondition g_finishCondition;
+/// @brief number of packages in the cpu queues
+static unsigned int g_cpuqueued;
+/// @brief number of scheduled packages that are not done yet, for all devices
+static unsigned int g_pending;
+static bool g_cpuStopping;
 static ThreadQueue *g_gpuqueue;
 #ifdef COM_OPENCL_ENABLED
 static cl_context g_context;
@@ -141,15 +172,150 @@ int COM_isHighlightedbNode(bNode *bnode)
 } // end extern "C"
 
 #if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
-void *WorkScheduler::thread_execute_cpu(void *data)
+static WorkPackage *cpu_queue_pop_front(CPUWorkQueue *queue)
 {
-	Device *device = (Device *)data;
+	WorkPackage *work = NULL;
+
+	BLI_spin_lock(&queue->lock);
+	if (!queue->packages.empty()) {
+		work = queue->packages.front();
+		queue->packages.pop_front();
+	}
+	BLI_spin_unlock(&queue->lock);
+
+	return work;
+}
+
+static WorkPackage *cpu_queue_pop_back(CPUWorkQueue *queue)
+{
+	WorkPackage *work = NULL;
+
+	BLI_spin_lock(&queue->lock);
+	if (!queue->packages.empty()) {
+		work = queue->packages.back();
+		queue->packages.pop_back();
+	}
+	BLI_spin_unlock(&queue->lock);
+
+	return work;
+}
+
+/**
+ * @brief get the next package for a cpu thread, waits until work is available
+ * @return the package, or NULL when the threads are stopped
+ */
+static WorkPackage *cpu_queue_pop(unsigned int queueIndex)
+{
+	const unsigned int numberOfQueues = g_cpuqueues.size();
 	WorkPackage *work;
-	
-	while ((work = (WorkPackage *)BLI_thread_queue_pop(g_cpuqueue))) {
+
+	BLI_mutex_lock(&g_workMutex);
+	for (;;) {
+		while (g_cpuqueued == 0 && !g_cpuStopping) {
+			BLI_condition_wait(&g_workCondition, &g_workMutex);
+		}
+		if (g_cpuqueued == 0) {
+			BLI_mutex_unlock(&g_workMutex);
+			return NULL;
+		}
+		g_cpuqueued--;
+		BLI_mutex_unlock(&g_workMutex);
+
+		/* a package is reserved, find it in the own queue first, otherwise steal one */
+		work = cpu_queue_pop_front(g_cpuqueues[queueIndex]);
+		for (unsigned int index = 1; work == NULL && index < numberOfQueues; index++) {
+			work = cpu_queue_pop_back(g_cpuqueues[(queueIndex + index) % numberOfQueues]);
+		}
+		if (work) {
+			return work;
+		}
+
+		/* the reserved package was added to a queue that was already checked, try again */
+		BLI_mutex_lock(&g_workMutex);
+		g_cpuqueued++;
+	}
+}
+
+static void cpu_queue_push(WorkPackage *work)
+{
+	const unsigned int numberOfQueues = g_cpuqueues.size();
+	pthread_t thread = pthread_self();
+	CPUWorkQueue *queue = NULL;
+	unsigned int index;
+
+	BLI_mutex_lock(&g_workMutex);
+	for (index = 0; index < numberOfQueues; index++) {
+		if (g_cpuqueues[index]->threadStarted && pthread_equal(g_cpuqueues[index]->thread, thread)) {
+			queue = g_cpuqueues[index];
+			break;
+		}
+	}
+
+	if (queue) {
+		/* work released by a cpu thread is calculated next by the same thread */
+		BLI_spin_lock(&queue->lock);
+		queue->packages.push_front(work);
+		BLI_spin_unlock(&queue->lock);
+	}
+	else {
+		/* work scheduled by another thread is distributed over the cpu threads, keeping its order */
+		queue = g_cpuqueues[g_cpuqueueNext];
+		g_cpuqueueNext = (g_cpuqueueNext + 1) % numberOfQueues;
+
+		BLI_spin_lock(&queue->lock);
+		queue->packages.push_back(work);
+		BLI_spin_unlock(&queue->lock);
+	}
+
+	g_cpuqueued++;
+	BLI_condition_notify_one(&g_workCondition);
+	BLI_mutex_unlock(&g_workMutex);
+}
+
+/**
+ * @brief execute a package on a device, or cancel it when the execution has been breaked
+ */
+static void execute_work(Device *device, WorkPackage *work)
+{
+	ExecutionGroup *group = work->getExecutionGroup();
+
+	if (group->isBreaked()) {
+		group->cancelChunkExecution(work->getChunkNumber());
+	}
+	else {
+		double start = PIL_check_seconds_timer();
+
 		HIGHLIGHT(work);
 		device->execute(work);
-		delete work;
+
+		group->addExecutionTime(PIL_check_seconds_timer() - start);
+	}
+	delete work;
+
+	BLI_mutex_lock(&g_workMutex);
+	g_pending--;
+	if (g_pending == 0) {
+		BLI_condition_notify_all(&g_finishCondition);
+	}
+	BLI_mutex_unlock(&g_workMutex);
+}
+
+void *WorkScheduler::thread_execute_cpu(void *data)
+{
+	CPUWorkQueue *queue = (CPUWorkQueue *)data;
+	unsigned int queueIndex = 0;
+	WorkPackage *work;
+
+	while (g_cpuqueues[queueIndex] != queue) {
+		queueIndex++;
+	}
+	BLI_mutex_lock(&g_workMutex);
+	queue->thread = pthread_self();
+	queue->threadStarted = true;
+	BLI_mutex_unlock(&g_workMutex);
+
+	while ((work = cpu_queue_pop(queueIndex))) {
+		execute_work(queue->device, work);
 	}
 	
 	return NULL;
@@ -161,9 +327,7 @@ void *WorkScheduler::thread_execute_gpu(void *data)
 	WorkPackage *work;
 	
 	while ((work = (WorkPackage *)BLI_thread_queue_pop(g_gpuqueue))) {
-		HIGHLIGHT(work);
-		device->execute(work);
-		delete work;
+		execute_work(device, work);
 	}
 	
 	return NULL;
@@ -180,15 +344,19 @@ void WorkScheduler::schedule(ExecutionGroup *group, int chunkNumber)
 	device.execute(package);
 	delete package;
 #elif COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+	BLI_mutex_lock(&g_workMutex);
+	g_pending++;
+	BLI_mutex_unlock(&g_workMutex);
+
 #ifdef COM_OPENCL_ENABLED
 	if (group->isOpenCL() && g_openclActive) {
 		BLI_thread_queue_push(g_gpuqueue, package);
 	}
 	else {
-		BLI_thread_queue_push(g_cpuqueue, package);
+		cpu_queue_push(package);
 	}
 #else
-	BLI_thread_queue_push(cpuqueue, package);
+	cpu_queue_push(package);
 #endif
 #endif
 }
@@ -197,11 +365,28 @@ void WorkScheduler::start(CompositorContext &context)
 {
 #if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
 	unsigned int index;
-	g_cpuqueue = BLI_thread_queue_init();
-	BLI_init_threads(&g_cputhreads, thread_execute_cpu, g_cpudevices.size());
+	BLI_mutex_init(&g_workMutex);
+	BLI_condition_init(&g_workCondition);
+	BLI_condition_init(&g_finishCondition);
+	g_cpuqueued = 0;
+	g_pending = 0;
+	g_cpuqueueNext = 0;
+	g_cpuStopping = false;
+
+	/* operations run tasks on the global task scheduler, which is created on first use, not thread safe */
+	BLI_task_scheduler_get();
+
 	for (index = 0; index < g_cpudevices.size(); index++) {
-		Device *device = g_cpudevices[index];
-		BLI_insert_thread(&g_cputhreads, device);
+		CPUWorkQueue *queue = new CPUWorkQueue();
+		queue->device = g_cpudevices[index];
+		queue->threadStarted = false;
+		BLI_spin_init(&queue->lock);
+		g_cpuqueues.push_back(queue);
+	}
+
+	BLI_init_threads(&g_cputhreads, thread_execute_cpu, g_cpuqueues.size());
+	for (index = 0; index < g_cpuqueues.size(); index++) {
+		BLI_insert_thread(&g_cputhreads, g_cpuqueues[index]);
 	}
 #ifdef COM_OPENCL_ENABLED
 	if (context.getHasActiveOpenCLDevices()) {
@@ -222,26 +407,31 @@ void WorkScheduler::start(CompositorContext &context)
 void WorkScheduler::finish()
 {
 #if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
-#ifdef COM_OPENCL_ENABLED
-	if (g_openclActive) {
-		BLI_thread_queue_wait_finish(g_gpuqueue);
-		BLI_thread_queue_wait_finish(g_cpuqueue);
-	}
-	else {
-		BLI_thread_queue_wait_finish(g_cpuqueue);
+	/* work done on one device can schedule work on the other devices, wait until all work is done */
+	BLI_mutex_lock(&g_workMutex);
+	while (g_pending > 0) {
+		BLI_condition_wait(&g_finishCondition, &g_workMutex);
 	}
-#else
-	BLI_thread_queue_wait_finish(cpuqueue);
-#endif
+	BLI_mutex_unlock(&g_workMutex);
 #endif
 }
 void WorkScheduler::stop()
 {
 #if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
-	BLI_thread_queue_nowait(g_cpuqueue);
+	unsigned int index;
+
+	BLI_mutex_lock(&g_workMutex);
+	g_cpuStopping = true;
+	BLI_condition_notify_all(&g_workCondition);
+	BLI_mutex_unlock(&g_workMutex);
+
 	BLI_end_threads(&g_cputhreads);
-	BLI_thread_queue_free(g_cpuqueue);
-	g_cpuqueue = NULL;
+	for (index = 0; index < g_cpuqueues.size(); index++) {
+		CPUWorkQueue *queue = g_cpuqueues[index];
+		BLI_spin_end(&queue->lock);
+		delete queue;
+	}
+	g_cpuqueues.clear();
 #ifdef COM_OPENCL_ENABLED
 	if (g_openclActive) {
 		BLI_thread_queue_nowait(g_gpuqueue);
@@ -250,6 +440,9 @@ void WorkScheduler::stop()
 		g_gpuqueue = NULL;
 	}
 #endif
+	BLI_condition_end(&g_workCondition);
+	BLI_condition_end(&g_finishCondition);
+	BLI_mutex_end(&g_workMutex);
 #endif
 }
 
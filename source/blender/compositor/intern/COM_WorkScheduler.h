@@ -60,6 +60,7 @@ public:
 	 * An execution group schedules a chunk in the WorkScheduler
 	 * when ExecutionGroup.isOpenCL is set the work will be handled by a OpenCLDevice
 	 * otherwide the work is scheduled for an CPUDevice
+	 * @note work scheduled from a CPU thread is calculated next by that thread, idle threads steal work from other threads
 	 * @see ExecutionGroup.execute
 	 * @param group the execution group
 	 * @param chunkNumber the number of the chunk in the group to be executed
@@ -102,6 +103,7 @@ public:
 
 	/**
 	 * @brief wait for all work to be completed.
+	 * @note includes the work scheduled by other work while waiting
 	 */
 	static void finish();
 
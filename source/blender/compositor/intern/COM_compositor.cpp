@@ -29,6 +29,7 @@ extern "C" {
 #include "BKE_global.h"
 
 #include "COM_compositor.h"
+#include "COM_BufferCache.h"
 #include "COM_ExecutionSystem.h"
 #include "COM_WorkScheduler.h"
 #include "OCL_opencl.h"
@@ -40,6 +41,7 @@ static char is_compositorMutex_init = FALSE;
 static void intern_freeCompositorCaches()
 {
 	deintializeDistortionCache();
+	BufferCache::clear();
 }
 
 void COM_execute(RenderData *rd, bNodeTree *editingtree, int rendering,
@@ -103,7 +105,7 @@ void COM_execute(RenderData *rd, bNodeTree *editingtree, int rendering,
 	BLI_mutex_unlock(&s_compositorMutex);
 }
 
-static void UNUSED_FUNCTION(COM_freeCaches)()
+void COM_clearCaches()
 {
 	if (is_compositorMutex_init) {
 		BLI_mutex_lock(&s_compositorMutex);
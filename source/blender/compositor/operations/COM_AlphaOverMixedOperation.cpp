@@ -55,3 +55,31 @@ void AlphaOverMixedOperation::executePixelSampled(float output[4], float x, floa
 	}
 }
 
+void AlphaOverMixedOperation::executeRect(float *output, float **inputs, int numberOfPixels)
+{
+	int i;
+
+	for (i = 0; i < numberOfPixels; i++) {
+		const float value = inputs[0][i * COM_NUMBER_OF_CHANNELS];
+		const float *inputColor1 = &inputs[1][i * COM_NUMBER_OF_CHANNELS];
+		const float *inputOverColor = &inputs[2][i * COM_NUMBER_OF_CHANNELS];
+		float *color = &output[i * COM_NUMBER_OF_CHANNELS];
+
+		if (inputOverColor[3] <= 0.0f) {
+			copy_v4_v4(color, inputColor1);
+		}
+		else if (value == 1.0f && inputOverColor[3] >= 1.0f) {
+			copy_v4_v4(color, inputOverColor);
+		}
+		else {
+			float addfac = 1.0f - this->m_x + inputOverColor[3] * this->m_x;
+			float premul = value * addfac;
+			float mul = 1.0f - value * inputOverColor[3];
+
+			color[0] = (mul * inputColor1[0]) + premul * inputOverColor[0];
+			color[1] = (mul * inputColor1[1]) + premul * inputOverColor[1];
+			color[2] = (mul * inputColor1[2]) + premul * inputOverColor[2];
+			color[3] = (mul * inputColor1[3]) + value * inputOverColor[3];
+		}
+	}
+}
@@ -42,6 +42,9 @@ public:
 	 * the inner loop of this program
 	 */
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+
+	bool isRectKernel() const { return true; }
+	void executeRect(float *output, float **inputs, int numberOfPixels);
 	
 	void setX(float x) { this->m_x = x; }
 };
@@ -54,3 +54,30 @@ void AlphaOverPremultiplyOperation::executePixelSampled(float output[4], float x
 	}
 }
 
+void AlphaOverPremultiplyOperation::executeRect(float *output, float **inputs, int numberOfPixels)
+{
+	int i;
+
+	for (i = 0; i < numberOfPixels; i++) {
+		const float value = inputs[0][i * COM_NUMBER_OF_CHANNELS];
+		const float *inputColor1 = &inputs[1][i * COM_NUMBER_OF_CHANNELS];
+		const float *inputOverColor = &inputs[2][i * COM_NUMBER_OF_CHANNELS];
+		float *color = &output[i * COM_NUMBER_OF_CHANNELS];
+
+		/* Zero alpha values should still permit an add of RGB data */
+		if (inputOverColor[3] < 0.0f) {
+			copy_v4_v4(color, inputColor1);
+		}
+		else if (value == 1.0f && inputOverColor[3] >= 1.0f) {
+			copy_v4_v4(color, inputOverColor);
+		}
+		else {
+			float mul = 1.0f - value * inputOverColor[3];
+
+			color[0] = (mul * inputColor1[0]) + value * inputOverColor[0];
+			color[1] = (mul * inputColor1[1]) + value * inputOverColor[1];
+			color[2] = (mul * inputColor1[2]) + value * inputOverColor[2];
+			color[3] = (mul * inputColor1[3]) + value * inputOverColor[3];
+		}
+	}
+}
@@ -41,5 +41,8 @@ public:
 	 */
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
 
+	bool isRectKernel() const { return true; }
+	void executeRect(float *output, float **inputs, int numberOfPixels);
+
 };
 #endif
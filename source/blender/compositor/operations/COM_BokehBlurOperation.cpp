@@ -24,6 +24,10 @@
 #include "BLI_math.h"
 #include "COM_OpenCLDevice.h"
 
+#ifdef __SSE__
+#  include <xmmintrin.h>
+#endif
+
 extern "C" {
 	#include "RE_pipeline.h"
 }
@@ -113,17 +117,32 @@ void BokehBlurOperation::executePixel(float output[4], int x, int y, void *data)
 		int offsetadd = getOffsetAdd();
 
 		float m = this->m_bokehDimension / pixelSize;
+#ifdef __SSE__
+		/* all channels of a pixel are accumulated in a single register */
+		__m128 color_accum_sse = _mm_loadu_ps(color_accum);
+		__m128 multiplier_accum_sse = _mm_loadu_ps(multiplier_accum);
+#endif
 		for (int ny = miny; ny < maxy; ny += step) {
 			int bufferindex = ((minx - bufferstartx) * 4) + ((ny - bufferstarty) * 4 * bufferwidth);
 			for (int nx = minx; nx < maxx; nx += step) {
 				float u = this->m_bokehMidX - (nx - x) * m;
 				float v = this->m_bokehMidY - (ny - y) * m;
 				this->m_inputBokehProgram->readSampled(bokeh, u, v, COM_PS_NEAREST);
+#ifdef __SSE__
+				const __m128 bokeh_sse = _mm_loadu_ps(bokeh);
+				color_accum_sse = _mm_add_ps(color_accum_sse, _mm_mul_ps(bokeh_sse, _mm_loadu_ps(&buffer[bufferindex])));
+				multiplier_accum_sse = _mm_add_ps(multiplier_accum_sse, bokeh_sse);
+#else
 				madd_v4_v4v4(color_accum, bokeh, &buffer[bufferindex]);
 				add_v4_v4(multiplier_accum, bokeh);
+#endif
 				bufferindex += offsetadd;
 			}
 		}
+#ifdef __SSE__
+		_mm_storeu_ps(color_accum, color_accum_sse);
+		_mm_storeu_ps(multiplier_accum, multiplier_accum_sse);
+#endif
 		output[0] = color_accum[0] * (1.0f / multiplier_accum[0]);
 		output[1] = color_accum[1] * (1.0f / multiplier_accum[1]);
 		output[2] = color_accum[2] * (1.0f / multiplier_accum[2]);
@@ -46,7 +46,23 @@ void ColorCorrectionOperation::executePixelSampled(float output[4], float x, flo
 	float inputMask[4];
 	this->m_inputImage->readSampled(inputImageColor, x, y, sampler);
 	this->m_inputMask->readSampled(inputMask, x, y, sampler);
-	
+
+	correctPixel(output, inputImageColor, inputMask[0]);
+}
+
+void ColorCorrectionOperation::executeRect(float *output, float **inputs, int numberOfPixels)
+{
+	int i;
+
+	for (i = 0; i < numberOfPixels; i++) {
+		correctPixel(&output[i * COM_NUMBER_OF_CHANNELS],
+		             &inputs[0][i * COM_NUMBER_OF_CHANNELS],
+		             inputs[1][i * COM_NUMBER_OF_CHANNELS]);
+	}
+}
+
+void ColorCorrectionOperation::correctPixel(float output[4], const float inputImageColor[4], float mask)
+{
 	float level = (inputImageColor[0] + inputImageColor[1] + inputImageColor[2]) / 3.0f;
 	float contrast = this->m_data->master.contrast;
 	float saturation = this->m_data->master.saturation;
@@ -55,8 +71,7 @@ void ColorCorrectionOperation::executePixelSampled(float output[4], float x, flo
 	float lift = this->m_data->master.lift;
 	float r, g, b;
 	
-	float value = inputMask[0];
-	value = min(1.0f, value);
+	float value = min(1.0f, mask);
 	const float mvalue = 1.0f - value;
 	
 	float levelShadows = 0.0;
@@ -38,6 +38,11 @@ private:
 	bool m_greenChannelEnabled;
 	bool m_blueChannelEnabled;
 
+	/**
+	 * @brief color correct a single pixel, shared by executePixelSampled and executeRect
+	 */
+	void correctPixel(float output[4], const float inputImageColor[4], float mask);
+
 public:
 	ColorCorrectionOperation();
 	
@@ -45,6 +50,9 @@ public:
 	 * the inner loop of this program
 	 */
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+
+	bool isRectKernel() const { return true; }
+	void executeRect(float *output, float **inputs, int numberOfPixels);
 	
 	/**
 	 * Initialize the execution
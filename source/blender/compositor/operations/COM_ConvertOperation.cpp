@@ -55,6 +55,19 @@ void ConvertValueToColorOperation::executePixelSampled(float output[4], float x,
 	output[3] = 1.0f;
 }
 
+void ConvertValueToColorOperation::executeRect(float *output, float **inputs, int numberOfPixels)
+{
+	int i;
+
+	for (i = 0; i < numberOfPixels; i++) {
+		const float *input = &inputs[0][i * COM_NUMBER_OF_CHANNELS];
+		float *color = &output[i * COM_NUMBER_OF_CHANNELS];
+
+		color[0] = color[1] = color[2] = input[0];
+		color[3] = 1.0f;
+	}
+}
+
 
 /* ******** Color to Value ******** */
 
@@ -71,6 +84,18 @@ void ConvertColorToValueOperation::executePixelSampled(float output[4], float x,
 	output[0] = (inputColor[0] + inputColor[1] + inputColor[2]) / 3.0f;
 }
 
+void ConvertColorToValueOperation::executeRect(float *output, float **inputs, int numberOfPixels)
+{
+	int i;
+
+	for (i = 0; i < numberOfPixels; i++) {
+		const float *input = &inputs[0][i * COM_NUMBER_OF_CHANNELS];
+		float *color = &output[i * COM_NUMBER_OF_CHANNELS];
+
+		color[0] = (input[0] + input[1] + input[2]) / 3.0f;
+	}
+}
+
 
 /* ******** Color to BW ******** */
 
@@ -87,6 +112,18 @@ void ConvertColorToBWOperation::executePixelSampled(float output[4], float x, fl
 	output[0] = rgb_to_bw(inputColor);
 }
 
+void ConvertColorToBWOperation::executeRect(float *output, float **inputs, int numberOfPixels)
+{
+	int i;
+
+	for (i = 0; i < numberOfPixels; i++) {
+		const float *input = &inputs[0][i * COM_NUMBER_OF_CHANNELS];
+		float *color = &output[i * COM_NUMBER_OF_CHANNELS];
+
+		color[0] = rgb_to_bw(input);
+	}
+}
+
 
 /* ******** Color to Vector ******** */
 
@@ -101,6 +138,18 @@ void ConvertColorToVectorOperation::executePixelSampled(float output[4], float x
 	this->m_inputOperation->readSampled(output, x, y, sampler);
 }
 
+void ConvertColorToVectorOperation::executeRect(float *output, float **inputs, int numberOfPixels)
+{
+	int i;
+
+	for (i = 0; i < numberOfPixels; i++) {
+		const float *input = &inputs[0][i * COM_NUMBER_OF_CHANNELS];
+		float *color = &output[i * COM_NUMBER_OF_CHANNELS];
+
+		copy_v4_v4(color, input);
+	}
+}
+
 
 /* ******** Value to Vector ******** */
 
@@ -120,6 +169,21 @@ void ConvertValueToVectorOperation::executePixelSampled(float output[4], float x
 	output[3] = 0.0f;
 }
 
+void ConvertValueToVectorOperation::executeRect(float *output, float **inputs, int numberOfPixels)
+{
+	int i;
+
+	for (i = 0; i < numberOfPixels; i++) {
+		const float *input = &inputs[0][i * COM_NUMBER_OF_CHANNELS];
+		float *color = &output[i * COM_NUMBER_OF_CHANNELS];
+
+		color[0] = input[0];
+		color[1] = input[0];
+		color[2] = input[0];
+		color[3] = 0.0f;
+	}
+}
+
 
 /* ******** Vector to Color ******** */
 
@@ -135,6 +199,19 @@ void ConvertVectorToColorOperation::executePixelSampled(float output[4], float x
 	output[3] = 1.0f;
 }
 
+void ConvertVectorToColorOperation::executeRect(float *output, float **inputs, int numberOfPixels)
+{
+	int i;
+
+	for (i = 0; i < numberOfPixels; i++) {
+		const float *input = &inputs[0][i * COM_NUMBER_OF_CHANNELS];
+		float *color = &output[i * COM_NUMBER_OF_CHANNELS];
+
+		copy_v3_v3(color, input);
+		color[3] = 1.0f;
+	}
+}
+
 
 /* ******** Vector to Value ******** */
 
@@ -151,6 +228,18 @@ void ConvertVectorToValueOperation::executePixelSampled(float output[4], float x
 	output[0] = (input[0] + input[1] + input[2]) / 3.0f;
 }
 
+void ConvertVectorToValueOperation::executeRect(float *output, float **inputs, int numberOfPixels)
+{
+	int i;
+
+	for (i = 0; i < numberOfPixels; i++) {
+		const float *input = &inputs[0][i * COM_NUMBER_OF_CHANNELS];
+		float *color = &output[i * COM_NUMBER_OF_CHANNELS];
+
+		color[0] = (input[0] + input[1] + input[2]) / 3.0f;
+	}
+}
+
 
 /* ******** RGB to YCC ******** */
 
@@ -323,6 +412,28 @@ void ConvertPremulToStraightOperation::executePixelSampled(float output[4], floa
 	output[3] = alpha;
 }
 
+void ConvertPremulToStraightOperation::executeRect(float *output, float **inputs, int numberOfPixels)
+{
+	int i;
+
+	for (i = 0; i < numberOfPixels; i++) {
+		const float *input = &inputs[0][i * COM_NUMBER_OF_CHANNELS];
+		float *color = &output[i * COM_NUMBER_OF_CHANNELS];
+
+		float alpha = input[3];
+
+		if (fabsf(alpha) < 1e-5f) {
+			zero_v3(color);
+		}
+		else {
+			mul_v3_v3fl(color, input, 1.0f / alpha);
+		}
+
+		/* never touches the alpha */
+		color[3] = alpha;
+	}
+}
+
 
 /* ******** Straight to Premul ******** */
 
@@ -346,6 +457,23 @@ void ConvertStraightToPremulOperation::executePixelSampled(float output[4], floa
 	output[3] = alpha;
 }
 
+void ConvertStraightToPremulOperation::executeRect(float *output, float **inputs, int numberOfPixels)
+{
+	int i;
+
+	for (i = 0; i < numberOfPixels; i++) {
+		const float *input = &inputs[0][i * COM_NUMBER_OF_CHANNELS];
+		float *color = &output[i * COM_NUMBER_OF_CHANNELS];
+
+		float alpha = input[3];
+
+		mul_v3_v3fl(color, input, alpha);
+
+		/* never touches the alpha */
+		color[3] = alpha;
+	}
+}
+
 
 /* ******** Separate Channels ******** */
 
@@ -373,6 +501,18 @@ void SeparateChannelOperation::executePixelSampled(float output[4], float x, flo
 	output[0] = input[this->m_channel];
 }
 
+void SeparateChannelOperation::executeRect(float *output, float **inputs, int numberOfPixels)
+{
+	int i;
+
+	for (i = 0; i < numberOfPixels; i++) {
+		const float *input = &inputs[0][i * COM_NUMBER_OF_CHANNELS];
+		float *color = &output[i * COM_NUMBER_OF_CHANNELS];
+
+		color[0] = input[this->m_channel];
+	}
+}
+
 
 /* ******** Combine Channels ******** */
 
@@ -427,3 +567,17 @@ void CombineChannelsOperation::executePixelSampled(float output[4], float x, flo
 		output[3] = input[0];
 	}
 }
+
+void CombineChannelsOperation::executeRect(float *output, float **inputs, int numberOfPixels)
+{
+	int i;
+
+	for (i = 0; i < numberOfPixels; i++) {
+		float *color = &output[i * COM_NUMBER_OF_CHANNELS];
+
+		color[0] = inputs[0][i * COM_NUMBER_OF_CHANNELS];
+		color[1] = inputs[1][i * COM_NUMBER_OF_CHANNELS];
+		color[2] = inputs[2][i * COM_NUMBER_OF_CHANNELS];
+		color[3] = inputs[3][i * COM_NUMBER_OF_CHANNELS];
+	}
+}
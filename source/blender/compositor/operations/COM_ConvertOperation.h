@@ -43,6 +43,8 @@ public:
 	ConvertValueToColorOperation();
 	
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	bool isRectKernel() const { return true; }
+	void executeRect(float *output, float **inputs, int numberOfPixels);
 };
 
 
@@ -51,6 +53,8 @@ public:
 	ConvertColorToValueOperation();
 	
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	bool isRectKernel() const { return true; }
+	void executeRect(float *output, float **inputs, int numberOfPixels);
 };
 
 
@@ -59,6 +63,8 @@ public:
 	ConvertColorToBWOperation();
 	
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	bool isRectKernel() const { return true; }
+	void executeRect(float *output, float **inputs, int numberOfPixels);
 };
 
 
@@ -67,6 +73,8 @@ public:
 	ConvertColorToVectorOperation();
 	
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	bool isRectKernel() const { return true; }
+	void executeRect(float *output, float **inputs, int numberOfPixels);
 };
 
 
@@ -75,6 +83,8 @@ public:
 	ConvertValueToVectorOperation();
 	
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	bool isRectKernel() const { return true; }
+	void executeRect(float *output, float **inputs, int numberOfPixels);
 };
 
 
@@ -83,6 +93,8 @@ public:
 	ConvertVectorToColorOperation();
 	
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	bool isRectKernel() const { return true; }
+	void executeRect(float *output, float **inputs, int numberOfPixels);
 };
 
 
@@ -91,6 +103,8 @@ public:
 	ConvertVectorToValueOperation();
 	
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	bool isRectKernel() const { return true; }
+	void executeRect(float *output, float **inputs, int numberOfPixels);
 };
 
 
@@ -159,6 +173,8 @@ public:
 	ConvertPremulToStraightOperation();
 
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	bool isRectKernel() const { return true; }
+	void executeRect(float *output, float **inputs, int numberOfPixels);
 };
 
 
@@ -167,6 +183,8 @@ public:
 	ConvertStraightToPremulOperation();
 
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	bool isRectKernel() const { return true; }
+	void executeRect(float *output, float **inputs, int numberOfPixels);
 };
 
 
@@ -177,6 +195,8 @@ private:
 public:
 	SeparateChannelOperation();
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	bool isRectKernel() const { return true; }
+	void executeRect(float *output, float **inputs, int numberOfPixels);
 	
 	void initExecution();
 	void deinitExecution();
@@ -194,6 +214,8 @@ private:
 public:
 	CombineChannelsOperation();
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	bool isRectKernel() const { return true; }
+	void executeRect(float *output, float **inputs, int numberOfPixels);
 	
 	void initExecution();
 	void deinitExecution();
@@ -21,10 +21,12 @@
  */
 
 #include <limits.h>
+#include <string.h>
 
 #include "COM_FastGaussianBlurOperation.h"
 #include "MEM_guardedalloc.h"
 #include "BLI_utildefines.h"
+#include "BLI_task.h"
 
 FastGaussianBlurOperation::FastGaussianBlurOperation() : BlurBaseOperation(COM_DT_COLOR)
 {
@@ -207,61 +209,41 @@ void FastGaussianBlurOperation::deinitializeTileData(rcti *rect, void *data)
 }
 
 
-void FastGaussianBlurOperation::IIR_gauss(MemoryBuffer *src, float sigma, unsigned int chan, unsigned int xy)
+/**
+ * @brief lines of a single IIR_gauss pass, calculated by one task
+ */
+typedef struct IIRGaussLines {
+	float *buffer;
+	unsigned int width;
+	unsigned int height;
+	unsigned int numChannels;
+	unsigned int chan;
+	/* false: filter rows, true: filter columns */
+	bool vertical;
+	/* range of rows or columns to filter */
+	unsigned int start;
+	unsigned int end;
+	double cf[4];
+	double tsM[9];
+} IIRGaussLines;
+
+/* lines filtered by a task at least, smaller passes use less tasks */
+#define IIR_GAUSS_MIN_LINES 16
+
+static void IIR_gauss_lines(IIRGaussLines *lines)
 {
-	double q, q2, sc, cf[4], tsM[9], tsu[3], tsv[3];
+	const double *cf = lines->cf;
+	const double *tsM = lines->tsM;
+	double tsu[3], tsv[3];
 	double *X, *Y, *W;
-	const unsigned int src_width = src->getWidth();
-	const unsigned int src_height = src->getHeight();
+	float *buffer = lines->buffer;
+	const unsigned int src_width = lines->width;
+	const unsigned int src_height = lines->height;
+	const unsigned int numChannels = lines->numChannels;
+	const unsigned int chan = lines->chan;
 	unsigned int x, y, sz;
 	unsigned int i;
-	float *buffer = src->getBuffer();
-	
-	// <0.5 not valid, though can have a possibly useful sort of sharpening effect
-	if (sigma < 0.5f) return;
-	
-	if ((xy < 1) || (xy > 3)) xy = 3;
-	
-	// XXX The YVV macro defined below explicitly expects sources of at least 3x3 pixels,
-	//     so just skiping blur along faulty direction if src's def is below that limit!
-	if (src_width < 3) xy &= ~1;
-	if (src_height < 3) xy &= ~2;
-	if (xy < 1) return;
-	
-	// see "Recursive Gabor Filtering" by Young/VanVliet
-	// all factors here in double.prec. Required, because for single.prec it seems to blow up if sigma > ~200
-	if (sigma >= 3.556f)
-		q = 0.9804f * (sigma - 3.556f) + 2.5091f;
-	else // sigma >= 0.5
-		q = (0.0561f * sigma + 0.5784f) * sigma - 0.2568f;
-	q2 = q * q;
-	sc = (1.1668 + q) * (3.203729649  + (2.21566 + q) * q);
-	// no gabor filtering here, so no complex multiplies, just the regular coefs.
-	// all negated here, so as not to have to recalc Triggs/Sdika matrix
-	cf[1] = q * (5.788961737 + (6.76492 + 3.0 * q) * q) / sc;
-	cf[2] = -q2 * (3.38246 + 3.0 * q) / sc;
-	// 0 & 3 unchanged
-	cf[3] = q2 * q / sc;
-	cf[0] = 1.0 - cf[1] - cf[2] - cf[3];
-	
-	// Triggs/Sdika border corrections,
-	// it seems to work, not entirely sure if it is actually totally correct,
-	// Besides J.M.Geusebroek's anigauss.c (see http://www.science.uva.nl/~mark),
-	// found one other implementation by Cristoph Lampert,
-	// but neither seem to be quite the same, result seems to be ok so far anyway.
-	// Extra scale factor here to not have to do it in filter,
-	// though maybe this had something to with the precision errors
-	sc = cf[0] / ((1.0 + cf[1] - cf[2] + cf[3]) * (1.0 - cf[1] - cf[2] - cf[3]) * (1.0 + cf[2] + (cf[1] - cf[3]) * cf[3]));
-	tsM[0] = sc * (-cf[3] * cf[1] + 1.0 - cf[3] * cf[3] - cf[2]);
-	tsM[1] = sc * ((cf[3] + cf[1]) * (cf[2] + cf[3] * cf[1]));
-	tsM[2] = sc * (cf[3] * (cf[1] + cf[3] * cf[2]));
-	tsM[3] = sc * (cf[1] + cf[3] * cf[2]);
-	tsM[4] = sc * (-(cf[2] - 1.0) * (cf[2] + cf[3] * cf[1]));
-	tsM[5] = sc * (-(cf[3] * cf[1] + cf[3] * cf[3] + cf[2] - 1.0) * cf[3]);
-	tsM[6] = sc * (cf[3] * cf[1] + cf[2] + cf[1] * cf[1] - cf[2] * cf[2]);
-	tsM[7] = sc * (cf[1] * cf[2] + cf[3] * cf[2] * cf[2] - cf[1] * cf[3] * cf[3] - cf[3] * cf[3] * cf[3] - cf[3] * cf[2] + cf[3]);
-	tsM[8] = sc * (cf[3] * (cf[1] + cf[3] * cf[2]));
-	
+
 #define YVV(L)                                                                          \
 {                                                                                       \
 	W[0] = cf[0] * X[0] + cf[1] * X[0] + cf[2] * X[0] + cf[3] * X[0];                   \
@@ -290,35 +272,35 @@ void FastGaussianBlurOperation::IIR_gauss(MemoryBuffer *src, float sigma, unsign
 	X = (double *)MEM_callocN(sz * sizeof(double), "IIR_gauss X buf");
 	Y = (double *)MEM_callocN(sz * sizeof(double), "IIR_gauss Y buf");
 	W = (double *)MEM_callocN(sz * sizeof(double), "IIR_gauss W buf");
-	if (xy & 1) {   // H
+	if (!lines->vertical) {   // H
 		int offset;
-		for (y = 0; y < src_height; ++y) {
+		for (y = lines->start; y < lines->end; ++y) {
 			const int yx = y * src_width;
-			offset = yx * COM_NUMBER_OF_CHANNELS + chan;
+			offset = yx * numChannels + chan;
 			for (x = 0; x < src_width; ++x) {
 				X[x] = buffer[offset];
-				offset += COM_NUMBER_OF_CHANNELS;
+				offset += numChannels;
 			}
 			YVV(src_width);
-			offset = yx * COM_NUMBER_OF_CHANNELS + chan;
+			offset = yx * numChannels + chan;
 			for (x = 0; x < src_width; ++x) {
 				buffer[offset] = Y[x];
-				offset += COM_NUMBER_OF_CHANNELS;
+				offset += numChannels;
 			}
 		}
 	}
-	if (xy & 2) {   // V
+	else {   // V
 		int offset;
-		const int add = src_width * COM_NUMBER_OF_CHANNELS;
+		const int add = src_width * numChannels;
 
-		for (x = 0; x < src_width; ++x) {
-			offset = x * COM_NUMBER_OF_CHANNELS + chan;
+		for (x = lines->start; x < lines->end; ++x) {
+			offset = x * numChannels + chan;
 			for (y = 0; y < src_height; ++y) {
 				X[y] = buffer[offset];
 				offset += add;
 			}
 			YVV(src_height);
-			offset = x * COM_NUMBER_OF_CHANNELS + chan;
+			offset = x * numChannels + chan;
 			for (y = 0; y < src_height; ++y) {
 				buffer[offset] = Y[y];
 				offset += add;
@@ -330,7 +312,114 @@ void FastGaussianBlurOperation::IIR_gauss(MemoryBuffer *src, float sigma, unsign
 	MEM_freeN(W);
 	MEM_freeN(Y);
 #undef YVV
+}
+
+static void IIR_gauss_lines_task(TaskPool *UNUSED(pool), void *taskdata, int UNUSED(threadid))
+{
+	IIR_gauss_lines((IIRGaussLines *)taskdata);
+}
+
+/**
+ * @brief filter all rows or columns of a pass, the lines are independent and divided over tasks
+ * @note runs on the global task scheduler, which WorkScheduler.start creates before the compositor threads
+ */
+static void IIR_gauss_pass(const IIRGaussLines *pass, unsigned int numberOfLines)
+{
+	TaskScheduler *scheduler = BLI_task_scheduler_get();
+	IIRGaussLines lines[BLENDER_MAX_THREADS];
+	int numberOfTasks = min(BLI_task_scheduler_num_threads(scheduler), BLENDER_MAX_THREADS);
+	int index;
+
+	numberOfTasks = max(min(numberOfTasks, (int)(numberOfLines / IIR_GAUSS_MIN_LINES)), 1);
+
+	for (index = 0; index < numberOfTasks; index++) {
+		lines[index] = *pass;
+		lines[index].start = (numberOfLines * index) / numberOfTasks;
+		lines[index].end = (numberOfLines * (index + 1)) / numberOfTasks;
+	}
+
+	if (numberOfTasks == 1) {
+		IIR_gauss_lines(&lines[0]);
+	}
+	else {
+		/* the calling compositor thread works on the tasks of its own pool while waiting */
+		TaskPool *pool = BLI_task_pool_create(scheduler, NULL);
+
+		for (index = 0; index < numberOfTasks; index++) {
+			BLI_task_pool_push(pool, IIR_gauss_lines_task, &lines[index], false, TASK_PRIORITY_HIGH);
+		}
+		BLI_task_pool_work_and_wait(pool);
+		BLI_task_pool_free(pool);
+	}
+}
+
+void FastGaussianBlurOperation::IIR_gauss(MemoryBuffer *src, float sigma, unsigned int chan, unsigned int xy)
+{
+	double q, q2, sc, cf[4], tsM[9];
+	const unsigned int src_width = src->getWidth();
+	const unsigned int src_height = src->getHeight();
+	IIRGaussLines pass;
+	// <0.5 not valid, though can have a possibly useful sort of sharpening effect
+	if (sigma < 0.5f) return;
+	
+	if ((xy < 1) || (xy > 3)) xy = 3;
+	
+	// XXX The YVV macro defined below explicitly expects sources of at least 3x3 pixels,
+	//     so just skiping blur along faulty direction if src's def is below that limit!
+	if (src_width < 3) xy &= ~1;
+	if (src_height < 3) xy &= ~2;
+	if (xy < 1) return;
+	
+	// see "Recursive Gabor Filtering" by Young/VanVliet
+	// all factors here in double.prec. Required, because for single.prec it seems to blow up if sigma > ~200
+	if (sigma >= 3.556f)
+		q = 0.9804f * (sigma - 3.556f) + 2.5091f;
+	else // sigma >= 0.5
+		q = (0.0561f * sigma + 0.5784f) * sigma - 0.2568f;
+	q2 = q * q;
+	sc = (1.1668 + q) * (3.203729649  + (2.21566 + q) * q);
+	// no gabor filtering here, so no complex multiplies, just the regular coefs.
+	// all negated here, so as not to have to recalc Triggs/Sdika matrix
+	cf[1] = q * (5.788961737 + (6.76492 + 3.0 * q) * q) / sc;
+	cf[2] = -q2 * (3.38246 + 3.0 * q) / sc;
+	// 0 & 3 unchanged
+	cf[3] = q2 * q / sc;
+	cf[0] = 1.0 - cf[1] - cf[2] - cf[3];
 	
+	// Triggs/Sdika border corrections,
+	// it seems to work, not entirely sure if it is actually totally correct,
+	// Besides J.M.Geusebroek's anigauss.c (see http://www.science.uva.nl/~mark),
+	// found one other implementation by Cristoph Lampert,
+	// but neither seem to be quite the same, result seems to be ok so far anyway.
+	// Extra scale factor here to not have to do it in filter,
+	// though maybe this had something to with the precision errors
+	sc = cf[0] / ((1.0 + cf[1] - cf[2] + cf[3]) * (1.0 - cf[1] - cf[2] - cf[3]) * (1.0 + cf[2] + (cf[1] - cf[3]) * cf[3]));
+	tsM[0] = sc * (-cf[3] * cf[1] + 1.0 - cf[3] * cf[3] - cf[2]);
+	tsM[1] = sc * ((cf[3] + cf[1]) * (cf[2] + cf[3] * cf[1]));
+	tsM[2] = sc * (cf[3] * (cf[1] + cf[3] * cf[2]));
+	tsM[3] = sc * (cf[1] + cf[3] * cf[2]);
+	tsM[4] = sc * (-(cf[2] - 1.0) * (cf[2] + cf[3] * cf[1]));
+	tsM[5] = sc * (-(cf[3] * cf[1] + cf[3] * cf[3] + cf[2] - 1.0) * cf[3]);
+	tsM[6] = sc * (cf[3] * cf[1] + cf[2] + cf[1] * cf[1] - cf[2] * cf[2]);
+	tsM[7] = sc * (cf[1] * cf[2] + cf[3] * cf[2] * cf[2] - cf[1] * cf[3] * cf[3] - cf[3] * cf[3] * cf[3] - cf[3] * cf[2] + cf[3]);
+	tsM[8] = sc * (cf[3] * (cf[1] + cf[3] * cf[2]));
+
+	pass.buffer = src->getBuffer();
+	pass.width = src_width;
+	pass.height = src_height;
+	pass.numChannels = src->getNumberOfChannels();
+	pass.chan = chan;
+	memcpy(pass.cf, cf, sizeof(cf));
+	memcpy(pass.tsM, tsM, sizeof(tsM));
+
+	if (xy & 1) {   // H
+		pass.vertical = false;
+		IIR_gauss_pass(&pass, src_height);
+	}
+	if (xy & 2) {   // V
+		pass.vertical = true;
+		IIR_gauss_pass(&pass, src_width);
+	}
 }
 
 
@@ -389,12 +478,13 @@ void *FastGaussianBlurValueOperation::initializeTileData(rcti *rect)
 	if (!this->m_iirgaus) {
 		MemoryBuffer *newBuf = (MemoryBuffer *)this->m_inputprogram->initializeTileData(rect);
 		MemoryBuffer *copy = newBuf->duplicate();
+		const int numChannels = copy->getNumberOfChannels();
 		FastGaussianBlurOperation::IIR_gauss(copy, this->m_sigma, 0, 3);
 
 		if (this->m_overlay == FAST_GAUSS_OVERLAY_MIN) {
 			float *src = newBuf->getBuffer();
 			float *dst = copy->getBuffer();
-			for (int i = copy->getWidth() * copy->getHeight(); i != 0; i--, src += COM_NUMBER_OF_CHANNELS, dst += COM_NUMBER_OF_CHANNELS) {
+			for (int i = copy->getWidth() * copy->getHeight(); i != 0; i--, src += numChannels, dst += numChannels) {
 				if (*src < *dst) {
 					*dst = *src;
 				}
@@ -403,7 +493,7 @@ void *FastGaussianBlurValueOperation::initializeTileData(rcti *rect)
 		else if (this->m_overlay == FAST_GAUSS_OVERLAY_MAX) {
 			float *src = newBuf->getBuffer();
 			float *dst = copy->getBuffer();
-			for (int i = copy->getWidth() * copy->getHeight(); i != 0; i--, src += COM_NUMBER_OF_CHANNELS, dst += COM_NUMBER_OF_CHANNELS) {
+			for (int i = copy->getWidth() * copy->getHeight(); i != 0; i--, src += numChannels, dst += numChannels) {
 				if (*src > *dst) {
 					*dst = *src;
 				}
@@ -94,6 +94,7 @@ void GaussianAlphaYBlurOperation::executePixel(float output[4], int x, int y, vo
 	const bool do_invert = this->m_do_subtract;
 	MemoryBuffer *inputBuffer = (MemoryBuffer *)data;
 	float *buffer = inputBuffer->getBuffer();
+	const int numChannels = inputBuffer->getNumberOfChannels();
 	int bufferwidth = inputBuffer->getWidth();
 	int bufferstartx = inputBuffer->getRect()->xmin;
 	int bufferstarty = inputBuffer->getRect()->ymin;
@@ -113,11 +114,11 @@ void GaussianAlphaYBlurOperation::executePixel(float output[4], int x, int y, vo
 	float multiplier_accum = 0.0f;
 
 	/* dilate */
-	float value_max = finv_test(buffer[(x * 4) + (y * 4 * bufferwidth)], do_invert); /* init with the current color to avoid unneeded lookups */
+	float value_max = finv_test(buffer[(x * numChannels) + (y * numChannels * bufferwidth)], do_invert); /* init with the current color to avoid unneeded lookups */
 	float distfacinv_max = 1.0f; /* 0 to 1 */
 
 	for (int ny = miny; ny <= maxy; ny += step) {
-		int bufferindex = ((minx - bufferstartx) * 4) + ((ny - bufferstarty) * 4 * bufferwidth);
+		int bufferindex = ((minx - bufferstartx) * numChannels) + ((ny - bufferstarty) * numChannels * bufferwidth);
 
 		const int index = (ny - y) + this->m_rad;
 		float value = finv_test(buffer[bufferindex], do_invert);
@@ -24,6 +24,10 @@
 #include "BLI_math.h"
 #include "MEM_guardedalloc.h"
 
+#ifdef __SSE__
+#  include <xmmintrin.h>
+#endif
+
 extern "C" {
 	#include "RE_pipeline.h"
 }
@@ -92,12 +96,24 @@ void GaussianXBlurOperation::executePixel(float output[4], int x, int y, void *d
 	int step = getStep();
 	int offsetadd = getOffsetAdd();
 	int bufferindex = ((minx - bufferstartx) * 4) + ((miny - bufferstarty) * 4 * bufferwidth);
+#ifdef __SSE__
+	/* all channels of a pixel are accumulated in a single register */
+	__m128 color_accum_sse = _mm_setzero_ps();
+	for (int nx = minx, index = (minx - x) + this->m_rad; nx <= maxx; nx += step, index += step) {
+		const float multiplier = this->m_gausstab[index];
+		color_accum_sse = _mm_add_ps(color_accum_sse, _mm_mul_ps(_mm_loadu_ps(&buffer[bufferindex]), _mm_set1_ps(multiplier)));
+		multiplier_accum += multiplier;
+		bufferindex += offsetadd;
+	}
+	_mm_storeu_ps(color_accum, color_accum_sse);
+#else
 	for (int nx = minx, index = (minx - x) + this->m_rad; nx <= maxx; nx += step, index += step) {
 		const float multiplier = this->m_gausstab[index];
 		madd_v4_v4fl(color_accum, &buffer[bufferindex], multiplier);
 		multiplier_accum += multiplier;
 		bufferindex += offsetadd;
 	}
+#endif
 	mul_v4_v4fl(output, color_accum, 1.0f / multiplier_accum);
 }
 
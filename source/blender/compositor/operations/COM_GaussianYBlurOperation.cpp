@@ -24,6 +24,10 @@
 #include "BLI_math.h"
 #include "MEM_guardedalloc.h"
 
+#ifdef __SSE__
+#  include <xmmintrin.h>
+#endif
+
 extern "C" {
 	#include "RE_pipeline.h"
 }
@@ -92,6 +96,18 @@ void GaussianYBlurOperation::executePixel(float output[4], int x, int y, void *d
 	int index;
 	int step = getStep();
 	const int bufferIndexx = ((minx - bufferstartx) * 4);
+#ifdef __SSE__
+	/* all channels of a pixel are accumulated in a single register */
+	__m128 color_accum_sse = _mm_setzero_ps();
+	for (int ny = miny; ny <= maxy; ny += step) {
+		index = (ny - y) + this->m_rad;
+		int bufferindex = bufferIndexx + ((ny - bufferstarty) * 4 * bufferwidth);
+		const float multiplier = this->m_gausstab[index];
+		color_accum_sse = _mm_add_ps(color_accum_sse, _mm_mul_ps(_mm_loadu_ps(&buffer[bufferindex]), _mm_set1_ps(multiplier)));
+		multiplier_accum += multiplier;
+	}
+	_mm_storeu_ps(color_accum, color_accum_sse);
+#else
 	for (int ny = miny; ny <= maxy; ny += step) {
 		index = (ny - y) + this->m_rad;
 		int bufferindex = bufferIndexx + ((ny - bufferstarty) * 4 * bufferwidth);
@@ -99,6 +115,7 @@ void GaussianYBlurOperation::executePixel(float output[4], int x, int y, void *d
 		madd_v4_v4fl(color_accum, &buffer[bufferindex], multiplier);
 		multiplier_accum += multiplier;
 	}
+#endif
 	mul_v4_v4fl(output, color_accum, 1.0f / multiplier_accum);
 }
 
@@ -66,6 +66,9 @@ public:
 	void setImageUser(ImageUser *imageuser) { this->m_imageUser = imageuser; }
 
 	void setFramenumber(int framenumber) { this->m_framenumber = framenumber; }
+
+	/* multiview images have a buffer per view */
+	bool isViewDependent() const { return true; }
 };
 class ImageOperation : public BaseImageOperation {
 public:
@@ -58,13 +58,14 @@ void KeyingClipOperation::executePixel(float output[4], int x, int y, void *data
 
 	MemoryBuffer *inputBuffer = (MemoryBuffer *)data;
 	float *buffer = inputBuffer->getBuffer();
+	const int numChannels = inputBuffer->getNumberOfChannels();
 
 	int bufferWidth = inputBuffer->getWidth();
 	int bufferHeight = inputBuffer->getHeight();
 
 	int i, j, count = 0, totalCount = 0;
 
-	float value = buffer[(y * bufferWidth + x) * 4];
+	float value = buffer[(y * bufferWidth + x) * numChannels];
 
 	bool ok = false;
 
@@ -76,7 +77,7 @@ void KeyingClipOperation::executePixel(float output[4], int x, int y, void *data
 				continue;
 
 			if (cx >= 0 && cx < bufferWidth && cy >= 0 && cy < bufferHeight) {
-				int bufferIndex = (cy * bufferWidth + cx) * 4;
+				int bufferIndex = (cy * bufferWidth + cx) * numChannels;
 				float currentValue = buffer[bufferIndex];
 
 				if (fabsf(currentValue - value) < tolerance) {
@@ -72,6 +72,16 @@ void MathBaseOperation::clampIfNeeded(float *color)
 	}
 }
 
+void MathBaseOperation::clampRectIfNeeded(float *output, int numberOfPixels)
+{
+	if (this->m_useClamp) {
+		int i;
+		for (i = 0; i < numberOfPixels; i++) {
+			CLAMP(output[i * COM_NUMBER_OF_CHANNELS], 0.0f, 1.0f);
+		}
+	}
+}
+
 void MathAddOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputValue1[4];
@@ -85,6 +95,20 @@ void MathAddOperation::executePixelSampled(float output[4], float x, float y, Pi
 	clampIfNeeded(output);
 }
 
+void MathAddOperation::executeRect(float *output, float **inputs, int numberOfPixels)
+{
+	int i;
+
+	for (i = 0; i < numberOfPixels; i++) {
+		const float value1 = inputs[0][i * COM_NUMBER_OF_CHANNELS];
+		const float value2 = inputs[1][i * COM_NUMBER_OF_CHANNELS];
+
+		output[i * COM_NUMBER_OF_CHANNELS] = value1 + value2;
+	}
+
+	clampRectIfNeeded(output, numberOfPixels);
+}
+
 void MathSubtractOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputValue1[4];
@@ -98,6 +122,20 @@ void MathSubtractOperation::executePixelSampled(float output[4], float x, float
 	clampIfNeeded(output);
 }
 
+void MathSubtractOperation::executeRect(float *output, float **inputs, int numberOfPixels)
+{
+	int i;
+
+	for (i = 0; i < numberOfPixels; i++) {
+		const float value1 = inputs[0][i * COM_NUMBER_OF_CHANNELS];
+		const float value2 = inputs[1][i * COM_NUMBER_OF_CHANNELS];
+
+		output[i * COM_NUMBER_OF_CHANNELS] = value1 - value2;
+	}
+
+	clampRectIfNeeded(output, numberOfPixels);
+}
+
 void MathMultiplyOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputValue1[4];
@@ -111,6 +149,20 @@ void MathMultiplyOperation::executePixelSampled(float output[4], float x, float
 	clampIfNeeded(output);
 }
 
+void MathMultiplyOperation::executeRect(float *output, float **inputs, int numberOfPixels)
+{
+	int i;
+
+	for (i = 0; i < numberOfPixels; i++) {
+		const float value1 = inputs[0][i * COM_NUMBER_OF_CHANNELS];
+		const float value2 = inputs[1][i * COM_NUMBER_OF_CHANNELS];
+
+		output[i * COM_NUMBER_OF_CHANNELS] = value1 * value2;
+	}
+
+	clampRectIfNeeded(output, numberOfPixels);
+}
+
 void MathDivideOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputValue1[4];
@@ -127,6 +179,21 @@ void MathDivideOperation::executePixelSampled(float output[4], float x, float y,
 	clampIfNeeded(output);
 }
 
+void MathDivideOperation::executeRect(float *output, float **inputs, int numberOfPixels)
+{
+	int i;
+
+	for (i = 0; i < numberOfPixels; i++) {
+		const float value1 = inputs[0][i * COM_NUMBER_OF_CHANNELS];
+		const float value2 = inputs[1][i * COM_NUMBER_OF_CHANNELS];
+
+		/* We don't want to divide by zero. */
+		output[i * COM_NUMBER_OF_CHANNELS] = (value2 == 0) ? 0.0f : value1 / value2;
+	}
+
+	clampRectIfNeeded(output, numberOfPixels);
+}
+
 void MathSineOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputValue1[4];
@@ -236,6 +303,34 @@ void MathPowerOperation::executePixelSampled(float output[4], float x, float y,
 	clampIfNeeded(output);
 }
 
+void MathPowerOperation::executeRect(float *output, float **inputs, int numberOfPixels)
+{
+	int i;
+
+	for (i = 0; i < numberOfPixels; i++) {
+		const float value1 = inputs[0][i * COM_NUMBER_OF_CHANNELS];
+		const float value2 = inputs[1][i * COM_NUMBER_OF_CHANNELS];
+
+		float result;
+		if (value1 >= 0) {
+			result = pow(value1, value2);
+		}
+		else {
+			float y_mod_1 = fmod(value2, 1);
+			/* if input value is not nearly an integer, fall back to zero, nicer than straight rounding */
+			if (y_mod_1 > 0.999f || y_mod_1 < 0.001f) {
+				result = pow(value1, floorf(value2 + 0.5f));
+			}
+			else {
+				result = 0.0f;
+			}
+		}
+		output[i * COM_NUMBER_OF_CHANNELS] = result;
+	}
+
+	clampRectIfNeeded(output, numberOfPixels);
+}
+
 void MathLogarithmOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputValue1[4];
@@ -265,6 +360,20 @@ void MathMinimumOperation::executePixelSampled(float output[4], float x, float y
 	clampIfNeeded(output);
 }
 
+void MathMinimumOperation::executeRect(float *output, float **inputs, int numberOfPixels)
+{
+	int i;
+
+	for (i = 0; i < numberOfPixels; i++) {
+		const float value1 = inputs[0][i * COM_NUMBER_OF_CHANNELS];
+		const float value2 = inputs[1][i * COM_NUMBER_OF_CHANNELS];
+
+		output[i * COM_NUMBER_OF_CHANNELS] = min(value1, value2);
+	}
+
+	clampRectIfNeeded(output, numberOfPixels);
+}
+
 void MathMaximumOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputValue1[4];
@@ -278,6 +387,20 @@ void MathMaximumOperation::executePixelSampled(float output[4], float x, float y
 	clampIfNeeded(output);
 }
 
+void MathMaximumOperation::executeRect(float *output, float **inputs, int numberOfPixels)
+{
+	int i;
+
+	for (i = 0; i < numberOfPixels; i++) {
+		const float value1 = inputs[0][i * COM_NUMBER_OF_CHANNELS];
+		const float value2 = inputs[1][i * COM_NUMBER_OF_CHANNELS];
+
+		output[i * COM_NUMBER_OF_CHANNELS] = max(value1, value2);
+	}
+
+	clampRectIfNeeded(output, numberOfPixels);
+}
+
 void MathRoundOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputValue1[4];
@@ -304,6 +427,20 @@ void MathLessThanOperation::executePixelSampled(float output[4], float x, float
 	clampIfNeeded(output);
 }
 
+void MathLessThanOperation::executeRect(float *output, float **inputs, int numberOfPixels)
+{
+	int i;
+
+	for (i = 0; i < numberOfPixels; i++) {
+		const float value1 = inputs[0][i * COM_NUMBER_OF_CHANNELS];
+		const float value2 = inputs[1][i * COM_NUMBER_OF_CHANNELS];
+
+		output[i * COM_NUMBER_OF_CHANNELS] = value1 < value2 ? 1.0f : 0.0f;
+	}
+
+	clampRectIfNeeded(output, numberOfPixels);
+}
+
 void MathGreaterThanOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputValue1[4];
@@ -317,6 +454,20 @@ void MathGreaterThanOperation::executePixelSampled(float output[4], float x, flo
 	clampIfNeeded(output);
 }
 
+void MathGreaterThanOperation::executeRect(float *output, float **inputs, int numberOfPixels)
+{
+	int i;
+
+	for (i = 0; i < numberOfPixels; i++) {
+		const float value1 = inputs[0][i * COM_NUMBER_OF_CHANNELS];
+		const float value2 = inputs[1][i * COM_NUMBER_OF_CHANNELS];
+
+		output[i * COM_NUMBER_OF_CHANNELS] = value1 > value2 ? 1.0f : 0.0f;
+	}
+
+	clampRectIfNeeded(output, numberOfPixels);
+}
+
 void MathModuloOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputValue1[4];
@@ -129,6 +129,28 @@ void MixAddOperation::executePixelSampled(float output[4], float x, float y, Pix
 	clampIfNeeded(output);
 }
 
+void MixAddOperation::executeRect(float *output, float **inputs, int numberOfPixels)
+{
+	int i;
+
+	for (i = 0; i < numberOfPixels; i++) {
+		const float *inputColor1 = &inputs[1][i * COM_NUMBER_OF_CHANNELS];
+		const float *inputColor2 = &inputs[2][i * COM_NUMBER_OF_CHANNELS];
+		float *color = &output[i * COM_NUMBER_OF_CHANNELS];
+
+		float value = inputs[0][i * COM_NUMBER_OF_CHANNELS];
+		if (this->useValueAlphaMultiply()) {
+			value *= inputColor2[3];
+		}
+		color[0] = inputColor1[0] + value * inputColor2[0];
+		color[1] = inputColor1[1] + value * inputColor2[1];
+		color[2] = inputColor1[2] + value * inputColor2[2];
+		color[3] = inputColor1[3];
+	}
+
+	clampRectIfNeeded(output, numberOfPixels);
+}
+
 /* ******** Mix Blend Operation ******** */
 
 MixBlendOperation::MixBlendOperation() : MixBaseOperation()
@@ -160,6 +182,29 @@ void MixBlendOperation::executePixelSampled(float output[4], float x, float y, P
 	clampIfNeeded(output);
 }
 
+void MixBlendOperation::executeRect(float *output, float **inputs, int numberOfPixels)
+{
+	int i;
+
+	for (i = 0; i < numberOfPixels; i++) {
+		const float *inputColor1 = &inputs[1][i * COM_NUMBER_OF_CHANNELS];
+		const float *inputColor2 = &inputs[2][i * COM_NUMBER_OF_CHANNELS];
+		float *color = &output[i * COM_NUMBER_OF_CHANNELS];
+
+		float value = inputs[0][i * COM_NUMBER_OF_CHANNELS];
+		if (this->useValueAlphaMultiply()) {
+			value *= inputColor2[3];
+		}
+		float valuem = 1.0f - value;
+		color[0] = valuem * (inputColor1[0]) + value * (inputColor2[0]);
+		color[1] = valuem * (inputColor1[1]) + value * (inputColor2[1]);
+		color[2] = valuem * (inputColor1[2]) + value * (inputColor2[2]);
+		color[3] = inputColor1[3];
+	}
+
+	clampRectIfNeeded(output, numberOfPixels);
+}
+
 /* ******** Mix Burn Operation ******** */
 
 MixBurnOperation::MixBurnOperation() : MixBaseOperation()
@@ -308,6 +353,33 @@ void MixDarkenOperation::executePixelSampled(float output[4], float x, float y,
 	clampIfNeeded(output);
 }
 
+void MixDarkenOperation::executeRect(float *output, float **inputs, int numberOfPixels)
+{
+	int i;
+
+	for (i = 0; i < numberOfPixels; i++) {
+		const float *inputColor1 = &inputs[1][i * COM_NUMBER_OF_CHANNELS];
+		const float *inputColor2 = &inputs[2][i * COM_NUMBER_OF_CHANNELS];
+		float *color = &output[i * COM_NUMBER_OF_CHANNELS];
+
+		float value = inputs[0][i * COM_NUMBER_OF_CHANNELS];
+		if (this->useValueAlphaMultiply()) {
+			value *= inputColor2[3];
+		}
+		float valuem = 1.0f - value;
+		float tmp;
+		tmp = inputColor2[0] + ((1.0f - inputColor2[0]) * valuem);
+		color[0] = (tmp < inputColor1[0]) ? tmp : inputColor1[0];
+		tmp = inputColor2[1] + ((1.0f - inputColor2[1]) * valuem);
+		color[1] = (tmp < inputColor1[1]) ? tmp : inputColor1[1];
+		tmp = inputColor2[2] + ((1.0f - inputColor2[2]) * valuem);
+		color[2] = (tmp < inputColor1[2]) ? tmp : inputColor1[2];
+		color[3] = inputColor1[3];
+	}
+
+	clampRectIfNeeded(output, numberOfPixels);
+}
+
 /* ******** Mix Difference Operation ******** */
 
 MixDifferenceOperation::MixDifferenceOperation() : MixBaseOperation()
@@ -338,6 +410,29 @@ void MixDifferenceOperation::executePixelSampled(float output[4], float x, float
 	clampIfNeeded(output);
 }
 
+void MixDifferenceOperation::executeRect(float *output, float **inputs, int numberOfPixels)
+{
+	int i;
+
+	for (i = 0; i < numberOfPixels; i++) {
+		const float *inputColor1 = &inputs[1][i * COM_NUMBER_OF_CHANNELS];
+		const float *inputColor2 = &inputs[2][i * COM_NUMBER_OF_CHANNELS];
+		float *color = &output[i * COM_NUMBER_OF_CHANNELS];
+
+		float value = inputs[0][i * COM_NUMBER_OF_CHANNELS];
+		if (this->useValueAlphaMultiply()) {
+			value *= inputColor2[3];
+		}
+		float valuem = 1.0f - value;
+		color[0] = valuem * inputColor1[0] + value * fabsf(inputColor1[0] - inputColor2[0]);
+		color[1] = valuem * inputColor1[1] + value * fabsf(inputColor1[1] - inputColor2[1]);
+		color[2] = valuem * inputColor1[2] + value * fabsf(inputColor1[2] - inputColor2[2]);
+		color[3] = inputColor1[3];
+	}
+
+	clampRectIfNeeded(output, numberOfPixels);
+}
+
 /* ******** Mix Difference Operation ******** */
 
 MixDivideOperation::MixDivideOperation() : MixBaseOperation()
@@ -379,6 +474,29 @@ void MixDivideOperation::executePixelSampled(float output[4], float x, float y,
 	clampIfNeeded(output);
 }
 
+void MixDivideOperation::executeRect(float *output, float **inputs, int numberOfPixels)
+{
+	int i;
+
+	for (i = 0; i < numberOfPixels; i++) {
+		const float *inputColor1 = &inputs[1][i * COM_NUMBER_OF_CHANNELS];
+		const float *inputColor2 = &inputs[2][i * COM_NUMBER_OF_CHANNELS];
+		float *color = &output[i * COM_NUMBER_OF_CHANNELS];
+
+		float value = inputs[0][i * COM_NUMBER_OF_CHANNELS];
+		if (this->useValueAlphaMultiply()) {
+			value *= inputColor2[3];
+		}
+		float valuem = 1.0f - value;
+		color[0] = (inputColor2[0] != 0.0f) ? valuem * (inputColor1[0]) + value * (inputColor1[0]) / inputColor2[0] : 0.0f;
+		color[1] = (inputColor2[1] != 0.0f) ? valuem * (inputColor1[1]) + value * (inputColor1[1]) / inputColor2[1] : 0.0f;
+		color[2] = (inputColor2[2] != 0.0f) ? valuem * (inputColor1[2]) + value * (inputColor1[2]) / inputColor2[2] : 0.0f;
+		color[3] = inputColor1[3];
+	}
+
+	clampRectIfNeeded(output, numberOfPixels);
+}
+
 /* ******** Mix Dodge Operation ******** */
 
 MixDodgeOperation::MixDodgeOperation() : MixBaseOperation()
@@ -562,6 +680,32 @@ void MixLightenOperation::executePixelSampled(float output[4], float x, float y,
 	clampIfNeeded(output);
 }
 
+void MixLightenOperation::executeRect(float *output, float **inputs, int numberOfPixels)
+{
+	int i;
+
+	for (i = 0; i < numberOfPixels; i++) {
+		const float *inputColor1 = &inputs[1][i * COM_NUMBER_OF_CHANNELS];
+		const float *inputColor2 = &inputs[2][i * COM_NUMBER_OF_CHANNELS];
+		float *color = &output[i * COM_NUMBER_OF_CHANNELS];
+
+		float value = inputs[0][i * COM_NUMBER_OF_CHANNELS];
+		if (this->useValueAlphaMultiply()) {
+			value *= inputColor2[3];
+		}
+		float tmp;
+		tmp = value * inputColor2[0];
+		color[0] = (tmp > inputColor1[0]) ? tmp : inputColor1[0];
+		tmp = value * inputColor2[1];
+		color[1] = (tmp > inputColor1[1]) ? tmp : inputColor1[1];
+		tmp = value * inputColor2[2];
+		color[2] = (tmp > inputColor1[2]) ? tmp : inputColor1[2];
+		color[3] = inputColor1[3];
+	}
+
+	clampRectIfNeeded(output, numberOfPixels);
+}
+
 /* ******** Mix Linear Light Operation ******** */
 
 MixLinearLightOperation::MixLinearLightOperation() : MixBaseOperation()
@@ -631,6 +775,29 @@ void MixMultiplyOperation::executePixelSampled(float output[4], float x, float y
 	clampIfNeeded(output);
 }
 
+void MixMultiplyOperation::executeRect(float *output, float **inputs, int numberOfPixels)
+{
+	int i;
+
+	for (i = 0; i < numberOfPixels; i++) {
+		const float *inputColor1 = &inputs[1][i * COM_NUMBER_OF_CHANNELS];
+		const float *inputColor2 = &inputs[2][i * COM_NUMBER_OF_CHANNELS];
+		float *color = &output[i * COM_NUMBER_OF_CHANNELS];
+
+		float value = inputs[0][i * COM_NUMBER_OF_CHANNELS];
+		if (this->useValueAlphaMultiply()) {
+			value *= inputColor2[3];
+		}
+		float valuem = 1.0f - value;
+		color[0] = inputColor1[0] * (valuem + value * inputColor2[0]);
+		color[1] = inputColor1[1] * (valuem + value * inputColor2[1]);
+		color[2] = inputColor1[2] * (valuem + value * inputColor2[2]);
+		color[3] = inputColor1[3];
+	}
+
+	clampRectIfNeeded(output, numberOfPixels);
+}
+
 /* ******** Mix Ovelray Operation ******** */
 
 MixOverlayOperation::MixOverlayOperation() : MixBaseOperation()
@@ -748,6 +915,29 @@ void MixScreenOperation::executePixelSampled(float output[4], float x, float y,
 	clampIfNeeded(output);
 }
 
+void MixScreenOperation::executeRect(float *output, float **inputs, int numberOfPixels)
+{
+	int i;
+
+	for (i = 0; i < numberOfPixels; i++) {
+		const float *inputColor1 = &inputs[1][i * COM_NUMBER_OF_CHANNELS];
+		const float *inputColor2 = &inputs[2][i * COM_NUMBER_OF_CHANNELS];
+		float *color = &output[i * COM_NUMBER_OF_CHANNELS];
+
+		float value = inputs[0][i * COM_NUMBER_OF_CHANNELS];
+		if (this->useValueAlphaMultiply()) {
+			value *= inputColor2[3];
+		}
+		float valuem = 1.0f - value;
+		color[0] = 1.0f - (valuem + value * (1.0f - inputColor2[0])) * (1.0f - inputColor1[0]);
+		color[1] = 1.0f - (valuem + value * (1.0f - inputColor2[1])) * (1.0f - inputColor1[1]);
+		color[2] = 1.0f - (valuem + value * (1.0f - inputColor2[2])) * (1.0f - inputColor1[2]);
+		color[3] = inputColor1[3];
+	}
+
+	clampRectIfNeeded(output, numberOfPixels);
+}
+
 /* ******** Mix Soft Light Operation ******** */
 
 MixSoftLightOperation::MixSoftLightOperation() : MixBaseOperation()
@@ -814,6 +1004,28 @@ void MixSubtractOperation::executePixelSampled(float output[4], float x, float y
 	clampIfNeeded(output);
 }
 
+void MixSubtractOperation::executeRect(float *output, float **inputs, int numberOfPixels)
+{
+	int i;
+
+	for (i = 0; i < numberOfPixels; i++) {
+		const float *inputColor1 = &inputs[1][i * COM_NUMBER_OF_CHANNELS];
+		const float *inputColor2 = &inputs[2][i * COM_NUMBER_OF_CHANNELS];
+		float *color = &output[i * COM_NUMBER_OF_CHANNELS];
+
+		float value = inputs[0][i * COM_NUMBER_OF_CHANNELS];
+		if (this->useValueAlphaMultiply()) {
+			value *= inputColor2[3];
+		}
+		color[0] = inputColor1[0] - value * (inputColor2[0]);
+		color[1] = inputColor1[1] - value * (inputColor2[1]);
+		color[2] = inputColor1[2] - value * (inputColor2[2]);
+		color[3] = inputColor1[3];
+	}
+
+	clampRectIfNeeded(output, numberOfPixels);
+}
+
 /* ******** Mix Value Operation ******** */
 
 MixValueOperation::MixValueOperation() : MixBaseOperation()
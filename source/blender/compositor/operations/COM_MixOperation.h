@@ -50,6 +50,16 @@ protected:
 			CLAMP(color[3], 0.0f, 1.0f);
 		}
 	}
+
+	inline void clampRectIfNeeded(float *output, int numberOfPixels)
+	{
+		if (m_useClamp) {
+			int i;
+			for (i = 0; i < numberOfPixels * COM_NUMBER_OF_CHANNELS; i++) {
+				CLAMP(output[i], 0.0f, 1.0f);
+			}
+		}
+	}
 	
 public:
 	/**
@@ -84,12 +94,16 @@ class MixAddOperation : public MixBaseOperation {
 public:
 	MixAddOperation();
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	bool isRectKernel() const { return true; }
+	void executeRect(float *output, float **inputs, int numberOfPixels);
 };
 
 class MixBlendOperation : public MixBaseOperation {
 public:
 	MixBlendOperation();
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	bool isRectKernel() const { return true; }
+	void executeRect(float *output, float **inputs, int numberOfPixels);
 };
 
 class MixBurnOperation : public MixBaseOperation {
@@ -108,18 +122,24 @@ class MixDarkenOperation : public MixBaseOperation {
 public:
 	MixDarkenOperation();
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	bool isRectKernel() const { return true; }
+	void executeRect(float *output, float **inputs, int numberOfPixels);
 };
 
 class MixDifferenceOperation : public MixBaseOperation {
 public:
 	MixDifferenceOperation();
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	bool isRectKernel() const { return true; }
+	void executeRect(float *output, float **inputs, int numberOfPixels);
 };
 
 class MixDivideOperation : public MixBaseOperation {
 public:
 	MixDivideOperation();
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	bool isRectKernel() const { return true; }
+	void executeRect(float *output, float **inputs, int numberOfPixels);
 };
 
 class MixDodgeOperation : public MixBaseOperation {
@@ -144,6 +164,8 @@ class MixLightenOperation : public MixBaseOperation {
 public:
 	MixLightenOperation();
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	bool isRectKernel() const { return true; }
+	void executeRect(float *output, float **inputs, int numberOfPixels);
 };
 
 class MixLinearLightOperation : public MixBaseOperation {
@@ -156,6 +178,8 @@ class MixMultiplyOperation : public MixBaseOperation {
 public:
 	MixMultiplyOperation();
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	bool isRectKernel() const { return true; }
+	void executeRect(float *output, float **inputs, int numberOfPixels);
 };
 
 class MixOverlayOperation : public MixBaseOperation {
@@ -174,6 +198,8 @@ class MixScreenOperation : public MixBaseOperation {
 public:
 	MixScreenOperation();
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	bool isRectKernel() const { return true; }
+	void executeRect(float *output, float **inputs, int numberOfPixels);
 };
 
 class MixSoftLightOperation : public MixBaseOperation {
@@ -186,6 +212,8 @@ class MixSubtractOperation : public MixBaseOperation {
 public:
 	MixSubtractOperation();
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	bool isRectKernel() const { return true; }
+	void executeRect(float *output, float **inputs, int numberOfPixels);
 };
 
 class MixValueOperation : public MixBaseOperation {
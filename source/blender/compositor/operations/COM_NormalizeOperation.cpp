@@ -89,6 +89,7 @@ void *NormalizeOperation::initializeTileData(rcti *rect)
 		NodeTwoFloats *minmult = new NodeTwoFloats();
 
 		float *buffer = tile->getBuffer();
+		const int numChannels = tile->getNumberOfChannels();
 		int p = tile->getWidth() * tile->getHeight();
 		float *bc = buffer;
 
@@ -104,7 +105,7 @@ void *NormalizeOperation::initializeTileData(rcti *rect)
 			if ((value < minv) && (value >= -BLENDER_ZMAX)) {
 				minv = value;
 			}
-			bc += 4;
+			bc += numChannels;
 		}
 
 		minmult->x = minv;
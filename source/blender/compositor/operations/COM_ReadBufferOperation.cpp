@@ -92,6 +92,22 @@ void ReadBufferOperation::executePixelFiltered(float output[4], float x, float y
 	}
 }
 
+void ReadBufferOperation::readRow(float *output, int x, int y, int width)
+{
+	if (m_single_value) {
+		/* write buffer has a single value stored at (0,0) */
+		float value[4];
+		int i;
+		m_buffer->read(value, 0, 0);
+		for (i = 0; i < width; i++) {
+			copy_v4_v4(&output[i * COM_NUMBER_OF_CHANNELS], value);
+		}
+	}
+	else {
+		m_buffer->readRow(output, x, y, width);
+	}
+}
+
 bool ReadBufferOperation::determineDependingAreaOfInterest(rcti *input, ReadBufferOperation *readOperation, rcti *output)
 {
 	if (this == readOperation) {
@@ -104,6 +104,7 @@ public:
 	short getLayerId() { return this->m_layerId; }
 	void setViewId(short viewId) { this->m_viewId = viewId; }
 	short getViewId() { return this->m_viewId; }
+	bool isViewDependent() const { return true; }
 	void initExecution();
 	void deinitExecution();
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
@@ -48,6 +48,18 @@ void SetAlphaOperation::executePixelSampled(float output[4], float x, float y, P
 	output[3] = alphaInput[0];
 }
 
+void SetAlphaOperation::executeRect(float *output, float **inputs, int numberOfPixels)
+{
+	int i;
+
+	for (i = 0; i < numberOfPixels; i++) {
+		float *color = &output[i * COM_NUMBER_OF_CHANNELS];
+
+		copy_v3_v3(color, &inputs[0][i * COM_NUMBER_OF_CHANNELS]);
+		color[3] = inputs[1][i * COM_NUMBER_OF_CHANNELS];
+	}
+}
+
 void SetAlphaOperation::deinitExecution()
 {
 	this->m_inputColor = NULL;
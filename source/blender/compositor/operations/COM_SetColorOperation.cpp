@@ -32,6 +32,15 @@ void SetColorOperation::executePixelSampled(float output[4], float x, float y, P
 	copy_v4_v4(output, this->m_color);
 }
 
+void SetColorOperation::executeRect(float *output, float **inputs, int numberOfPixels)
+{
+	int i;
+
+	for (i = 0; i < numberOfPixels; i++) {
+		copy_v4_v4(&output[i * COM_NUMBER_OF_CHANNELS], this->m_color);
+	}
+}
+
 void SetColorOperation::determineResolution(unsigned int resolution[2], unsigned int preferredResolution[2])
 {
 	resolution[0] = preferredResolution[0];
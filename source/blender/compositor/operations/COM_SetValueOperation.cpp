@@ -32,6 +32,15 @@ void SetValueOperation::executePixelSampled(float output[4], float x, float y, P
 	output[0] = this->m_value;
 }
 
+void SetValueOperation::executeRect(float *output, float **inputs, int numberOfPixels)
+{
+	int i;
+
+	for (i = 0; i < numberOfPixels; i++) {
+		output[i * COM_NUMBER_OF_CHANNELS] = this->m_value;
+	}
+}
+
 void SetValueOperation::determineResolution(unsigned int resolution[2], unsigned int preferredResolution[2])
 {
 	resolution[0] = preferredResolution[0];
@@ -36,6 +36,20 @@ void SetVectorOperation::executePixelSampled(float output[4], float x, float y,
 	output[3] = this->m_w;
 }
 
+void SetVectorOperation::executeRect(float *output, float **inputs, int numberOfPixels)
+{
+	int i;
+
+	for (i = 0; i < numberOfPixels; i++) {
+		float *vector = &output[i * COM_NUMBER_OF_CHANNELS];
+
+		vector[0] = this->m_x;
+		vector[1] = this->m_y;
+		vector[2] = this->m_z;
+		vector[3] = this->m_w;
+	}
+}
+
 void SetVectorOperation::determineResolution(unsigned int resolution[2], unsigned int preferredResolution[2])
 {
 	resolution[0] = preferredResolution[0];
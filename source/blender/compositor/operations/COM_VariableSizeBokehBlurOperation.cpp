@@ -24,6 +24,10 @@
 #include "BLI_math.h"
 #include "COM_OpenCLDevice.h"
 
+#ifdef __SSE__
+#  include <xmmintrin.h>
+#endif
+
 extern "C" {
 	#include "RE_pipeline.h"
 }
@@ -137,16 +141,25 @@ void VariableSizeBokehBlurOperation::executePixel(float output[4], int x, int y,
 		copy_v4_fl(multiplier_accum, 1.0f);
 		float size_center = tempSize[0] * scalar;
 		
+		/* the size buffer has a single channel */
+		const int sizeChannels = inputSizeBuffer->getNumberOfChannels();
 		const int addXStep = QualityStepHelper::getStep() * COM_NUMBER_OF_CHANNELS;
+		const int addSizeXStep = QualityStepHelper::getStep() * sizeChannels;
 		
 		if (size_center > this->m_threshold) {
+#ifdef __SSE__
+			/* all channels of a pixel are accumulated in a single register */
+			__m128 color_accum_sse = _mm_loadu_ps(color_accum);
+			__m128 multiplier_accum_sse = _mm_loadu_ps(multiplier_accum);
+#endif
 			for (int ny = miny; ny < maxy; ny += QualityStepHelper::getStep()) {
 				float dy = ny - y;
-				int offsetNy = ny * inputSizeBuffer->getWidth() * COM_NUMBER_OF_CHANNELS;
-				int offsetNxNy = offsetNy + (minx * COM_NUMBER_OF_CHANNELS);
+				int offsetNy = ny * inputSizeBuffer->getWidth();
+				int offsetNxNy = (offsetNy + minx) * COM_NUMBER_OF_CHANNELS;
+				int sizeOffsetNxNy = (offsetNy + minx) * sizeChannels;
 				for (int nx = minx; nx < maxx; nx += QualityStepHelper::getStep()) {
 					if (nx != x || ny != y) {
-						float size = min(inputSizeFloatBuffer[offsetNxNy] * scalar, size_center);
+						float size = min(inputSizeFloatBuffer[sizeOffsetNxNy] * scalar, size_center);
 						if (size > this->m_threshold) {
 							float dx = nx - x;
 							if (size > fabsf(dx) && size > fabsf(dy)) {
@@ -154,14 +167,25 @@ void VariableSizeBokehBlurOperation::executePixel(float output[4], int x, int y,
 								    (float)(COM_BLUR_BOKEH_PIXELS / 2) + (dx / size) * (float)((COM_BLUR_BOKEH_PIXELS / 2) - 1),
 								    (float)(COM_BLUR_BOKEH_PIXELS / 2) + (dy / size) * (float)((COM_BLUR_BOKEH_PIXELS / 2) - 1)};
 								inputBokehBuffer->readNoCheck(bokeh, uv[0], uv[1]);
+#ifdef __SSE__
+								const __m128 bokeh_sse = _mm_loadu_ps(bokeh);
+								color_accum_sse = _mm_add_ps(color_accum_sse, _mm_mul_ps(bokeh_sse, _mm_loadu_ps(&inputProgramFloatBuffer[offsetNxNy])));
+								multiplier_accum_sse = _mm_add_ps(multiplier_accum_sse, bokeh_sse);
+#else
 								madd_v4_v4v4(color_accum, bokeh, &inputProgramFloatBuffer[offsetNxNy]);
 								add_v4_v4(multiplier_accum, bokeh);
+#endif
 							}
 						}
 					}
 					offsetNxNy += addXStep;
+					sizeOffsetNxNy += addSizeXStep;
 				}
 			}
+#ifdef __SSE__
+			_mm_storeu_ps(color_accum, color_accum_sse);
+			_mm_storeu_ps(multiplier_accum, multiplier_accum_sse);
+#endif
 		}
 
 		output[0] = color_accum[0] / multiplier_accum[0];
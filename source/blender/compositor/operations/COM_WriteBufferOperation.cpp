@@ -24,6 +24,8 @@
 #include "COM_defines.h"
 #include <stdio.h>
 #include "COM_OpenCLDevice.h"
+#include "COM_BufferCache.h"
+#include "MEM_guardedalloc.h"
 
 WriteBufferOperation::WriteBufferOperation() : NodeOperation()
 {
@@ -31,6 +33,7 @@ WriteBufferOperation::WriteBufferOperation() : NodeOperation()
 	this->m_memoryProxy = new MemoryProxy();
 	this->m_memoryProxy->setWriteBufferOperation(this);
 	this->m_memoryProxy->setExecutor(NULL);
+	this->m_cacheKey = 0;
 }
 WriteBufferOperation::~WriteBufferOperation()
 {
@@ -47,20 +50,41 @@ void WriteBufferOperation::executePixelSampled(float output[4], float x, float y
 
 void WriteBufferOperation::initExecution()
 {
+	MemoryBuffer *cachedBuffer = NULL;
+
 	this->m_input = this->getInputOperation(0);
-	this->m_memoryProxy->allocate(this->m_width, this->m_height);
+	if (this->m_cacheKey) {
+		cachedBuffer = BufferCache::acquire(this);
+	}
+
+	if (cachedBuffer) {
+		this->m_memoryProxy->setBuffer(cachedBuffer);
+	}
+	else {
+		this->m_memoryProxy->allocate(this->m_width, this->m_height);
+	}
 }
 
 void WriteBufferOperation::deinitExecution()
 {
 	this->m_input = NULL;
-	this->m_memoryProxy->free();
+	if (this->m_cacheKey) {
+		/* the buffer is owned by the cache */
+		BufferCache::release(this, this->m_memoryProxy->getBuffer());
+		this->m_memoryProxy->setBuffer(NULL);
+	}
+	else {
+		this->m_memoryProxy->free();
+	}
 }
 
 void WriteBufferOperation::executeRegion(rcti *rect, unsigned int tileNumber)
 {
 	MemoryBuffer *memoryBuffer = this->m_memoryProxy->getBuffer();
 	float *buffer = memoryBuffer->getBuffer();
+	const int numChannels = memoryBuffer->getNumberOfChannels();
+	ExecutionGroup *executionGroup = this->m_memoryProxy->getExecutor();
+	float color[4];
 	if (this->m_input->isComplex()) {
 		void *data = this->m_input->initializeTileData(rect);
 		int x1 = rect->xmin;
@@ -71,10 +95,11 @@ void WriteBufferOperation::executeRegion(rcti *rect, unsigned int tileNumber)
 		int y;
 		bool breaked = false;
 		for (y = y1; y < y2 && (!breaked); y++) {
-			int offset4 = (y * memoryBuffer->getWidth() + x1) * COM_NUMBER_OF_CHANNELS;
+			int offset = (y * memoryBuffer->getWidth() + x1) * numChannels;
 			for (x = x1; x < x2; x++) {
-				this->m_input->read(&(buffer[offset4]), x, y, data);
-				offset4 += COM_NUMBER_OF_CHANNELS;
+				this->m_input->read(color, x, y, data);
+				memcpy(&buffer[offset], color, sizeof(float) * numChannels);
+				offset += numChannels;
 			}
 			if (isBreaked()) {
 				breaked = true;
@@ -86,6 +111,44 @@ void WriteBufferOperation::executeRegion(rcti *rect, unsigned int tileNumber)
 			data = NULL;
 		}
 	}
+	else if (executionGroup && executionGroup->hasRectKernels()) {
+		/* the operations writing to this buffer are fused, calculate a row at a time */
+		int x1 = rect->xmin;
+		int y1 = rect->ymin;
+		int x2 = rect->xmax;
+		int y2 = rect->ymax;
+		float *rows = executionGroup->allocateRectKernelRows(x2 - x1);
+		float *outputRow = NULL;
+
+		/* rect kernels calculate 4 channels per pixel */
+		if (numChannels != COM_NUMBER_OF_CHANNELS) {
+			outputRow = (float *)MEM_mallocN(sizeof(float) * COM_NUMBER_OF_CHANNELS * (x2 - x1), __func__);
+		}
+
+		int x;
+		int y;
+		bool breaked = false;
+		for (y = y1; y < y2 && (!breaked); y++) {
+			int offset = (y * memoryBuffer->getWidth() + x1) * numChannels;
+			if (outputRow) {
+				executionGroup->executeRectKernels(outputRow, rows, x1, y, x2 - x1);
+				for (x = 0; x < x2 - x1; x++) {
+					memcpy(&buffer[offset], &outputRow[x * COM_NUMBER_OF_CHANNELS], sizeof(float) * numChannels);
+					offset += numChannels;
+				}
+			}
+			else {
+				executionGroup->executeRectKernels(&(buffer[offset]), rows, x1, y, x2 - x1);
+			}
+			if (isBreaked()) {
+				breaked = true;
+			}
+		}
+		if (outputRow) {
+			MEM_freeN(outputRow);
+		}
+		MEM_freeN(rows);
+	}
 	else {
 		int x1 = rect->xmin;
 		int y1 = rect->ymin;
@@ -96,10 +159,11 @@ void WriteBufferOperation::executeRegion(rcti *rect, unsigned int tileNumber)
 		int y;
 		bool breaked = false;
 		for (y = y1; y < y2 && (!breaked); y++) {
-			int offset4 = (y * memoryBuffer->getWidth() + x1) * COM_NUMBER_OF_CHANNELS;
+			int offset = (y * memoryBuffer->getWidth() + x1) * numChannels;
 			for (x = x1; x < x2; x++) {
-				this->m_input->readSampled(&(buffer[offset4]), x, y, COM_PS_NEAREST);
-				offset4 += COM_NUMBER_OF_CHANNELS;
+				this->m_input->readSampled(color, x, y, COM_PS_NEAREST);
+				memcpy(&buffer[offset], color, sizeof(float) * numChannels);
+				offset += numChannels;
 			}
 			if (isBreaked()) {
 				breaked = true;
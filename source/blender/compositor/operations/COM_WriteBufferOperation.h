@@ -26,6 +26,9 @@
 #include "COM_NodeOperation.h"
 #include "COM_MemoryProxy.h"
 #include "COM_SocketReader.h"
+
+#include "BLI_sys_types.h"
+
 /**
  * @brief Operation to write to a tile
  * @ingroup Operation
@@ -34,6 +37,12 @@ class WriteBufferOperation : public NodeOperation {
 	MemoryProxy *m_memoryProxy;
 	bool m_single_value; /* single value stored in buffer */
 	NodeOperation *m_input;
+
+	/**
+	 * @brief key of the buffer in the BufferCache, 0 when the buffer isn't cached
+	 * @see BufferCache
+	 */
+	uint64_t m_cacheKey;
 public:
 	WriteBufferOperation();
 	~WriteBufferOperation();
@@ -42,6 +51,8 @@ public:
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
 	const bool isWriteBufferOperation() const { return true; }
 	bool isSingleValue() const { return m_single_value; }
+	void setCacheKey(uint64_t key) { this->m_cacheKey = key; }
+	uint64_t getCacheKey() const { return this->m_cacheKey; }
 	
 	void executeRegion(rcti *rect, unsigned int tileNumber);
 	void initExecution();
@@ -0,0 +1,227 @@
+/*
+ * Copyright 2013, Blender Foundation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * Benchmark of the gaussian and fast gaussian blur operations.
+ *
+ * Usage: blurbench [width] [height] [size] [runs] [threads]
+ *
+ * A noisy color image is blurred with the given size in pixels, by the
+ * GaussianXBlurOperation and GaussianYBlurOperation pixel by pixel, like a
+ * compositor chunk does, and by the IIR_gauss passes of the fast gaussian
+ * blur, which are divided over the threads of the task scheduler. Printed
+ * are the best times and the megapixels per second of every blur.
+ *
+ * The SSE accumulation of the gaussian blurs is used when the compiler
+ * defines __SSE__, compare with a build with -U__SSE__ for the scalar code.
+ * Compare runs with 1 and more threads for the fast gaussian speedup.
+ */
+
+/* To compile run:
+ * gcc -O2 -c -D__LITTLE_ENDIAN__ -DWITH_BOOL_COMPAT -D__BLI_STRICT_FLAGS_H__ \
+ *     -I../../../blenlib -I../../../makesdna -I../../../../../intern/guardedalloc -I../../../../../intern/atomic \
+ *     ../../../blenlib/intern/{listbase,gsqueue,task,threads,time,rct}.c \
+ *     ../../../blenlib/intern/{math_base,math_base_inline,math_vector,math_vector_inline}.c \
+ *     ../../../../../intern/guardedalloc/intern/mallocn*.c
+ * g++ -O2 -D__LITTLE_ENDIAN__ -DWITH_BOOL_COMPAT \
+ *     -I../.. -I../../intern -I../../operations -I../../nodes -I../../../blenlib -I../../../blenkernel \
+ *     -I../../../makesdna -I../../../makesrna -I../../../makesrna/intern -I../../../imbuf \
+ *     -I../../../render/extern/include -I../../../windowmanager -I../../../../../intern/opencl \
+ *     -I../../../../../intern/guardedalloc blurbench.cpp \
+ *     ../../intern/COM_{NodeBase,NodeOperation,Socket,InputSocket,OutputSocket,SocketConnection}.cpp \
+ *     ../../intern/COM_{SocketReader,MemoryBuffer,MemoryProxy}.cpp \
+ *     ../../operations/COM_{BlurBaseOperation,QualityStepHelper,FastGaussianBlurOperation}.cpp \
+ *     ../../operations/COM_{GaussianXBlurOperation,GaussianYBlurOperation}.cpp \
+ *     *.o -lpthread -o blurbench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "COM_ExecutionSystem.h"
+#include "COM_MemoryBuffer.h"
+#include "COM_Node.h"
+#include "COM_FastGaussianBlurOperation.h"
+#include "COM_GaussianXBlurOperation.h"
+#include "COM_GaussianYBlurOperation.h"
+
+extern "C" {
+#include "BLI_task.h"
+#include "BLI_threads.h"
+#include "PIL_time.h"
+#include "RE_pipeline.h"
+#include "RNA_access.h"
+#include "rna_internal_types.h"
+#include "DNA_scene_types.h"
+}
+
+static void fill_image(MemoryBuffer *buffer)
+{
+	const int width = buffer->getWidth(), height = buffer->getHeight();
+	unsigned int seed = 1;
+
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			float color[4];
+
+			for (int c = 0; c < 4; c++) {
+				seed = seed * 1103515245u + 12345u;
+				color[c] = (float)((seed >> 8) & 0xFFFF) / (float)0xFFFF;
+			}
+			buffer->writePixel(x, y, color);
+		}
+	}
+}
+
+/* evaluate a complex operation for every pixel of an input buffer */
+static double run_complex(NodeOperation *operation, MemoryBuffer *input, MemoryBuffer *output)
+{
+	const int width = output->getWidth(), height = output->getHeight();
+	double start = PIL_check_seconds_timer();
+	float color[4];
+
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			operation->read(color, x, y, input);
+			output->writePixel(x, y, color);
+		}
+	}
+
+	return PIL_check_seconds_timer() - start;
+}
+
+static double run_fast_gaussian(MemoryBuffer *input, MemoryBuffer *output, float sigma)
+{
+	double start = PIL_check_seconds_timer();
+
+	output->copyContentFrom(input);
+	for (int c = 0; c < COM_NUMBER_OF_CHANNELS; c++)
+		FastGaussianBlurOperation::IIR_gauss(output, sigma, c, 3);
+
+	return PIL_check_seconds_timer() - start;
+}
+
+static void print_result(const char *name, double best, int width, int height)
+{
+	printf("%-16s %10.4f %10.1f\n", name, best, (double)width * height / best / 1e6);
+}
+
+/* the sockets link to the node tree and execution system, which the benchmark doesn't use */
+void Node::addSetValueOperation(ExecutionSystem *graph, InputSocket *inputsocket, int editorNodeInputSocketIndex) {}
+void Node::addSetColorOperation(ExecutionSystem *graph, InputSocket *inputsocket, int editorNodeInputSocketIndex) {}
+void Node::addSetVectorOperation(ExecutionSystem *graph, InputSocket *inputsocket, int editorNodeInputSocketIndex) {}
+void ExecutionSystem::addSocketConnection(SocketConnection *connection) {}
+void ExecutionSystem::removeSocketConnection(SocketConnection *connection) {}
+
+extern "C" {
+StructRNA RNA_NodeSocket;
+void RNA_pointer_create(ID *id, StructRNA *type, void *data, PointerRNA *r_ptr) {}
+float RNA_float_get(PointerRNA *ptr, const char *name) { return 0.0f; }
+void RNA_float_get_array(PointerRNA *ptr, const char *name, float *values) {}
+
+/* the gauss filter of RE_filter_value in initrender.c, the only filter used here */
+float RE_filter_value(int type, float x)
+{
+	const float gaussfac = 1.6f;
+
+	x = fabsf(x) * gaussfac;
+	return (1.0f / expf(x * x) - 1.0f / expf(gaussfac * gaussfac * 2.25f));
+}
+}
+
+int main(int argc, char **argv)
+{
+	int width = (argc > 1) ? atoi(argv[1]) : 1920;
+	int height = (argc > 2) ? atoi(argv[2]) : 1080;
+	int size = (argc > 3) ? atoi(argv[3]) : 20;
+	int runs = (argc > 4) ? atoi(argv[4]) : 3;
+	int threads = (argc > 5) ? atoi(argv[5]) : 0;
+
+	if (width <= 0 || height <= 0 || size <= 0 || runs <= 0 || threads < 0) {
+		printf("Usage: %s [width] [height] [size] [runs] [threads]\n", argv[0]);
+		return 1;
+	}
+
+	BLI_threadapi_init();
+	BLI_system_num_threads_override_set(threads);
+
+	rcti rect;
+	BLI_rcti_init(&rect, 0, width, 0, height);
+
+	MemoryBuffer *image = new MemoryBuffer(COM_DT_COLOR, &rect);
+	MemoryBuffer *blurred_x = new MemoryBuffer(COM_DT_COLOR, &rect);
+	MemoryBuffer *blurred = new MemoryBuffer(COM_DT_COLOR, &rect);
+	fill_image(image);
+
+	NodeBlurData data;
+	memset(&data, 0, sizeof(data));
+	data.sizex = size;
+	data.sizey = size;
+	data.filtertype = R_FILTER_GAUSS;
+
+	GaussianXBlurOperation blurx;
+	GaussianYBlurOperation blury;
+	NodeBlurData datax = data, datay = data;
+	unsigned int resolution[2] = {(unsigned int)width, (unsigned int)height};
+
+	blurx.setData(&datax);
+	blurx.setSize(1.0f);
+	blurx.setResolution(resolution);
+	blury.setData(&datay);
+	blury.setSize(1.0f);
+	blury.setResolution(resolution);
+
+	blurx.initExecution();
+	blury.initExecution();
+
+	double best[3];
+
+	for (int run = 0; run < runs; run++) {
+		double t[3];
+
+		t[0] = run_complex(&blurx, image, blurred_x);
+		t[1] = run_complex(&blury, blurred_x, blurred);
+		t[2] = run_fast_gaussian(image, blurred, size / 2.0f);
+
+		for (int i = 0; i < 3; i++)
+			best[i] = (run == 0) ? t[i] : min(best[i], t[i]);
+	}
+
+	printf("Blur %dx%d, size %d, %d threads, best of %d runs\n\n", width, height, size,
+	       BLI_task_scheduler_num_threads(BLI_task_scheduler_get()), runs);
+	printf("%-16s %10s %10s\n", "blur", "time (s)", "Mpixels/s");
+
+	print_result("gaussian x", best[0], width, height);
+	print_result("gaussian y", best[1], width, height);
+	print_result("fast gaussian", best[2], width, height);
+
+	blurx.deinitExecution();
+	blury.deinitExecution();
+
+	delete image;
+	delete blurred_x;
+	delete blurred;
+
+	BLI_threadapi_exit();
+
+	return 0;
+}
@@ -0,0 +1,142 @@
+/*
+ * Copyright 2013, Blender Foundation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * Test of the BufferCache keys of nodes using an ID block.
+ *
+ * Usage: buffercachetest
+ *
+ * A cached buffer is reused when its key didn't change, so every change of
+ * data a node reads must change the key (a cache miss), and unchanged data
+ * must give the same key (a cache hit). Returns non zero on failure.
+ */
+
+/* To compile run:
+ * g++ -I../../intern -I../../../blenlib -I../../../makesdna -I../../../../../intern/guardedalloc \
+ *     buffercachetest.cpp ../../intern/COM_BufferCacheKey.cpp -o buffercachetest
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "COM_BufferCacheKey.h"
+
+extern "C" {
+#include "BLI_utildefines.h"
+#include "DNA_camera_types.h"
+#include "DNA_ID.h"
+#include "DNA_node_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+}
+
+static int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+	printf("%-48s %s\n", what, ok ? "ok" : "FAILED");
+	if (!ok)
+		failures++;
+}
+
+static uint64_t node_key(bNode *node)
+{
+	return BufferCacheKey::hashNodeID(BUFFER_CACHE_HASH_INIT, node);
+}
+
+static void init_camera(Object *ob, Camera *camera)
+{
+	memset(ob, 0, sizeof(*ob));
+	memset(camera, 0, sizeof(*camera));
+
+	strcpy(ob->id.name, "OBCamera");
+	ob->type = OB_CAMERA;
+	ob->data = camera;
+
+	strcpy(camera->id.name, "CACamera");
+	camera->lens = 35.0f;
+	camera->sensor_x = 32.0f;
+	camera->sensor_y = 18.0f;
+	camera->YF_dofdist = 10.0f;
+}
+
+int main(void)
+{
+	static Scene scene;
+	static Object camob, camob_other, dof_ob;
+	static Camera camera, camera_other;
+	static Image image;
+	static bNode node;
+	uint64_t key;
+
+	strcpy(scene.id.name, "SCScene");
+	strcpy(image.id.name, "IMImage");
+	init_camera(&camob, &camera);
+	init_camera(&camob_other, &camera_other);
+
+	/* defocus node */
+	node.id = &scene.id;
+	scene.camera = &camob;
+
+	check(BufferCacheKey::isCacheable(&node), "scene node is cacheable");
+
+	key = node_key(&node);
+	check(node_key(&node) == key, "unchanged camera hits");
+
+	camera.lens = 50.0f;
+	check(node_key(&node) != key, "camera lens change misses");
+	camera.lens = 35.0f;
+	check(node_key(&node) == key, "restored camera lens hits");
+
+	camera.YF_dofdist = 5.0f;
+	check(node_key(&node) != key, "dof distance change misses");
+	camera.YF_dofdist = 10.0f;
+
+	camera.sensor_x = 36.0f;
+	check(node_key(&node) != key, "sensor size change misses");
+	camera.sensor_x = 32.0f;
+
+	camera.dof_ob = &dof_ob;
+	check(node_key(&node) != key, "dof object change misses");
+	key = node_key(&node);
+	dof_ob.obmat[3][2] = 2.0f;
+	check(node_key(&node) != key, "dof object move misses");
+	camera.dof_ob = NULL;
+	key = node_key(&node);
+
+	camob.obmat[3][2] = 1.0f;
+	check(node_key(&node) != key, "camera move misses");
+	camob.obmat[3][2] = 0.0f;
+
+	scene.camera = &camob_other;
+	check(node_key(&node) != key, "active camera change misses");
+	scene.camera = NULL;
+	check(node_key(&node) != key, "scene without camera misses");
+	scene.camera = &camob;
+	check(node_key(&node) == key, "restored active camera hits");
+
+	/* images can change without the node changing */
+	node.id = &image.id;
+	check(!BufferCacheKey::isCacheable(&node), "image node is not cacheable");
+
+	node.id = NULL;
+	check(BufferCacheKey::isCacheable(&node), "node without ID block is cacheable");
+
+	printf("%d failures\n", failures);
+	return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,260 @@
+/*
+ * Copyright 2013, Blender Foundation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * Benchmark of the keying matte pipeline with value and color buffers.
+ *
+ * Usage: keyingbench [width] [height] [runs]
+ *
+ * A synthetic green screen image is keyed, the matte is blurred along X and
+ * Y and then clipped, using the keying operations and writing every step
+ * into a MemoryBuffer like the WriteBufferOperation does. The pipeline runs
+ * once with COM_DT_VALUE matte buffers (1 channel, what value sockets get)
+ * and once with COM_DT_COLOR matte buffers (4 channels, what every buffer
+ * used before). Printed are the best time of every step and the memory of
+ * the matte buffers. Both must give the same matte.
+ */
+
+/* To compile run:
+ * gcc -O2 -c -D__LITTLE_ENDIAN__ -DWITH_BOOL_COMPAT -D__BLI_STRICT_FLAGS_H__ \
+ *     -I../../../blenlib -I../../../makesdna -I../../../../../intern/guardedalloc -I../../../../../intern/atomic \
+ *     ../../../blenlib/intern/{listbase,gsqueue,task,threads,time,rct}.c \
+ *     ../../../blenlib/intern/{math_base,math_base_inline,math_vector,math_vector_inline}.c \
+ *     ../../../../../intern/guardedalloc/intern/mallocn*.c
+ * g++ -O2 -D__LITTLE_ENDIAN__ -DWITH_BOOL_COMPAT \
+ *     -I../.. -I../../intern -I../../operations -I../../nodes -I../../../blenlib -I../../../blenkernel \
+ *     -I../../../makesdna -I../../../makesrna -I../../../makesrna/intern -I../../../imbuf \
+ *     -I../../../render/extern/include -I../../../windowmanager -I../../../../../intern/opencl \
+ *     -I../../../../../intern/guardedalloc keyingbench.cpp \
+ *     ../../intern/COM_{NodeBase,NodeOperation,Socket,InputSocket,OutputSocket,SocketConnection}.cpp \
+ *     ../../intern/COM_{SocketReader,MemoryBuffer,MemoryProxy}.cpp \
+ *     ../../operations/COM_{KeyingOperation,KeyingBlurOperation,KeyingClipOperation,SetColorOperation}.cpp \
+ *     *.o -lpthread -o keyingbench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "COM_ExecutionSystem.h"
+#include "COM_MemoryBuffer.h"
+#include "COM_Node.h"
+#include "COM_SocketConnection.h"
+#include "COM_SetColorOperation.h"
+#include "COM_KeyingOperation.h"
+#include "COM_KeyingBlurOperation.h"
+#include "COM_KeyingClipOperation.h"
+
+extern "C" {
+#include "PIL_time.h"
+#include "RNA_access.h"
+#include "rna_internal_types.h"
+}
+
+#define NUM_STEPS 4
+
+static const char *step_names[NUM_STEPS] = {"keying", "blur x", "blur y", "clip"};
+
+/* green screen with a lit subject in front of it, its edges and some noise */
+class GreenScreenOperation : public NodeOperation {
+public:
+	GreenScreenOperation(int width, int height)
+	{
+		this->addOutputSocket(COM_DT_COLOR);
+		this->setWidth(width);
+		this->setHeight(height);
+	}
+
+	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+	{
+		const float cx = x / getWidth() - 0.5f, cy = y / getHeight() - 0.5f;
+		const float dist = sqrtf(cx * cx + cy * cy);
+		const unsigned int hash = ((unsigned int)x * 73856093u) ^ ((unsigned int)y * 19349663u);
+		const float noise = (float)(hash % 1024) / 1024.0f * 0.05f;
+		/* subject coverage, with a soft edge */
+		const float subject = min_ff(max_ff((0.3f - dist) * 50.0f, 0.0f), 1.0f);
+
+		output[0] = 0.1f + noise + subject * (0.8f + 0.2f * cx);
+		output[1] = 0.8f - noise - subject * 0.2f;
+		output[2] = 0.15f + noise + subject * 0.5f;
+		output[3] = 1.0f;
+	}
+};
+
+static void connect(NodeOperation *from, NodeOperation *to, int index)
+{
+	SocketConnection *connection = new SocketConnection();
+	OutputSocket *fromSocket = from->getOutputSocket(0);
+	InputSocket *toSocket = to->getInputSocket(index);
+
+	connection->setFromSocket(fromSocket);
+	connection->setToSocket(toSocket);
+	fromSocket->addConnection(connection);
+	toSocket->setConnection(connection);
+}
+
+/* evaluate a complex operation for every pixel of an input buffer */
+static double run_complex_step(NodeOperation *operation, MemoryBuffer *input, MemoryBuffer *output)
+{
+	const int width = output->getWidth(), height = output->getHeight();
+	double start = PIL_check_seconds_timer();
+	float color[4];
+
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			operation->read(color, x, y, input);
+			output->writePixel(x, y, color);
+		}
+	}
+
+	return PIL_check_seconds_timer() - start;
+}
+
+static double run_keying_step(NodeOperation *operation, MemoryBuffer *output)
+{
+	const int width = output->getWidth(), height = output->getHeight();
+	double start = PIL_check_seconds_timer();
+	float color[4];
+
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			operation->readSampled(color, x, y, COM_PS_NEAREST);
+			output->writePixel(x, y, color);
+		}
+	}
+
+	return PIL_check_seconds_timer() - start;
+}
+
+/* run the pipeline with the given matte datatype, returns the sum of the final matte */
+static double run_pipeline(DataType datatype, int width, int height, int runs,
+                           KeyingOperation *keying, KeyingBlurOperation *blurx,
+                           KeyingBlurOperation *blury, KeyingClipOperation *clip)
+{
+	rcti rect;
+	BLI_rcti_init(&rect, 0, width, 0, height);
+
+	MemoryBuffer *matte = new MemoryBuffer(datatype, &rect);
+	MemoryBuffer *blurred_x = new MemoryBuffer(datatype, &rect);
+	MemoryBuffer *blurred = new MemoryBuffer(datatype, &rect);
+	MemoryBuffer *clipped = new MemoryBuffer(datatype, &rect);
+	double best[NUM_STEPS];
+
+	for (int run = 0; run < runs; run++) {
+		double t[NUM_STEPS];
+
+		t[0] = run_keying_step(keying, matte);
+		t[1] = run_complex_step(blurx, matte, blurred_x);
+		t[2] = run_complex_step(blury, blurred_x, blurred);
+		t[3] = run_complex_step(clip, blurred, clipped);
+
+		for (int i = 0; i < NUM_STEPS; i++)
+			best[i] = (run == 0) ? t[i] : min(best[i], t[i]);
+	}
+
+	double total = 0.0, sum = 0.0;
+	const int numChannels = matte->getNumberOfChannels();
+	const float *buffer = clipped->getBuffer();
+
+	printf("%-8s", (datatype == COM_DT_VALUE) ? "value" : "color");
+	for (int i = 0; i < NUM_STEPS; i++) {
+		printf(" %10.4f", best[i]);
+		total += best[i];
+	}
+	printf(" %10.4f %10.1f\n", total,
+	       4.0 * sizeof(float) * numChannels * width * height / (1024.0 * 1024.0));
+
+	for (int i = 0; i < width * height; i++)
+		sum += buffer[i * numChannels];
+
+	delete matte;
+	delete blurred_x;
+	delete blurred;
+	delete clipped;
+
+	return sum;
+}
+
+/* the sockets link to the node tree and execution system, which the benchmark doesn't use */
+void Node::addSetValueOperation(ExecutionSystem *graph, InputSocket *inputsocket, int editorNodeInputSocketIndex) {}
+void Node::addSetColorOperation(ExecutionSystem *graph, InputSocket *inputsocket, int editorNodeInputSocketIndex) {}
+void Node::addSetVectorOperation(ExecutionSystem *graph, InputSocket *inputsocket, int editorNodeInputSocketIndex) {}
+void ExecutionSystem::addSocketConnection(SocketConnection *connection) {}
+void ExecutionSystem::removeSocketConnection(SocketConnection *connection) {}
+
+extern "C" {
+StructRNA RNA_NodeSocket;
+void RNA_pointer_create(ID *id, StructRNA *type, void *data, PointerRNA *r_ptr) {}
+float RNA_float_get(PointerRNA *ptr, const char *name) { return 0.0f; }
+void RNA_float_get_array(PointerRNA *ptr, const char *name, float *values) {}
+}
+
+int main(int argc, char **argv)
+{
+	int width = (argc > 1) ? atoi(argv[1]) : 1920;
+	int height = (argc > 2) ? atoi(argv[2]) : 1080;
+	int runs = (argc > 3) ? atoi(argv[3]) : 5;
+
+	if (width <= 0 || height <= 0 || runs <= 0) {
+		printf("Usage: %s [width] [height] [runs]\n", argv[0]);
+		return 1;
+	}
+
+	GreenScreenOperation image(width, height);
+	SetColorOperation screen;
+	const float screen_color[4] = {0.1f, 0.8f, 0.15f, 1.0f};
+	screen.setChannels(screen_color);
+
+	KeyingOperation keying;
+	KeyingBlurOperation blurx, blury;
+	KeyingClipOperation clip;
+
+	connect(&image, &keying, 0);
+	connect(&screen, &keying, 1);
+
+	blurx.setSize(8);
+	blurx.setAxis(KeyingBlurOperation::BLUR_AXIS_X);
+	blury.setSize(8);
+	blury.setAxis(KeyingBlurOperation::BLUR_AXIS_Y);
+	clip.setKernelRadius(3);
+	clip.setClipBlack(0.1f);
+	clip.setClipWhite(0.9f);
+
+	keying.initExecution();
+
+	printf("Keying %dx%d, best of %d runs\n\n", width, height, runs);
+	printf("%-8s", "matte");
+	for (int i = 0; i < NUM_STEPS; i++)
+		printf(" %10s", step_names[i]);
+	printf(" %10s %10s\n", "total (s)", "MB");
+
+	double value_sum = run_pipeline(COM_DT_VALUE, width, height, runs, &keying, &blurx, &blury, &clip);
+	double color_sum = run_pipeline(COM_DT_COLOR, width, height, runs, &keying, &blurx, &blury, &clip);
+
+	keying.deinitExecution();
+
+	if (value_sum != color_sum) {
+		printf("\nvalue and color mattes differ (%f and %f)\n", value_sum, color_sum);
+		return 1;
+	}
+
+	return 0;
+}
@@ -162,7 +162,9 @@ void undo_editmode_push(bContext *C, const char *name,
 	/* copy  */
 	memused = MEM_get_memory_in_use();
 	editdata = getdata(C);
+	MEM_tag_push(MEM_TAG_UNDO);
 	curundo->undodata = curundo->from_editmode(editdata, obedit->data);
+	MEM_tag_pop();
 	curundo->undosize = MEM_get_memory_in_use() - memused;
 	curundo->ob = obedit;
 	curundo->id = obedit->id;
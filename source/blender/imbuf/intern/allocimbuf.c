@@ -203,7 +203,12 @@ bool addzbufImBuf(ImBuf *ibuf)
 	
 	size = (size_t)(ibuf->x * ibuf->y) * sizeof(unsigned int);
 
-	if ((ibuf->zbuf = MEM_mapallocN(size, __func__))) {
+	/* pixels are accounted to images, also when allocated for renders or caches */
+	MEM_tag_push(MEM_TAG_IMAGE);
+	ibuf->zbuf = MEM_mapallocN(size, __func__);
+	MEM_tag_pop();
+
+	if (ibuf->zbuf) {
 		ibuf->mall |= IB_zbuf;
 		ibuf->flags |= IB_zbuf;
 		return true;
@@ -222,7 +227,11 @@ bool addzbuffloatImBuf(ImBuf *ibuf)
 	
 	size = (size_t)(ibuf->x * ibuf->y) * sizeof(float);
 
-	if ((ibuf->zbuf_float = MEM_mapallocN(size, __func__))) {
+	MEM_tag_push(MEM_TAG_IMAGE);
+	ibuf->zbuf_float = MEM_mapallocN(size, __func__);
+	MEM_tag_pop();
+
+	if (ibuf->zbuf_float) {
 		ibuf->mall |= IB_zbuffloat;
 		ibuf->flags |= IB_zbuffloat;
 		return true;
@@ -303,7 +312,11 @@ bool imb_addrectfloatImBuf(ImBuf *ibuf)
 	size = (size_t)(ibuf->x * ibuf->y) * sizeof(float[4]);
 
 	ibuf->channels = 4;
-	if ((ibuf->rect_float = MEM_mapallocN(size, __func__))) {
+	MEM_tag_push(MEM_TAG_IMAGE);
+	ibuf->rect_float = MEM_mapallocN(size, __func__);
+	MEM_tag_pop();
+
+	if (ibuf->rect_float) {
 		ibuf->mall |= IB_rectfloat;
 		ibuf->flags |= IB_rectfloat;
 		return true;
@@ -326,7 +339,11 @@ bool imb_addrectImBuf(ImBuf *ibuf)
 	
 	size = (size_t)(ibuf->x * ibuf->y) * sizeof(unsigned int);
 
-	if ((ibuf->rect = MEM_mapallocN(size, __func__))) {
+	MEM_tag_push(MEM_TAG_IMAGE);
+	ibuf->rect = MEM_mapallocN(size, __func__);
+	MEM_tag_pop();
+
+	if (ibuf->rect) {
 		ibuf->mall |= IB_rect;
 		ibuf->flags |= IB_rect;
 		if (ibuf->planes > 32) {
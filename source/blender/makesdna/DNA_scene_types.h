@@ -1288,6 +1288,7 @@ typedef struct Scene {
 #define R_SIMPLIFY			0x1000000
 #define R_EDGE_FRS			0x2000000 /* R_EDGE reserved for Freestyle */
 #define R_PERSISTENT_DATA	0x4000000 /* keep data around for re-render */
+#define R_VIEWS_SHARE_DATA	0x8000000 /* convert render data once for all views */
 
 /* seq_flag */
 #define R_SEQ_GL_PREV 1
@@ -5032,6 +5032,14 @@ static void rna_def_scene_render_data(BlenderRNA *brna)
 	RNA_def_property_enum_funcs(prop, NULL, "rna_RenderSettings_views_setup_set", NULL);
 	RNA_def_property_update(prop, NC_SPACE | ND_SPACE_VIEW3D, NULL);
 
+	prop = RNA_def_property(srna, "use_views_share_data", PROP_BOOLEAN, PROP_NONE);
+	RNA_def_property_boolean_sdna(prop, NULL, "mode", R_VIEWS_SHARE_DATA);
+	RNA_def_property_ui_text(prop, "Share View Data",
+	                         "Convert the scene once and reuse the render data for all views, "
+	                         "only rotating it into every view camera (not used with ray tracing, speed vectors, "
+	                         "panorama, approximate AO and volumes)");
+	RNA_def_property_update(prop, NC_SCENE | ND_RENDER_OPTIONS, NULL);
+
 	/* engine */
 	prop = RNA_def_property(srna, "engine", PROP_ENUM, PROP_NONE);
 	RNA_def_property_enum_items(prop, engine_items);
@@ -304,6 +304,11 @@ void ntreeCompositTagRender(Scene *curscene)
 			}
 		}
 	}
+
+#ifdef WITH_COMPOSITOR
+	/* render layer buffers cached while editing are outdated */
+	COM_clearCaches();
+#endif
 }
 
 static int node_animation_properties(bNodeTree *ntree, bNode *node)
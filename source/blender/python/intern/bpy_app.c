@@ -41,6 +41,8 @@
 #include "bpy_app_handlers.h"
 #include "bpy_driver.h"
 
+#include "MEM_guardedalloc.h"
+
 #include "BLI_utildefines.h"
 #include "BLI_path_util.h"
 
@@ -268,6 +270,40 @@ static PyObject *bpy_app_autoexec_fail_message_get(PyObject *UNUSED(self), void
 	return PyC_UnicodeFromByte(G.autoexec_fail);
 }
 
+PyDoc_STRVAR(bpy_app_memory_tags_doc,
+"Dictionary with the memory accounted to each allocation category, as dictionaries of "
+"'in_use' and 'peak' bytes, and 'allocations' and 'allocated' bytes so far, "
+"compare two reads for rates (read-only)"
+);
+static PyObject *bpy_app_memory_tags_get(PyObject *UNUSED(self), void *UNUSED(closure))
+{
+	PyObject *ret = PyDict_New();
+	PyObject *item, *value;
+	int tag;
+
+#define SetSizeItem(key, size) \
+	PyDict_SetItemString(item, key, value = PyLong_FromSize_t(size)); Py_DECREF(value)
+
+	for (tag = 0; tag < MEM_TAG_TOT; tag++) {
+		MEM_TagStats stats;
+
+		MEM_tag_stats(tag, &stats);
+
+		item = PyDict_New();
+		SetSizeItem("in_use", stats.mem_in_use);
+		SetSizeItem("peak", stats.peak_mem);
+		SetSizeItem("allocations", stats.totalloc);
+		SetSizeItem("allocated", stats.totalloc_len);
+
+		PyDict_SetItemString(ret, MEM_tag_name(tag), item);
+		Py_DECREF(item);
+	}
+
+#undef SetSizeItem
+
+	return ret;
+}
+
 
 static PyGetSetDef bpy_app_getsets[] = {
 	{(char *)"debug",           bpy_app_debug_get, bpy_app_debug_set, (char *)bpy_app_debug_doc, (void *)G_DEBUG},
@@ -281,6 +317,7 @@ static PyGetSetDef bpy_app_getsets[] = {
 	{(char *)"debug_value", bpy_app_debug_value_get, bpy_app_debug_value_set, (char *)bpy_app_debug_value_doc, NULL},
 	{(char *)"tempdir", bpy_app_tempdir_get, NULL, (char *)bpy_app_tempdir_doc, NULL},
 	{(char *)"driver_namespace", bpy_app_driver_dict_get, NULL, (char *)bpy_app_driver_dict_doc, NULL},
+	{(char *)"memory_tags", bpy_app_memory_tags_get, NULL, (char *)bpy_app_memory_tags_doc, NULL},
 
 	/* security */
 	{(char *)"autoexec_fail", bpy_app_global_flag_get, NULL, NULL, (void *)G_SCRIPT_AUTOEXEC_FAIL},
@@ -34,6 +34,8 @@
 #ifndef __RAYINTERSECTION_H__
 #define __RAYINTERSECTION_H__
 
+#include "raycounter.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
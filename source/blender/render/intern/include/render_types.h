@@ -652,6 +652,9 @@ typedef struct LampRen {
 
 /* objectren->flag */
 #define R_INSTANCEABLE		1
+#define R_CALC_VNORMALS		2	/* vertex normals are calculated when finalizing */
+#define R_CALC_TANGENT		4
+#define R_CALC_NMAP_TANGENT	8
 
 /* objectinstance->flag */
 #define R_DUPLI_TRANSFORMED	1
@@ -51,6 +51,7 @@ typedef int (*RE_rayobjectcontrol_test_break_callback)(void *data);
 typedef struct RayObjectControl {
 	void *data;
 	RE_rayobjectcontrol_test_break_callback test_break;
+	int num_threads;	/* threads to use when building, 0 or 1 builds on the calling thread only */
 } RayObjectControl;
 
 /* Returns true if for some reason a heavy processing function should stop
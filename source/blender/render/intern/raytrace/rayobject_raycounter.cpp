@@ -30,6 +30,8 @@
  */
 
 
+#include <stdio.h>
+
 #include "rayobject.h"
 #include "raycounter.h"
 
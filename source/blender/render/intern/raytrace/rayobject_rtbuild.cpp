@@ -40,6 +40,7 @@
 #include "MEM_guardedalloc.h"
 
 #include "BLI_math.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 static bool selected_node(RTBuilder::Object *node)
@@ -61,6 +62,8 @@ static void rtbuild_init(RTBuilder *b)
 		b->sorted_begin[i] = b->sorted_end[i] = NULL;
 		
 	INIT_MINMAX(b->bb, b->bb + 3);
+
+	b->task_scheduler = NULL;
 }
 
 RTBuilder *rtbuild_create(int size)
@@ -85,6 +88,7 @@ RTBuilder *rtbuild_create(int size)
 
 void rtbuild_free(RTBuilder *b)
 {
+	if (b->task_scheduler) BLI_task_scheduler_free(b->task_scheduler);
 	if (b->primitives.begin) MEM_freeN(b->primitives.begin);
 
 	for (int i = 0; i < 3; i++)
@@ -153,8 +157,57 @@ static void object_sort(Item *begin, Item *end, int axis)
 	assert(false);
 }
 
+/* runs func for the three axes, in parallel when the builder has a task scheduler */
+struct RTBuildAxisTask {
+	RTBuilder *b;
+	void *data;
+	void (*func)(RTBuilder *b, int axis, void *data);
+};
+
+static void rtbuild_axis_task(TaskPool *pool, void *taskdata, int UNUSED(threadid))
+{
+	RTBuildAxisTask *task = (RTBuildAxisTask *)BLI_task_pool_userdata(pool);
+	int axis = (int)(intptr_t)taskdata;
+
+	task->func(task->b, axis, task->data);
+}
+
+static void rtbuild_for_axes(RTBuilder *b, void (*func)(RTBuilder *b, int axis, void *data), void *data)
+{
+	if (b->task_scheduler) {
+		RTBuildAxisTask task = {b, data, func};
+		TaskPool *pool = BLI_task_pool_create(b->task_scheduler, &task);
+
+		for (int axis = 0; axis < 3; axis++)
+			BLI_task_pool_push(pool, rtbuild_axis_task, (void *)(intptr_t)axis, false, TASK_PRIORITY_HIGH);
+
+		BLI_task_pool_work_and_wait(pool);
+		BLI_task_pool_free(pool);
+	}
+	else {
+		for (int axis = 0; axis < 3; axis++)
+			func(b, axis, data);
+	}
+}
+
+static void rtbuild_sort_axis(RTBuilder *b, int axis, void *UNUSED(data))
+{
+	if (b->sorted_begin[axis])
+		object_sort(b->sorted_begin[axis], b->sorted_end[axis], axis);
+}
+
 void rtbuild_done(RTBuilder *b, RayObjectControl *ctrl)
 {
+	if (ctrl->num_threads > 1 && rtbuild_size(b) >= RTBUILD_PARALLEL_SIZE) {
+		if (RE_rayobjectcontrol_test_break(ctrl))
+			return;
+
+		/* kept for splitting and building the tree, freed with the builder */
+		b->task_scheduler = BLI_task_scheduler_create(ctrl->num_threads);
+		rtbuild_for_axes(b, rtbuild_sort_axis, NULL);
+		return;
+	}
+
 	for (int i = 0; i < 3; i++) {
 		if (b->sorted_begin[i]) {
 			if (RE_rayobjectcontrol_test_break(ctrl)) break;
@@ -321,6 +374,95 @@ struct SweepCost {
 	float cost;
 };
 
+/* Sweep over the objects sorted on one axis for the split with the lowest cost. Only splits
+ * cheaper than bound are considered, offset is left unchanged when there is none. */
+static void heuristic_object_split_axis(RTBuilder *b, int axis, SweepCost *sweep, float bound, float *r_cost, int *r_offset)
+{
+	int size = rtbuild_size(b);
+	float bcost = bound;
+	SweepCost sweep_left;
+
+	RTBuilder::Object **obj = b->sorted_begin[axis];
+	
+//	float right_cost = 0;
+	for (int i = size - 1; i >= 0; i--) {
+		if (i == size - 1) {
+			copy_v3_v3(sweep[i].bb, obj[i]->bb);
+			copy_v3_v3(sweep[i].bb + 3, obj[i]->bb + 3);
+			sweep[i].cost = obj[i]->cost;
+		}
+		else {
+			sweep[i].bb[0] = min_ff(obj[i]->bb[0], sweep[i + 1].bb[0]);
+			sweep[i].bb[1] = min_ff(obj[i]->bb[1], sweep[i + 1].bb[1]);
+			sweep[i].bb[2] = min_ff(obj[i]->bb[2], sweep[i + 1].bb[2]);
+			sweep[i].bb[3] = max_ff(obj[i]->bb[3], sweep[i + 1].bb[3]);
+			sweep[i].bb[4] = max_ff(obj[i]->bb[4], sweep[i + 1].bb[4]);
+			sweep[i].bb[5] = max_ff(obj[i]->bb[5], sweep[i + 1].bb[5]);
+			sweep[i].cost  = obj[i]->cost + sweep[i + 1].cost;
+		}
+//		right_cost += obj[i]->cost;
+	}
+	
+	sweep_left.bb[0] = obj[0]->bb[0];
+	sweep_left.bb[1] = obj[0]->bb[1];
+	sweep_left.bb[2] = obj[0]->bb[2];
+	sweep_left.bb[3] = obj[0]->bb[3];
+	sweep_left.bb[4] = obj[0]->bb[4];
+	sweep_left.bb[5] = obj[0]->bb[5];
+	sweep_left.cost  = obj[0]->cost;
+	
+//	right_cost -= obj[0]->cost;	if (right_cost < 0) right_cost = 0;
+
+	for (int i = 1; i < size; i++) {
+		//Worst case heuristic (cost of each child is linear)
+		float hcost, left_side, right_side;
+		
+		// not using log seems to have no impact on raytracing perf, but
+		// makes tree construction quicker, left out for now to test (brecht)
+		// left_side  = bb_area(sweep_left.bb, sweep_left.bb + 3) * (sweep_left.cost + logf((float)i));
+		// right_side = bb_area(sweep[i].bb,   sweep[i].bb   + 3) * (sweep[i].cost   + logf((float)size - i));
+		left_side = bb_area(sweep_left.bb, sweep_left.bb + 3) * (sweep_left.cost);
+		right_side = bb_area(sweep[i].bb, sweep[i].bb + 3) * (sweep[i].cost);
+		hcost = left_side + right_side;
+
+		assert(left_side >= 0);
+		assert(right_side >= 0);
+		
+		if (left_side > bcost) break;   //No way we can find a better heuristic in this axis
+
+		assert(hcost >= 0);
+		if (hcost < bcost) {
+			bcost = hcost;
+			*r_offset = i;
+		}
+		DO_MIN(obj[i]->bb,   sweep_left.bb);
+		DO_MAX(obj[i]->bb + 3, sweep_left.bb + 3);
+
+		sweep_left.cost += obj[i]->cost;
+//		right_cost -= obj[i]->cost; if (right_cost < 0) right_cost = 0;
+	}
+
+	*r_cost = bcost;
+}
+
+struct HeuristicSplit {
+	SweepCost *sweep[3];
+	float cost[3];
+	int offset[3];
+};
+
+static void heuristic_object_split_axis_task(RTBuilder *b, int axis, void *data)
+{
+	HeuristicSplit *split = (HeuristicSplit *)data;
+
+	heuristic_object_split_axis(b, axis, split->sweep[axis], FLT_MAX, &split->cost[axis], &split->offset[axis]);
+}
+
+static void partition_selected_axis(RTBuilder *b, int axis, void *UNUSED(data))
+{
+	std::stable_partition(b->sorted_begin[axis], b->sorted_end[axis], selected_node);
+}
+
 /* Object Surface Area Heuristic splitter */
 int rtbuild_heuristic_object_split(RTBuilder *b, int nchilds)
 {
@@ -333,80 +475,50 @@ int rtbuild_heuristic_object_split(RTBuilder *b, int nchilds)
 		float bcost = FLT_MAX;
 		baxis = -1, boffset = size / 2;
 
-		SweepCost *sweep = (SweepCost *)MEM_mallocN(sizeof(SweepCost) * size, "RTBuilder.HeuristicSweep");
-		
-		for (int axis = 0; axis < 3; axis++) {
-			SweepCost sweep_left;
-
-			RTBuilder::Object **obj = b->sorted_begin[axis];
-			
-//			float right_cost = 0;
-			for (int i = size - 1; i >= 0; i--) {
-				if (i == size - 1) {
-					copy_v3_v3(sweep[i].bb, obj[i]->bb);
-					copy_v3_v3(sweep[i].bb + 3, obj[i]->bb + 3);
-					sweep[i].cost = obj[i]->cost;
-				}
-				else {
-					sweep[i].bb[0] = min_ff(obj[i]->bb[0], sweep[i + 1].bb[0]);
-					sweep[i].bb[1] = min_ff(obj[i]->bb[1], sweep[i + 1].bb[1]);
-					sweep[i].bb[2] = min_ff(obj[i]->bb[2], sweep[i + 1].bb[2]);
-					sweep[i].bb[3] = max_ff(obj[i]->bb[3], sweep[i + 1].bb[3]);
-					sweep[i].bb[4] = max_ff(obj[i]->bb[4], sweep[i + 1].bb[4]);
-					sweep[i].bb[5] = max_ff(obj[i]->bb[5], sweep[i + 1].bb[5]);
-					sweep[i].cost  = obj[i]->cost + sweep[i + 1].cost;
-				}
-//				right_cost += obj[i]->cost;
+		if (b->task_scheduler) {
+			/* all axes at once, each with its own sweep. the first axis with the lowest
+			 * cost is used, the same split as found sweeping the axes in order */
+			HeuristicSplit split;
+
+			for (int axis = 0; axis < 3; axis++) {
+				split.sweep[axis] = (SweepCost *)MEM_mallocN(sizeof(SweepCost) * size, "RTBuilder.HeuristicSweep");
+				split.offset[axis] = -1;
 			}
-			
-			sweep_left.bb[0] = obj[0]->bb[0];
-			sweep_left.bb[1] = obj[0]->bb[1];
-			sweep_left.bb[2] = obj[0]->bb[2];
-			sweep_left.bb[3] = obj[0]->bb[3];
-			sweep_left.bb[4] = obj[0]->bb[4];
-			sweep_left.bb[5] = obj[0]->bb[5];
-			sweep_left.cost  = obj[0]->cost;
-			
-//			right_cost -= obj[0]->cost;	if (right_cost < 0) right_cost = 0;
-
-			for (int i = 1; i < size; i++) {
-				//Worst case heuristic (cost of each child is linear)
-				float hcost, left_side, right_side;
-				
-				// not using log seems to have no impact on raytracing perf, but
-				// makes tree construction quicker, left out for now to test (brecht)
-				// left_side  = bb_area(sweep_left.bb, sweep_left.bb + 3) * (sweep_left.cost + logf((float)i));
-				// right_side = bb_area(sweep[i].bb,   sweep[i].bb   + 3) * (sweep[i].cost   + logf((float)size - i));
-				left_side = bb_area(sweep_left.bb, sweep_left.bb + 3) * (sweep_left.cost);
-				right_side = bb_area(sweep[i].bb, sweep[i].bb + 3) * (sweep[i].cost);
-				hcost = left_side + right_side;
-
-				assert(left_side >= 0);
-				assert(right_side >= 0);
-				
-				if (left_side > bcost) break;   //No way we can find a better heuristic in this axis
-
-				assert(hcost >= 0);
-				// this makes sure the tree built is the same whatever is the order of the sorting axis
-				if (hcost < bcost || (hcost == bcost && axis < baxis)) {
-					bcost = hcost;
+
+			rtbuild_for_axes(b, heuristic_object_split_axis_task, &split);
+
+			for (int axis = 0; axis < 3; axis++) {
+				if (split.offset[axis] != -1 && split.cost[axis] < bcost) {
+					bcost = split.cost[axis];
 					baxis = axis;
-					boffset = i;
+					boffset = split.offset[axis];
 				}
-				DO_MIN(obj[i]->bb,   sweep_left.bb);
-				DO_MAX(obj[i]->bb + 3, sweep_left.bb + 3);
 
-				sweep_left.cost += obj[i]->cost;
-//				right_cost -= obj[i]->cost; if (right_cost < 0) right_cost = 0;
+				MEM_freeN(split.sweep[axis]);
 			}
-			
-			//assert(baxis >= 0 && baxis < 3);
-			if (!(baxis >= 0 && baxis < 3))
-				baxis = 0;
 		}
-			
-		
-		MEM_freeN(sweep);
+		else {
+			SweepCost *sweep = (SweepCost *)MEM_mallocN(sizeof(SweepCost) * size, "RTBuilder.HeuristicSweep");
+
+			for (int axis = 0; axis < 3; axis++) {
+				int offset = -1;
+
+				// only cheaper splits are taken from later axes, this makes sure the tree
+				// built is the same whatever is the order of the sorting axis
+				heuristic_object_split_axis(b, axis, sweep, bcost, &bcost, &offset);
+
+				if (offset != -1) {
+					baxis = axis;
+					boffset = offset;
+				}
+			}
+
+			MEM_freeN(sweep);
+		}
+
+		//assert(baxis >= 0 && baxis < 3);
+		if (!(baxis >= 0 && baxis < 3))
+			baxis = 0;
 	}
 	else if (size == 2) {
 		baxis = 0;
@@ -426,8 +538,7 @@ int rtbuild_heuristic_object_split(RTBuilder *b, int nchilds)
 	/* Adjust sorted arrays for childs */
 	for (int i = 0; i < boffset; i++) b->sorted_begin[baxis][i]->selected = true;
 	for (int i = boffset; i < size; i++) b->sorted_begin[baxis][i]->selected = false;
-	for (int i = 0; i < 3; i++)
-		std::stable_partition(b->sorted_begin[i], b->sorted_end[i], selected_node);
+	rtbuild_for_axes(b, partition_selected_axis, NULL);
 
 	return nchilds;
 }
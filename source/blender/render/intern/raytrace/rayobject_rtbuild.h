@@ -51,6 +51,10 @@ extern "C" {
  */
 #define RTBUILD_MAX_CHILDS 32
 
+/* trees with this many primitives are sorted, split and built with multiple threads,
+ * when the RayObjectControl allows it */
+#define RTBUILD_PARALLEL_SIZE 8192
+
 
 typedef struct RTBuilder {
 	struct Object {
@@ -79,6 +83,9 @@ typedef struct RTBuilder {
 	
 	float bb[6];
 
+	/* only set on the root builder of a parallel build and the children split on the main thread */
+	struct TaskScheduler *task_scheduler;
+
 } RTBuilder;
 
 /* used during creation */
@@ -0,0 +1,286 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2013 by Blender Foundation.
+ * All rights reserved.
+ *
+ * The Original Code is: all of this file.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/**
+ * Raytree benchmark, building every raytree structure for the same faces.
+ *
+ * Usage: raytreebench [faces] [rays] [threads]
+ *
+ * The faces are small triangles in clusters of different density, like the
+ * objects of a scene. For every R_RAYSTRUCTURE_* type the tree is built with
+ * the given number of threads, then the same random rays are traced through
+ * it as nearest hit (mirror) and any hit (shadow) rays on a single thread.
+ * Printed are the build time, the trace times and, when compiled with
+ * RE_RAYCOUNTER, the bounding box and face tests per mirror ray as the
+ * traversal cost. All trees must find the same number of hits.
+ */
+
+/* To compile run:
+ * gcc -O2 -c -D__LITTLE_ENDIAN__ -DWITH_BOOL_COMPAT -D__BLI_STRICT_FLAGS_H__ \
+ *     -I../../../../../blenlib -I../../../../../makesdna \
+ *     -I../../../../../../../intern/guardedalloc -I../../../../../../../intern/atomic \
+ *     ../../../../../blenlib/intern/{BLI_kdopbvh,BLI_linklist,BLI_memarena,BLI_mempool,threads,task,gsqueue}.c \
+ *     ../../../../../blenlib/intern/{listbase,time,math_base,math_base_inline,math_geom,math_geom_inline}.c \
+ *     ../../../../../blenlib/intern/{math_matrix,math_rotation,math_vector,math_vector_inline}.c \
+ *     ../../../../../../../intern/guardedalloc/intern/mallocn*.c
+ * g++ -O2 -msse2 -DRE_RAYCOUNTER -D__LITTLE_ENDIAN__ -DWITH_BOOL_COMPAT \
+ *     -I../.. -I../../../include -I../../../../extern/include -I../../../../../blenlib \
+ *     -I../../../../../blenkernel -I../../../../../makesdna -I../../../../../../../intern/guardedalloc \
+ *     raytreebench.cpp ../../*.cpp *.o -lpthread -o raytreebench
+ * Leave out -DRE_RAYCOUNTER to time the trace without the counters.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BLI_utildefines.h"
+#include "BLI_math.h"
+#include "BLI_threads.h"
+#include "PIL_time.h"
+#include "BKE_global.h"
+#include "DNA_scene_types.h"
+}
+
+#include "rayintersection.h"
+#include "rayobject.h"
+#include "raycounter.h"
+#include "rayobject_internal.h"
+
+/* the raytree code prints some statistics with --debug */
+Global G;
+
+#define CLUSTERS 64
+#define OCTREE_RESOLUTION 128
+
+static const struct {
+	int type;
+	const char *name;
+} structures[] = {
+	{R_RAYSTRUCTURE_OCTREE, "Octree"},
+	{R_RAYSTRUCTURE_BLIBVH, "BLI BVH"},
+	{R_RAYSTRUCTURE_VBVH, "VBVH"},
+#ifdef __SSE__
+	{R_RAYSTRUCTURE_SIMD_SVBVH, "SIMD SVBVH"},
+	{R_RAYSTRUCTURE_SIMD_QBVH, "SIMD QBVH"},
+#endif
+};
+
+static unsigned int seed = 1;
+
+static float random_float(void)
+{
+	seed = seed * 1103515245u + 12345u;
+	return (float)((seed >> 8) & 0xFFFFFF) / (float)0x1000000;
+}
+
+/* roughly normal distribution in [-1, 1] */
+static float random_offset(void)
+{
+	return (random_float() + random_float() + random_float()) * (2.0f / 3.0f) - 1.0f;
+}
+
+static void random_direction(float dir[3])
+{
+	do {
+		dir[0] = 2.0f * random_float() - 1.0f;
+		dir[1] = 2.0f * random_float() - 1.0f;
+		dir[2] = 2.0f * random_float() - 1.0f;
+	} while (len_squared_v3(dir) > 1.0f || len_squared_v3(dir) < 1e-4f);
+
+	normalize_v3(dir);
+}
+
+/* triangles in clusters of random size around random centers in the unit cube */
+static float (*make_triangles(int totface))[3]
+{
+	float (*co)[3] = (float (*)[3])MEM_mallocN(sizeof(float) * 9 * totface, "raytreebench coords");
+	float centers[CLUSTERS][3], radius[CLUSTERS];
+	int i, j;
+
+	for (i = 0; i < CLUSTERS; i++) {
+		for (j = 0; j < 3; j++)
+			centers[i][j] = random_float();
+		radius[i] = 0.01f + 0.1f * random_float();
+	}
+
+	for (i = 0; i < totface; i++) {
+		int c = (int)(random_float() * random_float() * CLUSTERS);
+		float center[3], edge[3];
+
+		for (j = 0; j < 3; j++)
+			center[j] = centers[c][j] + radius[c] * random_offset();
+
+		copy_v3_v3(co[3 * i], center);
+
+		for (j = 1; j < 3; j++) {
+			random_direction(edge);
+			madd_v3_v3v3fl(co[3 * i + j], center, edge, 0.002f + 0.01f * random_float());
+		}
+	}
+
+	return co;
+}
+
+static void make_rays(int totray, float (*start)[3], float (*dir)[3])
+{
+	int i, j;
+
+	for (i = 0; i < totray; i++) {
+		for (j = 0; j < 3; j++)
+			start[i][j] = random_float();
+		random_direction(dir[i]);
+	}
+}
+
+static int trace_rays(RayObject *tree, int mode, int totray, float (*start)[3], float (*dir)[3], double *time,
+                      void *counter)
+{
+	double starttime = PIL_check_seconds_timer();
+	int i, hits = 0;
+
+	for (i = 0; i < totray; i++) {
+		Isect isec;
+
+		memset(&isec, 0, sizeof(isec));
+		copy_v3_v3(isec.start, start[i]);
+		copy_v3_v3(isec.dir, dir[i]);
+		isec.dist = RE_RAYTRACE_MAXDIST;
+		isec.mode = mode;
+		isec.lay = -1;
+		isec.check = RE_CHECK_VLR_NONE;
+#ifdef RE_RAYCOUNTER
+		isec.raycounter = (RayCounter *)counter;
+#else
+		(void)counter;
+#endif
+
+		if (RE_rayobject_raycast(tree, &isec))
+			hits++;
+	}
+
+	*time = PIL_check_seconds_timer() - starttime;
+
+	return hits;
+}
+
+int main(int argc, char **argv)
+{
+	int totface = (argc > 1) ? atoi(argv[1]) : 1000000;
+	int totray = (argc > 2) ? atoi(argv[2]) : 1000000;
+	int threads = (argc > 3) ? atoi(argv[3]) : BLI_system_thread_count();
+	float (*co)[3], (*start)[3], (*dir)[3];
+	RayFace *faces;
+	int i, s;
+
+	if (totface <= 0 || totray <= 0 || threads <= 0) {
+		printf("Usage: %s [faces] [rays] [threads]\n", argv[0]);
+		return 1;
+	}
+
+	BLI_threadapi_init();
+
+	co = make_triangles(totface);
+	start = (float (*)[3])MEM_mallocN(sizeof(float) * 3 * totray, "raytreebench starts");
+	dir = (float (*)[3])MEM_mallocN(sizeof(float) * 3 * totray, "raytreebench directions");
+	faces = (RayFace *)MEM_callocN(sizeof(RayFace) * totface, "raytreebench faces");
+
+	make_rays(totray, start, dir);
+
+	printf("%d faces, %d rays, building with %d threads\n\n", totface, totray, threads);
+	printf("%-12s %10s %10s %10s %10s %10s %10s\n",
+	       "structure", "build (s)", "mirror (s)", "hits", "shadow (s)", "bb/ray", "faces/ray");
+
+	for (s = 0; s < (int)(sizeof(structures) / sizeof(structures[0])); s++) {
+		RayObject *tree;
+#ifdef RE_RAYCOUNTER
+		RayCounter counter;
+#else
+		int counter;
+#endif
+		double starttime, build_time, mirror_time, shadow_time;
+		int mirror_hits, shadow_hits;
+		float bb_tests = 0.0f, face_tests = 0.0f;
+
+		if (structures[s].type == R_RAYSTRUCTURE_OCTREE)
+			tree = RE_rayobject_octree_create(OCTREE_RESOLUTION, totface);
+		else if (structures[s].type == R_RAYSTRUCTURE_BLIBVH)
+			tree = RE_rayobject_blibvh_create(totface);
+		else if (structures[s].type == R_RAYSTRUCTURE_VBVH)
+			tree = RE_rayobject_vbvh_create(totface);
+		else if (structures[s].type == R_RAYSTRUCTURE_SIMD_SVBVH)
+			tree = RE_rayobject_svbvh_create(totface);
+		else
+			tree = RE_rayobject_qbvh_create(totface);
+
+		RE_rayobject_set_control(tree, NULL, NULL);
+		RE_rayobject_align(tree)->control.num_threads = threads;
+
+		starttime = PIL_check_seconds_timer();
+
+		for (i = 0; i < totface; i++) {
+			/* face pointers only need to be unique, for the self intersection test */
+			RayObject *face = RE_rayface_from_coords(&faces[i], faces, &faces[i],
+			                                         co[3 * i], co[3 * i + 1], co[3 * i + 2], NULL);
+			RE_rayobject_add(tree, face);
+		}
+		RE_rayobject_done(tree);
+
+		build_time = PIL_check_seconds_timer() - starttime;
+
+		memset(&counter, 0, sizeof(counter));
+		mirror_hits = trace_rays(tree, RE_RAY_MIRROR, totray, start, dir, &mirror_time, &counter);
+
+#ifdef RE_RAYCOUNTER
+		bb_tests = (float)(counter.bb.test + counter.simd_bb.test) / (float)totray;
+		face_tests = (float)counter.faces.test / (float)totray;
+#endif
+
+		shadow_hits = trace_rays(tree, RE_RAY_SHADOW, totray, start, dir, &shadow_time, &counter);
+
+		printf("%-12s %10.3f %10.3f %10d %10.3f %10.1f %10.1f\n",
+		       structures[s].name, build_time, mirror_time, mirror_hits, shadow_time, bb_tests, face_tests);
+
+		if (shadow_hits != mirror_hits)
+			printf("%-12s shadow rays found %d hits\n", "", shadow_hits);
+
+		RE_rayobject_free(tree);
+	}
+
+	MEM_freeN(co);
+	MEM_freeN(start);
+	MEM_freeN(dir);
+	MEM_freeN(faces);
+
+	BLI_threadapi_exit();
+
+	return 0;
+}
@@ -32,8 +32,11 @@
 
 #include <assert.h>
 #include <algorithm>
+#include <vector>
 
 #include "BLI_memarena.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
 
 #include "rayobject_rtbuild.h"
 
@@ -104,11 +107,28 @@ static void append_sibling(Node *node, Node *sibling)
 
 /*
  * Builds a binary VBVH from a rtbuild
+ *
+ * When the rtbuild has a task scheduler, the top levels are split on the calling thread
+ * (each split sweeping the three axes in parallel) and the subtrees below are built by tasks.
+ * Tasks allocate their nodes in blocks, so the arena is only locked once per block.
  */
+#define VBVH_NODE_BLOCK_SIZE 256
+
 template<class Node>
 struct BuildBinaryVBVH {
 	MemArena *arena;
 	RayObjectControl *control;
+	ThreadMutex arena_mutex;
+
+	struct NodeBlock {
+		Node *next, *end;
+	};
+
+	struct SubtreeTask {
+		BuildBinaryVBVH *build;
+		RTBuilder builder;
+		Node *node;
+	};
 
 	void test_break()
 	{
@@ -122,9 +142,24 @@ struct BuildBinaryVBVH {
 		control = c;
 	}
 
-	Node *create_node()
+	Node *create_node(NodeBlock *block)
 	{
-		Node *node = (Node *)BLI_memarena_alloc(arena, sizeof(Node) );
+		Node *node;
+
+		if (block) {
+			if (block->next == block->end) {
+				BLI_mutex_lock(&arena_mutex);
+				block->next = (Node *)BLI_memarena_alloc(arena, sizeof(Node) * VBVH_NODE_BLOCK_SIZE);
+				BLI_mutex_unlock(&arena_mutex);
+
+				block->end = block->next + VBVH_NODE_BLOCK_SIZE;
+			}
+
+			node = block->next++;
+		}
+		else
+			node = (Node *)BLI_memarena_alloc(arena, sizeof(Node) );
+
 		assert(RE_rayobject_isAligned(node));
 
 		node->sibling = NULL;
@@ -140,9 +175,12 @@ struct BuildBinaryVBVH {
 	
 	Node *transform(RTBuilder *builder)
 	{
+		if (builder->task_scheduler)
+			return transform_parallel(builder);
+
 		try
 		{
-			return _transform(builder);
+			return _transform(builder, NULL);
 			
 		} catch (...)
 		{
@@ -150,25 +188,30 @@ struct BuildBinaryVBVH {
 		return NULL;
 	}
 	
-	Node *_transform(RTBuilder *builder)
+	Node *_transform(RTBuilder *builder, NodeBlock *block)
 	{
 		int size = rtbuild_size(builder);
 
-		if (size == 0) {
+		if (size == 0)
 			return NULL;
-		}
-		else if (size == 1) {
-			Node *node = create_node();
+
+		Node *node = create_node(block);
+		_transform_node(builder, node, block);
+		return node;
+	}
+
+	void _transform_node(RTBuilder *builder, Node *node, NodeBlock *block)
+	{
+		int size = rtbuild_size(builder);
+
+		if (size == 1) {
 			INIT_MINMAX(node->bb, node->bb + 3);
 			rtbuild_merge_bb(builder, node->bb, node->bb + 3);
 			node->child = (Node *) rtbuild_get_primitive(builder, 0);
-			return node;
 		}
 		else {
 			test_break();
 			
-			Node *node = create_node();
-
 			Node **child = &node->child;
 
 			int nc = rtbuild_split(builder);
@@ -179,16 +222,122 @@ struct BuildBinaryVBVH {
 				RTBuilder tmp;
 				rtbuild_get_child(builder, i, &tmp);
 				
-				*child = _transform(&tmp);
+				*child = _transform(&tmp, block);
 				DO_MIN((*child)->bb, node->bb);
 				DO_MAX((*child)->bb + 3, node->bb + 3);
 				child = &((*child)->sibling);
 			}
 
 			*child = NULL;
-			return node;
 		}
 	}
+
+	static void subtree_task(TaskPool *UNUSED(pool), void *taskdata, int UNUSED(threadid))
+	{
+		SubtreeTask *task = (SubtreeTask *)taskdata;
+		NodeBlock block = {NULL, NULL};
+
+		try
+		{
+			task->build->_transform_node(&task->builder, task->node, &block);
+		} catch (...)
+		{
+			/* stopped, checked when all tasks are done */
+		}
+	}
+
+	/* split nodes on this thread until there are enough subtrees to keep all threads busy,
+	 * bounding boxes of the split nodes are calculated when the subtrees are done */
+	void _transform_top(TaskPool *pool, RTBuilder *builder, Node *node, int depth, NodeBlock *block,
+	                    std::vector<Node *> &top_nodes)
+	{
+		int size = rtbuild_size(builder);
+
+		if (depth == 0 || size < RTBUILD_PARALLEL_SIZE) {
+			SubtreeTask *task = (SubtreeTask *)MEM_mallocN(sizeof(SubtreeTask), "VBVH SubtreeTask");
+
+			task->build = this;
+			task->builder = *builder;
+			task->builder.task_scheduler = NULL;
+			task->node = node;
+
+			BLI_task_pool_push(pool, subtree_task, task, true, TASK_PRIORITY_HIGH);
+			return;
+		}
+
+		test_break();
+
+		top_nodes.push_back(node);
+
+		Node **child = &node->child;
+
+		int nc = rtbuild_split(builder);
+
+		assert(nc == 2);
+		for (int i = 0; i < nc; i++) {
+			RTBuilder tmp;
+			rtbuild_get_child(builder, i, &tmp);
+			tmp.task_scheduler = builder->task_scheduler;
+
+			*child = create_node(block);
+			_transform_top(pool, &tmp, *child, depth - 1, block, top_nodes);
+			child = &((*child)->sibling);
+		}
+
+		*child = NULL;
+	}
+
+	Node *transform_parallel(RTBuilder *builder)
+	{
+		int size = rtbuild_size(builder);
+		int num_threads = BLI_task_scheduler_num_threads(builder->task_scheduler);
+		int depth = 1;
+		bool stop = false;
+
+		if (size == 0)
+			return NULL;
+
+		/* about four subtrees per thread */
+		while ((1 << depth) < num_threads * 4)
+			depth++;
+
+		TaskPool *pool = BLI_task_pool_create(builder->task_scheduler, NULL);
+		std::vector<Node *> top_nodes;
+		NodeBlock block = {NULL, NULL};
+
+		BLI_mutex_init(&arena_mutex);
+
+		Node *root = create_node(&block);
+
+		try
+		{
+			_transform_top(pool, builder, root, depth, &block, top_nodes);
+		} catch (...)
+		{
+			stop = true;
+		}
+
+		BLI_task_pool_work_and_wait(pool);
+		BLI_task_pool_free(pool);
+
+		BLI_mutex_end(&arena_mutex);
+
+		if (stop || RE_rayobjectcontrol_test_break(control))
+			return NULL;
+
+		/* children of split nodes were added after them */
+		for (int i = (int)top_nodes.size() - 1; i >= 0; i--) {
+			Node *node = top_nodes[i];
+
+			INIT_MINMAX(node->bb, node->bb + 3);
+			for (Node *child = node->child; child; child = child->sibling) {
+				DO_MIN(child->bb, node->bb);
+				DO_MAX(child->bb + 3, node->bb + 3);
+			}
+		}
+
+		return root;
+	}
 };
 
 #if 0
@@ -40,6 +40,7 @@
 #include "BLI_utildefines.h"
 #include "BLI_rand.h"
 #include "BLI_memarena.h"
+#include "BLI_task.h"
 #include "BLI_ghash.h"
 #include "BLI_linklist.h"
 #ifdef WITH_FREESTYLE
@@ -3725,8 +3726,12 @@ static void init_render_mesh(Render *re, ObjectRen *obr, int timeoffset)
 			autosmooth(re, obr, mat, me->smoothresh);
 		}
 
-		if (recalc_normals!=0 || need_tangent!=0)
-			calc_vertexnormals(re, obr, need_tangent, need_nmap_tangent);
+		/* done in finalize_render_object, in parallel for all objects */
+		if (recalc_normals!=0 || need_tangent!=0) {
+			obr->flag |= R_CALC_VNORMALS;
+			if (need_tangent) obr->flag |= R_CALC_TANGENT;
+			if (need_nmap_tangent) obr->flag |= R_CALC_NMAP_TANGENT;
+		}
 	}
 
 	dm->release(dm);
@@ -4219,8 +4224,9 @@ void init_render_world(Render *re)
 /* Object Finalization														 */
 /* ------------------------------------------------------------------------- */
 
-/* prevent phong interpolation for giving ray shadow errors (terminator problem) */
-static void set_phong_threshold(ObjectRen *obr)
+/* prevent phong interpolation for giving ray shadow errors (terminator problem),
+ * returns the smoothresh for the object, 0.0 when it has no smooth faces */
+static float phong_threshold(ObjectRen *obr)
 {
 //	VertRen *ver;
 	VlakRen *vlr;
@@ -4263,8 +4269,10 @@ static void set_phong_threshold(ObjectRen *obr)
 	
 	if (tot) {
 		thresh/= (float)tot;
-		obr->ob->smoothresh= cosf(0.5f*(float)M_PI-saacos(thresh));
+		return cosf(0.5f*(float)M_PI-saacos(thresh));
 	}
+
+	return 0.0f;
 }
 
 /* per face check if all samples should be taken.
@@ -4505,83 +4513,85 @@ static void check_non_flat_quads(ObjectRen *obr)
 	}
 }
 
-static void finalize_render_object(Render *re, ObjectRen *obr, int timeoffset)
+/* only accesses the ObjectRen, so it can run in parallel for all objects,
+ * the phong threshold is returned rather than set on the shared Object */
+static float finalize_render_object(Render *re, ObjectRen *obr)
 {
 	Object *ob= obr->ob;
 	VertRen *ver= NULL;
 	StrandRen *strand= NULL;
 	StrandBound *sbound= NULL;
 	float min[3], max[3], smin[3], smax[3];
+	float smoothresh= 0.0f;
 	int a, b;
 
-	if (obr->totvert || obr->totvlak || obr->tothalo || obr->totstrand) {
-		/* the exception below is because displace code now is in init_render_mesh call, 
-		 * I will look at means to have autosmooth enabled for all object types
-		 * and have it as general postprocess, like displace */
-		if (ob->type!=OB_MESH && test_for_displace(re, ob))
-			do_displacement(re, obr, NULL, NULL);
-	
-		if (!timeoffset) {
-			/* phong normal interpolation can cause error in tracing
-			 * (terminator problem) */
-			ob->smoothresh= 0.0;
-			if ((re->r.mode & R_RAYTRACE) && (re->r.mode & R_SHADOW))
-				set_phong_threshold(obr);
-			
-			if (re->flag & R_BAKING && re->r.bake_quad_split != 0) {
-				/* Baking lets us define a quad split order */
-				split_quads(obr, re->r.bake_quad_split);
-			}
-			else if (BKE_object_is_animated(re->scene, ob))
-				split_quads(obr, 1);
-			else {
-				if ((re->r.mode & R_SIMPLIFY && re->r.simplify_flag & R_SIMPLE_NO_TRIANGULATE) == 0)
-					check_non_flat_quads(obr);
-			}
-			
-			set_fullsample_trace_flag(re, obr);
+	if (obr->flag & R_CALC_VNORMALS) {
+		calc_vertexnormals(re, obr, (obr->flag & R_CALC_TANGENT) != 0, (obr->flag & R_CALC_NMAP_TANGENT) != 0);
+		obr->flag &= ~(R_CALC_VNORMALS | R_CALC_TANGENT | R_CALC_NMAP_TANGENT);
+	}
 
-			/* compute bounding boxes for clipping */
-			INIT_MINMAX(min, max);
-			for (a=0; a<obr->totvert; a++) {
-				if ((a & 255)==0) ver= obr->vertnodes[a>>8].vert;
-				else ver++;
+	if (!(obr->totvert || obr->totvlak || obr->tothalo || obr->totstrand))
+		return smoothresh;
 
-				minmax_v3v3_v3(min, max, ver->co);
-			}
+	/* phong normal interpolation can cause error in tracing
+	 * (terminator problem) */
+	if ((re->r.mode & R_RAYTRACE) && (re->r.mode & R_SHADOW))
+		smoothresh= phong_threshold(obr);
+	
+	if (re->flag & R_BAKING && re->r.bake_quad_split != 0) {
+		/* Baking lets us define a quad split order */
+		split_quads(obr, re->r.bake_quad_split);
+	}
+	else if (BKE_object_is_animated(re->scene, ob))
+		split_quads(obr, 1);
+	else {
+		if ((re->r.mode & R_SIMPLIFY && re->r.simplify_flag & R_SIMPLE_NO_TRIANGULATE) == 0)
+			check_non_flat_quads(obr);
+	}
+	
+	set_fullsample_trace_flag(re, obr);
 
-			if (obr->strandbuf) {
-				float width;
-				
-				/* compute average bounding box of strandpoint itself (width) */
-				if (obr->strandbuf->flag & R_STRAND_B_UNITS)
-					obr->strandbuf->maxwidth = max_ff(obr->strandbuf->ma->strand_sta, obr->strandbuf->ma->strand_end);
-				else
-					obr->strandbuf->maxwidth= 0.0f;
-				
-				width= obr->strandbuf->maxwidth;
-				sbound= obr->strandbuf->bound;
-				for (b=0; b<obr->strandbuf->totbound; b++, sbound++) {
-					
-					INIT_MINMAX(smin, smax);
+	/* compute bounding boxes for clipping */
+	INIT_MINMAX(min, max);
+	for (a=0; a<obr->totvert; a++) {
+		if ((a & 255)==0) ver= obr->vertnodes[a>>8].vert;
+		else ver++;
 
-					for (a=sbound->start; a<sbound->end; a++) {
-						strand= RE_findOrAddStrand(obr, a);
-						strand_minmax(strand, smin, smax, width);
-					}
+		minmax_v3v3_v3(min, max, ver->co);
+	}
 
-					copy_v3_v3(sbound->boundbox[0], smin);
-					copy_v3_v3(sbound->boundbox[1], smax);
+	if (obr->strandbuf) {
+		float width;
+		
+		/* compute average bounding box of strandpoint itself (width) */
+		if (obr->strandbuf->flag & R_STRAND_B_UNITS)
+			obr->strandbuf->maxwidth = max_ff(obr->strandbuf->ma->strand_sta, obr->strandbuf->ma->strand_end);
+		else
+			obr->strandbuf->maxwidth= 0.0f;
+		
+		width= obr->strandbuf->maxwidth;
+		sbound= obr->strandbuf->bound;
+		for (b=0; b<obr->strandbuf->totbound; b++, sbound++) {
+			
+			INIT_MINMAX(smin, smax);
 
-					minmax_v3v3_v3(min, max, smin);
-					minmax_v3v3_v3(min, max, smax);
-				}
+			for (a=sbound->start; a<sbound->end; a++) {
+				strand= RE_findOrAddStrand(obr, a);
+				strand_minmax(strand, smin, smax, width);
 			}
 
-			copy_v3_v3(obr->boundbox[0], min);
-			copy_v3_v3(obr->boundbox[1], max);
+			copy_v3_v3(sbound->boundbox[0], smin);
+			copy_v3_v3(sbound->boundbox[1], smax);
+
+			minmax_v3v3_v3(min, max, smin);
+			minmax_v3v3_v3(min, max, smax);
 		}
 	}
+
+	copy_v3_v3(obr->boundbox[0], min);
+	copy_v3_v3(obr->boundbox[1], max);
+
+	return smoothresh;
 }
 
 /* ------------------------------------------------------------------------- */
@@ -4764,7 +4774,14 @@ static void init_render_object_data(Render *re, ObjectRen *obr, int timeoffset)
 			init_render_mball(re, obr);
 	}
 
-	finalize_render_object(re, obr, timeoffset);
+	/* the exception below is because displace code now is in init_render_mesh call, 
+	 * I will look at means to have autosmooth enabled for all object types
+	 * and have it as general postprocess, like displace */
+	if (obr->totvert || obr->totvlak || obr->tothalo || obr->totstrand)
+		if (ob->type!=OB_MESH && test_for_displace(re, ob))
+			do_displacement(re, obr, NULL, NULL);
+
+	/* finalize_render_object is done by database_finalize_objects */
 
 	re->totvert += obr->totvert;
 	re->totvlak += obr->totvlak;
@@ -5096,8 +5113,94 @@ static void add_group_render_dupli_obs(Render *re, Group *group, int nolamps, in
 	}
 }
 
+typedef struct FinalizeObject {
+	ObjectRen *obr;
+	float smoothresh;
+} FinalizeObject;
+
+static void finalize_render_object_task(TaskPool *pool, void *taskdata, int UNUSED(threadid))
+{
+	Render *re = (Render *)BLI_task_pool_userdata(pool);
+	FinalizeObject *fo = (FinalizeObject *)taskdata;
+
+	fo->smoothresh = finalize_render_object(re, fo->obr);
+}
+
+/* finalize the objects converted after obr_prev, in parallel. objects are converted
+ * serially since modifier and particle evaluation is not thread safe, but after that
+ * normals, tangents, quad splitting and bounds only need the ObjectRen itself. the
+ * results are applied in object order, so they are the same as converting serially */
+static void database_finalize_objects(Render *re, ObjectRen *obr_prev)
+{
+	ObjectRen *obr, *obr_first = (obr_prev)? obr_prev->next: re->objecttable.first;
+	FinalizeObject *objects;
+	int a, totobject = 0;
+
+	for (obr = obr_first; obr; obr = obr->next)
+		totobject++;
+
+	if (totobject == 0)
+		return;
+
+	objects = MEM_mallocN(sizeof(FinalizeObject) * totobject, "FinalizeObject");
+
+	for (obr = obr_first, a = 0; obr; obr = obr->next, a++) {
+		objects[a].obr = obr;
+		objects[a].smoothresh = 0.0f;
+
+		/* quads can get split, faces are counted again afterwards */
+		re->totvlak -= obr->totvlak;
+	}
+
+	if (re->r.threads > 1 && totobject > 1) {
+		TaskScheduler *task_scheduler = BLI_task_scheduler_create(re->r.threads);
+		TaskPool *task_pool = BLI_task_pool_create(task_scheduler, re);
+
+		for (a = 0; a < totobject; a++)
+			BLI_task_pool_push(task_pool, finalize_render_object_task, &objects[a], false, TASK_PRIORITY_HIGH);
+
+		BLI_task_pool_work_and_wait(task_pool);
+
+		BLI_task_pool_free(task_pool);
+		BLI_task_scheduler_free(task_scheduler);
+	}
+	else {
+		for (a = 0; a < totobject; a++)
+			objects[a].smoothresh = finalize_render_object(re, objects[a].obr);
+	}
+
+	for (a = 0; a < totobject; a++) {
+		obr = objects[a].obr;
+
+		if (obr->totvert || obr->totvlak || obr->tothalo || obr->totstrand)
+			obr->ob->smoothresh = objects[a].smoothresh;
+
+		re->totvlak += obr->totvlak;
+	}
+
+	MEM_freeN(objects);
+}
+
+static void database_init_objects_stats(Render *re, double starttime, double finalizetime)
+{
+	const char *infostr = re->i.infostr;
+	char str[256], convertstr[32], finalizestr[32];
+	double endtime = PIL_check_seconds_timer();
+
+	BLI_timestr(finalizetime - starttime, convertstr, sizeof(convertstr));
+	BLI_timestr(endtime - finalizetime, finalizestr, sizeof(finalizestr));
+	BLI_snprintf(str, sizeof(str), IFACE_("Preparing Scene data | Convert: %s, Finalize: %s"),
+	             convertstr, finalizestr);
+
+	re->i.infostr = str;
+	re->stats_draw(re->sdh, &re->i);
+	re->i.infostr = infostr;
+}
+
 static void database_init_objects(Render *re, unsigned int renderlay, int nolamps, int onlyselected, Object *actob, int timeoffset)
 {
+	ObjectRen *obr_prev = re->objecttable.last;
+	double starttime = PIL_check_seconds_timer(), finalizetime;
 	Base *base;
 	Object *ob;
 	Group *group;
@@ -5267,8 +5370,15 @@ static void database_init_objects(Render *re, unsigned int renderlay, int nolamp
 	for (group= re->main->group.first; group; group=group->id.next)
 		add_group_render_dupli_obs(re, group, nolamps, onlyselected, actob, timeoffset, 0);
 
-	if (!re->test_break(re->tbh))
+	/* normals, quad splitting and bounds, not needed for speed vectors */
+	finalizetime = PIL_check_seconds_timer();
+	if (!timeoffset && !re->test_break(re->tbh))
+		database_finalize_objects(re, obr_prev);
+
+	if (!re->test_break(re->tbh)) {
 		RE_makeRenderInstances(re);
+		database_init_objects_stats(re, starttime, finalizetime);
+	}
 }
 
 /* used to be 'rotate scene' */
@@ -5455,8 +5565,8 @@ void RE_DataBase_IncrementalView(Render *re, float viewmat[4][4], int restore)
 	
 	env_rotate_scene(re, tmat, !restore);
 
-	/* SSS points distribution depends on view */
-	if ((re->r.mode & R_SSS) && !re->test_break(re->tbh))
+	/* SSS points distribution depends on view, restoring is followed by a new view */
+	if (!restore && (re->r.mode & R_SSS) && !re->test_break(re->tbh))
 		make_sss_tree(re);
 }
 
@@ -948,6 +948,9 @@ static void *do_part_thread(void *pa_v)
 {
 	RenderPart *pa = pa_v;
 
+	/* tags are per thread */
+	MEM_tag_push(MEM_TAG_RENDER);
+
 	pa->status = PART_STATUS_IN_PROGRESS;
 
 	/* need to return nicely all parts on esc */
@@ -987,6 +990,8 @@ static void *do_part_thread(void *pa_v)
 	}
 	
 	pa->status = PART_STATUS_READY;
+
+	MEM_tag_pop();
 	
 	return NULL;
 }
@@ -1326,10 +1331,67 @@ void RE_TileProcessor(Render *re)
 
 /* ************  This part uses API, for rendering Blender scenes ********** */
 
+/* the database of the first view can be rotated into the other view cameras,
+ * like the preview render does, unless it contains view dependent data */
+static int render_views_share_database(Render *re)
+{
+	if ((re->r.mode & R_VIEWS_SHARE_DATA) == 0)
+		return 0;
+
+	/* speed vectors need a database per view */
+	if ((re->r.mode & R_PANORAMA) || render_scene_needs_vector(re))
+		return 0;
+
+	/* the raytree is built from the geometry in the camera space of the first view,
+	 * rotating the database only transforms instances and lamps */
+	if (re->r.mode & R_RAYTRACE)
+		return 0;
+
+	/* approximate AO is gathered in camera space */
+	if (re->wrld.mode & (WO_AMB_OCC | WO_ENV_LIGHT | WO_INDIRECT_LIGHT))
+		if (re->wrld.ao_gather_method == WO_AOGATHER_APPROX)
+			return 0;
+
+	/* volume light cache and camera inside volume tests are done in camera space */
+	if (re->volumes.first)
+		return 0;
+
+	return 1;
+}
+
+static void render_view_rotate_database(Render *re)
+{
+	Object *camera = RE_GetViewCamera(re);
+	float mat[4][4];
+
+	RE_SetCamera(re, camera);
+
+	normalize_m4_m4(mat, camera->obmat);
+	invert_m4(mat);
+
+	RE_DataBase_IncrementalView(re, mat, 0);
+	RE_DataBase_ApplyWindow(re);
+}
+
+static void render_view_stats(Render *re, const char *viewname, double starttime, int shared)
+{
+	char str[256], timestr[64];
+
+	BLI_timestr(PIL_check_seconds_timer() - starttime, timestr, sizeof(timestr));
+	BLI_snprintf(str, sizeof(str), IFACE_("View %s done, Time: %s%s"), viewname, timestr,
+	             shared ? IFACE_(" (shared database)") : "");
+
+	re->i.infostr = str;
+	re->stats_draw(re->sdh, &re->i);
+	re->i.infostr = NULL;
+}
+
 static void do_render_3d(Render *re)
 {
+	RenderView *rv;
 	int cfra_backup;
 	int view, numviews;
+	int shared_database = FALSE;
 
 	/* try external */
 	if (RE_engine_render(re, 0))
@@ -1346,9 +1408,10 @@ static void do_render_3d(Render *re)
 	/* init main render result */
 	main_render_result_new(re);
 
-	/* we need a new database for each view */
+	/* we need a new database for each view, unless it can be shared */
 	numviews = BLI_countlist(&re->result->views);
-	for (view = 0; view < numviews; view++) {
+	for (view = 0, rv = re->result->views.first; view < numviews; view++, rv = rv->next) {
+		double view_starttime = PIL_check_seconds_timer();
 
 		re->actview = view;
 
@@ -1357,7 +1420,9 @@ static void do_render_3d(Render *re)
 			re->draw_lock(re->dlh, 1);
 
 		/* make render verts/faces/halos/lamps */
-		if (render_scene_needs_vector(re))
+		if (shared_database)
+			render_view_rotate_database(re);
+		else if (render_scene_needs_vector(re))
 			RE_Database_FromScene_Vectors(re, re->main, re->scene, re->lay);
 		else {
 			RE_Database_FromScene(re, re->main, re->scene, re->lay, 1);
@@ -1382,10 +1447,23 @@ static void do_render_3d(Render *re)
 			if (!re->test_break(re->tbh))
 				add_halo_flare(re);
 
-		/* free all render verts etc */
-		RE_Database_Free(re);
+		if (numviews > 1)
+			render_view_stats(re, rv->name, view_starttime, shared_database);
+
+		/* keep the database for the next view, rotated back to the first view */
+		if (shared_database)
+			RE_DataBase_IncrementalView(re, re->viewmat, 1);
+		else if (view + 1 < numviews && !re->test_break(re->tbh) && render_views_share_database(re))
+			shared_database = TRUE;
+		else {
+			/* free all render verts etc */
+			RE_Database_Free(re);
+		}
 	}
 
+	if (shared_database)
+		RE_Database_Free(re);
+
 	main_render_result_end(re);
 
 	re->scene->r.cfra = cfra_backup;
@@ -2389,6 +2467,8 @@ static void do_render_seq(Render *re)
 /* main loop: doing sequence + fields + blur + 3d render + compositing */
 static void do_render_all_options(Render *re)
 {
+	MEM_tag_push(MEM_TAG_RENDER);
+
 	BKE_scene_camera_switch_update(re->scene);
 
 	re->i.starttime = PIL_check_seconds_timer();
@@ -2425,6 +2505,8 @@ static void do_render_all_options(Render *re)
 		renderresult_stampinfo(re);
 		re->display_draw(re->ddh, re->result, NULL, re->actview);
 	}
+
+	MEM_tag_pop();
 }
 
 static int check_valid_camera(Scene *scene, Object *camera_override)
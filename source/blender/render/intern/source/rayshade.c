@@ -42,9 +42,11 @@
 
 #include "BLI_blenlib.h"
 #include "BLI_cpu.h"
+#include "BLI_ghash.h"
 #include "BLI_jitter.h"
 #include "BLI_math.h"
 #include "BLI_rand.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include "BLF_translation.h"
@@ -87,12 +89,13 @@ static int test_break(void *data)
 	return re->test_break(re->tbh);
 }
 
-static void RE_rayobject_config_control(RayObject *r, Render *re)
+static void RE_rayobject_config_control(RayObject *r, Render *re, int num_threads)
 {
 	if (RE_rayobject_isRayAPI(r)) {
 		r = RE_rayobject_align(r);
 		r->control.data = re;
 		r->control.test_break = test_break;
+		r->control.num_threads = num_threads;
 	}
 }
 
@@ -134,14 +137,14 @@ RayObject *RE_rayobject_create(int type, int size, int octree_resolution)
 	return res;
 }
 
-static RayObject* rayobject_create(Render *re, int type, int size)
+static RayObject* rayobject_create(Render *re, int type, int size, int num_threads)
 {
 	RayObject * res = NULL;
 
 	res = RE_rayobject_create(type, size, re->r.ocres);
 	
 	if (res)
-		RE_rayobject_config_control(res, re);
+		RE_rayobject_config_control(res, re, num_threads);
 
 	return res;
 }
@@ -224,7 +227,7 @@ static int is_raytraceable(Render *re, ObjectInstanceRen *obi)
 }
 
 
-RayObject* makeraytree_object(Render *re, ObjectInstanceRen *obi)
+static RayObject* makeraytree_object_ex(Render *re, ObjectInstanceRen *obi, int num_threads)
 {
 	/*TODO
 	 * out-of-memory safeproof
@@ -250,7 +253,7 @@ RayObject* makeraytree_object(Render *re, ObjectInstanceRen *obi)
 			return NULL;
 
 		//Create Ray cast accelaration structure
-		raytree = rayobject_create( re,  re->r.raytrace_structure, faces );
+		raytree = rayobject_create( re,  re->r.raytrace_structure, faces, num_threads );
 		if (  (re->r.raytrace_options & R_RAYTRACE_USE_LOCAL_COORDS) )
 			vlakprimitive = obr->rayprimitives = (VlakPrimitive *)MEM_callocN(faces * sizeof(VlakPrimitive), "ObjectRen primitives");
 		else
@@ -292,6 +295,11 @@ RayObject* makeraytree_object(Render *re, ObjectInstanceRen *obi)
 	return obi->obr->raytree;
 }
 
+RayObject* makeraytree_object(Render *re, ObjectInstanceRen *obi)
+{
+	return makeraytree_object_ex(re, obi, re->r.threads);
+}
+
 static int has_special_rayobject(Render *re, ObjectInstanceRen *obi)
 {
 	if ( (obi->flag & R_TRANSFORMED) && (re->r.raytrace_options & R_RAYTRACE_USE_INSTANCES) ) {
@@ -309,6 +317,47 @@ static int has_special_rayobject(Render *re, ObjectInstanceRen *obi)
 	}
 	return 0;
 }
+static void makeraytree_object_task(TaskPool *pool, void *taskdata, int UNUSED(threadid))
+{
+	Render *re = (Render *)BLI_task_pool_userdata(pool);
+
+	/* objects are already built in parallel, build each tree on one thread */
+	makeraytree_object_ex(re, (ObjectInstanceRen *)taskdata, 1);
+}
+
+/* build the trees of instanced objects concurrently, for the first instance of every
+ * object, in the same way makeraytree_single would build them one after the other */
+static void makeraytree_objects_threaded(Render *re)
+{
+	TaskScheduler *task_scheduler;
+	TaskPool *task_pool;
+	ObjectInstanceRen *obi;
+	GHash *objects;
+
+	if (re->r.threads <= 1)
+		return;
+
+	task_scheduler = BLI_task_scheduler_create(re->r.threads);
+	task_pool = BLI_task_pool_create(task_scheduler, re);
+	objects = BLI_ghash_ptr_new("makeraytree_objects_threaded gh");
+
+	for (obi = re->instancetable.first; obi; obi = obi->next) {
+		if (obi->obr->raytree || BLI_ghash_haskey(objects, obi->obr))
+			continue;
+
+		if (is_raytraceable(re, obi) && has_special_rayobject(re, obi)) {
+			BLI_ghash_insert(objects, obi->obr, obi);
+			BLI_task_pool_push(task_pool, makeraytree_object_task, obi, false, TASK_PRIORITY_HIGH);
+		}
+	}
+
+	BLI_task_pool_work_and_wait(task_pool);
+
+	BLI_ghash_free(objects, NULL, NULL);
+	BLI_task_pool_free(task_pool);
+	BLI_task_scheduler_free(task_scheduler);
+}
+
 /*
  * create a single raytrace structure with all faces
  */
@@ -344,7 +393,11 @@ static void makeraytree_single(Render *re)
 	}
 	
 	//Create raytree
-	raytree = re->raytree = rayobject_create( re, re->r.raytrace_structure, faces+special );
+	/* trees of instanced objects are built in parallel first */
+	if (special > 1)
+		makeraytree_objects_threaded(re);
+
+	raytree = re->raytree = rayobject_create( re, re->r.raytrace_structure, faces+special, re->r.threads );
 
 	if ( (re->r.raytrace_options & R_RAYTRACE_USE_LOCAL_COORDS) ) {
 		vlakprimitive = re->rayprimitives = (VlakPrimitive *)MEM_callocN(faces * sizeof(VlakPrimitive), "Raytrace vlak-primitives");
@@ -412,6 +465,7 @@ static void makeraytree_single(Render *re)
 void makeraytree(Render *re)
 {
 	float min[3], max[3], sub[3];
+	double starttime;
 	int i;
 	
 	re->i.infostr = IFACE_("Raytree.. preparing");
@@ -422,6 +476,8 @@ void makeraytree(Render *re)
 	if (re->r.raytrace_structure == R_RAYSTRUCTURE_OCTREE)
 		re->r.raytrace_options &= ~( R_RAYTRACE_USE_INSTANCES | R_RAYTRACE_USE_LOCAL_COORDS);
 
+	starttime = PIL_check_seconds_timer();
+
 	makeraytree_single(re);
 
 	if (test_break(re)) {
@@ -448,6 +504,10 @@ void makeraytree(Render *re)
 
 		re->maxdist = len_v3(sub);
 
+		if (G.debug & G_DEBUG) {
+			printf("Raytree built in %.3fs with %d threads\n", PIL_check_seconds_timer() - starttime, re->r.threads);
+		}
+
 		re->i.infostr = IFACE_("Raytree finished");
 		re->stats_draw(re->sdh, &re->i);
 	}
@@ -310,6 +310,7 @@ static int print_help(int UNUSED(argc), const char **UNUSED(argv), void *data)
 	BLI_argsPrintArgDoc(ba, "--debug-libmv");
 #endif
 	BLI_argsPrintArgDoc(ba, "--debug-memory");
+	BLI_argsPrintArgDoc(ba, "--threadcache-memory");
 	BLI_argsPrintArgDoc(ba, "--debug-jobs");
 	BLI_argsPrintArgDoc(ba, "--debug-python");
 
@@ -455,6 +456,12 @@ static int debug_mode_memory(int UNUSED(argc), const char **UNUSED(argv), void *
 	return 0;
 }
 
+static int threadcache_memory(int UNUSED(argc), const char **UNUSED(argv), void *UNUSED(data))
+{
+	/* the allocator is switched in main(), before anything is allocated */
+	return 0;
+}
+
 static int set_debug_value(int argc, const char **argv, void *UNUSED(data))
 {
 	if (argc > 1) {
@@ -1400,6 +1407,7 @@ static void setupArguments(bContext *C, bArgs *ba, SYS_SystemHandle *syshandle)
 	BLI_argsAdd(ba, 1, NULL, "--debug-libmv", "\n\tEnable debug messages from libmv library", debug_mode_libmv, NULL);
 #endif
 	BLI_argsAdd(ba, 1, NULL, "--debug-memory", "\n\tEnable fully guarded memory allocation and debugging", debug_mode_memory, NULL);
+	BLI_argsAdd(ba, 1, NULL, "--threadcache-memory", "\n\tEnable per thread caching of small memory allocations (faster with many threads, cached memory isn't freed)", threadcache_memory, NULL);
 
 	BLI_argsAdd(ba, 1, NULL, "--debug-value", "<value>\n\tSet debug value of <value> on startup\n", set_debug_value, NULL);
 	BLI_argsAdd(ba, 1, NULL, "--debug-jobs",  "\n\tEnable time profiling for background jobs.", debug_mode_generic, (void *)G_DEBUG_JOBS);
@@ -1498,18 +1506,27 @@ int main(int argc, const char **argv)
 	 */
 	{
 		int i;
+		bool use_threadcache = false;
 		for (i = 0; i < argc; i++) {
 			if (STREQ(argv[i], "--debug") || STREQ(argv[i], "-d") ||
 			    STREQ(argv[i], "--debug-memory"))
 			{
 				printf("Switching to fully guarded memory allocator.\n");
 				MEM_use_guarded_allocator();
+				use_threadcache = false;
 				break;
 			}
+			else if (STREQ(argv[i], "--threadcache-memory")) {
+				use_threadcache = true;
+			}
 			else if (STREQ(argv[i], "--")) {
 				break;
 			}
 		}
+
+		if (use_threadcache) {
+			MEM_use_threadcache_allocator();
+		}
 	}
 
 #ifdef BUILD_DATE
@@ -250,6 +250,18 @@ BL_ArmatureObject::BL_ArmatureObject(
 	game_copy_pose(&m_pose, m_objArma->pose, 1);
 	// store the original armature object matrix
 	memcpy(m_obmat, m_objArma->obmat, sizeof(m_obmat));
+
+	/* the pose is evaluated on a private copy of the blender object, so the
+	 * replicas don't have to be updated one after the other */
+	m_objPose = (Object *)MEM_mallocN(sizeof(Object), "BL_ArmatureObject pose object");
+	memcpy(m_objPose, m_objArma, sizeof(Object));
+	m_objPose->pose = m_pose;
+
+	m_hasConstraints = false;
+	for (bPoseChannel *pchan = (bPoseChannel *)m_pose->chanbase.first; pchan; pchan = pchan->next) {
+		if (pchan->constraints.first)
+			m_hasConstraints = true;
+	}
 }
 
 BL_ArmatureObject::~BL_ArmatureObject()
@@ -266,6 +278,8 @@ BL_ArmatureObject::~BL_ArmatureObject()
 		game_free_pose(m_pose);
 	if (m_framePose)
 		game_free_pose(m_framePose);
+	if (m_objPose)
+		MEM_freeN(m_objPose);
 }
 
 
@@ -437,6 +451,9 @@ void BL_ArmatureObject::ProcessReplica()
 	m_pose = NULL;
 	m_framePose = NULL;
 	game_copy_pose(&m_pose, pose, 1);
+
+	m_objPose = (Object *)MEM_dupallocN(m_objPose);
+	m_objPose->pose = m_pose;
 }
 
 void BL_ArmatureObject::ReParentLogic()
@@ -472,24 +489,38 @@ void BL_ArmatureObject::ApplyPose()
 {
 	m_armpose = m_objArma->pose;
 	m_objArma->pose = m_pose;
+	UpdatePose();
+}
+
+void BL_ArmatureObject::UpdatePose()
+{
 	// in the GE, we use ctime to store the timestep
 	m_pose->ctime = (float)m_timestep;
 	//m_scene->r.cfra++;
 	if (m_lastapplyframe != m_lastframe) {
+		bPose *armpose = m_objArma->pose;
+
+		// bone constraints can target the armature itself through its blender object
+		if (m_hasConstraints)
+			m_objArma->pose = m_pose;
+
 		// update the constraint if any, first put them all off so that only the active ones will be updated
 		SG_DList::iterator<BL_ArmatureConstraint> cit(m_controlledConstraints);
 		for (cit.begin(); !cit.end(); ++cit) {
 			(*cit)->UpdateTarget();
 		}
-		// update ourself
-		UpdateBlenderObjectMatrix(m_objArma);
-		BKE_pose_where_is(m_scene, m_objArma); // XXX
+		// update ourself, on our copy of the blender object
+		memcpy(m_objPose, m_objArma, sizeof(Object));
+		m_objPose->pose = m_pose;
+		UpdateBlenderObjectMatrix(m_objPose);
+		BKE_pose_where_is(m_scene, m_objPose); // XXX
 		// restore ourself
-		memcpy(m_objArma->obmat, m_obmat, sizeof(m_obmat));
+		memcpy(m_objPose->obmat, m_obmat, sizeof(m_obmat));
 		// restore active targets
 		for (cit.begin(); !cit.end(); ++cit) {
 			(*cit)->RestoreTarget();
 		}
+		m_objArma->pose = armpose;
 		m_lastapplyframe = m_lastframe;
 	}
 }
@@ -80,6 +80,13 @@ public:
 
 	void ApplyPose();
 	void RestorePose();
+	/**
+	 * Update the bone matrices of the pose for the current frame. Unlike
+	 * ApplyPose() the pose isn't set on the blender object, use GetPoseObject()
+	 * to read it. Without constraints the blender object isn't changed at all,
+	 * so armatures sharing it can be updated at the same time.
+	 */
+	void UpdatePose();
 
 	bool SetActiveAction(class BL_ActionActuator *act, short priority, double curtime);
 	
@@ -88,6 +95,9 @@ public:
 	const struct Scene * GetScene() const { return m_scene; }
 	
 	Object* GetArmatureObject() {return m_objArma;}
+	/// Private copy of the blender object, with the pose of this armature
+	Object* GetPoseObject() {return m_objPose;}
+	bool HasConstraints() const {return m_hasConstraints;}
 
 	int GetVertDeformType() {return m_vert_deform_type;}
 
@@ -128,6 +138,7 @@ protected:
 	/* list element: BL_ArmatureChannel. Use SG_DList to avoid list replication */
 	SG_DList			m_poseChannels;
 	Object				*m_objArma;
+	Object				*m_objPose;
 	struct bArmature	*m_armature;
 	struct bPose		*m_pose;
 	struct bPose		*m_armpose;
@@ -144,6 +155,7 @@ protected:
 	float m_obmat[4][4];
 
 	double			m_lastapplyframe;
+	bool			m_hasConstraints;
 };
 
 /* Pose function specific to the game engine */
@@ -33,10 +33,6 @@
 #  pragma warning (disable:4786)
 #endif
 
-// Eigen3 stuff used for BGEDeformVerts
-#include <Eigen/Core>
-#include <Eigen/LU>
-
 #include "BL_SkinDeformer.h"
 #include "CTR_Map.h"
 #include "STR_HashedString.h"
@@ -96,7 +92,11 @@ BL_SkinDeformer::BL_SkinDeformer(BL_DeformableGameObject *gameobj,
 							m_poseApplied(false),
 							m_recalcNormal(true),
 							m_copyNormals(false),
-							m_dfnrToPC(NULL)
+							m_deformedAhead(false),
+							m_dfnrToPC(NULL),
+							m_skinGroups(NULL),
+							m_skinWeights(NULL),
+							m_skinMats(NULL)
 {
 	copy_m4_m4(m_obmat, bmeshobj->obmat);
 	m_deformflags = get_deformflags(bmeshobj);
@@ -117,7 +117,11 @@ BL_SkinDeformer::BL_SkinDeformer(
 		m_releaseobject(release_object),
 		m_recalcNormal(recalc_normal),
 		m_copyNormals(false),
-		m_dfnrToPC(NULL)
+		m_deformedAhead(false),
+		m_dfnrToPC(NULL),
+		m_skinGroups(NULL),
+		m_skinWeights(NULL),
+		m_skinMats(NULL)
 	{
 		// this is needed to ensure correct deformation of mesh:
 		// the deformation is done with Blender's armature_deform_verts() function
@@ -134,6 +138,12 @@ BL_SkinDeformer::~BL_SkinDeformer()
 		m_armobj->Release();
 	if (m_dfnrToPC)
 		delete [] m_dfnrToPC;
+	if (m_skinGroups)
+		delete [] m_skinGroups;
+	if (m_skinWeights)
+		delete [] m_skinWeights;
+	if (m_skinMats)
+		delete [] m_skinMats;
 }
 
 void BL_SkinDeformer::Relink(CTR_Map<class CTR_HashedPtr, void*>*map)
@@ -157,10 +167,12 @@ bool BL_SkinDeformer::Apply(RAS_IPolyMaterial *mat)
 	RAS_MeshSlot *slot;
 	size_t i, nmat, imat;
 
-	// update the vertex in m_transverts
-	if (!Update())
+	// update the vertex in m_transverts, unless DeformAhead() already did
+	if (!Update() && !m_deformedAhead)
 		return false;
 
+	m_deformedAhead = false;
+
 	if (m_transverts) {
 		// the vertex cache is unique to this deformer, no need to update it
 		// if it wasn't updated! We must update all the materials at once
@@ -207,23 +219,22 @@ void BL_SkinDeformer::ProcessReplica()
 	BL_MeshDeformer::ProcessReplica();
 	m_lastArmaUpdate = -1;
 	m_releaseobject = false;
+	m_deformedAhead = false;
 	m_dfnrToPC = NULL;
+	m_skinGroups = NULL;
+	m_skinWeights = NULL;
+	m_skinMats = NULL;
 }
 
 void BL_SkinDeformer::BlenderDeformVerts()
 {
-	float obmat[4][4];	// the original object matrix
-	Object* par_arma = m_armobj->GetArmatureObject();
+	Object* par_arma = m_armobj->GetPoseObject();
+	// the blender object is shared by the replicas, deform a copy with the reference matrix
+	Object ob_mesh = *m_objMesh;
 
-	// save matrix first
-	copy_m4_m4(obmat, m_objMesh->obmat);
-	// set reference matrix
-	copy_m4_m4(m_objMesh->obmat, m_obmat);
+	copy_m4_m4(ob_mesh.obmat, m_obmat);
 
-	armature_deform_verts( par_arma, m_objMesh, NULL, m_transverts, NULL, m_bmesh->totvert, m_deformflags, NULL, NULL );
-		
-	// restore matrix 
-	copy_m4_m4(m_objMesh->obmat, obmat);
+	armature_deform_verts( par_arma, &ob_mesh, NULL, m_transverts, NULL, m_bmesh->totvert, m_deformflags, NULL, NULL );
 
 #ifdef __NLA_DEFNORMALS
 		if (m_recalcNormal)
@@ -233,11 +244,11 @@ void BL_SkinDeformer::BlenderDeformVerts()
 
 void BL_SkinDeformer::BGEDeformVerts()
 {
-	Object *par_arma = m_armobj->GetArmatureObject();
+	Object *par_arma = m_armobj->GetPoseObject();
 	MDeformVert *dverts = m_bmesh->dvert;
 	bDeformGroup *dg;
 	int defbase_tot = BLI_countlist(&m_objMesh->defbase);
-	Eigen::Matrix4f pre_mat, post_mat, chan_mat, norm_chan_mat;
+	float pre_mat[4][4], post_mat[4][4], tmp_mat[4][4];
 
 	if (!dverts)
 		return;
@@ -257,68 +268,39 @@ void BL_SkinDeformer::BGEDeformVerts()
 		}
 	}
 
-	post_mat = Eigen::Matrix4f::Map((float*)m_obmat).inverse() * Eigen::Matrix4f::Map((float*)m_armobj->GetArmatureObject()->obmat);
-	pre_mat = post_mat.inverse();
-
-	MDeformVert *dv= dverts;
-	MDeformWeight *dw;
-
-	for (int i=0; i<m_bmesh->totvert; ++i, dv++)
+	if (m_skinWeights == NULL)
 	{
-		float contrib = 0.f, weight, max_weight=-1.f;
-		bPoseChannel *pchan=NULL;
-		Eigen::Map<Eigen::Vector3f> norm = Eigen::Vector3f::Map(m_transnors[i]);
-		Eigen::Vector4f vec(0, 0, 0, 1);
-		Eigen::Vector4f co(m_transverts[i][0],
-							m_transverts[i][1],
-							m_transverts[i][2],
-							1.f);
-
-		if (!dv->totweight)
-			continue;
-
-		co = pre_mat * co;
-
-		dw= dv->dw;
-
-		for (unsigned int j= dv->totweight; j != 0; j--, dw++)
-		{
-			const int index = dw->def_nr;
-
-			if (index < defbase_tot && (pchan=m_dfnrToPC[index]))
-			{
-				weight = dw->weight;
+		const int totvert = m_bmesh->totvert;
 
-				if (weight)
-				{
-					chan_mat = Eigen::Matrix4f::Map((float*)pchan->chan_mat);
-
-					// Update Vertex Position
-					vec.noalias() += (chan_mat*co - co)*weight;
+		m_skinGroups = new int[totvert * BL_SKIN_MAX_INFLUENCES];
+		m_skinWeights = new float[totvert * BL_SKIN_MAX_INFLUENCES];
+		m_skinMats = new float[max_ii(defbase_tot, 1)][4][4];
+		BL_BuildSkinLayout(dverts, totvert, m_dfnrToPC, defbase_tot, m_skinGroups, m_skinWeights);
+	}
 
-					// Save the most influential channel so we can use it to update the vertex normal
-					if (weight > max_weight)
-					{
-						max_weight = weight;
-						norm_chan_mat = chan_mat;
-					}
+	invert_m4_m4(tmp_mat, m_obmat);
+	mul_m4_m4m4(post_mat, tmp_mat, par_arma->obmat);
+	invert_m4_m4(pre_mat, post_mat);
 
-					contrib += weight;
-				}
-			}
+	// Fold the transform to armature space and back into the matrix of every channel,
+	// the blended matrix of a vertex then deforms it in mesh space
+	for (int g = 0; g < defbase_tot; ++g)
+	{
+		if (m_dfnrToPC[g]) {
+			mul_m4_m4m4(tmp_mat, m_dfnrToPC[g]->chan_mat, pre_mat);
+			mul_m4_m4m4(m_skinMats[g], post_mat, tmp_mat);
 		}
-		
-		// Update Vertex Normal
-		norm = norm_chan_mat.topLeftCorner<3, 3>()*norm;
+	}
 
-		co.noalias() += vec/contrib;
-		co[3] = 1.f; // Make sure we have a 1 for the w component!
+	const int totvert = m_bmesh->totvert;
 
-		co = post_mat * co;
+	BL_SkinVerts(m_transverts, totvert, m_skinGroups, m_skinWeights, m_skinMats);
 
-		m_transverts[i][0] = co[0];
-		m_transverts[i][1] = co[1];
-		m_transverts[i][2] = co[2];
+	// Update Vertex Normal with the most influential channel
+	for (int i=0; i<totvert; ++i)
+	{
+		if (m_skinWeights[i] != 0.f)
+			mul_mat3_m4_v3(m_dfnrToPC[m_skinGroups[i]]->chan_mat, m_transnors[i]);
 	}
 	m_copyNormals = true;
 }
@@ -340,7 +322,7 @@ bool BL_SkinDeformer::UpdateInternal(bool shape_applied)
 			}
 		}
 
-		m_armobj->ApplyPose();
+		m_armobj->UpdatePose();
 
 		switch (m_armobj->GetVertDeformType())
 		{
@@ -355,7 +337,6 @@ bool BL_SkinDeformer::UpdateInternal(bool shape_applied)
 		/* Update the current frame */
 		m_lastArmaUpdate=m_armobj->GetLastFrame();
 
-		m_armobj->RestorePose();
 		/* dynamic vertex, cannot use display list */
 		m_bDynamic = true;
 		/* indicate that the m_transverts and normals are up to date */
@@ -370,6 +351,12 @@ bool BL_SkinDeformer::Update(void)
 	return UpdateInternal(false);
 }
 
+void BL_SkinDeformer::DeformAhead(void)
+{
+	if (Update())
+		m_deformedAhead = true;
+}
+
 /* XXX note: I propose to drop this function */
 void BL_SkinDeformer::SetArmature(BL_ArmatureObject *armobj)
 {
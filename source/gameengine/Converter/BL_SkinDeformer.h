@@ -47,6 +47,8 @@
 
 #include "RAS_Deformer.h"
 
+#include "BL_SkinLayout.h"
+
 
 class BL_SkinDeformer : public BL_MeshDeformer  
 {
@@ -76,6 +78,15 @@ public:
 	bool Update (void);
 	bool UpdateInternal (bool shape_applied);
 	bool Apply (class RAS_IPolyMaterial *polymat);
+	/**
+	 * Deform the vertices before drawing, so that the meshes of different armatures can be
+	 * deformed at the same time. The next Apply() copies the result into the mesh slots.
+	 */
+	void DeformAhead (void);
+	BL_ArmatureObject *GetArmature()
+	{
+		return m_armobj;
+	}
 	bool UpdateBuckets(void) 
 	{
 		// update the deformer and all the mesh slots; Apply() does it well, so just call it.
@@ -108,9 +119,15 @@ protected:
 	bool					m_poseApplied;
 	bool					m_recalcNormal;
 	bool					m_copyNormals; // dirty flag so we know if Apply() needs to copy normal information (used for BGEDeformVerts())
+	bool					m_deformedAhead; // m_transverts were updated by DeformAhead() and still need to be copied by Apply()
 	struct bPoseChannel**	m_dfnrToPC;
 	short					m_deformflags;
 
+	/* skinning layout of BGEDeformVerts(), see BL_BuildSkinLayout() */
+	int*					m_skinGroups;
+	float*					m_skinWeights;
+	float					(*m_skinMats)[4][4];	// deform matrix of every vertex group in mesh space
+
 	void BlenderDeformVerts();
 	void BGEDeformVerts();
 
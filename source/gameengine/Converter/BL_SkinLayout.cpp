@@ -0,0 +1,139 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2013 by Blender Foundation.
+ * All rights reserved.
+ *
+ * The Original Code is: all of this file.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file gameengine/Converter/BL_SkinLayout.cpp
+ *  \ingroup bgeconv
+ */
+
+#include "BL_SkinLayout.h"
+
+#include "DNA_meshdata_types.h"
+#include "BLI_math.h"
+
+#ifdef __SSE__
+#  include <xmmintrin.h>
+#endif
+
+void BL_BuildSkinLayout(const MDeformVert *dv, int totvert,
+                        bPoseChannel **dfnrToPC, int defbase_tot,
+                        int *skinGroups, float *skinWeights)
+{
+	for (int i = 0; i < totvert; ++i, ++dv)
+	{
+		int groups[BL_SKIN_MAX_INFLUENCES];
+		float weights[BL_SKIN_MAX_INFLUENCES];
+		float contrib = 0.f;
+		int tot = 0, k;
+		const MDeformWeight *dw = dv->dw;
+
+		for (int j = 0; j < dv->totweight; ++j, ++dw)
+		{
+			const int index = dw->def_nr;
+			const float weight = dw->weight;
+
+			if (index >= defbase_tot || !dfnrToPC[index] || weight == 0.f)
+				continue;
+
+			// Keep the strongest weights, the strongest first: its channel deforms the normal
+			if (tot < BL_SKIN_MAX_INFLUENCES)
+				k = tot++;
+			else if (weight > weights[BL_SKIN_MAX_INFLUENCES - 1])
+				k = BL_SKIN_MAX_INFLUENCES - 1;
+			else
+				continue;
+
+			for (; k > 0 && weights[k - 1] < weight; k--) {
+				weights[k] = weights[k - 1];
+				groups[k] = groups[k - 1];
+			}
+			weights[k] = weight;
+			groups[k] = index;
+		}
+
+		for (k = 0; k < tot; k++)
+			contrib += weights[k];
+
+		// Unused influences get no weight, but a valid group so the kernel doesn't need to test them
+		for (k = 0; k < BL_SKIN_MAX_INFLUENCES; k++) {
+			skinGroups[k * totvert + i] = (tot) ? groups[(k < tot) ? k : 0] : 0;
+			skinWeights[k * totvert + i] = (k < tot) ? weights[k] / contrib : 0.f;
+		}
+	}
+}
+
+void BL_SkinVerts(float (*verts)[3], int totvert, const int *skinGroups, const float *skinWeights,
+                  float (*mats)[4][4])
+{
+	for (int i=0; i<totvert; ++i)
+	{
+		const int *groups = skinGroups + i;
+		const float *weights = skinWeights + i;
+		float *co = verts[i];
+
+		if (weights[0] == 0.f)
+			continue;
+
+#ifdef __SSE__
+		__m128 w = _mm_set1_ps(weights[0]);
+		const float (*mat)[4] = mats[groups[0]];
+		__m128 col0 = _mm_mul_ps(_mm_loadu_ps(mat[0]), w);
+		__m128 col1 = _mm_mul_ps(_mm_loadu_ps(mat[1]), w);
+		__m128 col2 = _mm_mul_ps(_mm_loadu_ps(mat[2]), w);
+		__m128 col3 = _mm_mul_ps(_mm_loadu_ps(mat[3]), w);
+
+		for (int k = 1; k < BL_SKIN_MAX_INFLUENCES; k++)
+		{
+			w = _mm_set1_ps(weights[k * totvert]);
+			mat = mats[groups[k * totvert]];
+			col0 = _mm_add_ps(col0, _mm_mul_ps(_mm_loadu_ps(mat[0]), w));
+			col1 = _mm_add_ps(col1, _mm_mul_ps(_mm_loadu_ps(mat[1]), w));
+			col2 = _mm_add_ps(col2, _mm_mul_ps(_mm_loadu_ps(mat[2]), w));
+			col3 = _mm_add_ps(col3, _mm_mul_ps(_mm_loadu_ps(mat[3]), w));
+		}
+
+		float result[4];
+		__m128 r = _mm_add_ps(_mm_mul_ps(col0, _mm_set1_ps(co[0])), col3);
+		r = _mm_add_ps(r, _mm_mul_ps(col1, _mm_set1_ps(co[1])));
+		r = _mm_add_ps(r, _mm_mul_ps(col2, _mm_set1_ps(co[2])));
+		_mm_storeu_ps(result, r);
+		copy_v3_v3(co, result);
+#else
+		float blend_mat[4][4];
+
+		zero_m4(blend_mat);
+
+		for (int k = 0; k < BL_SKIN_MAX_INFLUENCES; k++) {
+			float (*mat)[4] = mats[groups[k * totvert]];
+
+			for (int c = 0; c < 4; c++)
+				madd_v4_v4fl(blend_mat[c], mat[c], weights[k * totvert]);
+		}
+
+		mul_m4_v3(blend_mat, co);
+#endif
+	}
+}
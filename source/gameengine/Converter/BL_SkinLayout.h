@@ -0,0 +1,58 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2013 by Blender Foundation.
+ * All rights reserved.
+ *
+ * The Original Code is: all of this file.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file BL_SkinLayout.h
+ *  \ingroup bgeconv
+ */
+
+#ifndef __BL_SKINLAYOUT_H__
+#define __BL_SKINLAYOUT_H__
+
+/* maximum number of bones influencing a vertex with ARM_VDEF_BGE_CPU skinning */
+#define BL_SKIN_MAX_INFLUENCES 4
+
+struct MDeformVert;
+struct bPoseChannel;
+
+/**
+ * Build the skinning layout of a mesh: the BL_SKIN_MAX_INFLUENCES strongest normalized
+ * weights of every vertex, the strongest first, stored influence after influence
+ * (index [influence * totvert + vertex]). Weights of vertex groups without a deforming
+ * pose channel in dfnrToPC are skipped.
+ */
+void BL_BuildSkinLayout(const struct MDeformVert *dvert, int totvert,
+                        struct bPoseChannel **dfnrToPC, int defbase_tot,
+                        int *groups, float *weights);
+
+/**
+ * Deform the vertices with the weighted sum of the matrices of their vertex groups.
+ * Vertices without weights are left unchanged.
+ */
+void BL_SkinVerts(float (*co)[3], int totvert, const int *groups, const float *weights,
+                  float (*mats)[4][4]);
+
+#endif  /* __BL_SKINLAYOUT_H__ */
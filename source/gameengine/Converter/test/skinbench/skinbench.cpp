@@ -0,0 +1,225 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2013 by Blender Foundation.
+ * All rights reserved.
+ *
+ * The Original Code is: all of this file.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/**
+ * Benchmark of the BGE CPU skinning (ARM_VDEF_BGE_CPU).
+ *
+ * Usage: skinbench [verts] [bones] [runs]
+ *
+ * A mesh where every vertex has 1 to 6 weights of nearby bones is skinned
+ * with BL_SkinVerts() using the layout of BL_BuildSkinLayout(), and with a
+ * loop over the MDeformVert weights of every vertex, like BGEDeformVerts()
+ * did before the layout. Printed are the best times, the vertices per second
+ * and the largest distance between both results, which must be about zero
+ * except for vertices with more than BL_SKIN_MAX_INFLUENCES weights.
+ *
+ * BL_SkinVerts() uses SSE when the compiler defines __SSE__, compare with a
+ * build with -U__SSE__ for the scalar code.
+ */
+
+/* To compile run:
+ * gcc -O2 -c -D__LITTLE_ENDIAN__ -DWITH_BOOL_COMPAT -D__BLI_STRICT_FLAGS_H__ \
+ *     -I../../../../blender/blenlib -I../../../../blender/makesdna \
+ *     -I../../../../../intern/guardedalloc -I../../../../../intern/atomic \
+ *     ../../../../blender/blenlib/intern/{math_base,math_base_inline,math_geom,math_geom_inline}.c \
+ *     ../../../../blender/blenlib/intern/{math_matrix,math_rotation,math_vector,math_vector_inline,time}.c \
+ *     ../../../../../intern/guardedalloc/intern/mallocn*.c
+ * g++ -O2 -D__LITTLE_ENDIAN__ -DWITH_BOOL_COMPAT -I../.. -I../../../../blender/blenlib \
+ *     -I../../../../blender/makesdna skinbench.cpp ../../BL_SkinLayout.cpp *.o -lpthread -o skinbench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+#include "BL_SkinLayout.h"
+
+extern "C" {
+#include "BLI_utildefines.h"
+#include "BLI_math.h"
+#include "PIL_time.h"
+#include "DNA_action_types.h"
+#include "DNA_meshdata_types.h"
+}
+
+#define MAX_WEIGHTS 6
+
+static unsigned int seed = 1;
+
+static float random_float(void)
+{
+	seed = seed * 1103515245u + 12345u;
+	return (float)((seed >> 8) & 0xFFFFFF) / (float)0x1000000;
+}
+
+/* vertices along a chain of bones, weighted to the bones around them */
+static void make_mesh(int totvert, int totbone, float (*co)[3], MDeformVert *dvert, MDeformWeight *dw)
+{
+	for (int i = 0; i < totvert; i++) {
+		const float along = random_float() * totbone;
+		const int bone = (int)along;
+		const int totweight = 1 + (int)(random_float() * MAX_WEIGHTS);
+
+		co[i][0] = along;
+		co[i][1] = random_float() - 0.5f;
+		co[i][2] = random_float() - 0.5f;
+
+		dvert[i].dw = &dw[i * MAX_WEIGHTS];
+		dvert[i].totweight = totweight;
+
+		for (int j = 0; j < totweight; j++) {
+			dvert[i].dw[j].def_nr = min_ii(max_ii(bone + j - totweight / 2, 0), totbone - 1);
+			dvert[i].dw[j].weight = random_float();
+		}
+	}
+}
+
+/* every bone bends a bit more around Z and moves up */
+static void make_pose(int totbone, float (*mats)[4][4])
+{
+	for (int b = 0; b < totbone; b++) {
+		const float angle = 0.01f * b;
+
+		unit_m4(mats[b]);
+		mats[b][0][0] = cosf(angle);
+		mats[b][0][1] = sinf(angle);
+		mats[b][1][0] = -sinf(angle);
+		mats[b][1][1] = cosf(angle);
+		mats[b][3][2] = 0.1f * b;
+	}
+}
+
+/* weighted sum of the deformed positions of all weights of the MDeformVert */
+static void skin_dvert_loop(float (*co)[3], int totvert, const MDeformVert *dvert, float (*mats)[4][4])
+{
+	for (int i = 0; i < totvert; i++) {
+		const MDeformWeight *dw = dvert[i].dw;
+		float sum[3] = {0.0f, 0.0f, 0.0f}, contrib = 0.0f;
+
+		for (int j = 0; j < dvert[i].totweight; j++, dw++) {
+			float deformed[3];
+
+			if (dw->weight == 0.0f)
+				continue;
+
+			mul_v3_m4v3(deformed, mats[dw->def_nr], co[i]);
+			madd_v3_v3fl(sum, deformed, dw->weight);
+			contrib += dw->weight;
+		}
+
+		if (contrib > 0.0f)
+			mul_v3_v3fl(co[i], sum, 1.0f / contrib);
+	}
+}
+
+static void print_result(const char *name, double best, int totvert)
+{
+	printf("%-16s %10.4f %12.0f\n", name, best, totvert / best);
+}
+
+int main(int argc, char **argv)
+{
+	int totvert = (argc > 1) ? atoi(argv[1]) : 1000000;
+	int totbone = (argc > 2) ? atoi(argv[2]) : 64;
+	int runs = (argc > 3) ? atoi(argv[3]) : 10;
+
+	if (totvert <= 0 || totbone <= 0 || runs <= 0) {
+		printf("Usage: %s [verts] [bones] [runs]\n", argv[0]);
+		return 1;
+	}
+
+	float (*rest)[3] = new float[totvert][3];
+	float (*co)[3] = new float[totvert][3];
+	float (*co_ref)[3] = new float[totvert][3];
+	MDeformVert *dvert = new MDeformVert[totvert];
+	MDeformWeight *dw = new MDeformWeight[totvert * MAX_WEIGHTS];
+	float (*mats)[4][4] = new float[totbone][4][4];
+	int *groups = new int[totvert * BL_SKIN_MAX_INFLUENCES];
+	float *weights = new float[totvert * BL_SKIN_MAX_INFLUENCES];
+
+	/* the layout only tests if a vertex group has a pose channel */
+	bPoseChannel channel;
+	bPoseChannel **dfnrToPC = new bPoseChannel*[totbone];
+	for (int b = 0; b < totbone; b++)
+		dfnrToPC[b] = &channel;
+
+	make_mesh(totvert, totbone, rest, dvert, dw);
+	make_pose(totbone, mats);
+
+	double best_layout = 0.0, best_skin = 0.0, best_ref = 0.0;
+
+	for (int run = 0; run < runs; run++) {
+		double start = PIL_check_seconds_timer();
+		BL_BuildSkinLayout(dvert, totvert, dfnrToPC, totbone, groups, weights);
+		double layout = PIL_check_seconds_timer() - start;
+
+		memcpy(co, rest, sizeof(float) * 3 * totvert);
+		start = PIL_check_seconds_timer();
+		BL_SkinVerts(co, totvert, groups, weights, mats);
+		double skin = PIL_check_seconds_timer() - start;
+
+		memcpy(co_ref, rest, sizeof(float) * 3 * totvert);
+		start = PIL_check_seconds_timer();
+		skin_dvert_loop(co_ref, totvert, dvert, mats);
+		double ref = PIL_check_seconds_timer() - start;
+
+		best_layout = (run == 0) ? layout : std::min(best_layout, layout);
+		best_skin = (run == 0) ? skin : std::min(best_skin, skin);
+		best_ref = (run == 0) ? ref : std::min(best_ref, ref);
+	}
+
+	/* vertices with up to BL_SKIN_MAX_INFLUENCES weights must match, others are approximated */
+	float max_error = 0.0f, max_approximation = 0.0f;
+	for (int i = 0; i < totvert; i++) {
+		if (dvert[i].totweight <= BL_SKIN_MAX_INFLUENCES)
+			max_error = max_ff(max_error, len_v3v3(co[i], co_ref[i]));
+		else
+			max_approximation = max_ff(max_approximation, len_v3v3(co[i], co_ref[i]));
+	}
+
+	printf("Skinning %d vertices with %d bones, best of %d runs\n\n", totvert, totbone, runs);
+	printf("%-16s %10s %12s\n", "", "time (s)", "verts/s");
+	print_result("build layout", best_layout, totvert);
+	print_result("layout skinning", best_skin, totvert);
+	print_result("dvert loop", best_ref, totvert);
+	printf("\nlargest difference %f, %f with more than %d weights\n", max_error, max_approximation,
+	       BL_SKIN_MAX_INFLUENCES);
+
+	delete [] rest;
+	delete [] co;
+	delete [] co_ref;
+	delete [] dvert;
+	delete [] dw;
+	delete [] mats;
+	delete [] groups;
+	delete [] weights;
+	delete [] dfnrToPC;
+
+	return 0;
+}
@@ -73,7 +73,7 @@ public:
 	virtual void	EndFrame();
 	virtual void	RegisterSensor(class SCA_ISensor* sensor);
 	int		GetType();
-	//SG_DList &GetSensors() { return m_sensors; }
+	SG_DList &GetSensors() { return m_sensors; }
 
 
 	void			Replace_LogicManager(SCA_LogicManager* logicmgr) { m_logicmgr= logicmgr; }
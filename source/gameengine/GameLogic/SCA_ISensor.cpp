@@ -70,6 +70,8 @@ SCA_ISensor::SCA_ISensor(SCA_IObject* gameobj,
 	m_pulse_frequency = 0;
 	m_state = false;
 	m_prev_state = false;
+	m_concurrent_evaluated = false;
+	m_concurrent_result = false;
 	
 	m_eventmgr = eventmgr;
 }
@@ -235,13 +237,23 @@ void SCA_ISensor::ActivateControllers(class SCA_LogicManager* logicmgr)
 	}
 }
 
+void SCA_ISensor::EvaluateConcurrently()
+{
+	// same conditions as Activate()
+	if (m_links && !m_suspended) {
+		m_concurrent_result = this->Evaluate();
+		m_concurrent_evaluated = true;
+	}
+}
+
 void SCA_ISensor::Activate(class SCA_LogicManager* logicmgr)
 {
 	
 	// calculate if a __triggering__ is wanted
 	// don't evaluate a sensor that is not connected to any controller
 	if (m_links && !m_suspended) {
-		bool result = this->Evaluate();
+		bool result = (m_concurrent_evaluated) ? m_concurrent_result : this->Evaluate();
+		m_concurrent_evaluated = false;
 		// store the state for the rest of the logic system
 		m_prev_state = m_state;
 		m_state = this->IsPositiveTrigger();
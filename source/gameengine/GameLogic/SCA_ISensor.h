@@ -90,6 +90,12 @@ protected:
 	/** previous state (for tap option) */
 	bool m_prev_state;
 
+	/** Evaluate() was already called by EvaluateConcurrently() this frame */
+	bool m_concurrent_evaluated;
+
+	/** result of that Evaluate() */
+	bool m_concurrent_result;
+
 	std::vector<class SCA_IController*>		m_linkedcontrollers;
 
 public:
@@ -113,6 +119,19 @@ public:
 	/* The IsPosTrig() also has to change, to keep things consistent.        */
 	void Activate(class SCA_LogicManager* logicmgr);
 	virtual bool Evaluate() = 0;
+
+	/**
+	 * Can Evaluate() run in parallel with the sensors of other objects?
+	 * Only for sensors that don't change or read anything but their own object.
+	 */
+	virtual bool IsConcurrent() { return false; }
+
+	/** Evaluate the sensor ahead of Activate(), called by SCA_LogicManager::BeginFrame() */
+	void EvaluateConcurrently();
+	void ClearConcurrentResult()
+	{
+		m_concurrent_evaluated = false;
+	}
 	virtual bool IsPositiveTrigger();
 	virtual void Init();
 
@@ -38,9 +38,17 @@
 #include "SCA_EventManager.h"
 #include "SCA_PythonController.h"
 #include <set>
+#include <algorithm>
 
+#include "BLI_task.h"
+
+/* minimum number of concurrent sensors of an event manager to evaluate them in parallel,
+ * and of sensors per task */
+#define SCA_CONCURRENT_SENSORS_MIN	64
+#define SCA_CONCURRENT_SENSORS_TASK	32
 
 SCA_LogicManager::SCA_LogicManager()
+	: m_taskscheduler(NULL)
 {
 }
 
@@ -184,11 +192,87 @@ void SCA_LogicManager::RegisterToActuator(SCA_IController* controller,SCA_IActua
 
 
 
+static bool sensor_parent_less(SCA_ISensor *a, SCA_ISensor *b)
+{
+	return a->GetParent() < b->GetParent();
+}
+
+struct ConcurrentSensorsTask {
+	SCA_ISensor **sensors;
+	int totsensor;
+};
+
+static void evaluate_sensors_task(TaskPool *UNUSED(pool), void *taskdata, int UNUSED(threadid))
+{
+	ConcurrentSensorsTask *task = (ConcurrentSensorsTask*)taskdata;
+
+	for (int i = 0; i < task->totsensor; i++)
+		task->sensors[i]->EvaluateConcurrently();
+}
+
+/**
+ * Evaluate the concurrent sensors of an event manager in parallel. Their Activate() then
+ * only uses the result, so the controllers are still triggered in the order of the event
+ * manager. The sensors of an object are evaluated by the same task, they can share the
+ * properties of the object.
+ */
+void SCA_LogicManager::EvaluateConcurrentSensors(SCA_EventManager* eventmgr)
+{
+	SG_DList::iterator<SCA_ISensor> it(eventmgr->GetSensors());
+
+	m_concurrentSensors.clear();
+	for (it.begin(); !it.end(); ++it) {
+		if ((*it)->IsConcurrent())
+			m_concurrentSensors.push_back(*it);
+	}
+
+	if (m_concurrentSensors.size() < SCA_CONCURRENT_SENSORS_MIN)
+		return;
+
+	m_sortedSensors = m_concurrentSensors;
+	std::stable_sort(m_sortedSensors.begin(), m_sortedSensors.end(), sensor_parent_less);
+
+	vector<ConcurrentSensorsTask> tasks;
+	int totsensor = m_sortedSensors.size();
+	int start = 0;
+
+	for (int i = 1; i <= totsensor; i++) {
+		/* split at the first new object once the task is large enough */
+		if (i == totsensor ||
+		    (i - start >= SCA_CONCURRENT_SENSORS_TASK &&
+		     m_sortedSensors[i]->GetParent() != m_sortedSensors[i - 1]->GetParent()))
+		{
+			ConcurrentSensorsTask task = {&m_sortedSensors[start], i - start};
+			tasks.push_back(task);
+			start = i;
+		}
+	}
+
+	TaskPool *pool = BLI_task_pool_create(m_taskscheduler, NULL);
+
+	for (unsigned int i = 0; i < tasks.size(); i++)
+		BLI_task_pool_push(pool, evaluate_sensors_task, &tasks[i], false, TASK_PRIORITY_HIGH);
+
+	BLI_task_pool_work_and_wait(pool);
+	BLI_task_pool_free(pool);
+}
+
 void SCA_LogicManager::BeginFrame(double curtime, double fixedtime)
 {
 	for (vector<SCA_EventManager*>::const_iterator ie=m_eventmanagers.begin(); !(ie==m_eventmanagers.end()); ie++)
+	{
+		if (m_taskscheduler)
+			EvaluateConcurrentSensors(*ie);
+
 		(*ie)->NextFrame(curtime, fixedtime);
 
+		if (m_taskscheduler) {
+			// in case NextFrame() didn't activate all sensors
+			for (vector<SCA_ISensor*>::iterator is = m_concurrentSensors.begin(); is != m_concurrentSensors.end(); ++is)
+				(*is)->ClearConcurrentResult();
+		}
+	}
+
 	for (SG_QList* obj = (SG_QList*)m_triggeredControllerSet.Remove();
 		obj != NULL;
 		obj = (SG_QList*)m_triggeredControllerSet.Remove())
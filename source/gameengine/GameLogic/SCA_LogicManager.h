@@ -70,9 +70,18 @@ typedef std::map<class SCA_ISensor*,controllerlist > sensormap_t;
 #include "SCA_EventManager.h"
 
 
+struct TaskScheduler;
+
 class SCA_LogicManager
 {
 	vector<class SCA_EventManager*>		m_eventmanagers;
+
+	// scheduler used to evaluate the concurrent sensors of the objects
+	// in parallel, NULL evaluates all sensors serially
+	struct TaskScheduler*				m_taskscheduler;
+	// sensors evaluated ahead of the NextFrame() of their event manager
+	vector<class SCA_ISensor*>			m_concurrentSensors;
+	vector<class SCA_ISensor*>			m_sortedSensors;
 	
 	// SG_DList: Head of objects having activated actuators
 	//           element: SCA_IObject::m_activeActuators
@@ -89,6 +98,8 @@ class SCA_LogicManager
 
 	CTR_Map<STR_HashedString,void*>		m_map_gamemeshname_to_blendobj;
 	CTR_Map<CHashedPtr,void*>			m_map_blendobj_to_gameobj;
+
+	void	EvaluateConcurrentSensors(SCA_EventManager* eventmgr);
 public:
 	SCA_LogicManager();
 	virtual ~SCA_LogicManager();
@@ -101,6 +112,7 @@ public:
 							   class SCA_IActuator* actuator);
 	
 	void	BeginFrame(double curtime, double fixedtime);
+	void	SetTaskScheduler(struct TaskScheduler* scheduler) { m_taskscheduler = scheduler; }
 	void	UpdateFrame(double curtime, bool frame);
 	void	EndFrame();
 	void	AddActiveActuator(SCA_IActuator* actua,bool event)
@@ -76,6 +76,7 @@ public:
 
 	virtual bool Evaluate();
 	virtual bool	IsPositiveTrigger();
+	virtual bool	IsConcurrent() { return true; }
 	virtual CValue*		FindIdentifier(const STR_String& identifiername);
 
 #ifdef WITH_PYTHON
@@ -0,0 +1,225 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2013 by Blender Foundation.
+ * All rights reserved.
+ *
+ * The Original Code is: all of this file.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/**
+ * Stress benchmark of the concurrent sensor evaluation of SCA_LogicManager.
+ *
+ * Usage: sensorbench [objects] [sensors] [frames] [threads]
+ *
+ * Every object has an integer property that changes every frame and the given
+ * number of property sensors, linked to an AND controller of the object like
+ * the converter links them. SCA_LogicManager::BeginFrame() runs for the given
+ * number of frames without a task scheduler, which evaluates all sensors
+ * serially, and with a task scheduler with the given number of threads (0 for
+ * all cores). Printed are the times per frame and the number of positive
+ * sensors of both runs, which must be the same.
+ */
+
+/* To compile run:
+ * gcc -O2 -c -D__LITTLE_ENDIAN__ -DWITH_BOOL_COMPAT -D__BLI_STRICT_FLAGS_H__ \
+ *     -I../../../../blender/blenlib -I../../../../blender/makesdna \
+ *     -I../../../../../intern/guardedalloc -I../../../../../intern/atomic \
+ *     ../../../../blender/blenlib/intern/{listbase,gsqueue,task,threads,time}.c \
+ *     ../../../../../intern/guardedalloc/intern/mallocn*.c
+ * g++ -std=gnu++98 -O2 -D__LITTLE_ENDIAN__ -DWITH_BOOL_COMPAT -I../.. -I../../../Expressions \
+ *     -I../../../SceneGraph -I../../../../blender/blenlib -I../../../../../intern/container \
+ *     -I../../../../../intern/string -I../../../../../intern/guardedalloc \
+ *     -I../../../../../intern/moto/include -include stdio.h sensorbench.cpp \
+ *     ../../SCA_{LogicManager,EventManager,PropertyEventManager,ISensor,PropertySensor}.cpp \
+ *     ../../SCA_{ILogicBrick,IObject,IController,ANDController,IActuator}.cpp \
+ *     ../../../Expressions/{Value,PyObjectPlus,BoolValue,IntValue,FloatValue,StringValue}.cpp \
+ *     ../../../Expressions/{ErrorValue,EmptyValue,ListValue,ConstExpr,Expression,Operator2Expr}.cpp \
+ *     ../../../Expressions/{Operator1Expr,IdentifierExpr,IfExpr,InputParser,KX_HashedPtr}.cpp \
+ *     ../../../../../intern/string/intern/STR_String.cpp \
+ *     *.o -lpthread -o sensorbench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "SCA_LogicManager.h"
+#include "SCA_PropertyEventManager.h"
+#include "SCA_PropertySensor.h"
+#include "SCA_ANDController.h"
+#include "SCA_IObject.h"
+#include "IntValue.h"
+
+extern "C" {
+#include "BLI_task.h"
+#include "BLI_threads.h"
+#include "PIL_time.h"
+}
+
+#define NUM_VALUES 4
+
+/* SCA_IObject leaves the CValue interface to the game objects */
+class SensorObject : public SCA_IObject
+{
+	STR_String m_name;
+
+public:
+	SensorObject() : m_name("SensorObject") {}
+
+	virtual CValue *Calc(VALUE_OPERATOR op, CValue *val) { return NULL; }
+	virtual CValue *CalcFinal(VALUE_DATA_TYPE dtype, VALUE_OPERATOR op, CValue *val) { return NULL; }
+	virtual const STR_String &GetText() { return m_name; }
+	virtual double GetNumber() { return -1.0; }
+	virtual STR_String &GetName() { return m_name; }
+	virtual void SetName(const char *name) { m_name = name; }
+	virtual CValue *GetReplica() { return NULL; }
+};
+
+struct SensorScene {
+	SCA_LogicManager *logicmgr;
+	std::vector<SCA_IObject*> objects;
+	std::vector<SCA_ISensor*> sensors;
+};
+
+static void create_scene(SensorScene *scene, int totobject, int totsensor)
+{
+	scene->logicmgr = new SCA_LogicManager();
+
+	SCA_EventManager *eventmgr = new SCA_PropertyEventManager(scene->logicmgr);
+	scene->logicmgr->RegisterEventManager(eventmgr);
+
+	for (int i = 0; i < totobject; i++) {
+		SCA_IObject *obj = new SensorObject();
+		SCA_IController *cont = new SCA_ANDController(obj);
+		CIntValue *prop = new CIntValue(0);
+
+		obj->SetProperty("prop", prop);
+		prop->Release();
+
+		cont->SetExecutePriority(0);
+		cont->SetState(1);
+		obj->AddController(cont);
+
+		for (int j = 0; j < totsensor; j++) {
+			STR_String value;
+			value.Format("%d", j % NUM_VALUES);
+
+			SCA_ISensor *sensor = new SCA_PropertySensor(eventmgr, obj, "prop", value, "",
+			                                             SCA_PropertySensor::KX_PROPSENSOR_EQUAL);
+			sensor->SetExecutePriority(j);
+			obj->AddSensor(sensor);
+
+			sensor->ReserveController(1);
+			scene->logicmgr->RegisterToSensor(cont, sensor);
+			sensor->RegisterToManager();
+			scene->sensors.push_back(sensor);
+		}
+
+		/* links the sensors, like SetState() of the converted objects */
+		cont->ApplyState(1);
+		scene->objects.push_back(obj);
+	}
+}
+
+static void free_scene(SensorScene *scene)
+{
+	for (unsigned int i = 0; i < scene->sensors.size(); i++)
+		scene->sensors[i]->UnregisterToManager();
+
+	for (unsigned int i = 0; i < scene->objects.size(); i++)
+		scene->objects[i]->Release();
+
+	delete scene->logicmgr;
+}
+
+/* returns the time per frame, counts the positive sensors of all frames */
+static double run_frames(SensorScene *scene, int totframe, long *r_positive)
+{
+	double total = 0.0;
+	long positive = 0;
+
+	for (int frame = 0; frame < totframe; frame++) {
+		/* a new value for every object, every frame another sensor of it is positive */
+		for (unsigned int i = 0; i < scene->objects.size(); i++) {
+			CIntValue *value = new CIntValue((frame + i) % NUM_VALUES);
+			scene->objects[i]->GetProperty("prop")->SetValue(value);
+			value->Release();
+		}
+
+		double start = PIL_check_seconds_timer();
+		scene->logicmgr->BeginFrame(frame, 1.0 / 60.0);
+		total += PIL_check_seconds_timer() - start;
+
+		for (unsigned int i = 0; i < scene->sensors.size(); i++)
+			positive += scene->sensors[i]->GetState();
+	}
+
+	*r_positive = positive;
+	return total / totframe;
+}
+
+int main(int argc, char **argv)
+{
+	int totobject = (argc > 1) ? atoi(argv[1]) : 1000;
+	int totsensor = (argc > 2) ? atoi(argv[2]) : 8;
+	int totframe = (argc > 3) ? atoi(argv[3]) : 200;
+	int threads = (argc > 4) ? atoi(argv[4]) : 0;
+
+	if (totobject <= 0 || totsensor <= 0 || totframe <= 0 || threads < 0) {
+		printf("Usage: %s [objects] [sensors] [frames] [threads]\n", argv[0]);
+		return 1;
+	}
+
+	BLI_threadapi_init();
+
+	if (threads == 0)
+		threads = BLI_system_thread_count();
+
+	TaskScheduler *scheduler = BLI_task_scheduler_create(threads);
+	SensorScene serial, parallel;
+	long serial_positive, parallel_positive;
+
+	create_scene(&serial, totobject, totsensor);
+	create_scene(&parallel, totobject, totsensor);
+	parallel.logicmgr->SetTaskScheduler(scheduler);
+
+	double serial_time = run_frames(&serial, totframe, &serial_positive);
+	double parallel_time = run_frames(&parallel, totframe, &parallel_positive);
+
+	printf("%d objects with %d property sensors, %d frames\n\n", totobject, totsensor, totframe);
+	printf("%-16s %12s %12s\n", "", "ms/frame", "positive");
+	printf("%-16s %12.4f %12ld\n", "serial", serial_time * 1000.0, serial_positive);
+	printf("%-10s %2d thr %12.4f %12ld\n", "parallel", threads, parallel_time * 1000.0, parallel_positive);
+
+	free_scene(&serial);
+	free_scene(&parallel);
+
+	BLI_task_scheduler_free(scheduler);
+	BLI_threadapi_exit();
+
+	if (serial_positive != parallel_positive) {
+		printf("\nserial and parallel sensors differ\n");
+		return 1;
+	}
+
+	return 0;
+}
@@ -26,6 +26,8 @@
 
 #include <cstdlib>
 #include <stdio.h>
+#include <float.h>
+#include <string.h>
 
 #include "BL_Action.h"
 #include "BL_ArmatureObject.h"
@@ -36,6 +38,8 @@
 
 #include "SG_Controller.h"
 
+#include "MEM_guardedalloc.h"
+
 // These three are for getting the action from the logic manager
 #include "KX_Scene.h"
 #include "SCA_LogicManager.h"
@@ -43,6 +47,9 @@
 extern "C" {
 #include "BKE_animsys.h"
 #include "BKE_action.h"
+#include "BKE_fcurve.h"
+#include "BLI_string.h"
+#include "DNA_anim_types.h"
 #include "RNA_access.h"
 #include "RNA_define.h"
 
@@ -71,7 +78,8 @@ BL_Action::BL_Action(class KX_GameObject* gameobj)
 	m_blendmode(ACT_BLEND_BLEND),
 	m_ipo_flags(0),
 	m_done(true),
-	m_calc_localtime(true)
+	m_calc_localtime(true),
+	m_ipo_pending(false)
 {
 }
 
@@ -353,12 +361,94 @@ void BL_Action::BlendShape(Key* key, float srcweight, std::vector<float>& blends
 	//printf("\n");
 }
 
+/* Evaluate the bone F-Curves of an action into a pose of the armature object.
+ * Unlike animsys_evaluate_action() the pose doesn't have to be set on the
+ * Blender object and the current values of the F-Curves aren't written, so
+ * replicas and armatures playing the same action can be evaluated at the same
+ * time. The other F-Curves of the action are handled by the IPO controllers. */
+static void evaluate_pose_fcurves(Object *arm, bPose *pose, bAction *action, float ctime)
+{
+	const char *prefix = "pose.bones[\"";
+
+	for (FCurve *fcu = (FCurve *)action->curves.first; fcu; fcu = fcu->next) {
+		if (fcu->grp && (fcu->grp->flag & AGRP_MUTED))
+			continue;
+		if (fcu->flag & (FCURVE_MUTED | FCURVE_DISABLED))
+			continue;
+		// Drivers may run Python, those are left to the render
+		if (fcu->driver || fcu->rna_path == NULL || strncmp(fcu->rna_path, prefix, strlen(prefix)) != 0)
+			continue;
+		if (fcu->totvert == 0 && !list_has_suitable_fmodifier(&fcu->modifiers, 0, FMI_TYPE_GENERATE_CURVE))
+			continue;
+
+		char *name = BLI_str_quoted_substrN(fcu->rna_path, "pose.bones[");
+		bPoseChannel *pchan = (name) ? BKE_pose_channel_find_name(pose, name) : NULL;
+		const char *path = (pchan) ? fcu->rna_path + strlen(prefix) + strlen(name) + 2 : NULL;
+
+		if (name)
+			MEM_freeN(name);
+
+		// Path of the property relative to the bone, after the '"].'
+		if (pchan == NULL || *path != '.')
+			continue;
+
+		PointerRNA ptrrna, propptr;
+		PropertyRNA *prop;
+
+		RNA_pointer_create(&arm->id, &RNA_PoseBone, pchan, &ptrrna);
+
+		if (!RNA_path_resolve_property(&ptrrna, path + 1, &propptr, &prop) || !RNA_property_animateable(&propptr, prop))
+			continue;
+
+		const int index = fcu->array_index;
+		const int len = RNA_property_array_length(&propptr, prop);
+		const float value = evaluate_fcurve(fcu, ctime);
+
+		if (len && index >= len)
+			continue;
+
+		switch (RNA_property_type(prop)) {
+			case PROP_BOOLEAN:
+				if (len)
+					RNA_property_boolean_set_index(&propptr, prop, index, value > (1.0f - FLT_EPSILON));
+				else
+					RNA_property_boolean_set(&propptr, prop, value > (1.0f - FLT_EPSILON));
+				break;
+			case PROP_INT:
+				if (len)
+					RNA_property_int_set_index(&propptr, prop, index, (int)value);
+				else
+					RNA_property_int_set(&propptr, prop, (int)value);
+				break;
+			case PROP_FLOAT:
+				if (len)
+					RNA_property_float_set_index(&propptr, prop, index, value);
+				else
+					RNA_property_float_set(&propptr, prop, value);
+				break;
+			case PROP_ENUM:
+				RNA_property_enum_set(&propptr, prop, (int)value);
+				break;
+			default:
+				break;
+		}
+	}
+}
+
 void BL_Action::Update(float curtime)
+{
+	Evaluate(curtime);
+	UpdateIPO();
+}
+
+void BL_Action::Evaluate(float curtime)
 {
 	// Don't bother if we're done with the animation
 	if (m_done)
 		return;
 
+	m_ipo_pending = true;
+
 	curtime -= KX_KetsjiEngine::GetSuspendedDelta();
 
 	// Grab the start time here so we don't end up with a negative m_localtime when
@@ -405,19 +495,7 @@ void BL_Action::Update(float curtime)
 		obj->GetPose(&m_pose);
 
 		// Extract the pose from the action
-		{
-			Object *arm = obj->GetArmatureObject();
-			bPose *temp = arm->pose;
-
-			arm->pose = m_pose;
-
-			PointerRNA ptrrna;
-			RNA_id_pointer_create(&arm->id, &ptrrna);
-
-			animsys_evaluate_action(&ptrrna, m_action, NULL, m_localtime);
-
-			arm->pose = temp;
-		}
+		evaluate_pose_fcurves(obj->GetArmatureObject(), m_pose, m_action, m_localtime);
 
 		// Handle blending between armature actions
 		if (m_blendin && m_blendframe<m_blendin)
@@ -485,6 +563,14 @@ void BL_Action::Update(float curtime)
 			obj->SetActiveAction(NULL, 0, curtime);
 		}
 	}
+}
+
+void BL_Action::UpdateIPO()
+{
+	if (!m_ipo_pending)
+		return;
+
+	m_ipo_pending = false;
 
 	m_obj->UpdateIPO(m_localtime, m_ipo_flags & ACT_IPOFLAG_CHILD);
 
@@ -69,6 +69,7 @@ private:
 
 	bool m_done;
 	bool m_calc_localtime;
+	bool m_ipo_pending;
 
 	void ClearControllerList();
 	void InitIPO();
@@ -105,6 +106,16 @@ public:
 	 * Update the action's frame, etc.
 	 */
 	void Update(float curtime);
+	/**
+	 * Update the action's frame and evaluate the pose or shape of the object.
+	 * Only the object's own data is changed, so different objects can be
+	 * evaluated at the same time. UpdateIPO() must be called afterwards.
+	 */
+	void Evaluate(float curtime);
+	/**
+	 * Apply the frame of the last Evaluate() to the object's IPOs
+	 */
+	void UpdateIPO();
 
 	// Accessors
 	float GetFrame();
@@ -98,6 +98,16 @@ public:
 	 */
 	void Update(float);
 
+	/**
+	 * Evaluate the pose or shape of any running actions, see BL_Action::Evaluate()
+	 */
+	void Evaluate(float);
+
+	/**
+	 * Apply the evaluated actions to the object's IPOs
+	 */
+	void UpdateIPOs();
+
 #ifdef WITH_CXX_GUARDEDALLOC
 	MEM_CXX_CLASS_ALLOC_FUNCS("GE:BL_ActionManager")
 #endif
@@ -464,6 +464,16 @@ void KX_GameObject::UpdateActionManager(float curtime)
 	GetActionManager()->Update(curtime);
 }
 
+void KX_GameObject::EvaluateActionManager(float curtime)
+{
+	GetActionManager()->Evaluate(curtime);
+}
+
+void KX_GameObject::UpdateActionManagerIPOs()
+{
+	GetActionManager()->UpdateIPOs();
+}
+
 float KX_GameObject::GetActionFrame(short layer)
 {
 	return GetActionManager()->GetActionFrame(layer);
@@ -298,6 +298,17 @@ public:
 	 */
 	void UpdateActionManager(float curtime);
 
+	/**
+	 * Evaluate the object's actions without touching the scenegraph,
+	 * UpdateActionManagerIPOs() must be called afterwards
+	 */
+	void EvaluateActionManager(float curtime);
+
+	/**
+	 * Apply the evaluated actions to the object's IPOs
+	 */
+	void UpdateActionManagerIPOs();
+
 	/*********************************
 	 * End Animation API
 	 *********************************/
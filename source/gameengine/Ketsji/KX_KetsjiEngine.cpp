@@ -77,6 +77,8 @@
 
 #include "KX_NavMeshObject.h"
 
+#include "BLI_task.h"
+
 // If define: little test for Nzc: guarded drawing. If the canvas is
 // not valid, skip rendering this frame.
 //#define NZC_GUARDED_OUTPUT
@@ -93,8 +95,10 @@ const char KX_KetsjiEngine::m_profileLabels[tc_numCategories][15] = {
 	"Physics:",		// tc_physics
 	"Logic:",		// tc_logic
 	"Animations:",	// tc_animations
+	"Deformers:",	// tc_deformers
 	"Network:",		// tc_network
 	"Scenegraph:",	// tc_scenegraph
+	"Culling:",		// tc_culling
 	"Rasterizer:",	// tc_rasterizer
 	"Services:",	// tc_services
 	"Overhead:",	// tc_overhead
@@ -181,6 +185,8 @@ KX_KetsjiEngine::KX_KetsjiEngine(KX_ISystem* system)
 	for (int i = tc_first; i < tc_numCategories; i++)
 		m_logger->AddCategory((KX_TimeCategory)i);
 
+	m_taskscheduler = BLI_task_scheduler_create(TASK_SCHEDULER_AUTO_THREADS);
+
 #ifdef WITH_PYTHON
 	m_pyprofiledict = PyDict_New();
 #endif
@@ -194,6 +200,7 @@ KX_KetsjiEngine::KX_KetsjiEngine(KX_ISystem* system)
 KX_KetsjiEngine::~KX_KetsjiEngine()
 {
 	delete m_logger;
+	BLI_task_scheduler_free(m_taskscheduler);
 	if (m_usedome)
 		delete m_dome;
 
@@ -598,6 +605,12 @@ bool KX_KetsjiEngine::NextFrame()
 		frames = m_maxLogicFrame;
 	}
 
+	// count the scenegraph updates of the logic frames of this frame
+	if (frames > 0) {
+		for (sceneit = m_scenes.begin();sceneit != m_scenes.end(); ++sceneit)
+			(*sceneit)->ResetUpdatedNodeCount();
+	}
+
 	while (frames)
 	{
 	
@@ -819,6 +832,12 @@ bool KX_KetsjiEngine::NextFrame()
 
 void KX_KetsjiEngine::Render()
 {
+	// Skinned meshes are deformed in parallel before the scenes are drawn,
+	// the deformers that can't be updated ahead are updated when drawn.
+	m_logger->StartLog(tc_deformers, m_kxsystem->GetTimeInSeconds(), true);
+	for (KX_SceneList::iterator sceneit = m_scenes.begin(); sceneit != m_scenes.end(); ++sceneit)
+		(*sceneit)->UpdateDeformers();
+
 	if (m_usedome) {
 		RenderDome();
 		return;
@@ -1182,7 +1201,9 @@ void KX_KetsjiEngine::RenderShadowBuffers(KX_Scene *scene)
 			light->BindShadowBuffer(m_rasterizer, m_canvas, cam, camtrans);
 
 			/* update scene */
+			m_logger->StartLog(tc_culling, m_kxsystem->GetTimeInSeconds(), true);
 			scene->CalculateVisibleMeshes(m_rasterizer, cam, light->GetShadowLayer());
+			m_logger->StartLog(tc_rasterizer, m_kxsystem->GetTimeInSeconds(), true);
 
 			/* render */
 			m_rasterizer->ClearDepthBuffer();
@@ -1310,7 +1331,7 @@ void KX_KetsjiEngine::RenderFrame(KX_Scene* scene, KX_Camera* cam)
 	// and this call though. Visibility is imparted when this call
 	// runs through the individual objects.
 
-	m_logger->StartLog(tc_scenegraph, m_kxsystem->GetTimeInSeconds(), true);
+	m_logger->StartLog(tc_culling, m_kxsystem->GetTimeInSeconds(), true);
 	SG_SetActiveStage(SG_STAGE_CULLING);
 
 	scene->CalculateVisibleMeshes(m_rasterizer,cam);
@@ -1387,6 +1408,8 @@ void KX_KetsjiEngine::PostProcessScene(KX_Scene* scene)
 
 	SG_SetActiveStage(SG_STAGE_SCENE);
 
+	scene->SetTaskScheduler(m_taskscheduler);
+
 	// if there is no activecamera, or the camera is being
 	// overridden we need to construct a temporarily camera
 	if (!scene->GetActiveCamera() || override_camera)
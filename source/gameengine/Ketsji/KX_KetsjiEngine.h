@@ -43,6 +43,7 @@
 #include <vector>
 
 class KX_TimeCategoryLogger;
+struct TaskScheduler;
 
 #define LEFT_EYE  1
 #define RIGHT_EYE 2
@@ -154,8 +155,10 @@ private:
 		tc_physics = 0,
 		tc_logic,
 		tc_animations,
+		tc_deformers,
 		tc_network,
 		tc_scenegraph,
+		tc_culling,
 		tc_rasterizer,
 		tc_services,	// time spent in miscelaneous activities
 		tc_overhead,	// profile info drawing overhead
@@ -166,6 +169,9 @@ private:
 
 	/** Time logger. */
 	KX_TimeCategoryLogger*	m_logger;
+
+	/** Scheduler for the tasks of the scenes (armatures and their deformers). */
+	struct TaskScheduler*	m_taskscheduler;
 	
 	/** Labels for profiling display. */
 	static const char		m_profileLabels[tc_numCategories][15];
@@ -89,8 +89,11 @@
 #include "BL_ModifierDeformer.h"
 #include "BL_ShapeDeformer.h"
 #include "BL_DeformableGameObject.h"
+#include "BL_ArmatureObject.h"
 #include "KX_ObstacleSimulation.h"
 
+#include "BLI_task.h"
+
 #ifdef WITH_BULLET
 #include "KX_SoftBodyDeformer.h"
 #include "KX_ConvertPhysicsObject.h"
@@ -101,6 +104,7 @@
 #include "KX_Light.h"
 
 #include <stdio.h>
+#include <algorithm>
 
 static void *KX_SceneReplicationFunc(SG_IObject* node,void* gameobj,void* scene)
 {
@@ -229,6 +233,9 @@ KX_Scene::KX_Scene(class SCA_IInputDevice* keyboarddevice,
 	default:
 		m_obstacleSimulation = NULL;
 	}
+
+	m_taskscheduler = NULL;
+	m_updatedNodes = 0;
 	
 #ifdef WITH_PYTHON
 	m_attr_dict = NULL;
@@ -1443,19 +1450,10 @@ void KX_Scene::MarkSubTreeVisible(SG_Tree *node, RAS_IRasterizer* rasty, bool vi
 		MarkSubTreeVisible(node->Right(), rasty, visible, cam, layer);
 }
 
-void KX_Scene::MarkVisible(RAS_IRasterizer* rasty, KX_GameObject* gameobj,KX_Camera*  cam,int layer)
+/* Test an object against the view frustum, only reads the object and the camera
+ * so objects can be tested in parallel once the camera frustum is extracted. */
+static bool object_inside_frustum(KX_GameObject* gameobj, KX_Camera* cam)
 {
-	// User (Python/Actuator) has forced object invisible...
-	if (!gameobj->GetSGNode() || !gameobj->GetVisible())
-		return;
-	
-	// Shadow lamp layers
-	if (layer && !(gameobj->GetLayer() & layer)) {
-		gameobj->SetCulled(true);
-		gameobj->UpdateBuckets(false);
-		return;
-	}
-
 	// If Frustum culling is off, the object is always visible.
 	bool vis = !cam->GetFrustumCulling();
 	
@@ -1486,7 +1484,28 @@ void KX_Scene::MarkVisible(RAS_IRasterizer* rasty, KX_GameObject* gameobj,KX_Cam
 				break;
 		}
 	}
+
+	return vis;
+}
+
+void KX_Scene::MarkVisible(RAS_IRasterizer* rasty, KX_GameObject* gameobj,KX_Camera*  cam,int layer)
+{
+	// User (Python/Actuator) has forced object invisible...
+	if (!gameobj->GetSGNode() || !gameobj->GetVisible())
+		return;
 	
+	// Shadow lamp layers
+	if (layer && !(gameobj->GetLayer() & layer)) {
+		gameobj->SetCulled(true);
+		gameobj->UpdateBuckets(false);
+		return;
+	}
+
+	MarkVisible(rasty, gameobj, object_inside_frustum(gameobj, cam));
+}
+
+void KX_Scene::MarkVisible(RAS_IRasterizer* rasty, KX_GameObject* gameobj, bool vis)
+{
 	if (vis)
 	{
 		int nummeshes = gameobj->GetMeshCount();
@@ -1521,6 +1540,73 @@ void KX_Scene::PhysicsCullingCallback(KX_ClientObjectInfo *objectInfo, void* cul
 	gameobj->UpdateBuckets(false);
 }
 
+/* minimum number of objects to test them in parallel, and number of objects per task */
+#define KX_CULLING_PARALLEL_MIN		1024
+#define KX_CULLING_TASK_SIZE		256
+
+enum {
+	KX_CULLING_NOT_TESTED = 0,
+	KX_CULLING_OUTSIDE,
+	KX_CULLING_INSIDE
+};
+
+struct CullingTask {
+	CListValue *objects;
+	KX_Camera *cam;
+	int layer;
+	int start, end;
+	char *results;
+};
+
+static void culling_task(TaskPool *UNUSED(pool), void *taskdata, int UNUSED(threadid))
+{
+	CullingTask *task = (CullingTask*)taskdata;
+
+	for (int i = task->start; i < task->end; i++) {
+		KX_GameObject *gameobj = static_cast<KX_GameObject*>(task->objects->GetValue(i));
+
+		// the objects that MarkVisible() doesn't test are left to it
+		if (!gameobj->GetSGNode() || !gameobj->GetVisible() || (task->layer && !(gameobj->GetLayer() & task->layer)))
+			continue;
+
+		task->results[i] = (object_inside_frustum(gameobj, task->cam)) ? KX_CULLING_INSIDE : KX_CULLING_OUTSIDE;
+	}
+}
+
+void KX_Scene::MarkVisibleParallel(RAS_IRasterizer* rasty, KX_Camera* cam, int layer)
+{
+	const int count = m_objectlist->GetCount();
+	std::vector<char> results(count, KX_CULLING_NOT_TESTED);
+	std::vector<CullingTask> tasks;
+
+	// the camera extracts its frustum on first use, do it before the tasks share it
+	cam->ExtractFrustumSphere();
+	cam->GetNormalizedClipPlanes();
+
+	for (int start = 0; start < count; start += KX_CULLING_TASK_SIZE) {
+		CullingTask task = {m_objectlist, cam, layer, start, std::min(start + KX_CULLING_TASK_SIZE, count), &results[0]};
+		tasks.push_back(task);
+	}
+
+	TaskPool *pool = BLI_task_pool_create(m_taskscheduler, NULL);
+
+	for (unsigned int i = 0; i < tasks.size(); i++)
+		BLI_task_pool_push(pool, culling_task, &tasks[i], false, TASK_PRIORITY_HIGH);
+
+	BLI_task_pool_work_and_wait(pool);
+	BLI_task_pool_free(pool);
+
+	// the mesh buckets aren't thread safe, update them in the order of the object list
+	for (int i = 0; i < count; i++) {
+		KX_GameObject *gameobj = static_cast<KX_GameObject*>(m_objectlist->GetValue(i));
+
+		if (results[i] == KX_CULLING_NOT_TESTED)
+			MarkVisible(rasty, gameobj, cam, layer);
+		else
+			MarkVisible(rasty, gameobj, results[i] == KX_CULLING_INSIDE);
+	}
+}
+
 void KX_Scene::CalculateVisibleMeshes(RAS_IRasterizer* rasty,KX_Camera* cam, int layer)
 {
 	bool dbvt_culling = false;
@@ -1548,7 +1634,11 @@ void KX_Scene::CalculateVisibleMeshes(RAS_IRasterizer* rasty,KX_Camera* cam, int
 		                                                 KX_GetActiveEngine()->GetCanvas()->GetViewPort(),
 		                                                 mvmat, pmat);
 	}
-	if (!dbvt_culling) {
+	if (!dbvt_culling && m_taskscheduler && m_objectlist->GetCount() >= KX_CULLING_PARALLEL_MIN) {
+		// the physics engine couldn't help us, test the objects in parallel
+		MarkVisibleParallel(rasty, cam, layer);
+	}
+	else if (!dbvt_culling) {
 		// the physics engine couldn't help us, do it the hard way
 		for (int i = 0; i < m_objectlist->GetCount(); i++)
 		{
@@ -1596,10 +1686,94 @@ void KX_Scene::AddAnimatedObject(CValue* gameobj)
 	m_animatedlist->Add(gameobj);
 }
 
+/* Skin deformers of the meshes parented to an armature that can be deformed
+ * ahead of the render. Shape and modifier deformers run drivers, and bone
+ * constraints read their target objects, so those are left for the render. */
+static void get_skin_deformers(BL_ArmatureObject *armature, std::vector<BL_SkinDeformer*>& deformers)
+{
+	if (armature->HasConstraints())
+		return;
+
+	CListValue *children = armature->GetChildren();
+
+	for (int i = 0; i < children->GetCount(); ++i) {
+		KX_GameObject *child = (KX_GameObject*)children->GetValue(i);
+
+		if (child->GetCulled() || child->GetDeformer() == NULL)
+			continue;
+
+		BL_SkinDeformer *deformer = dynamic_cast<BL_SkinDeformer*>(child->GetDeformer());
+
+		if (deformer && !dynamic_cast<BL_ShapeDeformer*>(deformer) && deformer->GetArmature() == armature)
+			deformers.push_back(deformer);
+	}
+
+	children->Release();
+}
+
+/* Armatures evaluate their actions into their own pose and deform their
+ * skinned meshes on private copies of the Blender objects, so every armature
+ * is updated by its own task, replicas included. */
+struct ArmatureTask {
+	BL_ArmatureObject *armature;
+	float curtime;
+};
+
+static void evaluate_armature_task(TaskPool *UNUSED(pool), void *taskdata, int UNUSED(threadid))
+{
+	ArmatureTask *task = (ArmatureTask*)taskdata;
+
+	task->armature->EvaluateActionManager(task->curtime);
+}
+
+static void deform_armature_task(TaskPool *UNUSED(pool), void *taskdata, int UNUSED(threadid))
+{
+	ArmatureTask *task = (ArmatureTask*)taskdata;
+	std::vector<BL_SkinDeformer*> deformers;
+
+	get_skin_deformers(task->armature, deformers);
+
+	for (unsigned int i = 0; i < deformers.size(); ++i)
+		deformers[i]->DeformAhead();
+}
+
+static void run_armature_tasks(TaskScheduler *scheduler, std::vector<BL_ArmatureObject*>& armatures,
+                               float curtime, TaskRunFunction run)
+{
+	std::vector<ArmatureTask> tasks(armatures.size());
+
+	for (unsigned int i = 0; i < armatures.size(); ++i) {
+		tasks[i].armature = armatures[i];
+		tasks[i].curtime = curtime;
+	}
+
+	if (scheduler == NULL || tasks.size() < 2) {
+		for (unsigned int i = 0; i < tasks.size(); ++i)
+			run(NULL, &tasks[i], 0);
+		return;
+	}
+
+	TaskPool *pool = BLI_task_pool_create(scheduler, NULL);
+
+	for (unsigned int i = 0; i < tasks.size(); ++i)
+		BLI_task_pool_push(pool, run, &tasks[i], false, TASK_PRIORITY_HIGH);
+
+	BLI_task_pool_work_and_wait(pool);
+	BLI_task_pool_free(pool);
+}
+
+void KX_Scene::SetTaskScheduler(struct TaskScheduler* scheduler)
+{
+	m_taskscheduler = scheduler;
+	m_logicmgr->SetTaskScheduler(scheduler);
+}
+
 void KX_Scene::UpdateAnimations(double curtime)
 {
 	KX_GameObject *gameobj;
 	bool needs_update;
+	std::vector<KX_GameObject*> updated;
+	std::vector<BL_ArmatureObject*> armatures;
 
 	for (int i=0; i<m_animatedlist->GetCount(); ++i) {
 		gameobj = (KX_GameObject*)m_animatedlist->GetValue(i);
@@ -1637,11 +1811,37 @@ void KX_Scene::UpdateAnimations(double curtime)
 				needs_update = true;
 
 			children->Release();
+
+			if (needs_update)
+				armatures.push_back((BL_ArmatureObject*)gameobj);
 		}
+		else
+			gameobj->EvaluateActionManager(curtime);
 
 		if (needs_update)
-			gameobj->UpdateActionManager(curtime);
+			updated.push_back(gameobj);
 	}
+
+	// Armature poses are the expensive part, evaluate them in parallel
+	run_armature_tasks(m_taskscheduler, armatures, (float)curtime, evaluate_armature_task);
+
+	// Ipo's change the scenegraph, so they are updated afterwards in the original order
+	for (unsigned int i = 0; i < updated.size(); ++i)
+		updated[i]->UpdateActionManagerIPOs();
+}
+
+void KX_Scene::UpdateDeformers()
+{
+	std::vector<BL_ArmatureObject*> armatures;
+
+	for (int i=0; i<m_animatedlist->GetCount(); ++i) {
+		KX_GameObject *gameobj = (KX_GameObject*)m_animatedlist->GetValue(i);
+
+		if (gameobj->GetGameObjectType() == SCA_IObject::OBJ_ARMATURE)
+			armatures.push_back((BL_ArmatureObject*)gameobj);
+	}
+
+	run_armature_tasks(m_taskscheduler, armatures, 0.0f, deform_armature_task);
 }
 
 void KX_Scene::LogicUpdateFrame(double curtime, bool frame)
@@ -1684,7 +1884,7 @@ void KX_Scene::UpdateParents(double curtime)
 
 	while ((node = SG_Node::GetNextScheduled(m_sghead)) != NULL)
 	{
-		node->UpdateWorldData(curtime);
+		m_updatedNodes += node->UpdateWorldData(curtime);
 	}
 
 	//for (int i=0; i<GetRootParentList()->GetCount(); i++)
@@ -2407,6 +2607,7 @@ PyAttributeDef KX_Scene::Attributes[] = {
 	KX_PYATTRIBUTE_BOOL_RO("activity_culling",		KX_Scene, m_activity_culling),
 	KX_PYATTRIBUTE_FLOAT_RW("activity_culling_radius", 0.5f, FLT_MAX, KX_Scene, m_activity_box_radius),
 	KX_PYATTRIBUTE_BOOL_RO("dbvt_culling",			KX_Scene, m_dbvt_culling),
+	KX_PYATTRIBUTE_INT_RO("updated_nodes",			KX_Scene, m_updatedNodes),
 	{ NULL }	//Sentinel
 };
 
@@ -58,6 +58,7 @@
 struct SM_MaterialProps;
 struct SM_ShapeProps;
 struct Scene;
+struct TaskScheduler;
 
 class CTR_HashedPtr;
 class CListValue;
@@ -284,6 +285,8 @@ protected:
 	void MarkVisible(SG_Tree *node, RAS_IRasterizer* rasty, KX_Camera*cam,int layer=0);
 	void MarkSubTreeVisible(SG_Tree *node, RAS_IRasterizer* rasty, bool visible, KX_Camera*cam,int layer=0);
 	void MarkVisible(RAS_IRasterizer* rasty, KX_GameObject* gameobj, KX_Camera*cam, int layer=0);
+	void MarkVisible(RAS_IRasterizer* rasty, KX_GameObject* gameobj, bool visible);
+	void MarkVisibleParallel(RAS_IRasterizer* rasty, KX_Camera* cam, int layer);
 	static void PhysicsCullingCallback(KX_ClientObjectInfo* objectInfo, void* cullingInfo);
 
 	double				m_suspendedtime;
@@ -295,6 +298,18 @@ protected:
 
 	KX_ObstacleSimulation* m_obstacleSimulation;
 
+	/**
+	 * Scheduler of the engine, used to update armatures and their
+	 * deformers in parallel. NULL updates them one after the other.
+	 */
+	struct TaskScheduler* m_taskscheduler;
+
+	/**
+	 * Number of scenegraph nodes whose world transform was updated
+	 * by UpdateParents() since the start of the frame.
+	 */
+	int m_updatedNodes;
+
 public:
 	KX_Scene(class SCA_IInputDevice* keyboarddevice,
 		class SCA_IInputDevice* mousedevice,
@@ -317,6 +332,8 @@ public:
 	static bool KX_ScenegraphUpdateFunc(SG_IObject* node,void* gameobj,void* scene);
 	static bool KX_ScenegraphRescheduleFunc(SG_IObject* node,void* gameobj,void* scene);
 	void UpdateParents(double curtime);
+	int GetUpdatedNodeCount() { return m_updatedNodes; }
+	void ResetUpdatedNodeCount() { m_updatedNodes = 0; }
 	void DupliGroupRecurse(CValue* gameobj, int level);
 	bool IsObjectInGroup(CValue* gameobj)
 	{ 
@@ -347,6 +364,11 @@ public:
 	void LogicBeginFrame(double curtime);
 	void LogicUpdateFrame(double curtime, bool frame);
 	void UpdateAnimations(double curtime);
+	/**
+	 * Deform the skinned meshes of the updated armatures before rendering.
+	 */
+	void UpdateDeformers();
+	void SetTaskScheduler(struct TaskScheduler* scheduler);
 
 		void
 	LogicEndFrame(
@@ -65,21 +65,57 @@ public:
 	}
 };
 
-struct RAS_BucketManager::backtofront
+/* Sort the mesh slots on depth with a radix sort on the bits of the depth as a float,
+ * 8 bits per pass. The sort is stable: slots at the same depth keep the order of
+ * their buckets. */
+void RAS_BucketManager::RadixSortSlots(vector<sortedmeshslot>& slots, bool backtofront)
 {
-	bool operator()(const sortedmeshslot &a, const sortedmeshslot &b)
-	{
-		return (a.m_z < b.m_z) || (a.m_z == b.m_z && a.m_ms < b.m_ms);
+	const size_t size = slots.size();
+	vector<unsigned int> keys(size), tmpkeys(size);
+	vector<sortedmeshslot> tmpslots(size);
+	size_t i;
+
+	if (size < 2)
+		return;
+
+	for (i = 0; i < size; i++) {
+		union { float f; unsigned int i; } z;
+		z.f = (float)slots[i].m_z;
+
+		/* flip the sign bit of positive floats and all bits of negative floats,
+		 * so that the unsigned integers sort like the floats */
+		keys[i] = z.i ^ ((z.i & 0x80000000) ? 0xFFFFFFFF : 0x80000000);
+		if (!backtofront)
+			keys[i] = ~keys[i];
 	}
-};
 
-struct RAS_BucketManager::fronttoback
-{
-	bool operator()(const sortedmeshslot &a, const sortedmeshslot &b)
-	{
-		return (a.m_z > b.m_z) || (a.m_z == b.m_z && a.m_ms > b.m_ms);
+	for (int shift = 0; shift < 32; shift += 8) {
+		size_t offsets[256] = {0};
+		size_t offset = 0;
+
+		for (i = 0; i < size; i++)
+			offsets[(keys[i] >> shift) & 0xFF]++;
+
+		/* all keys have the same byte, nothing to do for this pass */
+		if (offsets[(keys[0] >> shift) & 0xFF] == size)
+			continue;
+
+		for (int b = 0; b < 256; b++) {
+			size_t count = offsets[b];
+			offsets[b] = offset;
+			offset += count;
+		}
+
+		for (i = 0; i < size; i++) {
+			size_t j = offsets[(keys[i] >> shift) & 0xFF]++;
+			tmpkeys[j] = keys[i];
+			tmpslots[j] = slots[i];
+		}
+
+		keys.swap(tmpkeys);
+		slots.swap(tmpslots);
 	}
-};
+}
 
 /* bucket manager */
 
@@ -131,10 +167,7 @@ void RAS_BucketManager::OrderBuckets(const MT_Transform& cameratrans, BucketList
 		}
 	}
 		
-	if (alpha)
-		sort(slots.begin(), slots.end(), backtofront());
-	else
-		sort(slots.begin(), slots.end(), fronttoback());
+	RadixSortSlots(slots, alpha);
 }
 
 void RAS_BucketManager::RenderAlphaBuckets(const MT_Transform& cameratrans, RAS_IRasterizer* rasty)
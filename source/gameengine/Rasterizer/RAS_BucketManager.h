@@ -44,8 +44,6 @@ class RAS_BucketManager
 	BucketList m_AlphaBuckets;
 	
 	struct sortedmeshslot;
-	struct backtofront;
-	struct fronttoback;
 
 public:
 	RAS_BucketManager();
@@ -76,6 +74,7 @@ public:
 
 private:
 	void OrderBuckets(const MT_Transform& cameratrans, BucketList& buckets, vector<sortedmeshslot>& slots, bool alpha);
+	static void RadixSortSlots(vector<sortedmeshslot>& slots, bool backtofront);
 
 	void RenderSolidBuckets(const MT_Transform& cameratrans,
 		RAS_IRasterizer* rasty);
@@ -186,14 +186,18 @@ void SG_Node::RemoveChild(SG_Node* child)
 
 
 
-void SG_Node::UpdateWorldData(double time, bool parentUpdated)
+int SG_Node::UpdateWorldData(double time, bool parentUpdated)
 {
+	int updated = 0;
+
 	//if (!GetSGParent())
 	//	return;
 
-	if (UpdateSpatialData(GetSGParent(),time,parentUpdated))
+	if (UpdateSpatialData(GetSGParent(),time,parentUpdated)) {
 		// to update the 
 		ActivateUpdateTransformCallback();
+		updated++;
+	}
 
 	// The node is updated, remove it from the update list
 	Delink();
@@ -201,8 +205,15 @@ void SG_Node::UpdateWorldData(double time, bool parentUpdated)
 	// update children's worlddata
 	for (NodeList::iterator it = m_children.begin();it!=m_children.end();++it)
 	{
-		(*it)->UpdateWorldData(time, parentUpdated);
+		SG_Node *child = *it;
+
+		// a child that isn't modified keeps its world data if this node didn't move,
+		// unless one of its controllers (ipo's) changes it
+		if (parentUpdated || child->IsModified() || !child->GetSGControllerList().empty())
+			updated += child->UpdateWorldData(time, parentUpdated);
 	}
+
+	return updated;
 }
 
 
@@ -185,9 +185,12 @@ public:
 	/**
 	 * Update the spatial data of this node. Iterate through
 	 * the children of this node and update their world data.
+	 * Children that can't have moved are skipped, modified nodes
+	 * deeper in the tree are scheduled for update themselves.
+	 * \return the number of nodes whose world data changed
 	 */
 
-		void
+		int
 	UpdateWorldData(
 		double time,
 		bool parentUpdated=false